@@ -332,6 +332,9 @@ def export_scene(depsgraph, is_preview, fs):
         # light spectrum color, it defines color of the light
         fs.serialize(lamp.color[:])
 
+        # light group the light belongs to
+        fs.serialize(lamp.sort_data.light_group)
+
         # spot light and area light have extra properties to be serialized
         if lamp.type == 'SPOT':
             falloff_start = degrees(lamp.spot_size * ( 1.0 - lamp.spot_blend ) * 0.5)
@@ -355,7 +358,9 @@ def export_scene(depsgraph, is_preview, fs):
         fs.serialize(matrix_to_tuple(global_matrix))
         fs.serialize(( 1.0 , 1.0 , 1.0 ))   # light tint color
         fs.serialize( 1.0 )                 # sky light scaling, not supported since it is not pbs.
+        fs.serialize( scene.sort_hdr_sky.light_group )
         fs.serialize(bpy.path.abspath( hdr_sky_image.filepath ))
+        fs.serialize( scene.sort_hdr_sky.mis_compensation )
 
     # to indicate the scene stream comes to an end
     fs.serialize(SID('End of Entities'))
@@ -368,9 +373,13 @@ def name_compat(name):
         return name.replace(' ', '_')
 
 # export glocal settings for the renderer
+# name of the image file generated by the renderer
+def get_output_file_name(scene):
+    return 'blender_generated.' + scene.sort_data.output_format
+
 def export_global_config(scene, fs, sort_resource_path):
     # global renderer configuration
-    sort_output_file = 'blender_generated.exr'
+    sort_output_file = get_output_file_name(scene)
     xres = scene.render.resolution_x * scene.render.resolution_percentage / 100
     yres = scene.render.resolution_y * scene.render.resolution_percentage / 100
 
@@ -379,7 +388,7 @@ def export_global_config(scene, fs, sort_resource_path):
     integrator_type = sort_data.integrator_type_prop
     accelerator_type = sort_data.accelerator_type_prop
 
-    fs.serialize( 0 )
+    fs.serialize( 11 )    # version of global configuration, it needs to match GLOBAL_CONFIGURATION_VERSION in SORT.
     fs.serialize( sort_resource_path )
     fs.serialize( sort_output_file )
     fs.serialize( 64 )    # tile size, hard-coded it until I need to update it throught exposed interface later.
@@ -388,6 +397,23 @@ def export_global_config(scene, fs, sort_resource_path):
     fs.serialize( int(xres) )
     fs.serialize( int(yres) )
     fs.serialize( sort_data.clampping )
+    fs.serialize( sort_data.exr_half )
+    fs.serialize( int(sort_data.exr_compression) )
+    aov_enabled = sort_data.output_format == 'exr'
+    fs.serialize( aov_enabled and sort_data.aov_depth )
+    fs.serialize( aov_enabled and sort_data.aov_normal )
+    fs.serialize( aov_enabled and sort_data.aov_albedo )
+    fs.serialize( aov_enabled and sort_data.aov_sample_count )
+    fs.serialize( sort_data.aov_light_group_count if aov_enabled else 0 )
+    fs.serialize( int(sort_data.filter_type) )
+    fs.serialize( sort_data.filter_radius if sort_data.filter_type != '0' else 0.5 )
+    fs.serialize( sort_data.adaptive_sampling )
+    fs.serialize( int(sort_data.adaptive_min_spp) )
+    fs.serialize( int(sort_data.adaptive_batch_spp) )
+    fs.serialize( sort_data.adaptive_threshold )
+    fs.serialize( int(sort_data.progressive_spp) if sort_data.progressive else 0 )
+    fs.serialize( int(sort_data.sampler_type) )
+    fs.serialize( sort_data.deterministic )
 
     if accelerator_type == "bvh":
         fs.serialize( SID('Bvh') )
@@ -416,10 +442,17 @@ def export_global_config(scene, fs, sort_resource_path):
     fs.serialize( int(sort_data.inte_max_recur_depth) )
     if integrator_type == "PathTracing":
         fs.serialize( int(sort_data.max_bssrdf_bounces) )
+        fs.serialize( bool(sort_data.pt_path_guiding) )
+        fs.serialize( int(sort_data.pt_guiding_iterations) )
+        fs.serialize( int(sort_data.pt_guiding_memory) )
+        fs.serialize( bool(sort_data.pt_adrrs) )
     if integrator_type == "AmbientOcclusion":
         fs.serialize( sort_data.ao_max_dist )
-    if integrator_type == "BidirPathTracing" or integrator_type == "LightTracing":
+    if integrator_type == "BidirPathTracing" or integrator_type == "LightTracing" or integrator_type == "VertexConnectionMerging":
         fs.serialize( bool(sort_data.bdpt_mis) )
+    if integrator_type == "VertexConnectionMerging":
+        fs.serialize( sort_data.vcm_radius )
+        fs.serialize( sort_data.vcm_alpha )
     if integrator_type == "InstantRadiosity":
         fs.serialize( sort_data.ir_light_path_set_num )
         fs.serialize( sort_data.ir_light_path_num )
@@ -439,26 +472,28 @@ def export_smoke(obj, fs):
         return
 
     fs.serialize( SID('has_volume') )
-    
-    # dimension of the volume data
-    x, y, z = domain.domain_resolution
-    fs.serialize(x)
-    fs.serialize(y)
-    fs.serialize(z)
-
-    # the color itself, don't export it for now
-    # color_grid = np.fromiter(domain.color_grid, dtype=np.float32)
-    # fs.serialize(color_grid)
 
-    FLTFMT = struct.Struct('=f')
+    quantize = bpy.context.scene.sort_data.volume_quantization
+    resolution = domain.domain_resolution
 
     # the density itself
-    density_data = bytearray()
-    density_grid = np.fromiter(domain.density_grid, dtype=np.float32)
-    for density in density_grid:
-        density_data += FLTFMT.pack(density)
+    export_volume_grid(fs, resolution, np.fromiter(domain.density_grid, dtype=np.float32), quantize)
+
+    # the color, alpha channel is dropped, the density already takes care of it
+    color_grid = np.fromiter(domain.color_grid, dtype=np.float32)
+    if len(color_grid) == 4 * len(domain.density_grid):
+        export_volume_grid(fs, resolution, color_grid.reshape(-1, 4)[:, :3], quantize)
+    else:
+        export_volume_grid(fs, (0, 0, 0), np.zeros(0, dtype=np.float32), quantize)
 
-    fs.serialize(density_data)
+# export a grid of volume data, channels of a voxel are next to each other and x goes first, then y and z
+def export_volume_grid(fs, resolution, grid, quantize):
+    x, y, z = resolution
+    fs.serialize(int(x))
+    fs.serialize(int(y))
+    fs.serialize(int(z))
+    fs.serialize(bool(quantize))
+    fs.serialize(np.ascontiguousarray(grid, dtype=np.float32).tobytes())
 
 # export a mesh
 def export_mesh(obj, mesh, fs):
@@ -914,5 +949,8 @@ def export_materials(depsgraph, fs):
         fs.serialize( material.sort_material.volume_step )
         fs.serialize( material.sort_material.volume_step_cnt )
 
+        # emitted radiance of surfaces with the material, emissive triangles are sampled as lights
+        fs.serialize( tuple( c * material.sort_material.emission_strength for c in material.sort_material.emission_color ) )
+
     # indicate the end of material parsing
     fs.serialize(SID('End of Material'))
\ No newline at end of file
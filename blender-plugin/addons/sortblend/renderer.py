@@ -98,7 +98,9 @@ class SORT_Thread():
                 # update header info to make sure it is not processed again
                 self.shared_memory[i] = self.shared_memory[i] + 1
 
-            if all_done is True:
+            # in progressive rendering, tiles get updated again in later passes, only stop once the whole rendering is done
+            progress = self.shared_memory[self.render_engine.image_size_in_bytes * 2 + self.render_engine.image_header_size]
+            if all_done is True and progress >= 100:
                 break
 
         # close the shared memory if it is the last update
@@ -241,7 +243,7 @@ class SORTRenderEngine(bpy.types.RenderEngine):
             result = self.begin_result(0, 0, scene.render.resolution_x, scene.render.resolution_y)
 
             # update image memory
-            output_file = intermediate_dir + 'blender_generated.exr'
+            output_file = intermediate_dir + exporter.get_output_file_name(scene)
             result.layers[0].load_from_file(output_file)
 
             # refresh the update
@@ -17,6 +17,16 @@ import bpy
 import bl_ui
 from .. import base
 
+@base.register_class
+class SORTLightData(bpy.types.PropertyGroup):
+    light_group : bpy.props.IntProperty( name='Light Group', default=0, min=0, max=7, description='Radiance of lights in the same group is written to the same AOV.')
+    @classmethod
+    def register(cls):
+        bpy.types.Light.sort_data = bpy.props.PointerProperty(name="SORT Data", type=cls)
+    @classmethod
+    def unregister(cls):
+        del bpy.types.Light.sort_data
+
 class SORTLightPanel(bl_ui.properties_data_light.DataButtonsPanel):
     bl_space_type = "PROPERTIES"
     bl_region_type = "WINDOW"
@@ -37,6 +47,7 @@ class LIGHT_PT_SORTPanel(SORTLightPanel, bpy.types.Panel):
 
         layout.prop( light , 'color' )
         layout.prop( light , 'energy' )
+        layout.prop( light.sort_data , 'light_group' )
 
         type = light.type
         if type == 'SPOT':
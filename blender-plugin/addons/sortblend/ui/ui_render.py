@@ -33,7 +33,8 @@ class SORTRenderData(bpy.types.PropertyGroup):
                          ("InstantRadiosity", "Instant Radiosity", "", 4),
                          ("AmbientOcclusion", "Ambient Occlusion", "", 5),
                          ("DirectLight", "Direct Lighting", "", 6),
-                         ("WhittedRT", "Whitted", "", 7) ]
+                         ("WhittedRT", "Whitted", "", 7),
+                         ("VertexConnectionMerging", "Vertex Connection and Merging", "Passes of progressive rendering are iterations of merging", 8) ]
     integrator_type_prop : bpy.props.EnumProperty(items=integrator_types, name='Accelerator')
 
     # general integrator parameters
@@ -42,6 +43,14 @@ class SORTRenderData(bpy.types.PropertyGroup):
     # maxmum bounces supported in BSSRDF, exceeding the threshold will result in replacing BSSRDF with Lambert
     max_bssrdf_bounces : bpy.props.IntProperty(name='Maximum Bounces in SSS path', default=4, min=1)
 
+    # path guiding learns incident radiance in a few training iterations before rendering
+    pt_path_guiding : bpy.props.BoolProperty(name='Path Guiding', default=False)
+    pt_guiding_iterations : bpy.props.IntProperty(name='Training Iterations', default=5, min=1, max=12)
+    pt_guiding_memory : bpy.props.IntProperty(name='Guiding Memory Budget (MB)', default=64, min=1)
+
+    # russian roulette and splitting driven by a pixel estimation rendered before the final image
+    pt_adrrs : bpy.props.BoolProperty(name='Adjoint-driven Russian Roulette and Splitting', default=False)
+
     # ao integrator parameters
     ao_max_dist : bpy.props.FloatProperty(name='Maximum Distance', default=3.0, min=0.01)
 
@@ -53,6 +62,10 @@ class SORTRenderData(bpy.types.PropertyGroup):
     # bidirectional path tracing parameters
     bdpt_mis : bpy.props.BoolProperty(name='Multiple Importance Sampling', default=True)
 
+    # vertex connection and merging parameters, the radius is relative to the radius of the scene
+    vcm_radius : bpy.props.FloatProperty(name='Merging Radius', default=0.003, min=0.0001, max=0.1, precision=4)
+    vcm_alpha : bpy.props.FloatProperty(name='Radius Reduction', default=0.75, min=0.01, max=1.0)
+
     #------------------------------------------------------------------------------------#
     #                              Spatial Accelerator Settings                          #
     #------------------------------------------------------------------------------------#
@@ -94,12 +107,54 @@ class SORTRenderData(bpy.types.PropertyGroup):
     #                                 Sampling Settings                                  #
     #------------------------------------------------------------------------------------#
     sampler_count_prop : bpy.props.IntProperty(name='Count',default=1, min=1)
+    sampler_types = [ ("0", "Random", "Independent random numbers", 0),
+                      ("1", "Sobol", "Owen-scrambled Sobol sequence", 1),
+                      ("2", "PMJ02", "Progressive multi-jittered (0,2) sequence, well stratified in every pair of dimensions", 2) ]
+    sampler_type : bpy.props.EnumProperty(items=sampler_types, name='Sampler', default='1')
+    filter_types = [ ("0", "Box", "Average samples inside a pixel", 0),
+                     ("1", "Gaussian", "Gaussian filter", 1),
+                     ("2", "Mitchell", "Mitchell-Netravali filter, sharper with slight ringing", 2),
+                     ("3", "Blackman-Harris", "Blackman-Harris window, smooth with little aliasing", 3) ]
+    filter_type : bpy.props.EnumProperty(items=filter_types, name='Filter', default='0')
+    filter_radius : bpy.props.FloatProperty(name='Filter Radius', default=1.5, min=0.5, max=4.0, description='Radius of the reconstruction filter in pixels, box filter with radius of 0.5 only takes samples inside a pixel.')
+    adaptive_sampling : bpy.props.BoolProperty(name='Adaptive Sampling', default=False, description='Stop taking samples in a pixel once it converges, sample count becomes the maximum number of samples per pixel.')
+    adaptive_min_spp : bpy.props.IntProperty(name='Minimum Samples', default=16, min=2, description='Number of samples taken before estimating error of a pixel.')
+    adaptive_batch_spp : bpy.props.IntProperty(name='Samples per Round', default=8, min=1, description='Number of samples taken in each round after the first one.')
+    adaptive_threshold : bpy.props.FloatProperty(name='Noise Threshold', default=0.02, min=0.0001, max=1.0, description='Target relative standard error of pixels.')
+    progressive : bpy.props.BoolProperty(name='Progressive', default=False, description='Render the whole image in multiple passes so that a full image shows up quickly, adaptive sampling is not supported in this mode.')
+    progressive_spp : bpy.props.IntProperty(name='Samples per Pass', default=1, min=1, description='Number of samples per pixel taken in each pass.')
+    deterministic : bpy.props.BoolProperty(name='Deterministic', default=False, description='Bitwise identical result across runs regardless of the number of threads, it is slightly slower.')
+
+    #------------------------------------------------------------------------------------#
+    #                                  Volume Settings                                   #
+    #------------------------------------------------------------------------------------#
+    volume_quantization : bpy.props.BoolProperty(name='Quantize Volumes', default=False, description='Store volume data in 16 bits per channel, it takes half the memory with a tiny loss of precision.')
 
     #------------------------------------------------------------------------------------#
     #                                 Threading Settings                                 #
     #------------------------------------------------------------------------------------#
     thread_num_prop : bpy.props.IntProperty(name='Thread Num', default=8, min=1, max=32)
 
+    #------------------------------------------------------------------------------------#
+    #                                  Output Settings                                   #
+    #------------------------------------------------------------------------------------#
+    output_formats = [ ("exr", "OpenEXR", "High dynamic range image in OpenEXR format", 0),
+                       ("hdr", "Radiance HDR", "High dynamic range image in RGBE format", 1),
+                       ("png", "PNG", "8 bits sRGB image, mostly for preview", 2) ]
+    output_format : bpy.props.EnumProperty(items=output_formats, name='Format', default='exr')
+    exr_half : bpy.props.BoolProperty(name='Half Float', default=True, description='Store OpenEXR channels in half precision.')
+    exr_compressions = [ ("0", "None", "", 0),
+                         ("1", "RLE", "", 1),
+                         ("2", "ZIPS", "", 2),
+                         ("3", "ZIP", "", 3),
+                         ("4", "PIZ", "", 4) ]
+    exr_compression : bpy.props.EnumProperty(items=exr_compressions, name='Compression', default='3')
+    aov_depth : bpy.props.BoolProperty(name='Depth', default=False, description='Output distance from camera to the first hit, OpenEXR only.')
+    aov_normal : bpy.props.BoolProperty(name='Normal', default=False, description='Output shading normal of the first hit, OpenEXR only.')
+    aov_albedo : bpy.props.BoolProperty(name='Albedo', default=False, description='Output albedo of the first hit, OpenEXR only.')
+    aov_sample_count : bpy.props.BoolProperty(name='Sample Count', default=False, description='Output number of valid samples per pixel, OpenEXR only.')
+    aov_light_group_count : bpy.props.IntProperty(name='Light Groups', default=0, min=0, max=8, description='Number of light groups to output, OpenEXR only.')
+
     #------------------------------------------------------------------------------------#
     #                                 Debugging Settings                                 #
     #------------------------------------------------------------------------------------#
@@ -152,10 +207,19 @@ class RENDER_PT_IntegratorPanel(SORTRenderPanel,bpy.types.Panel):
             self.layout.prop(data,"inte_max_recur_depth")
         if integrator_type == "PathTracing":
             self.layout.prop(data,"max_bssrdf_bounces" )
+            self.layout.prop(data,"pt_path_guiding")
+            if data.pt_path_guiding:
+                self.layout.prop(data,"pt_guiding_iterations")
+                self.layout.prop(data,"pt_guiding_memory")
+            self.layout.prop(data,"pt_adrrs")
         if integrator_type == "AmbientOcclusion":
             self.layout.prop(data,"ao_max_dist")
         if integrator_type == "BidirPathTracing":
             self.layout.prop(data,"bdpt_mis")
+        if integrator_type == "VertexConnectionMerging":
+            self.layout.prop(data,"bdpt_mis")
+            self.layout.prop(data,"vcm_radius")
+            self.layout.prop(data,"vcm_alpha")
         if integrator_type == "InstantRadiosity":
             self.layout.prop(data,"ir_light_path_set_num")
             self.layout.prop(data,"ir_light_path_num")
@@ -202,6 +266,40 @@ class RENDER_PT_SamplerPanel(SORTRenderPanel, bpy.types.Panel):
     bl_label = 'Sample'
     def draw(self, context):
         self.layout.prop(context.scene.sort_data,"sampler_count_prop")
+        self.layout.prop(context.scene.sort_data,"sampler_type")
+        self.layout.prop(context.scene.sort_data,"filter_type")
+        self.layout.prop(context.scene.sort_data,"filter_radius")
+        self.layout.prop(context.scene.sort_data,"adaptive_sampling")
+        if context.scene.sort_data.adaptive_sampling:
+            self.layout.prop(context.scene.sort_data,"adaptive_min_spp")
+            self.layout.prop(context.scene.sort_data,"adaptive_batch_spp")
+            self.layout.prop(context.scene.sort_data,"adaptive_threshold")
+        self.layout.prop(context.scene.sort_data,"progressive")
+        if context.scene.sort_data.progressive:
+            self.layout.prop(context.scene.sort_data,"progressive_spp")
+        self.layout.prop(context.scene.sort_data,"deterministic")
+
+@base.register_class
+class RENDER_PT_VolumePanel(SORTRenderPanel, bpy.types.Panel):
+    bl_label = 'Volume'
+    def draw(self, context):
+        self.layout.prop(context.scene.sort_data,"volume_quantization")
+
+@base.register_class
+class RENDER_PT_OutputPanel(SORTRenderPanel, bpy.types.Panel):
+    bl_label = 'Output'
+    def draw(self, context):
+        data = context.scene.sort_data
+        self.layout.prop(data,"output_format")
+        if data.output_format == "exr":
+            self.layout.prop(data,"exr_half")
+            self.layout.prop(data,"exr_compression")
+            self.layout.label(text='AOVs')
+            self.layout.prop(data,"aov_depth")
+            self.layout.prop(data,"aov_normal")
+            self.layout.prop(data,"aov_albedo")
+            self.layout.prop(data,"aov_sample_count")
+            self.layout.prop(data,"aov_light_group_count")
 
 @base.register_class
 class SORT_export_debug_scene(bpy.types.Operator):
@@ -49,6 +49,8 @@ class SORTHDRSky(bpy.types.PropertyGroup):
 
     hdr_image : bpy.props.PointerProperty(type=bpy.types.Image)
     preview : bpy.props.EnumProperty(items=generate_preview)
+    light_group : bpy.props.IntProperty( name='Light Group', default=0, min=0, max=7, description='Radiance of the sky is written to the AOV of this light group.')
+    mis_compensation : bpy.props.BoolProperty( name='MIS Compensation', default=True, description='Sample regions brighter than the average radiance more often and leave the rest mostly to BSDF sampling.')
     @classmethod
     def register(cls):
         bpy.types.Scene.sort_hdr_sky = bpy.props.PointerProperty(name="SORT HDR Sky", type=cls)
@@ -71,3 +73,5 @@ class HDRSKY_PT_SORTPanel(bpy.types.Panel):
     def draw(self, context):
         self.layout.template_ID(context.scene.sort_hdr_sky, 'hdr_image', open='image.open')
         self.layout.template_icon_view(context.scene.sort_hdr_sky, 'preview', show_labels=True)
+        self.layout.prop(context.scene.sort_hdr_sky, 'light_group')
+        self.layout.prop(context.scene.sort_hdr_sky, 'mis_compensation')
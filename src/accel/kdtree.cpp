@@ -347,7 +347,7 @@ void KDTree::traverse( const Kd_Node* node , const Ray& ray , BSSRDFIntersection
             // make sure the primitive is not checked before
             auto checked = false;
             for( auto i = 0u ; i < intersect.cnt ; ++i ){
-                if( primitive == intersect.intersections[i]->intersection.primitive ){
+                if( primitive == intersect.intersections[i].intersection.primitive ){
                     checked = true;
                     break;
                 }
@@ -361,23 +361,22 @@ void KDTree::traverse( const Kd_Node* node , const Ray& ray , BSSRDFIntersection
             const auto intersected = primitive->GetIntersect( ray , &intersection );
             if( intersected ){
                 if( intersect.cnt < TOTAL_SSS_INTERSECTION_CNT ){
-                    intersect.intersections[intersect.cnt] = SORT_MALLOC(BSSRDFIntersection)();
-                    intersect.intersections[intersect.cnt++]->intersection = intersection;
+                    intersect.intersections[intersect.cnt++].intersection = intersection;
                 }else{
                     auto picked_i = -1;
                     auto t = 0.0f;
                     for( auto i = 0 ; i < TOTAL_SSS_INTERSECTION_CNT ; ++i ){
-                        if( t < intersect.intersections[i]->intersection.t ){
-                            t = intersect.intersections[i]->intersection.t;
+                        if( t < intersect.intersections[i].intersection.t ){
+                            t = intersect.intersections[i].intersection.t;
                             picked_i = i;
                         }
                     }
                     if( picked_i >= 0 )
-                        intersect.intersections[picked_i]->intersection = intersection;
+                        intersect.intersections[picked_i].intersection = intersection;
 
                     intersect.maxt = 0.0f;
                     for( auto i = 0u ; i < intersect.cnt ; ++i )
-                        intersect.maxt = std::max( intersect.maxt , intersect.intersections[i]->intersection.t );
+                        intersect.maxt = std::max( intersect.maxt , intersect.intersections[i].intersection.t );
                 }
             }
         }
@@ -356,7 +356,7 @@ void UniGrid::traverse( const Ray& ray , BSSRDFIntersections& intersect , unsign
         // make sure the primitive is not checked before
         auto checked = false;
         for( auto i = 0u ; i < intersect.cnt ; ++i ){
-            if( primitive == intersect.intersections[i]->intersection.primitive ){
+            if( primitive == intersect.intersections[i].intersection.primitive ){
                 checked = true;
                 break;
             }
@@ -370,23 +370,22 @@ void UniGrid::traverse( const Ray& ray , BSSRDFIntersections& intersect , unsign
         const auto intersected = primitive->GetIntersect( ray , &intersection );
         if( intersected ){
             if( intersect.cnt < TOTAL_SSS_INTERSECTION_CNT ){
-                intersect.intersections[intersect.cnt] = SORT_MALLOC(BSSRDFIntersection)();
-                intersect.intersections[intersect.cnt++]->intersection = intersection;
+                intersect.intersections[intersect.cnt++].intersection = intersection;
             }else{
                 auto picked_i = -1;
                 auto t = 0.0f;
                 for( auto i = 0 ; i < TOTAL_SSS_INTERSECTION_CNT ; ++i ){
-                    if( t < intersect.intersections[i]->intersection.t ){
-                        t = intersect.intersections[i]->intersection.t;
+                    if( t < intersect.intersections[i].intersection.t ){
+                        t = intersect.intersections[i].intersection.t;
                         picked_i = i;
                     }
                 }
                 if( picked_i >= 0 )
-                    intersect.intersections[picked_i]->intersection = intersection;
+                    intersect.intersections[picked_i].intersection = intersection;
 
                 intersect.maxt = 0.0f;
                 for( auto i = 0u ; i < intersect.cnt ; ++i )
-                    intersect.maxt = std::max( intersect.maxt , intersect.intersections[i]->intersection.t );
+                    intersect.maxt = std::max( intersect.maxt , intersect.intersections[i].intersection.t );
             }
         }
     }
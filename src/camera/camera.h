@@ -55,6 +55,13 @@ public:
     //! @return     Camera forward direction in world space.
     virtual Vector GetForward() const = 0;
 
+    //! @brief      Get viewing point.
+    //!
+    //! @return     The viewing point of the camera in world space, it is the center of the lens if there is any.
+    const Point& GetEye() const {
+        return m_eye;
+    }
+
     //! @brief Get camera coordinate according to a view direction in world space. It is used in light tracing or bi-directional path tracing algorithm.
     //! @param inter            The intersection to be considered when randomly sampling a point on the sensor.
     //! @param pdfw             PDF w.r.t the solid angle of choosing the direction.
@@ -27,9 +27,12 @@
 #include "core/rtti.h"
 #include "imagesensor/blenderimage.h"
 #include "imagesensor/rendertargetimage.h"
+#include "texture/imageoutput.h"
+#include "sampler/adaptive.h"
+#include "sampler/sampler.h"
 
 //! @brief  This needs to be update every time the content of GlobalConfiguration changes.
-constexpr unsigned int GLOBAL_CONFIGURATION_VERSION = 0;
+constexpr unsigned int GLOBAL_CONFIGURATION_VERSION = 11;
 
 //! @brief  GlobalConfiguration saves some global state.
 class GlobalConfiguration : public Singleton<GlobalConfiguration> , SerializableObject {
@@ -153,6 +156,70 @@ public:
         return m_clampping;
     }
 
+    //! @brief      Get settings of the output image.
+    //!
+    //! @return     Settings of the output image, like precision and compression of EXR files.
+    const ImageOutputConfig&        GetImageOutputConfig() const{
+        return m_imageOutputConfig;
+    }
+
+    //! @brief      Get the reconstruction filter.
+    //!
+    //! @return     Filter used to reconstruct pixels from samples.
+    const Filter&                   GetFilter() const{
+        return m_filter;
+    }
+
+    //! @brief      Get settings of adaptive sampling.
+    //!
+    //! When enabled, sample per pixel is the maximum number of samples a pixel could take.
+    //!
+    //! @return     Settings of adaptive sampling.
+    const AdaptiveSamplingConfig&   GetAdaptiveSampling() const{
+        return m_adaptiveSampling;
+    }
+
+    //! @brief      Get sample per pixel of each pass in progressive rendering.
+    //!
+    //! Progressive rendering renders the whole frame multiple times, each pass takes a few samples
+    //! per pixel only, so that a full image shows up quickly.
+    //!
+    //! @return     Sample per pixel of each pass, zero means progressive rendering is disabled.
+    unsigned int                    GetProgressiveSpp() const{
+        return m_progressiveSpp;
+    }
+
+    //! @brief      Get the number of passes to render the frame.
+    //!
+    //! @return     Number of passes, it is always one if progressive rendering is disabled.
+    unsigned int                    GetPassCnt() const{
+        return m_progressiveSpp == 0 ? 1 : ( m_samplePerPixel + m_progressiveSpp - 1 ) / m_progressiveSpp;
+    }
+
+    //! @brief      Get the type of sampler generating samples of pixels.
+    //!
+    //! @return     Type of the sampler.
+    SamplerType                     GetSamplerType() const{
+        return m_samplerType;
+    }
+
+    //! @brief      Whether rendering is deterministic.
+    //!
+    //! In deterministic mode, the result is bitwise identical across runs, no matter how many threads there are.
+    //! Tiles are merged into the film in the order they are scheduled, which costs a little bit of performance.
+    //!
+    //! @return     Whether rendering is deterministic.
+    bool                            GetDeterministic() const{
+        return m_deterministic;
+    }
+
+    //! @brief      Get the registry of arbitrary output variables.
+    //!
+    //! @return     Registry of all enabled channels rendered along with the beauty pass.
+    const AOVRegistry&              GetAOVRegistry() const{
+        return m_aovRegistry;
+    }
+
     //! @brief      Parse command line.
     //!
     //! This is not a perfect way to parse command line arguments. If there is a space in the path,
@@ -196,6 +263,8 @@ public:
                 m_profilingEnalbed = value_str == "on";
             }else if (key_str == "nomaterial" ){
                 m_noMaterialSupport = true;
+            }else if (key_str == "deterministic" ){
+                m_deterministic = true;
             }
         }
 
@@ -218,6 +287,22 @@ public:
         stream >> m_samplePerPixel;
         stream >> m_resWidth >> m_resHeight;
         stream >> m_clampping;
+        int exr_compression = 0;
+        stream >> m_imageOutputConfig.exr_half >> exr_compression;
+        m_imageOutputConfig.exr_compression = (ExrCompression)exr_compression;
+        AOVConfig aov_config;
+        aov_config.Serialize( stream );
+        m_aovRegistry.Setup( aov_config );
+        m_filter.Serialize( stream );
+        m_adaptiveSampling.Serialize( stream );
+        stream >> m_progressiveSpp;
+        m_progressiveSpp = std::min( m_progressiveSpp , m_samplePerPixel );
+        int sampler_type = 0;
+        stream >> sampler_type;
+        m_samplerType = (SamplerType)sampler_type;
+        bool deterministic = false;
+        stream >> deterministic;
+        m_deterministic |= deterministic;
         StringID accelType , integratorType;
         stream >> accelType;
         m_accelerator = MakeUniqueInstance<Accelerator>(accelType);
@@ -256,6 +341,13 @@ private:
     bool                            m_noMaterialSupport = false;    /**< Disable material support in SORT. */
     std::string                     m_inputFile;                    /**< Full path of the input file. */
     float                           m_clampping = 0.0f;             /**< Clapping value of evaluated radiance. */
+    ImageOutputConfig               m_imageOutputConfig;            /**< Settings of the output image. */
+    AOVRegistry                     m_aovRegistry;                  /**< Registry of arbitrary output variables. */
+    Filter                          m_filter;                       /**< Reconstruction filter of the film. */
+    AdaptiveSamplingConfig          m_adaptiveSampling;             /**< Settings of adaptive sampling. */
+    unsigned int                    m_progressiveSpp = 0;           /**< Sample per pixel of each pass in progressive rendering, zero to disable it. */
+    SamplerType                     m_samplerType = SAMPLER_RANDOM; /**< Type of the sampler. */
+    bool                            m_deterministic = false;        /**< Whether the result is bitwise identical across runs. */
 
     //! @brief  Make constructor private
     GlobalConfiguration(){}
@@ -282,4 +374,12 @@ private:
 #define g_imageSensor               GlobalConfiguration::GetSingleton().GetImageSensor()
 #define g_profilingEnabled          GlobalConfiguration::GetSingleton().GetIsProfilingEnabled()
 #define g_noMaterial                GlobalConfiguration::GetSingleton().GetNoMaterial()
-#define g_clammping                 GlobalConfiguration::GetSingleton().GetClampping()
\ No newline at end of file
+#define g_clammping                 GlobalConfiguration::GetSingleton().GetClampping()
+#define g_imageOutputConfig         GlobalConfiguration::GetSingleton().GetImageOutputConfig()
+#define g_aovRegistry               GlobalConfiguration::GetSingleton().GetAOVRegistry()
+#define g_filter                    GlobalConfiguration::GetSingleton().GetFilter()
+#define g_adaptiveSampling          GlobalConfiguration::GetSingleton().GetAdaptiveSampling()
+#define g_progressiveSpp            GlobalConfiguration::GetSingleton().GetProgressiveSpp()
+#define g_passCnt                   GlobalConfiguration::GetSingleton().GetPassCnt()
+#define g_samplerType               GlobalConfiguration::GetSingleton().GetSamplerType()
+#define g_deterministic             GlobalConfiguration::GetSingleton().GetDeterministic()
\ No newline at end of file
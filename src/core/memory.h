@@ -19,6 +19,7 @@
 
 #include <list>
 #include <memory>
+#include <utility>
 #include "core/sassert.h"
 
 // 32KB memory for each memory block by default.
@@ -97,6 +98,30 @@ SORT_FORCEINLINE ::MemoryAllocator& GetStaticAllocator() {
     return memoryAllocator;
 }
 
+//! @brief  Redirect the memory allocated in the current thread to another allocator within a scope.
+/**
+ * Memory of the per-thread allocator is recycled after each sample. Data built through SORT_MALLOC that
+ * needs to outlive samples can be allocated within this scope, it lives as long as the allocator passed in.
+ */
+class MemoryAllocatorScope {
+public:
+    //! @brief  Constructor, memory is allocated from the allocator passed in since then.
+    //!
+    //! @param  allocator   The allocator to allocate memory from.
+    MemoryAllocatorScope(MemoryAllocator& allocator) : m_allocator(allocator) {
+        std::swap(GetStaticAllocator(), m_allocator);
+    }
+
+    //! @brief  Destructor, the per-thread allocator is restored.
+    ~MemoryAllocatorScope() {
+        std::swap(GetStaticAllocator(), m_allocator);
+    }
+
+private:
+    /**< The allocator taking the place of the per-thread allocator. */
+    MemoryAllocator&    m_allocator;
+};
+
 #define SORT_MALLOC(T)              new (GetStaticAllocator().Allocate<T>()) T
 #define SORT_MALLOC_ARRAY(T,cnt)    new (GetStaticAllocator().Allocate<T>(cnt)) T
 #define SORT_CLEAR_MEMPOOL()        GetStaticAllocator().Reset()
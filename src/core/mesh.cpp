@@ -189,4 +189,16 @@ Spectrum Mesh::SampleVolumeColor(const Point& pos) const {
         return 0.0f;
     const auto uvw = m_world2Volume.TransformPoint(pos);
     return m_volumeColor->Sample(uvw);
-}
\ No newline at end of file
+}
+
+void Mesh::BuildMajorantGrid(const MaterialBase* material) const {
+    if (m_majorantGrid || IS_PTR_INVALID(material) || !material->HasVolumeAttached())
+        return;
+
+    m_majorantGrid = std::make_unique<MajorantGrid>();
+    m_majorantGrid->Build(m_volumeDensity.get(), [&](float density) {
+        MediumSample ms;
+        material->EvaluateMediumSample(density, ms);
+        return (ms.basecolor * ms.extinction).GetMaxComponent();
+    });
+}
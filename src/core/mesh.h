@@ -25,6 +25,7 @@
 #include "math/transform.h"
 #include "stream/stream.h"
 #include "medium/mediumdata.h"
+#include "medium/majorantgrid.h"
 
 class MaterialBase;
 
@@ -89,6 +90,28 @@ public:
     //! @return         The color of the volume.
     Spectrum    SampleVolumeColor(const Point& pos) const;
 
+    //! @brief      Build the majorant grid of the volume inside the mesh.
+    //!
+    //! It needs the volume shader of the material, it is done once all materials are built. Nothing is done if
+    //! the grid is built already.
+    //!
+    //! @param  material    The material attaching the volume to the mesh.
+    void        BuildMajorantGrid(const MaterialBase* material) const;
+
+    //! @brief      Get the majorant grid of the volume inside the mesh.
+    //!
+    //! @return         The majorant grid, 'nullptr' if it is not built.
+    const MajorantGrid* GetMajorantGrid() const {
+        return m_majorantGrid.get();
+    }
+
+    //! @brief      Get the transformation from world space to volume texture space.
+    //!
+    //! @return         The transformation from world space to volume texture space.
+    const Matrix&   GetWorldToVolume() const {
+        return m_world2Volume;
+    }
+
 private:
     //! @brief      Generate tangent for the triangles.
     //!
@@ -110,4 +133,6 @@ private:
     std::unique_ptr<MediumDensity>  m_volumeDensity;
     /**< The color of the volume data inside this mesh. */
     std::unique_ptr<MediumColor>    m_volumeColor;
-};
\ No newline at end of file
+    /**< Upper bounds of the extinction of the volume inside this mesh, it is built after loading. */
+    mutable std::unique_ptr<MajorantGrid>   m_majorantGrid;
+};
\ No newline at end of file
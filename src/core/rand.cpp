@@ -16,116 +16,65 @@
  */
 
 #include "rand.h"
-#include "core/define.h"
 #include "core/thread.h"
+#include "sampler/sampler.h"
 
-#if defined(SORT_IN_LINUX)
-#elif defined(SORT_IN_WINDOWS)
-#include <time.h>
-#endif
-
-#include <random>
-
-// different implementation of the random generator on different platforms could cause problems, switched to old solution until I have time to work on it later.
-// #define HIDE_OLD_RANDDOM_GENERATOR
-
-#ifndef HIDE_OLD_RANDDOM_GENERATOR
-// Random Number Method Definitions
-#define M 397
-#define MATRIX_A 0x9908b0dfUL   /* constant vector a */
-#define UPPER_MASK 0x80000000UL /* most significant w-r bits */
-#define LOWER_MASK 0x7fffffffUL /* least significant r bits */
+// PCG32 with 64 bits of state, for further detail, please refer to http://www.pcg-random.org/
+// The increment is fixed so that each thread only needs 8 bytes of state.
+static constexpr unsigned long long PCG32_MULT = 0x5851f42d4c957f2dULL;
+static constexpr unsigned long long PCG32_INC  = 0x14057b7ef767814fULL;
 
 // variables used for random number generation
-static const int N = 624;
-static thread_local unsigned long mt[N]; /* the array for the state vector  */
-static thread_local int mti;
+static thread_local unsigned long long pcg_state = 0;
 static thread_local bool seed_setup = false;
 
-#else
-
-static thread_local std::default_random_engine  re;
-
-static thread_local std::uniform_int_distribution<unsigned>    dist_uint;
-static thread_local std::uniform_real_distribution<float>      dist_float( 0.0f , 1.0f );
-
-#endif
+// the sampler providing sample streams of the current thread
+static thread_local Sampler* bound_sampler = nullptr;
 
 // set the seed
 void sort_seed()
 {
-    unsigned _seed = ( ThreadId() + 1 ) * (unsigned)time(0);
-
-#ifndef HIDE_OLD_RANDDOM_GENERATOR
-    mt[0]= _seed & 0xffffffffUL;
-    for (mti=1; mti<N; mti++) {
-        mt[mti] =
-        (1812433253UL * (mt[mti-1] ^ (mt[mti-1] >> 30)) + mti);
-        /* See Knuth TAOCP Vol2. 3rd Ed. P.106 for multiplier. */
-        /* In the previous versions, MSBs of the seed affect   */
-        /* only MSBs of the array mt[].                        */
-        /* 2002/01/09 modified by Makoto Matsumoto             */
-        mt[mti] &= 0xffffffffUL;
-        /* for >32 bit machines */
-    }
+    // Random numbers outside of sample streams only depend on the thread, not the time of the run.
+    const unsigned long long seed = sort_hash( ThreadId() + 1 );
 
     seed_setup = true;
-#else
-    re.seed( _seed );
-#endif
+    pcg_state = 0u;
+    sort_rand();
+    pcg_state += seed;
+    sort_rand();
 }
 
 // generate a unsigned integer
 unsigned sort_rand()
 {
-#ifndef HIDE_OLD_RANDDOM_GENERATOR
-    unsigned long y;
-    {
-        static thread_local unsigned long mag01[2]={0x0UL, MATRIX_A};
-        /* mag01[x] = x * MATRIX_A  for x=0,1 */
-
-        if( seed_setup == false )
-            sort_seed();
-
-        if (mti >= N) { /* generate N words at one time */
-            int kk;
-
-            if (mti == N+1)   /* if Seed() has not been called, */
-                sort_seed(); /* default initial seed */
-
-            for (kk=0;kk<N-M;kk++) {
-                y = (mt[kk]&UPPER_MASK)|(mt[kk+1]&LOWER_MASK);
-                mt[kk] = mt[kk+M] ^ (y >> 1) ^ mag01[y & 0x1UL];
-            }
-            for (;kk<N-1;kk++) {
-                y = (mt[kk]&UPPER_MASK)|(mt[kk+1]&LOWER_MASK);
-                mt[kk] = mt[kk+(M-N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
-            }
-            y = (mt[N-1]&UPPER_MASK)|(mt[0]&LOWER_MASK);
-            mt[N-1] = mt[M-1] ^ (y >> 1) ^ mag01[y & 0x1UL];
-
-            mti = 0;
-        }
-
-        y = mt[mti++];
-
-        /* Tempering */
-        y ^= (y >> 11);
-        y ^= (y << 7) & 0x9d2c5680UL;
-        y ^= (y << 15) & 0xefc60000UL;
-        y ^= (y >> 18);
-    }
-    return y;
-#else
-    return dist_uint(re);
-#endif
+    if( seed_setup == false )
+        sort_seed();
+
+    const auto old_state = pcg_state;
+    pcg_state = old_state * PCG32_MULT + PCG32_INC;
+
+    const auto xorshifted = (unsigned)( ( ( old_state >> 18u ) ^ old_state ) >> 27u );
+    const auto rot = (unsigned)( old_state >> 59u );
+    return ( xorshifted >> rot ) | ( xorshifted << ( ( 0u - rot ) & 31 ) );
 }
 
 // generate a canonical random number
 float sort_canonical(){
-#ifndef HIDE_OLD_RANDDOM_GENERATOR
-    return (sort_rand() & 0xffffff) / float(1 << 24);
-#else
-    return dist_float(re);
-#endif
+    if( bound_sampler )
+        return bound_sampler->Next1D();
+
+    return ( sort_rand() >> 8 ) / float( 1 << 24 );
+}
+
+// bind a sampler to the current thread
+Sampler* sort_bind_sampler( Sampler* sampler ){
+    auto previous = bound_sampler;
+    bound_sampler = sampler;
+    return previous;
+}
+
+// a batch of counter-based canonical random numbers with consecutive counters
+void sort_hash_canonical_batch( unsigned key , unsigned first_counter , float* sample , unsigned num ){
+    for( unsigned i = 0 ; i < num ; ++i )
+        sample[i] = sort_hash_canonical( key , first_counter + i );
 }
@@ -17,12 +17,21 @@
 
 #pragma once
 
+#include "core/define.h"
+
 /*
 description :
     Random number generation method, the default 'rand' function provided by c++ standard library is not so good,
     another random number generation method is adapted here.
+
+    There are two kinds of generators. A tiny PCG32 generator with thread local state backs 'sort_rand' and
+    'sort_canonical' when there is no sampler bound to the thread. Counter-based generation, 'sort_hash_rand',
+    has no state at all, random numbers are pure functions of a key and a counter. Samplers key it with the
+    pixel, sample index and dimension so that the result doesn't depend on which thread takes the sample.
 */
 
+class Sampler;
+
 // set the seed
 void        sort_seed();
 
@@ -30,4 +39,44 @@ void        sort_seed();
 unsigned    sort_rand();
 
 // generate a canonical random number
+// note : it draws the next dimension of the current sample if there is a sampler bound to the thread
 float       sort_canonical();
+
+// bind a sampler to the current thread, nullptr to unbind it
+// para 'sampler' : the sampler to be bound
+// result         : the sampler bound previously
+Sampler*    sort_bind_sampler( Sampler* sampler );
+
+// hash an unsigned integer, this is the permutation of PCG with the RXS-M-XS output function
+SORT_FORCEINLINE unsigned sort_hash( unsigned v ){
+    const auto state = v * 747796405u + 2891336453u;
+    const auto word = ( ( state >> ( ( state >> 28u ) + 4u ) ) ^ state ) * 277803737u;
+    return ( word >> 22u ) ^ word;
+}
+
+// combine a value into a hash
+SORT_FORCEINLINE unsigned sort_hash_combine( unsigned seed , unsigned v ){
+    return seed ^ ( sort_hash( v ) + 0x9e3779b9u + ( seed << 6 ) + ( seed >> 2 ) );
+}
+
+// counter-based random unsigned integer
+// para 'key'     : key of the random stream, like a hash of pixel and dimension
+// para 'counter' : index of the random number in the stream
+SORT_FORCEINLINE unsigned sort_hash_rand( unsigned key , unsigned counter ){
+    return sort_hash( sort_hash( counter ) ^ key );
+}
+
+// counter-based canonical random number
+// para 'key'     : key of the random stream
+// para 'counter' : index of the random number in the stream
+SORT_FORCEINLINE float sort_hash_canonical( unsigned key , unsigned counter ){
+    return ( sort_hash_rand( key , counter ) >> 8 ) / float( 1 << 24 );
+}
+
+// a batch of counter-based canonical random numbers with consecutive counters
+// para 'key'           : key of the random stream
+// para 'first_counter' : counter of the first random number
+// para 'sample'        : the memory to save the random numbers
+// para 'num'           : number of random numbers to be generated
+// note : it is the same as calling 'sort_hash_canonical' for each counter in a scalar loop
+void        sort_hash_canonical_batch( unsigned key , unsigned first_counter , float* sample , unsigned num );
@@ -0,0 +1,41 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "samplemethod.h"
+#include "task/task.h"
+
+void Distribution2D::_init( const float* data , unsigned nu , unsigned nv ){
+    m_nu = nu;
+    m_nv = nv;
+    pConditions.resize( nv );
+    std::unique_ptr<float[]> m = std::make_unique<float[]>(nv);
+    ParallelForRows( (int)nv , [&]( int v0 , int v1 ){
+        for( auto i = v0 ; i < v1 ; i++ ){
+            pConditions[i] = AliasTable( &data[i*nu] , nu );
+            auto sum = 0.0;
+            for( auto j = 0u ; j < nu ; j++ )
+                sum += data[i*nu+j];
+            m[i] = (float)sum;
+        }
+    });
+    marginal = AliasTable( m.get() , nv );
+
+    auto sum = 0.0;
+    for( auto i = 0u ; i < nv ; i++ )
+        sum += m[i];
+    m_sum = (float)sum;
+}
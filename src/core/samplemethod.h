@@ -125,6 +125,73 @@ SORT_FORCEINLINE float UniformSpherePdf(){
     return INV_TWOPI * 0.5f;
 }
 
+// sampling a point on a triangle uniformly
+// para 'u' : a canonical random variable
+// para 'v' : a canonical random variable
+// para 'b0' : barycentric coordinate of the first vertex
+// para 'b1' : barycentric coordinate of the second vertex
+SORT_FORCEINLINE void UniformSampleTriangle( float u , float v , float& b0 , float& b1 ){
+    const auto su = sqrt( u );
+    b0 = 1.0f - su;
+    b1 = v * su;
+}
+
+// solid angle of a spherical triangle, the formula comes from "The Solid Angle of a Plane Triangle" by Van Oosterom and Strackee
+// para 'a' , 'b' , 'c' : normalized directions to the vertices of the triangle
+SORT_FORCEINLINE float SphericalTriangleArea( const Vector& a , const Vector& b , const Vector& c ){
+    return fabs( 2.0f * atan2( dot( a , cross( b , c ) ) , 1.0f + dot( a , b ) + dot( a , c ) + dot( b , c ) ) );
+}
+
+// angle between two normalized vectors, it is more robust than acos( dot( v0 , v1 ) ) for small angles
+SORT_FORCEINLINE float AngleBetween( const Vector& v0 , const Vector& v1 ){
+    if( dot( v0 , v1 ) < 0.0f )
+        return PI - 2.0f * asin( std::min( 1.0f , ( v0 + v1 ).Length() * 0.5f ) );
+    return 2.0f * asin( std::min( 1.0f , ( v1 - v0 ).Length() * 0.5f ) );
+}
+
+// sampling a direction in a spherical triangle uniformly, the algorithm comes from "Stratified Sampling of Spherical Triangles" by Arvo
+// para 'a' , 'b' , 'c' : normalized directions to the vertices of the triangle
+// para 'u' : a canonical random variable
+// para 'v' : a canonical random variable
+// para 'pdf' : pdf w.r.t solid angle, zero for degenerated triangles
+SORT_FORCEINLINE Vector UniformSampleSphericalTriangle( const Vector& a , const Vector& b , const Vector& c , float u , float v , float* pdf ){
+    auto n_ab = cross( a , b ) , n_bc = cross( b , c ) , n_ca = cross( c , a );
+    if( n_ab.SquaredLength() == 0.0f || n_bc.SquaredLength() == 0.0f || n_ca.SquaredLength() == 0.0f ){
+        if( pdf ) *pdf = 0.0f;
+        return Vector();
+    }
+    n_ab = normalize( n_ab );
+    n_bc = normalize( n_bc );
+    n_ca = normalize( n_ca );
+
+    // angles at the vertices, the area of the spherical triangle is their sum minus pi
+    const auto alpha = AngleBetween( n_ab , -n_ca );
+    const auto beta = AngleBetween( n_bc , -n_ab );
+    const auto gamma = AngleBetween( n_ca , -n_bc );
+    const auto area = alpha + beta + gamma - PI;
+    if( area <= 0.0f ){
+        if( pdf ) *pdf = 0.0f;
+        return Vector();
+    }
+    if( pdf ) *pdf = 1.0f / area;
+
+    // pick the sub-triangle with area proportional to 'u' by finding its third vertex 'cp' on the arc between 'a' and 'c'
+    const auto area_p = u * area + PI;
+    const auto cos_alpha = cos( alpha ) , sin_alpha = sin( alpha );
+    const auto sin_phi = sin( area_p ) * cos_alpha - cos( area_p ) * sin_alpha;
+    const auto cos_phi = cos( area_p ) * cos_alpha + sin( area_p ) * sin_alpha;
+    const auto k1 = cos_phi + cos_alpha;
+    const auto k2 = sin_phi - sin_alpha * dot( a , b );
+    const auto cos_bp = clamp( ( k2 + ( k2 * cos_phi - k1 * sin_phi ) * cos_alpha ) / ( ( k2 * sin_phi + k1 * cos_phi ) * sin_alpha ) , -1.0f , 1.0f );
+    const auto sin_bp = ssqrt( 1.0f - cos_bp * cos_bp );
+    const auto cp = cos_bp * a + sin_bp * normalize( c - dot( c , a ) * a );
+
+    // sample the arc between 'b' and 'cp' so that directions are uniformly distributed in the sub-triangle
+    const auto cos_theta = 1.0f - v * ( 1.0f - dot( cp , b ) );
+    const auto sin_theta = ssqrt( 1.0f - cos_theta * cos_theta );
+    return cos_theta * b + sin_theta * normalize( cp - dot( cp , b ) * b );
+}
+
 // one dimensional distribution
 class Distribution1D{
 public:
@@ -223,7 +290,95 @@ private:
     float                       sum;
 };
 
-// two dimensional distribution
+// alias table for sampling a discrete distribution in constant time, it is built with Vose's method
+class AliasTable{
+public:
+    // default constructor, the table is empty
+    AliasTable() = default;
+
+    // constructor
+    // para 'f' : weights of the buckets, they don't need to be normalized
+    // para 'n' : number of buckets
+    AliasTable( const float* f , unsigned n ){
+        if( f == nullptr || n == 0 )
+            return;
+
+        auto sum = 0.0;
+        for( auto i = 0u ; i < n ; ++i )
+            sum += f[i];
+
+        m_bins.resize( n );
+        for( auto i = 0u ; i < n ; ++i )
+            m_bins[i].p = sum > 0.0 ? (float)( f[i] / sum ) : 1.0f / (float)n;
+
+        // split the buckets into the ones with less and more than average weight
+        std::vector<std::pair<unsigned,double>> under , over;
+        for( auto i = 0u ; i < n ; ++i ){
+            const auto q = (double)m_bins[i].p * n;
+            ( q < 1.0 ? under : over ).push_back( std::make_pair( i , q ) );
+        }
+
+        // fill each light bucket with the excess of a heavy one
+        while( !under.empty() && !over.empty() ){
+            const auto un = under.back(); under.pop_back();
+            const auto ov = over.back(); over.pop_back();
+
+            m_bins[un.first].q = (float)un.second;
+            m_bins[un.first].alias = ov.first;
+
+            const auto excess = un.second + ov.second - 1.0;
+            ( excess < 1.0 ? under : over ).push_back( std::make_pair( ov.first , excess ) );
+        }
+
+        // the rest are full buckets, only different from one due to rounding errors
+        for( const auto& ov : over ) m_bins[ov.first].q = 1.0f;
+        for( const auto& un : under ) m_bins[un.first].q = 1.0f;
+    }
+
+    // get a discrete sample
+    // para 'u' : a canonical random variable
+    // para 'pmf' : probability of picking the bucket
+    // para 'remapped' : a new canonical random variable remapped from what is left in 'u' after picking the bucket
+    // result   : the picked bucket, -1 if there is no data in the table
+    int Sample( float u , float* pmf , float* remapped = nullptr ) const{
+        sAssert( u <= 1.0f && u >= 0.0f , SAMPLING );
+        if( m_bins.empty() )
+            return -1;
+
+        const auto n = (unsigned)m_bins.size();
+        const auto offset = std::min( (unsigned)( u * n ) , n - 1 );
+        const auto up = std::min( u * n - offset , 0.99999994f );
+        const auto& bin = m_bins[offset];
+        const auto keep = up < bin.q;
+        const auto ret = keep ? offset : bin.alias;
+        if( pmf )
+            *pmf = m_bins[ret].p;
+        if( remapped )
+            *remapped = std::min( keep ? up / bin.q : ( up - bin.q ) / ( 1.0f - bin.q ) , 0.99999994f );
+        return (int)ret;
+    }
+
+    // get the count
+    unsigned GetCount() const{
+        return (unsigned)m_bins.size();
+    }
+
+    // get probability of the bucket
+    float GetProperty( unsigned i ) const{
+        sAssert( i < m_bins.size() , GENERAL );
+        return m_bins[i].p;
+    }
+
+private:
+    struct Bin{
+        float       q = 1.0f;       // probability of keeping the bucket instead of picking its alias
+        float       p = 0.0f;       // probability of picking the bucket
+        unsigned    alias = 0;      // the other bucket sharing the slot
+    };
+    std::vector<Bin>    m_bins;
+};
+
+// two dimensional piecewise constant distribution, cells are picked in constant time with alias tables
 class Distribution2D{
 public:
     // default constructor
@@ -245,46 +400,45 @@ public:
     }
 
     // get a sample point
-    void SampleContinuous( float u , float v , float uv[2] , float* pdf ){
-        float pdf0 , pdf1;
-        uv[1] = marginal->SampleContinuous( v , &pdf1 );
-        int vi = (int)(uv[1] * m_nv);
-        if( vi > (int)(m_nv - 1) )
-            vi = (int)(m_nv - 1);
-        uv[0] = pConditions[vi]->SampleContinuous( u , &pdf0 );
+    // para 'u' : a canonical random variable
+    // para 'v' : a canonical random variable
+    // para 'uv' : the sampled point in [0,1)^2
+    // para 'pdf' : pdf w.r.t the area of [0,1)^2
+    void SampleContinuous( float u , float v , float uv[2] , float* pdf ) const{
+        float pdf0 = 0.0f , pdf1 = 0.0f , du = 0.0f , dv = 0.0f;
+        const auto vi = marginal.Sample( v , &pdf1 , &dv );
+        const auto ui = vi < 0 ? -1 : pConditions[vi].Sample( u , &pdf0 , &du );
+        if( ui < 0 || m_sum == 0.0f ){
+            uv[0] = uv[1] = 0.0f;
+            if( pdf ) *pdf = 0.0f;
+            return;
+        }
 
+        uv[0] = ( (float)ui + du ) / (float)m_nu;
+        uv[1] = ( (float)vi + dv ) / (float)m_nv;
         if( pdf )
-            *pdf = pdf0 * pdf1;
+            *pdf = pdf0 * m_nu * pdf1 * m_nv;
     }
     // get pdf
     float Pdf( float u , float v ) const{
-        u = clamp( u , 0.0f , 1.0f );
-        v = clamp( v , 0.0f , 1.0f );
-
-        int iu = (int)( u * m_nu );
-        int iv = (int)( v * m_nv );
-        if( pConditions[iv]->GetSum() * marginal->GetSum() == 0.0f )
+        if( m_sum == 0.0f )
             return 0.0f;
-        return pConditions[iv]->GetProperty( iu ) * m_nu * marginal->GetProperty( iv ) * m_nv ;// ( pConditions[iv]->GetSum() * marginal->GetSum() );
+
+        const auto iu = std::min( (unsigned)( clamp( u , 0.0f , 1.0f ) * m_nu ) , m_nu - 1 );
+        const auto iv = std::min( (unsigned)( clamp( v , 0.0f , 1.0f ) * m_nv ) , m_nv - 1 );
+        return pConditions[iv].GetProperty( iu ) * m_nu * marginal.GetProperty( iv ) * m_nv;
     }
 
 private:
     // the distribution in each row
-    std::vector<std::unique_ptr<Distribution1D>>    pConditions;
+    std::vector<AliasTable>     pConditions;
     // the marginal sampling distribution
-    std::unique_ptr<Distribution1D> marginal;
+    AliasTable                  marginal;
     // the size for the two dimensions
-    unsigned m_nu , m_nv;
-
-    // initialize data
-    void _init( const float* data , unsigned nu , unsigned nv ){
-        for( unsigned i = 0 ; i < nv ; i++ )
-            pConditions.push_back( std::make_unique<Distribution1D>( &data[i*nu] , nu ) );
-        std::unique_ptr<float[]> m = std::make_unique<float[]>(nv);
-        for( unsigned i = 0 ; i < nv ; i++ )
-            m[i] = pConditions[i]->GetSum();
-        marginal = std::make_unique<Distribution1D>( m.get() , nv );
-        m_nu = nu;
-        m_nv = nv;
-    }
+    unsigned m_nu = 0 , m_nv = 0;
+    // sum of the data
+    float    m_sum = 0.0f;
+
+    // initialize data, rows are built in parallel since environment maps could easily have millions of texels
+    void _init( const float* data , unsigned nu , unsigned nv );
 };
@@ -36,9 +36,11 @@
 
 SORT_STATS_DEFINE_COUNTER(sScenePrimitiveCount)
 SORT_STATS_DEFINE_COUNTER(sSceneLightCount)
+SORT_STATS_DEFINE_COUNTER(sLightBVHNodeCount)
 
 SORT_STATS_COUNTER("Statistics", "Total Primitive Count", sScenePrimitiveCount);
 SORT_STATS_COUNTER("Statistics", "Total Light Count", sSceneLightCount);
+SORT_STATS_COUNTER("Statistics", "Light BVH Node Count", sLightBVHNodeCount);
 
 bool Scene::LoadScene( IStreamBase& stream ){
     const StringID verificationBit( "verification bits" );
@@ -157,6 +159,21 @@ void Scene::genLightDistribution(){
         m_lights[i]->SetPickPDF( pdf[i] / total_pdf );
 
     m_lightsDis = std::make_unique<Distribution1D>( pdf.get() , count );
+
+    // bounded lights are organized in a light BVH for picking lights based on shading points
+    std::vector<LightBounds> bounds;
+    for( const auto light : m_lights ){
+        LightBounds lb;
+        if( light->GetBounds( lb ) && lb.phi > 0.0f ){
+            m_bvhLights.push_back( light );
+            bounds.push_back( lb );
+        }else if( light->IsInfinite() ){
+            m_infiniteLights.push_back( light );
+        }
+    }
+    m_lightBVH.Build( bounds );
+
+    SORT_STATS(sLightBVHNodeCount=(StatsInt)m_lightBVH.GetNodeCount());
 }
 
 const Light* Scene::SampleLight( float u , float* pdf ) const{
@@ -172,6 +189,36 @@ const Light* Scene::SampleLight( float u , float* pdf ) const{
     return nullptr;
 }
 
+const Light* Scene::SampleLight( const Point& p , const Vector& n , float u , float* pdf ) const{
+    sAssert( u >= 0.0f && u <= 1.0f , SAMPLING );
+
+    if( m_infiniteLights.empty() && m_lightBVH.IsEmpty() ){
+        if( pdf ) *pdf = 0.0f;
+        return nullptr;
+    }
+
+    // the light BVH is picked as if it is one more infinite light
+    const auto infinite_cnt = (unsigned)m_infiniteLights.size();
+    const auto p_infinite = m_lightBVH.IsEmpty() ? 1.0f : (float)infinite_cnt / (float)( infinite_cnt + 1 );
+    if( u < p_infinite ){
+        const auto i = std::min( (unsigned)( u / p_infinite * infinite_cnt ) , infinite_cnt - 1 );
+        if( pdf ) *pdf = p_infinite / infinite_cnt;
+        return m_infiniteLights[i];
+    }
+    if( m_lightBVH.IsEmpty() )
+        return nullptr;
+
+    // reuse the random number for traversing the light BVH
+    u = std::min( ( u - p_infinite ) / ( 1.0f - p_infinite ) , 0.99999994f );
+    float pmf = 0.0f;
+    const auto id = m_lightBVH.Sample( p , n , u , &pmf );
+    if( id < 0 || pmf == 0.0f )
+        return nullptr;
+
+    if( pdf ) *pdf = ( 1.0f - p_infinite ) * pmf;
+    return m_bvhLights[id];
+}
+
 float Scene::LightProperbility( unsigned i ) const{
     sAssert(IS_PTR_VALID(m_lightsDis), LIGHT );
     return m_lightsDis->GetProperty( i );
@@ -28,6 +28,7 @@
 #include "entity/entity.h"
 #include "core/primitive.h"
 #include "core/samplemethod.h"
+#include "light/lightbvh.h"
 
 class Light;
 struct BSSRDFIntersections;
@@ -109,8 +110,22 @@ public:
     void SetSkyLight(Light* light){
         m_skyLight = light;
     }
-    // get sampled light
+    // get sampled light, lights are picked based on their power
+    // note : this is for starting light paths, shading points should use the version below
     const Light* SampleLight( float u , float* pdf ) const;
+
+    //! @brief  Pick a light for a shading point based on the importance of lights to it.
+    //!
+    //! Bounded lights are picked through the light BVH, lights far away or facing away are rarely picked.
+    //! Infinite lights are picked uniformly, with the light BVH being one more candidate.
+    //!
+    //! @param  p       The shading point.
+    //! @param  n       The normal of the shading point, zero vector for points in media.
+    //! @param  u       A canonical random number.
+    //! @param  pdf     The probability of picking the light.
+    //! @return         The picked light, nullptr if no light could contribute to the shading point.
+    const Light* SampleLight( const Point& p , const Vector& n , float u , float* pdf ) const;
+
     // get the properbility of the sample
     float LightProperbility( unsigned i ) const;
     // get the number of lights
@@ -180,6 +195,10 @@ private:
     /**< distribution of light power */
     std::unique_ptr<Distribution1D>             m_lightsDis = nullptr;
 
+    LightBVH                                    m_lightBVH;             /**< Light BVH of all bounded lights. */
+    std::vector<const Light*>                   m_bvhLights;            /**< Lights in the light BVH, indexed by the light BVH. */
+    std::vector<const Light*>                   m_infiniteLights;       /**< Lights picked uniformly instead of through the light BVH. */
+
     // bounding box for the scene
     BBox    m_bbox;
     BBox    m_bboxVol;
@@ -26,6 +26,7 @@ void PointLightEntity::Serialize( IStreamBase& stream ){
     auto energy = 0.0f;
     stream >> energy;
     stream >> m_light->intensity;
+    stream >> m_light->m_lightGroup;
     m_light->intensity *= energy / FOUR_PI;
 }
 
@@ -39,6 +40,7 @@ void DirLightEntity::Serialize(IStreamBase& stream) {
     auto energy = 0.0f;
     stream >> energy;
     stream >> m_light->intensity;
+    stream >> m_light->m_lightGroup;
     m_light->intensity *= energy;
 }
 
@@ -52,6 +54,7 @@ void SpotLightEntity::Serialize(IStreamBase& stream) {
     auto energy = 0.0f;
     stream >> energy;
     stream >> m_light->intensity;
+    stream >> m_light->m_lightGroup;
     m_light->intensity *= energy / FOUR_PI;
     
     float cos_falloff_start, cos_total_range;
@@ -69,12 +72,15 @@ void SkyLightEntity::Serialize(IStreamBase& stream) {
     stream >> m_light->m_light2world;
     auto energy = 1.0f;
     stream >> energy >> m_light->intensity;
+    stream >> m_light->m_lightGroup;
     m_light->intensity *= energy;
 
     // the following code needs to be changed later.
     std::string filename;
     stream >> filename;
-    m_light->sky.Load(filename);
+    bool mis_compensation = true;
+    stream >> mis_compensation;
+    m_light->sky.Load(filename, mis_compensation);
 }
 
 void SkyLightEntity::FillScene(class Scene& scene) {
@@ -94,6 +100,7 @@ void AreaLightEntity::Serialize(IStreamBase& stream) {
     auto energy = 0.0f;
     stream >> energy;
     stream >> m_light->intensity;
+    stream >> m_light->m_lightGroup;
 
     StringID area_type;
     stream >> area_type;
@@ -19,13 +19,44 @@
 #include "visual.h"
 #include "material/matmanager.h"
 #include "core/scene.h"
+#include "light/meshlight.h"
+
+MeshVisual::MeshVisual() = default;
+MeshVisual::~MeshVisual() = default;
 
 void MeshVisual::FillScene( Scene& scene ){
     for (const auto& mi : m_memory->m_indices){
         m_triangles.push_back( std::make_unique<Triangle>( this , mi ) );
-        m_primitives.push_back(std::make_unique<Primitive>(m_memory.get(), mi.m_mat, m_triangles.back().get()));
+
+        // triangles with emissive materials are gathered in a mesh light so that they can be sampled explicitly
+        Light* light = nullptr;
+        if( mi.m_mat && !mi.m_mat->GetEmission().IsBlack() ){
+            const auto& v0 = m_memory->m_vertices[mi.m_id[0]];
+            const auto& v1 = m_memory->m_vertices[mi.m_id[1]];
+            const auto& v2 = m_memory->m_vertices[mi.m_id[2]];
+
+            // the same winding as the geometric normal of triangles, flipped to the side of the vertex normals
+            auto n = cross( v2.m_position - v0.m_position , v1.m_position - v0.m_position );
+            if( n.SquaredLength() > 0.0f ){
+                n = normalize( n );
+                if( dot( n , v0.m_normal + v1.m_normal + v2.m_normal ) < 0.0f )
+                    n = -n;
+
+                if( !m_light )
+                    m_light = std::make_unique<MeshLight>();
+                m_light->AddTriangle( v0.m_position , v1.m_position , v2.m_position , n , mi.m_mat->GetEmission() , m_triangles.back().get() );
+                light = m_light.get();
+            }
+        }
+
+        m_primitives.push_back(std::make_unique<Primitive>(m_memory.get(), mi.m_mat, m_triangles.back().get(), light));
         scene.AddPrimitive(m_primitives.back().get());
     }
+
+    if( m_light && !m_light->IsEmpty() ){
+        m_light->Build();
+        scene.AddLight( m_light.get() );
+    }
 }
 
 void MeshVisual::Serialize( IStreamBase& stream ){
@@ -23,6 +23,8 @@
 #include "shape/line.h"
 #include "core/primitive.h"
 
+class MeshLight;
+
 //! @brief Visual is the container for a specific type of shape that can be seen in SORT.
 /**
  * Visual could be a single shape, like sphere, triangle. It could also be a set of triangles,
@@ -54,6 +56,10 @@ class MeshVisual : public Visual{
 public:
     DEFINE_RTTI( MeshVisual , Visual );
 
+    //! @brief  Constructor and destructor are defined where the mesh light is a complete type.
+    MeshVisual();
+    ~MeshVisual() override;
+
     //! @brief  Fill the scene with triangles.
     //!
     //! @param  scene       The scene to be filled.
@@ -76,6 +82,8 @@ public:
     std::unique_ptr<Mesh>                 m_memory;
     /**< This is to make sure the memory of triangles will be properly cleared. */
     std::vector<std::unique_ptr<Triangle>>      m_triangles;
+    /**< Light of the triangles with emissive materials, it is only created if there is any. */
+    std::unique_ptr<MeshLight>                  m_light;
 };
 
 //! HairVisual has a bunch of lines.
@@ -0,0 +1,75 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "aov.h"
+#include "core/sassert.h"
+
+void AOVRegistry::Setup( const AOVConfig& config ){
+    m_channels.clear();
+    m_floatCnt = 0;
+    m_pixelFloatCnt = 0;
+    for( auto i = 0u ; i < AOV_TYPE_CNT ; ++i )
+        m_offsets[i] = -1;
+
+    if( config.depth )
+        addChannel( AOV_DEPTH , "depth" , { "Z" } , AOV_MINIMUM , FLT_MAX );
+    if( config.normal )
+        addChannel( AOV_NORMAL , "normal" , { "X" , "Y" , "Z" } , AOV_AVERAGE , 0.0f );
+    if( config.albedo )
+        addChannel( AOV_ALBEDO , "albedo" , { "R" , "G" , "B" } , AOV_AVERAGE , 0.0f );
+    if( config.sample_count )
+        addChannel( AOV_SAMPLE_COUNT , "samples" , { "Y" } , AOV_SUM , 1.0f );
+    for( auto i = 0u ; i < config.light_group_cnt ; ++i )
+        addChannel( (AOV_Type)( AOV_LIGHT_GROUP + i ) , "lightgroup" + std::to_string(i) , { "R" , "G" , "B" } , AOV_FILTERED , 0.0f );
+}
+
+void AOVRegistry::addChannel( AOV_Type type , const std::string& layer , const std::vector<std::string>& components , AOV_Accumulation accumulation , float sample_default ){
+    sAssert( m_floatCnt + components.size() <= AOV_MAX_FLOAT_CNT , GENERAL );
+    // floats accumulated per pixel can't come after filtered ones
+    sAssert( AOV_FILTERED == accumulation || m_pixelFloatCnt == m_floatCnt , GENERAL );
+
+    m_offsets[type] = m_floatCnt;
+    m_channels.push_back( { type , layer , components , accumulation , sample_default , m_floatCnt } );
+    for( auto i = 0u ; i < components.size() ; ++i ){
+        m_sampleDefaults[m_floatCnt] = sample_default;
+        m_isMinimum[m_floatCnt] = ( AOV_MINIMUM == accumulation );
+        ++m_floatCnt;
+    }
+    if( AOV_FILTERED != accumulation )
+        m_pixelFloatCnt = m_floatCnt;
+}
+
+AOVTile::AOVTile( const AOVRegistry& registry , int w , int h ) : m_registry(registry) , m_width(w) , m_height(h) {
+    const auto plane_size = w * h;
+    const auto float_cnt = registry.GetPixelFloatCnt();
+    m_data.resize( ( float_cnt + 1 ) * plane_size , 0.0f );
+    for( auto i = 0u ; i < float_cnt ; ++i ){
+        if( registry.IsMinimum(i) )
+            std::fill( m_data.begin() + i * plane_size , m_data.begin() + ( i + 1 ) * plane_size , FLT_MAX );
+    }
+}
+
+void AOVTile::Accumulate( int x , int y , const AOVSample& sample ){
+    const auto plane_size = m_width * m_height;
+    const auto float_cnt = m_registry.GetPixelFloatCnt();
+    auto* data = m_data.data() + y * m_width + x;
+    for( auto i = 0u ; i < float_cnt ; ++i , data += plane_size ){
+        const auto v = sample.Get(i);
+        *data = m_registry.IsMinimum(i) ? std::min( *data , v ) : *data + v;
+    }
+    *data += 1.0f;
+}
@@ -0,0 +1,288 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <float.h>
+#include <algorithm>
+#include "core/define.h"
+#include "spectrum/spectrum.h"
+#include "math/vector3.h"
+#include "stream/stream.h"
+
+//! @brief  Maximum number of light groups supported by the film.
+constexpr unsigned int MAX_LIGHT_GROUP_CNT = 8;
+
+//! @brief  Built-in arbitrary output variables, the channels rendered along with the beauty pass.
+enum AOV_Type : unsigned int {
+    AOV_DEPTH = 0 ,                                                 /**< Distance from the camera to the first hit. */
+    AOV_NORMAL ,                                                    /**< Shading normal of the first hit in world space. */
+    AOV_ALBEDO ,                                                    /**< Single sample estimation of the albedo at the first hit. */
+    AOV_SAMPLE_COUNT ,                                              /**< Number of valid samples taken in the pixel. */
+    AOV_LIGHT_GROUP ,                                               /**< Radiance contributed by lights of the first group. */
+    AOV_TYPE_CNT = AOV_LIGHT_GROUP + MAX_LIGHT_GROUP_CNT
+};
+
+//! @brief  How samples of a channel are merged in a pixel.
+enum AOV_Accumulation : unsigned int {
+    AOV_AVERAGE = 0 ,       /**< Samples are summed up and divided by the number of valid samples eventually. */
+    AOV_MINIMUM ,           /**< The smallest sample is kept, pixels with nothing recorded are resolved to zero. */
+    AOV_SUM ,               /**< Samples are summed up. */
+    AOV_FILTERED ,          /**< Samples are splatted through the reconstruction filter along with the beauty pass. */
+};
+
+//! @brief  Maximum number of floats a single sample of all channels could take.
+constexpr unsigned int AOV_MAX_FLOAT_CNT = 1 + 3 + 3 + 1 + 3 * MAX_LIGHT_GROUP_CNT;
+
+//! @brief  Settings of arbitrary output variables.
+struct AOVConfig {
+    bool            depth = false;          /**< Whether to output depth. */
+    bool            normal = false;         /**< Whether to output shading normal. */
+    bool            albedo = false;         /**< Whether to output albedo. */
+    bool            sample_count = false;   /**< Whether to output number of samples per pixel. */
+    unsigned int    light_group_cnt = 0;    /**< Number of light groups to output, zero means no light group output. */
+
+    //! @brief  Serializing data from stream
+    //!
+    //! @param  stream      Stream where the serialization data comes from.
+    void    Serialize( IStreamBase& stream ){
+        stream >> depth >> normal >> albedo >> sample_count >> light_group_cnt;
+        light_group_cnt = std::min( light_group_cnt , MAX_LIGHT_GROUP_CNT );
+    }
+};
+
+//! @brief  Description of one channel in the film.
+struct AOVChannel {
+    AOV_Type                    type;               /**< Type of the channel. */
+    std::string                 layer;              /**< Name of the layer in the output file, like 'normal'. */
+    std::vector<std::string>    components;         /**< Name of each component, like 'X', 'Y' and 'Z'. */
+    AOV_Accumulation            accumulation;       /**< How samples are merged in a pixel. */
+    float                       sample_default;     /**< Value of the channel in a sample where nothing is recorded. */
+    unsigned int                offset;             /**< Index of the first component among all floats of a sample. */
+};
+
+//! @brief  AOVRegistry keeps track of all enabled channels and their layout.
+//!
+//! Each component of every enabled channel takes one float in a sample. The film and the tiles
+//! lay out components in separated planes, one plane per component, so that merging and output
+//! run through contiguous memory. Filtered channels are registered after all the others, their
+//! floats are the tail of a sample and go to the film tile instead of the AOV tile.
+class AOVRegistry {
+public:
+    //! @brief  Default constructor, there is no channel enabled by default.
+    AOVRegistry(){
+        Setup( AOVConfig() );
+    }
+
+    //! @brief  Register all channels enabled in the configuration.
+    //!
+    //! @param  config      Settings of arbitrary output variables.
+    void    Setup( const AOVConfig& config );
+
+    //! @brief  Whether there is any channel enabled.
+    SORT_FORCEINLINE bool IsEmpty() const {
+        return m_channels.empty();
+    }
+
+    //! @brief  Whether a specific channel is enabled.
+    SORT_FORCEINLINE bool IsEnabled( unsigned int type ) const {
+        return type < AOV_TYPE_CNT && m_offsets[type] >= 0;
+    }
+
+    //! @brief  Index of the first component of a channel, it is only valid for enabled channels.
+    SORT_FORCEINLINE int GetOffset( unsigned int type ) const {
+        return m_offsets[type];
+    }
+
+    //! @brief  Number of floats of all enabled channels in a sample.
+    SORT_FORCEINLINE unsigned int GetFloatCnt() const {
+        return m_floatCnt;
+    }
+
+    //! @brief  Number of floats accumulated per pixel in the AOV tile, they are the leading floats of a sample.
+    SORT_FORCEINLINE unsigned int GetPixelFloatCnt() const {
+        return m_pixelFloatCnt;
+    }
+
+    //! @brief  Number of floats splatted through the reconstruction filter, they follow the ones accumulated per pixel.
+    SORT_FORCEINLINE unsigned int GetFilteredFloatCnt() const {
+        return m_floatCnt - m_pixelFloatCnt;
+    }
+
+    //! @brief  Get all enabled channels.
+    SORT_FORCEINLINE const std::vector<AOVChannel>& GetChannels() const {
+        return m_channels;
+    }
+
+    //! @brief  Value of each float in a sample where nothing is recorded.
+    SORT_FORCEINLINE const float* GetSampleDefaults() const {
+        return m_sampleDefaults;
+    }
+
+    //! @brief  Whether a float in a sample keeps the minimum, instead of the sum, during accumulation.
+    SORT_FORCEINLINE bool IsMinimum( unsigned int i ) const {
+        return m_isMinimum[i];
+    }
+
+private:
+    std::vector<AOVChannel> m_channels;                             /**< All enabled channels. */
+    int                     m_offsets[AOV_TYPE_CNT];                /**< Offset of each channel, negative value for disabled channel. */
+    unsigned int            m_floatCnt = 0;                         /**< Number of floats in a sample. */
+    unsigned int            m_pixelFloatCnt = 0;                    /**< Number of floats accumulated per pixel. */
+    float                   m_sampleDefaults[AOV_MAX_FLOAT_CNT];    /**< Default value of each float in a sample. */
+    bool                    m_isMinimum[AOV_MAX_FLOAT_CNT];         /**< Whether the float keeps minimum value. */
+
+    //! @brief  Add a channel in the registry.
+    void    addChannel( AOV_Type type , const std::string& layer , const std::vector<std::string>& components , AOV_Accumulation accumulation , float sample_default );
+};
+
+//! @brief  AOVSample holds the values of all enabled channels taken by a single camera ray.
+//!
+//! Integrators get it through the pixel sample, it is always fine to ignore it. Writing to a
+//! disabled channel is simply ignored.
+class AOVSample {
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  registry    Registry of enabled channels.
+    AOVSample( const AOVRegistry& registry ) : m_registry(registry) {
+        Reset();
+    }
+
+    //! @brief  Clear all values for the next sample.
+    SORT_FORCEINLINE void Reset() {
+        const auto defaults = m_registry.GetSampleDefaults();
+        for( auto i = 0u ; i < m_registry.GetFloatCnt() ; ++i )
+            m_data[i] = defaults[i];
+    }
+
+    //! @brief  Whether a channel is enabled.
+    SORT_FORCEINLINE bool IsEnabled( unsigned int type ) const {
+        return m_registry.IsEnabled( type );
+    }
+
+    //! @brief  Set value of a single component channel.
+    SORT_FORCEINLINE void Set( AOV_Type type , float v ) {
+        if( m_registry.IsEnabled( type ) )
+            m_data[m_registry.GetOffset(type)] = v;
+    }
+
+    //! @brief  Set value of a channel with three components.
+    SORT_FORCEINLINE void Set( AOV_Type type , float x , float y , float z ) {
+        if( !m_registry.IsEnabled( type ) )
+            return;
+        const auto offset = m_registry.GetOffset(type);
+        m_data[offset] = x;
+        m_data[offset + 1] = y;
+        m_data[offset + 2] = z;
+    }
+
+    //! @brief  Accumulate radiance contributed by a light group.
+    //!
+    //! @param  group       Index of the light group, radiance of a group that is not enabled is ignored.
+    //! @param  radiance    Radiance contributed by the lights in the group.
+    SORT_FORCEINLINE void AddLightGroup( int group , const Spectrum& radiance ) {
+        const auto type = AOV_LIGHT_GROUP + (unsigned int)group;
+        if( group < 0 || !m_registry.IsEnabled( type ) )
+            return;
+        const auto offset = m_registry.GetOffset(type);
+        m_data[offset] += radiance.r;
+        m_data[offset + 1] += radiance.g;
+        m_data[offset + 2] += radiance.b;
+    }
+
+    //! @brief  Scale radiance of all light groups.
+    //!
+    //! It keeps light groups consistent with the beauty pass when the radiance of the sample is clamped.
+    //!
+    //! @param  scale       Scale of each channel of the radiance.
+    SORT_FORCEINLINE void ScaleLightGroups( const Spectrum& scale ) {
+        for( auto group = 0u ; group < MAX_LIGHT_GROUP_CNT ; ++group ){
+            const auto type = AOV_LIGHT_GROUP + group;
+            if( !m_registry.IsEnabled( type ) )
+                continue;
+            const auto offset = m_registry.GetOffset(type);
+            m_data[offset] *= scale.r;
+            m_data[offset + 1] *= scale.g;
+            m_data[offset + 2] *= scale.b;
+        }
+    }
+
+    //! @brief  Get the raw value of a float in the sample.
+    SORT_FORCEINLINE float Get( unsigned int i ) const {
+        return m_data[i];
+    }
+
+    //! @brief  Get the floats splatted through the reconstruction filter, there are 'GetFilteredFloatCnt' of them.
+    SORT_FORCEINLINE const float* GetFiltered() const {
+        return m_data + m_registry.GetPixelFloatCnt();
+    }
+
+private:
+    const AOVRegistry&  m_registry;                     /**< Registry of enabled channels. */
+    float               m_data[AOV_MAX_FLOAT_CNT];      /**< Values of all enabled channels. */
+};
+
+//! @brief  AOVTile accumulates samples of a tile locally.
+//!
+//! A tile is owned by a single render task, there is no need for any lock during accumulation. Once the tile
+//! is done, it is merged into the film in one go. Filtered channels are not part of it, they are splatted in
+//! the film tile.
+class AOVTile {
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  registry    Registry of enabled channels.
+    //! @param  w           Width of the tile.
+    //! @param  h           Height of the tile.
+    AOVTile( const AOVRegistry& registry , int w , int h );
+
+    //! @brief  Accumulate a sample in a pixel.
+    //!
+    //! @param  x           Horizontal coordinate of the pixel inside the tile.
+    //! @param  y           Vertical coordinate of the pixel inside the tile.
+    //! @param  sample      Sample to be accumulated.
+    void    Accumulate( int x , int y , const AOVSample& sample );
+
+    //! @brief  Width of the tile.
+    SORT_FORCEINLINE int GetWidth() const {
+        return m_width;
+    }
+
+    //! @brief  Height of the tile.
+    SORT_FORCEINLINE int GetHeight() const {
+        return m_height;
+    }
+
+    //! @brief  Get the plane of a float among the floats accumulated per pixel.
+    SORT_FORCEINLINE const float* GetPlane( unsigned int i ) const {
+        return m_data.data() + i * m_width * m_height;
+    }
+
+    //! @brief  Get the plane of number of valid samples.
+    SORT_FORCEINLINE const float* GetCountPlane() const {
+        return GetPlane( m_registry.GetPixelFloatCnt() );
+    }
+
+private:
+    const AOVRegistry&  m_registry;     /**< Registry of enabled channels. */
+    const int           m_width;        /**< Width of the tile. */
+    const int           m_height;       /**< Height of the tile. */
+    std::vector<float>  m_data;         /**< Planes of all floats, followed by the plane of sample count. */
+};
@@ -44,13 +44,6 @@ void BlenderImage::StorePixel( int x , int y , const Spectrum& color , const Ren
     data[ inner_offset + 1 ] = color.g;
     data[ inner_offset + 2 ] = color.b;
     data[ inner_offset + 3 ] = 1.0f;
-
-    // for final update
-    {
-        std::lock_guard<spinlock_mutex> lock(m_mutex[y*m_width+x]);
-        Spectrum _color = m_rendertarget.GetColor(x,y);
-        m_rendertarget.SetColor(x, y, color+_color);
-    }
 }
 
 void BlenderImage::FinishTile( int tile_x , int tile_y , const Render_Task& rt ){
@@ -60,10 +53,12 @@ void BlenderImage::FinishTile( int tile_x , int tile_y , const Render_Task& rt )
     m_sharedMemory.sharedmemory.bytes[tile_y * m_tilenum_x + tile_x] = 1;
 
     std::lock_guard<std::mutex> lock(g_cntLock);
-    m_sharedMemory.sharedmemory.bytes[m_sharedMemory.sharedmemory.size - 2] = (int)((++m_finishedTileCnt) / (float)( m_tilenum_x * m_tilenum_y ) * 100.0f);
+    m_sharedMemory.sharedmemory.bytes[m_sharedMemory.sharedmemory.size - 2] = (int)((++m_finishedTileCnt) / (float)( m_tilenum_x * m_tilenum_y * g_passCnt ) * 100.0f);
 }
 
 void BlenderImage::PreProcess(){
+    ImageSensor::PreProcess();
+
     // create shared memory
     m_tilenum_x = (int)(ceil(g_resultResollutionWidth / (float)g_tileSize));
     m_tilenum_y = (int)(ceil(g_resultResollutionHeight / (float)g_tileSize));
@@ -82,6 +77,9 @@ void BlenderImage::PreProcess(){
 }
 
 void BlenderImage::PostProcess(){
+    // resolve the film into the render target first
+    ImageSensor::PostProcess();
+
     // perform a copy from render target to shared memory
     float* data = (float*)(m_sharedMemory.sharedmemory.bytes + m_header_offset + m_header_offset * g_tileSize * g_tileSize * 4 * sizeof(float));
 
@@ -97,6 +95,4 @@ void BlenderImage::PostProcess(){
 
     // signal a final update
     m_sharedMemory.sharedmemory.bytes[m_final_update_flag_offset] = 1;
-
-    ImageSensor::PostProcess();
 }
@@ -0,0 +1,115 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <algorithm>
+#include "filter.h"
+#include "math/utils.h"
+
+namespace {
+    // Mitchell-Netravali filter defined in [-2, 2], B = C = 1/3 as suggested by the original paper.
+    float mitchell1D( float x ){
+        constexpr float B = 1.0f / 3.0f;
+        constexpr float C = 1.0f / 3.0f;
+        x = fabs( x );
+        if( x > 2.0f )
+            return 0.0f;
+        if( x > 1.0f )
+            return ( ( -B - 6.0f * C ) * x * x * x + ( 6.0f * B + 30.0f * C ) * x * x + ( -12.0f * B - 48.0f * C ) * x + ( 8.0f * B + 24.0f * C ) ) * ( 1.0f / 6.0f );
+        return ( ( 12.0f - 9.0f * B - 6.0f * C ) * x * x * x + ( -18.0f + 12.0f * B + 6.0f * C ) * x * x + ( 6.0f - 2.0f * B ) ) * ( 1.0f / 6.0f );
+    }
+
+    // Four terms Blackman-Harris window, 't' goes from 0 to 1 across the whole window.
+    float blackmanHarris1D( float t ){
+        constexpr float a0 = 0.35875f;
+        constexpr float a1 = 0.48829f;
+        constexpr float a2 = 0.14128f;
+        constexpr float a3 = 0.01168f;
+        return a0 - a1 * cos( TWO_PI * t ) + a2 * cos( 2.0f * TWO_PI * t ) - a3 * cos( 3.0f * TWO_PI * t );
+    }
+}
+
+void Filter::Setup( FilterType type , float radius ){
+    m_type = type;
+    m_radius = std::min( std::max( radius , 0.5f ) , MAX_FILTER_RADIUS );
+    m_invRadius = 1.0f / m_radius;
+    m_apron = (int)ceil( m_radius - 0.5f );
+
+    // Values are taken at the center of each segment of the table.
+    const auto sigma = m_radius / 3.0f;
+    const auto gaussian_edge = exp( -m_radius * m_radius / ( 2.0f * sigma * sigma ) );
+    for( auto i = 0 ; i < FILTER_TABLE_SIZE ; ++i ){
+        const auto d = ( i + 0.5f ) * m_radius / FILTER_TABLE_SIZE;
+        switch( m_type ){
+        case FilterType::GAUSSIAN:
+            m_table[i] = std::max( 0.0f , exp( -d * d / ( 2.0f * sigma * sigma ) ) - gaussian_edge );
+            break;
+        case FilterType::MITCHELL:
+            m_table[i] = mitchell1D( 2.0f * d * m_invRadius );
+            break;
+        case FilterType::BLACKMAN_HARRIS:
+            m_table[i] = blackmanHarris1D( 0.5f + 0.5f * d * m_invRadius );
+            break;
+        default:
+            m_table[i] = 1.0f;
+            break;
+        }
+    }
+}
+
+FilmTile::FilmTile( const Filter& filter , const Vector2i& top_left , const Vector2i& size , unsigned int extra_cnt ) : m_filter(filter) , m_extraCnt( (int)extra_cnt ) {
+    const auto apron = filter.GetApron();
+    m_origin = Vector2i( top_left.x - apron , top_left.y - apron );
+    m_extent = Vector2i( size.x + 2 * apron , size.y + 2 * apron );
+    m_data.resize( GetPlaneCnt() * m_extent.x * m_extent.y , 0.0f );
+}
+
+void FilmTile::AddSample( float x , float y , const Spectrum& radiance , const float* extra ){
+    // Pixels whose center 'c' satisfies '-radius <= sample - c < radius' are covered by the sample.
+    const auto radius = m_filter.GetRadius();
+    const auto x0 = std::max( (int)floor( x - radius - 0.5f ) + 1 , m_origin.x );
+    const auto x1 = std::min( (int)floor( x + radius - 0.5f ) , m_origin.x + m_extent.x - 1 );
+    const auto y0 = std::max( (int)floor( y - radius - 0.5f ) + 1 , m_origin.y );
+    const auto y1 = std::min( (int)floor( y + radius - 0.5f ) , m_origin.y + m_extent.y - 1 );
+    if( x0 > x1 || y0 > y1 )
+        return;
+
+    // The filter is separable, values along each axis are looked up only once.
+    constexpr int MAX_FOOTPRINT = 2 * (int)MAX_FILTER_RADIUS + 1;
+    float wx[MAX_FOOTPRINT];
+    for( auto i = x0 ; i <= x1 ; ++i )
+        wx[i - x0] = m_filter.Lookup( x - ( i + 0.5f ) );
+
+    const auto plane_size = m_extent.x * m_extent.y;
+    auto* r = m_data.data();
+    auto* g = r + plane_size;
+    auto* b = g + plane_size;
+    auto* w = b + plane_size;
+    for( auto j = y0 ; j <= y1 ; ++j ){
+        const auto wy = m_filter.Lookup( y - ( j + 0.5f ) );
+        const auto row = ( j - m_origin.y ) * m_extent.x - m_origin.x;
+        for( auto i = x0 ; i <= x1 ; ++i ){
+            const auto weight = wx[i - x0] * wy;
+            const auto k = row + i;
+            r[k] += radiance.r * weight;
+            g[k] += radiance.g * weight;
+            b[k] += radiance.b * weight;
+            w[k] += weight;
+            for( auto e = 0 ; e < m_extraCnt ; ++e )
+                w[k + ( e + 1 ) * plane_size] += extra[e] * weight;
+        }
+    }
+}
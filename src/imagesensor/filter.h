@@ -0,0 +1,160 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <vector>
+#include "core/define.h"
+#include "spectrum/spectrum.h"
+#include "math/vector2.h"
+#include "stream/stream.h"
+
+//! @brief  Resolution of the precomputed table of a filter.
+constexpr int FILTER_TABLE_SIZE = 64;
+
+//! @brief  Maximum radius of a filter, in pixels.
+constexpr float MAX_FILTER_RADIUS = 4.0f;
+
+//! @brief  Reconstruction filters supported by the film.
+enum class FilterType : int {
+    BOX = 0 ,               /**< Box filter, a radius of 0.5 is the same with averaging samples in a pixel. */
+    GAUSSIAN ,              /**< Gaussian filter, shifted so that it goes to zero at the radius. */
+    MITCHELL ,              /**< Mitchell-Netravali filter with B = C = 1/3, it has negative lobes. */
+    BLACKMAN_HARRIS ,       /**< Blackman-Harris window, a smooth filter with a narrow main lobe. */
+};
+
+//! @brief  Filter reconstructs pixel values from samples taken at arbitrary position on the image plane.
+//!
+//! All supported filters are separable. Instead of evaluating the filter for every sample and pixel pair,
+//! a table of one dimensional filter values is precomputed and looked up along each axis.
+class Filter {
+public:
+    //! @brief  Default constructor, it is a box filter taking samples inside a pixel only.
+    Filter(){
+        Setup( FilterType::BOX , 0.5f );
+    }
+
+    //! @brief  Setup the filter.
+    //!
+    //! @param  type        Type of the filter.
+    //! @param  radius      Radius of the filter in pixels, it is clamped to the range of [0.5, MAX_FILTER_RADIUS].
+    void    Setup( FilterType type , float radius );
+
+    //! @brief  Serializing data from stream
+    //!
+    //! @param  stream      Stream where the serialization data comes from.
+    void    Serialize( IStreamBase& stream ){
+        int type = 0;
+        float radius = 0.5f;
+        stream >> type >> radius;
+        Setup( (FilterType)type , radius );
+    }
+
+    //! @brief  Get type of the filter.
+    SORT_FORCEINLINE FilterType GetType() const {
+        return m_type;
+    }
+
+    //! @brief  Get radius of the filter in pixels.
+    SORT_FORCEINLINE float GetRadius() const {
+        return m_radius;
+    }
+
+    //! @brief  Number of pixels a sample could reach beyond the pixel it falls in.
+    SORT_FORCEINLINE int GetApron() const {
+        return m_apron;
+    }
+
+    //! @brief  Look up the one dimensional filter value.
+    //!
+    //! @param  d       Offset from the center of the filter, in pixels.
+    //! @return         Value of the filter, zero if it is outside the filter. The boundary is part of the filter.
+    SORT_FORCEINLINE float Lookup( float d ) const {
+        const auto i = (int)( fabs( d ) * m_invRadius * FILTER_TABLE_SIZE );
+        return i < FILTER_TABLE_SIZE ? m_table[i] : ( i == FILTER_TABLE_SIZE ? m_table[FILTER_TABLE_SIZE - 1] : 0.0f );
+    }
+
+    //! @brief  Evaluate the filter.
+    //!
+    //! @param  dx      Horizontal offset from the center of the filter, in pixels.
+    //! @param  dy      Vertical offset from the center of the filter, in pixels.
+    //! @return         Value of the filter.
+    SORT_FORCEINLINE float Evaluate( float dx , float dy ) const {
+        return Lookup( dx ) * Lookup( dy );
+    }
+
+private:
+    FilterType  m_type = FilterType::BOX;       /**< Type of the filter. */
+    float       m_radius = 0.5f;                /**< Radius of the filter. */
+    float       m_invRadius = 2.0f;             /**< Reciprocal of the radius. */
+    int         m_apron = 0;                    /**< Number of pixels a sample could reach beyond its pixel. */
+    float       m_table[FILTER_TABLE_SIZE];     /**< Precomputed values of the one dimensional filter. */
+};
+
+//! @brief  FilmTile accumulates filtered samples of a render tile.
+//!
+//! Samples close to the border of a tile contribute to pixels in neighbor tiles. The tile keeps an apron
+//! around itself, wide enough to hold all these contributions. Since each tile is owned by one render task,
+//! there is no lock during accumulation, the tile is merged into the film once it is done. Besides radiance,
+//! a sample could carry extra values, like light groups, they are splatted with the same filter weights.
+class FilmTile {
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  filter      Reconstruction filter.
+    //! @param  top_left    Top-left corner of the render tile in the image.
+    //! @param  size        Size of the render tile.
+    //! @param  extra_cnt   Number of extra values carried by each sample.
+    FilmTile( const Filter& filter , const Vector2i& top_left , const Vector2i& size , unsigned int extra_cnt = 0 );
+
+    //! @brief  Splat a sample to all pixels covered by the filter.
+    //!
+    //! @param  x           Horizontal position of the sample on the image plane, in pixels.
+    //! @param  y           Vertical position of the sample on the image plane, in pixels.
+    //! @param  radiance    Radiance of the sample.
+    //! @param  extra       Extra values of the sample, it is only read when the tile has extra planes.
+    void    AddSample( float x , float y , const Spectrum& radiance , const float* extra = nullptr );
+
+    //! @brief  Top-left corner of the tile including its apron, it could be outside the image.
+    SORT_FORCEINLINE const Vector2i& GetOrigin() const {
+        return m_origin;
+    }
+
+    //! @brief  Size of the tile including its apron.
+    SORT_FORCEINLINE const Vector2i& GetExtent() const {
+        return m_extent;
+    }
+
+    //! @brief  Number of planes in the tile, it is four plus the number of extra values.
+    SORT_FORCEINLINE int GetPlaneCnt() const {
+        return 4 + m_extraCnt;
+    }
+
+    //! @brief  Get a plane of the tile, the first three are weighted radiance, the fourth one is the sum of weights.
+    //!         Weighted extra values follow.
+    SORT_FORCEINLINE const float* GetPlane( int i ) const {
+        return m_data.data() + i * m_extent.x * m_extent.y;
+    }
+
+private:
+    const Filter&       m_filter;       /**< Reconstruction filter. */
+    Vector2i            m_origin;       /**< Top-left corner of the tile including its apron. */
+    Vector2i            m_extent;       /**< Size of the tile including its apron. */
+    int                 m_extraCnt;     /**< Number of extra values carried by each sample. */
+    std::vector<float>  m_data;         /**< Planes of weighted red, green, blue, weights and extra values. */
+};
@@ -0,0 +1,211 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "imagesensor.h"
+#include "core/globalconfig.h"
+
+void ImageSensor::PreProcess(){
+    // filtered arbitrary output variables, like light groups, are splatted along with the radiance
+    m_film.assign( ( 4 + g_aovRegistry.GetFilteredFloatCnt() ) * m_width * m_height , 0.0f );
+
+    const auto tile_size = (int)g_tileSize;
+    m_tileCntX = ( m_width + tile_size - 1 ) / tile_size;
+    m_tileMutex = std::make_unique<std::mutex[]>( m_tileCntX * ( ( m_height + tile_size - 1 ) / tile_size ) );
+
+    const auto& registry = g_aovRegistry;
+    if( registry.IsEmpty() )
+        return;
+
+    const auto plane_size = m_width * m_height;
+    m_aov.assign( ( registry.GetPixelFloatCnt() + 1 ) * plane_size , 0.0f );
+    for( auto i = 0u ; i < registry.GetPixelFloatCnt() ; ++i ){
+        if( registry.IsMinimum(i) )
+            std::fill( m_aov.begin() + i * plane_size , m_aov.begin() + ( i + 1 ) * plane_size , FLT_MAX );
+    }
+}
+
+void ImageSensor::PostProcess(){
+    const auto plane_size = m_width * m_height;
+    const auto r = m_film.data();
+    const auto g = r + plane_size;
+    const auto b = g + plane_size;
+    const auto w = b + plane_size;
+    ParallelForRows( m_height , [&]( int y0 , int y1 ){
+        for( auto y = y0 ; y < y1 ; ++y ){
+            for( auto x = 0 ; x < m_width ; ++x ){
+                const auto k = y * m_width + x;
+                if( w[k] == 0.0f )
+                    continue;
+                // splats of light tracing could have been added in the render target already
+                const auto inv_w = 1.0f / w[k];
+                m_rendertarget.SetColor( x , y , m_rendertarget.GetColor( x , y ) + Spectrum( r[k] * inv_w , g[k] * inv_w , b[k] * inv_w ) );
+            }
+        }
+    });
+}
+
+void ImageSensor::StoreFilmTile( const FilmTile& tile , const Render_Task& rt ){
+    if( m_film.empty() )
+        return;
+
+    const auto tile_size = (int)g_tileSize;
+    const auto plane_size = m_width * m_height;
+    const auto& origin = tile.GetOrigin();
+    const auto plane_cnt = std::min( tile.GetPlaneCnt() , (int)( m_film.size() / plane_size ) );
+
+    // the region covered by the tile and its apron inside the image
+    const auto x0 = std::max( origin.x , 0 );
+    const auto y0 = std::max( origin.y , 0 );
+    const auto x1 = std::min( origin.x + tile.GetExtent().x , m_width );
+    const auto y1 = std::min( origin.y + tile.GetExtent().y , m_height );
+
+    // merge the region one film tile at a time, each under the lock of the film tile it overlaps
+    for( auto ty = y0 / tile_size ; ty * tile_size < y1 ; ++ty ){
+        for( auto tx = x0 / tile_size ; tx * tile_size < x1 ; ++tx ){
+            const auto rx0 = std::max( x0 , tx * tile_size );
+            const auto rx1 = std::min( x1 , ( tx + 1 ) * tile_size );
+            const auto ry0 = std::max( y0 , ty * tile_size );
+            const auto ry1 = std::min( y1 , ( ty + 1 ) * tile_size );
+
+            std::lock_guard<std::mutex> lock( m_tileMutex[ty * m_tileCntX + tx] );
+            for( auto c = 0 ; c < plane_cnt ; ++c ){
+                const auto src = tile.GetPlane(c);
+                const auto dst = m_film.data() + c * plane_size;
+                for( auto y = ry0 ; y < ry1 ; ++y ){
+                    const auto src_row = src + ( y - origin.y ) * tile.GetExtent().x - origin.x;
+                    const auto dst_row = dst + y * m_width;
+                    for( auto x = rx0 ; x < rx1 ; ++x )
+                        dst_row[x] += src_row[x];
+                }
+            }
+        }
+    }
+
+    // present the pixels of the tile, neighbors that are not done yet will contribute later
+    const auto& tl = rt.GetTopLeft();
+    const auto& size = rt.GetTileSize();
+    std::lock_guard<std::mutex> lock( m_tileMutex[( tl.y / tile_size ) * m_tileCntX + tl.x / tile_size] );
+    for( auto y = tl.y ; y < tl.y + size.y ; ++y ){
+        for( auto x = tl.x ; x < tl.x + size.x ; ++x ){
+            const auto k = y * m_width + x;
+            const auto w = m_film[3 * plane_size + k];
+            const auto inv_w = w != 0.0f ? 1.0f / w : 0.0f;
+            StorePixel( x , y , Spectrum( m_film[k] * inv_w , m_film[plane_size + k] * inv_w , m_film[2 * plane_size + k] * inv_w ) , rt );
+        }
+    }
+}
+
+void ImageSensor::StoreAOVTile( const AOVTile& tile , const Render_Task& rt ){
+    if( m_aov.empty() )
+        return;
+
+    const auto& registry = g_aovRegistry;
+    const auto plane_size = m_width * m_height;
+    const auto top_left = rt.GetTopLeft();
+
+    // the same tile could be rendered by multiple passes at the same time in progressive rendering
+    const auto tile_size = (int)g_tileSize;
+    std::lock_guard<std::mutex> lock( m_tileMutex[( top_left.y / tile_size ) * m_tileCntX + top_left.x / tile_size] );
+    for( auto i = 0u ; i <= registry.GetPixelFloatCnt() ; ++i ){
+        const auto is_minimum = i < registry.GetPixelFloatCnt() && registry.IsMinimum(i);
+        const auto src = tile.GetPlane(i);
+        auto dst = m_aov.data() + i * plane_size;
+        for( auto y = 0 ; y < tile.GetHeight() ; ++y ){
+            const auto src_row = src + y * tile.GetWidth();
+            auto dst_row = dst + ( top_left.y + y ) * m_width + top_left.x;
+            for( auto x = 0 ; x < tile.GetWidth() ; ++x )
+                dst_row[x] = is_minimum ? std::min( dst_row[x] , src_row[x] ) : dst_row[x] + src_row[x];
+        }
+    }
+}
+
+// splats buffered by the current thread in deterministic mode
+static thread_local std::vector<std::pair<Vector2i, Spectrum>> g_pendingSplats;
+
+void ImageSensor::UpdatePixel( int x , int y , const Spectrum& color ){
+    if( g_deterministic ){
+        g_pendingSplats.push_back( std::make_pair( Vector2i( x , y ) , color ) );
+        return;
+    }
+
+    std::lock_guard<spinlock_mutex> lock(m_mutex[y * m_width + x]);
+    m_rendertarget.SetColor( x , y , m_rendertarget.GetColor( x , y ) + color );
+}
+
+void ImageSensor::FlushSplats(){
+    for( const auto& splat : g_pendingSplats ){
+        const auto& p = splat.first;
+        std::lock_guard<spinlock_mutex> lock(m_mutex[p.y * m_width + p.x]);
+        m_rendertarget.SetColor( p.x , p.y , m_rendertarget.GetColor( p.x , p.y ) + splat.second );
+    }
+    g_pendingSplats.clear();
+}
+
+void ImageSensor::BeginTileMerge( unsigned int sequence ){
+    if( !g_deterministic )
+        return;
+
+    // Tasks are picked in the order of scheduling, all tiles before this one are being rendered or done already.
+    std::unique_lock<std::mutex> lock( m_mergeMutex );
+    m_mergeCondition.wait( lock , [&](){ return m_mergeSequence == sequence; } );
+}
+
+void ImageSensor::EndTileMerge( unsigned int sequence ){
+    if( !g_deterministic )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( m_mergeMutex );
+        m_mergeSequence = sequence + 1;
+    }
+    m_mergeCondition.notify_all();
+}
+
+void ImageSensor::ResolveAOV( std::vector<ImageChannel>& channels , std::vector<float>& planes ) const{
+    if( m_aov.empty() )
+        return;
+
+    const auto& registry = g_aovRegistry;
+    const auto plane_size = m_width * m_height;
+    const auto float_cnt = registry.GetFloatCnt();
+    const auto pixel_float_cnt = registry.GetPixelFloatCnt();
+    const auto count = m_aov.data() + pixel_float_cnt * plane_size;
+    const auto weight = m_film.data() + 3 * plane_size;
+
+    planes.resize( float_cnt * plane_size );
+    for( const auto& channel : registry.GetChannels() ){
+        for( auto c = 0u ; c < channel.components.size() ; ++c ){
+            const auto i = channel.offset + c;
+            // filtered floats are kept in the film, right after the sum of filter weights
+            const auto src = i < pixel_float_cnt ? m_aov.data() + i * plane_size : weight + ( i - pixel_float_cnt + 1 ) * plane_size;
+            const auto dst = planes.data() + i * plane_size;
+            ParallelForRows( m_height , [&]( int y0 , int y1 ){
+                for( auto k = y0 * m_width ; k < y1 * m_width ; ++k ){
+                    if( AOV_FILTERED == channel.accumulation )
+                        dst[k] = weight[k] != 0.0f ? src[k] / weight[k] : 0.0f;
+                    else if( AOV_AVERAGE == channel.accumulation )
+                        dst[k] = count[k] > 0.0f ? src[k] / count[k] : 0.0f;
+                    else if( AOV_MINIMUM == channel.accumulation )
+                        dst[k] = src[k] < FLT_MAX ? src[k] : 0.0f;
+                    else
+                        dst[k] = src[k];
+                }
+            });
+            channels.push_back( { channel.layer + "." + channel.components[c] , dst } );
+        }
+    }
+}
@@ -21,7 +21,11 @@
 #include "texture/rendertarget.h"
 #include "task/render_task.h"
 #include "core/thread.h"
+#include "aov.h"
+#include "filter.h"
+#include "texture/imageoutput.h"
 #include <mutex>
+#include <condition_variable>
 
 // generate output
 class ImageSensor{
@@ -31,13 +35,13 @@ public:
     }
     virtual ~ImageSensor(){}
 
-    // pre process
-    virtual void PreProcess() {}
+    // pre process, it allocates the film of filtered radiance and arbitrary output variables if there is any enabled
+    virtual void PreProcess();
 
     // finish image tile
     virtual void FinishTile( int tile_x , int tile_y , const Render_Task& rt ){}
 
-    // store pixel information
+    // present a pixel of a finished tile, the color is resolved from the film with contributions received so far
     virtual void StorePixel( int x , int y , const Spectrum& color , const Render_Task& rt ) = 0;
 
     // get width
@@ -50,15 +54,31 @@ public:
         return m_height;
     }
 
-    // post process
-    virtual void PostProcess(){}
+    // post process, it resolves the film into the render target
+    virtual void PostProcess();
 
-    // add radiance
-    virtual void UpdatePixel(int x, int y, const Spectrum& color){
-        std::lock_guard<spinlock_mutex> lock(m_mutex[y * m_width + x]);
-        Spectrum _color = m_rendertarget.GetColor(x, y);
-        m_rendertarget.SetColor(x, y, _color + color);
-    }
+    // add radiance, like splats of light tracing
+    // note : in deterministic mode, radiance is buffered and added in 'FlushSplats' of the current task
+    virtual void UpdatePixel(int x, int y, const Spectrum& color);
+
+    // add radiance buffered by the current thread in deterministic mode
+    void FlushSplats();
+
+    // wait until tiles scheduled before the tile are merged, it only waits in deterministic mode
+    // so that pixels always accumulate contributions of different tiles and passes in the same order
+    void BeginTileMerge( unsigned int sequence );
+
+    // finish merging a tile and let the next one start
+    void EndTileMerge( unsigned int sequence );
+
+    // merge filtered radiance of a finished tile, including its apron, into the film and present pixels of the tile
+    void StoreFilmTile( const FilmTile& tile , const Render_Task& rt );
+
+    // merge arbitrary output variables of a finished tile
+    void StoreAOVTile( const AOVTile& tile , const Render_Task& rt );
+
+    // resolve arbitrary output variables into planes ready for output
+    void ResolveAOV( std::vector<ImageChannel>& channels , std::vector<float>& planes ) const;
 
 protected:
     const int m_width;
@@ -69,4 +89,19 @@ protected:
 
     // the render target
     RenderTarget m_rendertarget;
+
+    // planes of filtered radiance and weights
+    std::vector<float>                  m_film;
+
+    // one lock for each tile of the film, the apron of a tile overlaps with its neighbors
+    std::unique_ptr<std::mutex[]>       m_tileMutex;
+    int                                 m_tileCntX = 0;
+
+    // planes of all arbitrary output variables, followed by the plane of sample count
+    std::vector<float>                  m_aov;
+
+    // tiles are merged in the order of scheduling in deterministic mode
+    std::mutex                          m_mergeMutex;
+    std::condition_variable             m_mergeCondition;
+    unsigned int                        m_mergeSequence = 0;
 };
@@ -20,12 +20,24 @@
 #include "core/path.h"
 
 void RenderTargetImage::StorePixel( int x , int y , const Spectrum& color , const Render_Task& rt ){
-    std::lock_guard<spinlock_mutex> lock(m_mutex[y*m_width + x]);
-    Spectrum _color = m_rendertarget.GetColor(x, y);
-    m_rendertarget.SetColor(x, y, color + _color);
+    // Nothing to present, the render target is resolved from the film once all tiles are done.
 }
 
 void RenderTargetImage::PostProcess(){
     ImageSensor::PostProcess();
-    m_rendertarget.Output(GetFilePathInExeFolder(g_outputFileName));
+
+    const auto filename = GetFilePathInExeFolder(g_outputFileName);
+
+    // arbitrary output variables are only supported in EXR, they go to the same file as extra layers
+    if( m_aov.empty() || ImageFileFormat::EXR != GetImageFileFormat(filename) ){
+        m_rendertarget.Output(filename, g_imageOutputConfig);
+        return;
+    }
+
+    std::vector<ImageChannel> channels = { { "R" , m_rendertarget.GetPlane(0) } ,
+                                           { "G" , m_rendertarget.GetPlane(1) } ,
+                                           { "B" , m_rendertarget.GetPlane(2) } };
+    std::vector<float> planes;
+    ResolveAOV( channels , planes );
+    SaveImage( filename , m_width , m_height , channels , g_imageOutputConfig );
 }
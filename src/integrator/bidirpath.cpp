@@ -35,100 +35,27 @@ SORT_STATS_AVG_COUNT("Bi-directional Path Tracing", "Average Path Length Startin
 Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Scene& scene ) const{
     SORT_STATS(++sPrimaryRayCount);
 
-    // pick a light randomly
-    float pdf;
-    const auto light = scene.SampleLight( sort_canonical() , &pdf );
-    if( light == 0 || pdf == 0.0f )
-        return 0.0f;
-
-    Spectrum li;
-
-    auto    light_emission_pdf = 0.0f;
-    auto    light_pdfa = 0.0f;
-    Ray     light_ray;
-    auto    cosAtLight = 1.0f;
-    LightSample light_sample(true);
-    const auto le = light->sample_l( light_sample , light_ray , &light_emission_pdf , &light_pdfa , &cosAtLight );
-
     //-----------------------------------------------------------------------------------------------------
     // Trace light path from light source
+    float pdf;
     std::vector<BDPT_Vertex> light_path;
-    auto    wi = light_ray;
-    double  vc = (light->IsDelta())?0.0f: MIS(cosAtLight / light_emission_pdf);
-    double  vcm = MIS(light_pdfa / light_emission_pdf);
-    auto    throughput = le * cosAtLight / (light_emission_pdf * pdf);
-    auto    rr = 1.0f;
-    while ((int)light_path.size() < max_recursive_depth){
-        SORT_STATS(++sTotalLengthPathFromLight);
-
-        BDPT_Vertex vert;
-        if (!scene.GetIntersect(wi, vert.inter))
-            break;
-
-        const auto distSqr = vert.inter.t * vert.inter.t;
-        const auto cosIn = absDot( wi.m_Dir , vert.inter.normal );
-        if( light_path.size() > 0 || ( light_path.size() == 0 && !light->IsInfinite() ) )
-            vcm *= MIS( distSqr );
-        vcm /= MIS( cosIn );
-        vc /= MIS( cosIn );
-
-        rr = 1.0f;
-        if (throughput.GetIntensity() < 0.01f)
-            rr = 0.5f;
-
-        vert.p = vert.inter.intersect;
-        vert.n = vert.inter.normal;
-        vert.wi = -wi.m_Dir;
-
-        vert.se = SORT_MALLOC(ScatteringEvent)(vert.inter, SE_EVALUATE_ALL_NO_SSS);
-        vert.inter.primitive->GetMaterial()->UpdateScatteringEvent(*vert.se);
-
-        vert.throughput = throughput;
-        vert.vcm = vcm;
-        vert.vc = vc;
-        vert.rr = rr;
-        vert.depth = (unsigned)(light_path.size() + 1);
-
-        light_path.push_back(vert);
-
-        //-----------------------------------------------------------------------------------------------------
-        // Path evaluation: light tracing
-        _ConnectCamera( vert , (unsigned)light_path.size() , light , scene );
-
-        // russian roulette
-        if (sort_canonical() > rr)
-            break;
-
-        float bsdf_pdf;
-        const auto bsdf_value = vert.se->Sample_BSDF( vert.wi , vert.wo , BsdfSample(true) , bsdf_pdf );
-        bsdf_pdf *= rr;
-
-        if( 0.0f == bsdf_pdf )
-            break;
-
-        const auto cosOut = absDot(vert.wo, vert.n);
-        throughput *= bsdf_value / bsdf_pdf;
-
-        if (throughput.IsBlack())
-            break;
-
-        const auto rev_bsdf_pdfw = vert.se->Pdf_BSDF( vert.wo , vert.wi ) * rr;
-        vc = MIS(cosOut/bsdf_pdf) * ( MIS(rev_bsdf_pdfw) * vc + vcm ) ;
-        vcm = MIS(1.0f/bsdf_pdf);
+    const auto light = _TraceLightPath( light_path , pdf , true , scene );
+    if( light == 0 )
+        return 0.0f;
 
-        wi = Ray(vert.inter.intersect, vert.wo, 0, 0.001f);
-    }
+    Spectrum li;
 
     //-----------------------------------------------------------------------------------------------------
     // Trace light path from eye point
     const auto lps = (const unsigned)light_path.size();
     const auto total_pixel = g_resultResollutionWidth * g_resultResollutionHeight;
-    wi = ray;
-    throughput = 1.0f;
+    auto wi = ray;
+    Spectrum throughput = 1.0f;
     auto light_path_len = 0;
-    vc = 0.0f;
-    vcm = MIS(total_pixel / ray.m_fPdfW);
-    rr = 1.0f;
+    double vc = 0.0f;
+    double vm = 0.0f;
+    double vcm = MIS(total_pixel / ray.m_fPdfW);
+    auto rr = 1.0f;
     while (light_path_len <= (int)max_recursive_depth){
         SORT_STATS(++sTotalLengthPathFromEye);
 
@@ -157,6 +84,7 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
         vcm *= MIS( distSqr );
         vcm /= MIS( cosIn );
         vc /= MIS( cosIn );
+        vm /= MIS( cosIn );
 
         //-----------------------------------------------------------------------------------------------------
         // Path evaluation: it hits a light source
@@ -187,6 +115,7 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
         vert.throughput = throughput;
         vert.vc = vc;
         vert.vcm = vcm;
+        vert.vm = vm;
         vert.rr = rr;
 
         //-----------------------------------------------------------------------------------------------------
@@ -198,6 +127,10 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
         for (unsigned j = 0; j < lps; ++j)
             li += _ConnectVertices( light_path[j] , vert , light , scene );
 
+        //-----------------------------------------------------------------------------------------------------
+        // Path evaluation: merge with light vertices nearby
+        li += _MergeVertices( vert );
+
         ++light_path_len;
 
         // Russian Roulette
@@ -218,7 +151,8 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
             break;
 
         const auto rev_bsdf_pdfw = vert.se->Pdf_BSDF( vert.wo , vert.wi ) * rr;
-        vc = MIS( cosOut / bsdf_pdf ) * ( MIS( rev_bsdf_pdfw ) * vc + vcm );
+        vc = MIS( cosOut / bsdf_pdf ) * ( MIS( rev_bsdf_pdfw ) * vc + vcm + m_misVmWeightFactor );
+        vm = MIS( cosOut / bsdf_pdf ) * ( MIS( rev_bsdf_pdfw ) * vm + vcm * m_misVcWeightFactor + 1.0f );
         vcm = MIS( 1.0f / bsdf_pdf );
 
         wi = Ray(vert.inter.intersect, vert.wo, 0, 0.001f);
@@ -227,6 +161,93 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
     return li;
 }
 
+const Light* BidirPathTracing::_TraceLightPath( std::vector<BDPT_Vertex>& light_path , float& pdf , bool connect_camera , const Scene& scene ) const{
+    // pick a light randomly
+    const auto light = scene.SampleLight( sort_canonical() , &pdf );
+    if( light == 0 || pdf == 0.0f )
+        return nullptr;
+
+    auto    light_emission_pdf = 0.0f;
+    auto    light_pdfa = 0.0f;
+    Ray     light_ray;
+    auto    cosAtLight = 1.0f;
+    LightSample light_sample(true);
+    const auto le = light->sample_l( light_sample , light_ray , &light_emission_pdf , &light_pdfa , &cosAtLight );
+
+    auto    wi = light_ray;
+    double  vc = (light->IsDelta())?0.0f: MIS(cosAtLight / light_emission_pdf);
+    double  vcm = MIS(light_pdfa / light_emission_pdf);
+    double  vm = vc * m_misVcWeightFactor;
+    auto    throughput = le * cosAtLight / (light_emission_pdf * pdf);
+    auto    rr = 1.0f;
+    while ((int)light_path.size() < max_recursive_depth){
+        SORT_STATS(++sTotalLengthPathFromLight);
+
+        BDPT_Vertex vert;
+        if (!scene.GetIntersect(wi, vert.inter))
+            break;
+
+        const auto distSqr = vert.inter.t * vert.inter.t;
+        const auto cosIn = absDot( wi.m_Dir , vert.inter.normal );
+        if( light_path.size() > 0 || ( light_path.size() == 0 && !light->IsInfinite() ) )
+            vcm *= MIS( distSqr );
+        vcm /= MIS( cosIn );
+        vc /= MIS( cosIn );
+        vm /= MIS( cosIn );
+
+        rr = 1.0f;
+        if (throughput.GetIntensity() < 0.01f)
+            rr = 0.5f;
+
+        vert.p = vert.inter.intersect;
+        vert.n = vert.inter.normal;
+        vert.wi = -wi.m_Dir;
+
+        vert.se = SORT_MALLOC(ScatteringEvent)(vert.inter, SE_EVALUATE_ALL_NO_SSS);
+        vert.inter.primitive->GetMaterial()->UpdateScatteringEvent(*vert.se);
+
+        vert.throughput = throughput;
+        vert.vcm = vcm;
+        vert.vc = vc;
+        vert.vm = vm;
+        vert.rr = rr;
+        vert.depth = (unsigned)(light_path.size() + 1);
+
+        light_path.push_back(vert);
+
+        //-----------------------------------------------------------------------------------------------------
+        // Path evaluation: light tracing
+        if( connect_camera )
+            _ConnectCamera( vert , (unsigned)light_path.size() , light , scene );
+
+        // russian roulette
+        if (sort_canonical() > rr)
+            break;
+
+        float bsdf_pdf;
+        const auto bsdf_value = vert.se->Sample_BSDF( vert.wi , vert.wo , BsdfSample(true) , bsdf_pdf );
+        bsdf_pdf *= rr;
+
+        if( 0.0f == bsdf_pdf )
+            break;
+
+        const auto cosOut = absDot(vert.wo, vert.n);
+        throughput *= bsdf_value / bsdf_pdf;
+
+        if (throughput.IsBlack())
+            break;
+
+        const auto rev_bsdf_pdfw = vert.se->Pdf_BSDF( vert.wo , vert.wi ) * rr;
+        vc = MIS(cosOut/bsdf_pdf) * ( MIS(rev_bsdf_pdfw) * vc + vcm + m_misVmWeightFactor );
+        vm = MIS(cosOut/bsdf_pdf) * ( MIS(rev_bsdf_pdfw) * vm + vcm * m_misVcWeightFactor + 1.0f );
+        vcm = MIS(1.0f/bsdf_pdf);
+
+        wi = Ray(vert.inter.intersect, vert.wo, 0, 0.001f);
+    }
+
+    return light;
+}
+
 void BidirPathTracing::RequestSample( Sampler* sampler , PixelSample* ps , unsigned ps_num ){
     Integrator::RequestSample( sampler, ps , ps_num );
     sample_per_pixel = ps_num;
@@ -255,8 +276,8 @@ Spectrum BidirPathTracing::_ConnectVertices( const BDPT_Vertex& p0 , const BDPT_
     const auto p0_a = p1_bsdf_pdfw * cosAtP0 * invDistcSqr;
     const auto p1_a = p0_bsdf_pdfw * cosAtP1 * invDistcSqr;
 
-    const double mis_0 = MIS( p0_a ) * ( p0.vcm + p0.vc * MIS( p0_bsdf_rev_pdfw ) );
-    const double mis_1 = MIS( p1_a ) * ( p1.vcm + p1.vc * MIS( p1_bsdf_rev_pdfw ) );
+    const double mis_0 = MIS( p0_a ) * ( m_misVmWeightFactor + p0.vcm + p0.vc * MIS( p0_bsdf_rev_pdfw ) );
+    const double mis_1 = MIS( p1_a ) * ( m_misVmWeightFactor + p1.vcm + p1.vc * MIS( p1_bsdf_rev_pdfw ) );
 
     const auto weight = (float)(1.0f / (mis_0 + 1.0f + mis_1));
 
@@ -312,7 +333,7 @@ Spectrum BidirPathTracing::_ConnectLight(const BDPT_Vertex& eye_vertex , const L
     const auto eye_bsdf_rev_pdfw = eye_vertex.se->Pdf_BSDF( wi , eye_vertex.wi ) * eye_vertex.rr;
 
     const double mis0 = light->IsDelta()?0.0f:MIS(eye_bsdf_pdfw / directPdfW);
-    const double mis1 = MIS( cosAtEyeVertex * emissionPdfW / ( cosAtLight * directPdfW ) ) * ( eye_vertex.vcm + eye_vertex.vc * MIS( eye_bsdf_rev_pdfw ) );
+    const double mis1 = MIS( cosAtEyeVertex * emissionPdfW / ( cosAtLight * directPdfW ) ) * ( m_misVmWeightFactor + eye_vertex.vcm + eye_vertex.vc * MIS( eye_bsdf_rev_pdfw ) );
 
     const auto weight = (float)(1.0f / (mis0 + mis1 + 1.0f));
 
@@ -374,7 +395,7 @@ void BidirPathTracing::_ConnectCamera(const BDPT_Vertex& light_vertex, int len ,
     if( !light_tracing_only ){
         const float lightvert_pdfA = camera_pdfW * absDot( light_vertex.n, n_delta ) * invSqrLen ;
         const float bsdf_rev_pdfw = light_vertex.se->Pdf_BSDF( -n_delta , light_vertex.wi ) * light_vertex.rr;
-        const double mis0 = ( light_vertex.vcm + light_vertex.vc * MIS( bsdf_rev_pdfw ) ) * MIS( lightvert_pdfA / total_pixel );
+        const double mis0 = ( m_misVmWeightFactor + light_vertex.vcm + light_vertex.vc * MIS( bsdf_rev_pdfw ) ) * MIS( lightvert_pdfA / total_pixel );
         const float weight = (float)(1.0f / (1.0f + mis0));
 
         radiance *= weight;
@@ -39,6 +39,7 @@ struct BDPT_Vertex{
     // MIS factors
     double      vc = 0.0f;
     double      vcm = 0.0f;
+    double      vm = 0.0f;
 
     // depth of the vertex
     int         depth = 0;
@@ -88,6 +89,13 @@ protected:
     bool    light_tracing_only = false;     // only do light tracing
     int     sample_per_pixel = 1;           // light sample per pixel
 
+    // MIS factors of vertex merging, both are zero without merging so that the extra terms vanish.
+    double  m_misVmWeightFactor = 0.0f;
+    double  m_misVcWeightFactor = 0.0f;
+
+    // trace a path from a light picked randomly, it returns the light, 'nullptr' if there is none
+    const Light*    _TraceLightPath( std::vector<BDPT_Vertex>& light_path , float& pdf , bool connect_camera , const Scene& scene ) const;
+
     // compute G term
     Spectrum    _Gterm( const BDPT_Vertex& p0 , const BDPT_Vertex& p1 ) const;
 
@@ -100,9 +108,10 @@ protected:
     // connect vertices
     Spectrum    _ConnectVertices( const BDPT_Vertex& light_vertex , const BDPT_Vertex& eye_vertex , const Light* light , const Scene& scene ) const;
 
-private:
-    // use multiple importance sampling to sample direct illumination
-    bool    m_bMIS = true;
+    // merge an eye vertex with light vertices nearby, there is no merging in bi-directional path tracing
+    virtual Spectrum    _MergeVertices( const BDPT_Vertex& eye_vertex ) const {
+        return 0.0f;
+    }
 
     // mis factor
     SORT_FORCEINLINE double MIS(double t) const {
@@ -112,5 +121,9 @@ private:
         return m_bMIS ? t * t : 1.0f;
     }
 
+private:
+    // use multiple importance sampling to sample direct illumination
+    bool    m_bMIS = true;
+
     SORT_STATS_ENABLE( "Bi-directional Path Tracing" )
 };
@@ -22,6 +22,9 @@
 #include "light/light.h"
 #include "core/memory.h"
 #include "sampler/sampler.h"
+#include "core/primitive.h"
+#include "material/material.h"
+#include "scatteringevent/scatteringevent.h"
 
 SORT_STATS_DECLARE_COUNTER(sPrimaryRayCount)
 
@@ -36,17 +39,29 @@ Spectrum DirectLight::Li( const Ray& r , const PixelSample& ps , const Scene& sc
     // get the intersection between the ray and the scene
     SurfaceInteraction ip;
     // evaluate light directly
-    if( false == scene.GetIntersect( r , ip ) )
-        return scene.Le( r );
+    if( false == scene.GetIntersect( r , ip ) ){
+        const auto le = scene.Le( r );
+        RecordLightGroupAOV( ps.aov , scene.GetSkyLight() , le );
+        return le;
+    }
 
     auto li = ip.Le( -r.m_Dir );
+    RecordLightGroupAOV( ps.aov , ip.primitive->GetLight() , li );
+
+    if( ps.aov ){
+        ScatteringEvent se( ip , SE_EVALUATE_ALL_NO_SSS );
+        ip.primitive->GetMaterial()->UpdateScatteringEvent( se );
+        RecordSurfaceAOV( ps.aov , r , ip , se );
+    }
 
     // evaluate direct light
     auto light_num = scene.LightNum();
     for( auto i = 0u ; i < light_num ; ++i ){
         const auto light = scene.GetLight(i);
-        li += EvaluateDirect( r , scene , light , ip , LightSample(true) , BsdfSample(true) , true );
+        const auto direct = EvaluateDirect( r , scene , light , ip , LightSample(true) , BsdfSample(true) , true );
+        RecordLightGroupAOV( ps.aov , light , direct );
+        li += direct;
     }
 
     return li;
-}
\ No newline at end of file
+}
\ No newline at end of file
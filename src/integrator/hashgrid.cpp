@@ -0,0 +1,73 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include "hashgrid.h"
+#include "task/task.h"
+
+// Number of points processed by a job when building the grid in parallel.
+static constexpr unsigned   HASHGRID_POINTS_PER_JOB = 4096;
+
+void HashGrid::Build( std::vector<Point> points , float radius ){
+    m_points = std::move( points );
+    m_radiusSqr = radius * radius;
+    m_invCellSize = 0.5f / radius;
+
+    const auto point_cnt = (unsigned)m_points.size();
+    const auto entry_cnt = std::max( 1u , point_cnt );
+    m_entryStart.assign( entry_cnt + 1 , 0 );
+    m_indices.resize( point_cnt );
+
+    // All jobs go through the points in the same blocks, the first one counts points in each entry and the second
+    // one scatters them.
+    const auto job_cnt = (int)( ( point_cnt + HASHGRID_POINTS_PER_JOB - 1 ) / HASHGRID_POINTS_PER_JOB );
+    const auto for_each_point = [&]( auto&& func ){
+        ParallelForRows( job_cnt , [&]( int j0 , int j1 ){
+            const auto end = std::min( point_cnt , (unsigned)j1 * HASHGRID_POINTS_PER_JOB );
+            for( auto i = (unsigned)j0 * HASHGRID_POINTS_PER_JOB ; i < end ; ++i )
+                func( i );
+        });
+    };
+
+    std::vector<unsigned> entries( point_cnt );
+    std::unique_ptr<std::atomic<unsigned>[]> counter( new std::atomic<unsigned>[entry_cnt] );
+    for( auto i = 0u ; i < entry_cnt ; ++i )
+        counter[i].store( 0 , std::memory_order_relaxed );
+
+    for_each_point( [&]( unsigned i ){
+        entries[i] = entry( m_points[i] );
+        counter[entries[i]].fetch_add( 1 , std::memory_order_relaxed );
+    });
+
+    // counters are turned into the offsets to scatter points to
+    for( auto i = 0u ; i < entry_cnt ; ++i ){
+        m_entryStart[i + 1] = m_entryStart[i] + counter[i].load( std::memory_order_relaxed );
+        counter[i].store( m_entryStart[i] , std::memory_order_relaxed );
+    }
+
+    for_each_point( [&]( unsigned i ){
+        m_indices[ counter[entries[i]].fetch_add( 1 , std::memory_order_relaxed ) ] = i;
+    });
+
+    // The order of points in an entry depends on threads, sorting them makes merging deterministic.
+    ParallelForRows( (int)( ( entry_cnt + HASHGRID_POINTS_PER_JOB - 1 ) / HASHGRID_POINTS_PER_JOB ) , [&]( int j0 , int j1 ){
+        const auto end = std::min( entry_cnt , (unsigned)j1 * HASHGRID_POINTS_PER_JOB );
+        for( auto e = (unsigned)j0 * HASHGRID_POINTS_PER_JOB ; e < end ; ++e )
+            std::sort( m_indices.begin() + m_entryStart[e] , m_indices.begin() + m_entryStart[e + 1] );
+    });
+}
@@ -0,0 +1,101 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include "math/point.h"
+
+//! @brief  Hash grid for finding points within a fixed radius around a query point.
+/**
+ * The space is divided into cells of twice the radius, cells are hashed into a table with as many entries as
+ * points. Points are sorted by the entries they fall into, so that the points of an entry are contiguous in
+ * memory. A query only visits the eight cells overlapping the sphere around the query point.
+ * Building the grid is done in parallel, the order of points in each entry is sorted by index so that the
+ * result doesn't depend on how threads are scheduled.
+ */
+class HashGrid{
+public:
+    //! @brief  Build the grid.
+    //!
+    //! @param  points      Positions of all points, it is kept in the grid.
+    //! @param  radius      Radius of queries.
+    void    Build( std::vector<Point> points , float radius );
+
+    //! @brief  Visit all points within the radius of a point.
+    //!
+    //! @param  p       The query point.
+    //! @param  func    Functor called with the index of each point within the radius.
+    template<class Func>
+    void    Query( const Point& p , Func&& func ) const {
+        if( m_points.empty() )
+            return;
+
+        // The sphere around the point only overlaps the cell containing it and its neighbors in the closer half.
+        const auto fx = p.x * m_invCellSize;
+        const auto fy = p.y * m_invCellSize;
+        const auto fz = p.z * m_invCellSize;
+        const auto cx = (int)std::floor( fx );
+        const auto cy = (int)std::floor( fy );
+        const auto cz = (int)std::floor( fz );
+        const auto x0 = ( fx - cx < 0.5f ) ? cx - 1 : cx;
+        const auto y0 = ( fy - cy < 0.5f ) ? cy - 1 : cy;
+        const auto z0 = ( fz - cz < 0.5f ) ? cz - 1 : cz;
+
+        // Different cells could collide in the same entry, each entry is only visited once.
+        unsigned visited[8];
+        auto visited_cnt = 0u;
+        for( auto i = 0 ; i < 8 ; ++i ){
+            const auto entry = hash( x0 + ( i & 1 ) , y0 + ( ( i >> 1 ) & 1 ) , z0 + ( i >> 2 ) );
+
+            auto duplicated = false;
+            for( auto j = 0u ; j < visited_cnt && !duplicated ; ++j )
+                duplicated = visited[j] == entry;
+            if( duplicated )
+                continue;
+            visited[visited_cnt++] = entry;
+
+            for( auto k = m_entryStart[entry] ; k < m_entryStart[entry + 1] ; ++k ){
+                const auto index = m_indices[k];
+                if( ( m_points[index] - p ).SquaredLength() <= m_radiusSqr )
+                    func( index );
+            }
+        }
+    }
+
+    //! @brief  Number of points in the grid.
+    unsigned    GetPointCount() const {
+        return (unsigned)m_points.size();
+    }
+
+private:
+    std::vector<Point>      m_points;               /**< Positions of all points. */
+    std::vector<unsigned>   m_indices;              /**< Indices of points sorted by the entries they fall into. */
+    std::vector<unsigned>   m_entryStart;           /**< Offset of the first point of each entry, with one more at the end. */
+    float                   m_radiusSqr = 0.0f;     /**< Squared radius of queries. */
+    float                   m_invCellSize = 1.0f;   /**< Reciprocal of the size of cells. */
+
+    //! @brief  Hash a cell into an entry of the table.
+    unsigned    hash( int x , int y , int z ) const {
+        return ( ( (unsigned)x * 73856093u ) ^ ( (unsigned)y * 19349663u ) ^ ( (unsigned)z * 83492791u ) ) % (unsigned)( m_entryStart.size() - 1 );
+    }
+
+    //! @brief  Entry of the table a point falls into.
+    unsigned    entry( const Point& p ) const {
+        return hash( (int)std::floor( p.x * m_invCellSize ) , (int)std::floor( p.y * m_invCellSize ) , (int)std::floor( p.z * m_invCellSize ) );
+    }
+};
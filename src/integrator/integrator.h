@@ -62,6 +62,20 @@ public:
     //! @brief  Some integrator have a post process step.
     virtual void PostProcess() {}
 
+    //! @brief  Whether the integrator prepares some data before each pass of progressive rendering.
+    //!
+    //! If it is true, passes are rendered one after another, the next pass starts only after all tiles of the
+    //! previous one are done.
+    virtual bool NeedPrePass() const {
+        return false;
+    }
+
+    //! @brief  Prepare data shared by all tiles of a pass, like light vertices for vertex merging.
+    //!
+    //! @param  scene   The rendering scene.
+    //! @param  pass    Index of the pass, starting from zero.
+    virtual void PrePass( const Scene& scene , unsigned pass ) {}
+
     //! @brief  Though most integrators do support live update in Blender, some doesn't, like light tracing.
     virtual bool NeedRefreshTile() const {
         return true;
@@ -74,27 +88,29 @@ public:
         stream >> max_recursive_depth;
     }
 
-    //! @brief  This interface is not well supported in SORT for now.
-    virtual void GenerateSample(const Sampler* sampler, PixelSample* samples, unsigned ps, const Scene& scene) const {
-        auto data = std::make_unique<float[]>(2 * ps);
-        sampler->Generate2D(data.get(), ps, true);
-        for (unsigned i = 0; i < ps; ++i)
-        {
-            samples[i].img_u = data[2 * i];
-            samples[i].img_v = data[2 * i + 1];
-        }
-
-        auto shuffle = std::make_unique<unsigned[]>(ps);
-        for (unsigned i = 0; i < ps; i++)
-            shuffle[i] = i;
-        std::shuffle(shuffle.get(), shuffle.get() + ps, std::default_random_engine(sort_rand()));
-
-        sampler->Generate2D(data.get(), ps);
+    //! @brief  Generate camera samples of a pixel.
+    //!
+    //! This is called once for every pixel, it doesn't allocate any memory. Image and lens samples of
+    //! all pixel samples are generated in batch by the sampler first, then scattered into pixel samples
+    //! in a single pass.
+    //!
+    //! @param  sampler     The sampler, the pixel needs to be started already.
+    //! @param  samples     The samples of the pixel.
+    //! @param  ps          Number of samples of the pixel.
+    //! @param  buffer      Scratch memory of at least 4 * ps floats, it is owned by the render task and reused for all pixels.
+    //! @param  scene       The rendering scene.
+    virtual void GenerateSample(const Sampler* sampler, PixelSample* samples, unsigned ps, float* buffer, const Scene& scene) const {
+        // Samplers decorrelate different dimensions already, there is no need to shuffle the samples.
+        const auto img = buffer;
+        const auto dof = buffer + 2 * ps;
+        sampler->Generate2D(img, ps, true);
+        sampler->Generate2D(dof, ps);
         for (unsigned i = 0; i < ps; ++i)
         {
-            unsigned sid = 2 * shuffle[i];
-            samples[i].dof_u = data[sid];
-            samples[i].dof_v = data[sid + 1];
+            samples[i].img_u = img[2 * i];
+            samples[i].img_v = img[2 * i + 1];
+            samples[i].dof_u = dof[2 * i];
+            samples[i].dof_v = dof[2 * i + 1];
         }
     }
 
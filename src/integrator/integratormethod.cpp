@@ -15,6 +15,7 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <cstring>
 #include "integratormethod.h"
 #include "math/ray.h"
 #include "math/interaction.h"
@@ -24,11 +25,21 @@
 #include "material/material.h"
 #include "light/light.h"
 #include "medium/phasefunction.h"
+#include "sampler/random.h"
 
 SORT_FORCEINLINE float MisFactor( float f, float g ){
     return (f*f) / (f*f + g*g);
 }
 
+// hash the bits of a vector, it tells camera rays of different samples apart
+SORT_FORCEINLINE unsigned hashBits( float x , float y , float z ){
+    unsigned bits[3];
+    memcpy( &bits[0] , &x , sizeof( unsigned ) );
+    memcpy( &bits[1] , &y , sizeof( unsigned ) );
+    memcpy( &bits[2] , &z , sizeof( unsigned ) );
+    return sort_hash_combine( sort_hash_combine( sort_hash( bits[0] ) , bits[1] ) , bits[2] );
+}
+
 Spectrum    EvaluateDirect( const ScatteringEvent& se , const Ray& r , const Scene& scene , const Light* light , const LightSample& ls ,const BsdfSample& bs ){
     const auto& ip = se.GetInteraction();
     Spectrum radiance;
@@ -218,10 +229,10 @@ Spectrum    EvaluateDirect(const Point& ip, const PhaseFunction* ph, const Vecto
 
 // This is only used by SSS for now, since it is a smooth BRDF, there is no need to do MIS.
 Spectrum SampleOneLight( const ScatteringEvent& se , const Ray& r, const SurfaceInteraction& inter, const Scene& scene, const MaterialBase* material, const MediumStack& ms) {
-    // Uniformly choose a light, this may not be the optimal solution in case of more lights, need more research in this topic later.
+    // Choose a light based on its importance to the shading point.
     float light_pick_pdf = 0.0f;
-    const auto light = scene.SampleLight( sort_canonical() , &light_pick_pdf );
-    if(IS_PTR_INVALID(light))
+    const auto light = scene.SampleLight( inter.intersect , inter.normal , sort_canonical() , &light_pick_pdf );
+    if(IS_PTR_INVALID(light) || light_pick_pdf == 0.0f )
         return 0.0f;
 
     Spectrum radiance;
@@ -264,4 +275,28 @@ Spectrum    EvaluateDirect( const Ray& r , const Scene& scene , const Light* lig
     ScatteringEvent se( ip , replaceSSS ? SE_EVALUATE_ALL_NO_SSS : SE_EVALUATE_ALL );
     ip.primitive->GetMaterial()->UpdateScatteringEvent( se );
     return EvaluateDirect( se , r , scene , light , ls , bs );
-}
\ No newline at end of file
+}
+void RecordSurfaceAOV( AOVSample* aov , const Ray& r , const SurfaceInteraction& ip , const ScatteringEvent& se ){
+    if( !aov )
+        return;
+
+    aov->Set( AOV_DEPTH , ip.t );
+    aov->Set( AOV_NORMAL , ip.normal.x , ip.normal.y , ip.normal.z );
+
+    // A single sample estimation of the directional albedo, it converges to the albedo as more samples are taken in the pixel.
+    // Random numbers come from a stream keyed by the camera ray instead of the sampler of the pixel, so that the beauty
+    // pass draws the same sample dimensions no matter whether the channel is enabled.
+    if( aov->IsEnabled( AOV_ALBEDO ) ){
+        RandomSampler sampler;
+        sampler.StartPixel( (int)hashBits( r.m_Dir.x , r.m_Dir.y , r.m_Dir.z ) , (int)hashBits( r.m_Ori.x , r.m_Ori.y , r.m_Ori.z ) );
+        SampleStreamScope sample_stream( &sampler );
+
+        Vector wi;
+        auto pdf = 0.0f;
+        const auto f = se.Sample_BSDF( -r.m_Dir , wi , BsdfSample(true) , pdf );
+        if( pdf > 0.0f && !f.IsBlack() ){
+            const auto albedo = f / pdf;
+            aov->Set( AOV_ALBEDO , albedo.r , albedo.g , albedo.b );
+        }
+    }
+}
@@ -18,6 +18,8 @@
 #pragma once
 
 #include "integrator.h"
+#include "imagesensor/aov.h"
+#include "light/light.h"
 
 struct	SurfaceInteraction;
 class	Light;
@@ -34,4 +36,13 @@ Spectrum    SampleOneLight( const ScatteringEvent& se , const Ray& r, const Surf
 
 // helper function to evaluate light contribution
 Spectrum    EvaluateDirect( const Ray& r , const Scene& scene , const Light* light , const SurfaceInteraction& ip ,
-                            const LightSample& ls , const BsdfSample& bs , bool replaceSSS = false );
\ No newline at end of file
+                            const LightSample& ls , const BsdfSample& bs , bool replaceSSS = false );
+
+// record arbitrary output variables at the first hit of a camera ray, like depth, normal and albedo
+void        RecordSurfaceAOV( AOVSample* aov , const Ray& r , const SurfaceInteraction& ip , const ScatteringEvent& se );
+
+// attribute radiance to the light group of a light
+SORT_FORCEINLINE void RecordLightGroupAOV( AOVSample* aov , const Light* light , const Spectrum& radiance ){
+    if( aov && light )
+        aov->AddLightGroup( light->GetLightGroup() , radiance );
+}
@@ -0,0 +1,279 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cmath>
+#include "pathguiding.h"
+#include "math/utils.h"
+
+// Maximum depth of directional trees, the finest quadrants cover about 2^-40 of the sphere.
+static constexpr unsigned   DTREE_MAX_DEPTH = 20;
+// Leaves of the spatial tree are split once the number of samples exceeds this, scaled by sqrt(2^iteration).
+static constexpr float      STREE_SPLIT_THRESHOLD = 12000.0f;
+// Fraction of the total energy a quadrant needs to be split.
+static constexpr float      DTREE_SPLIT_THRESHOLD = 0.01f;
+// The spatial tree stops splitting once leaves can't afford directional trees of this many nodes.
+static constexpr unsigned   DTREE_MIN_NODES = 64;
+
+DirectionalTree::DirectionalTree(){
+    m_nodes.emplace_back();
+}
+
+Vector2f DirectionalTree::DirToCanonical( const Vector& dir ){
+    const auto cos_theta = clamp( dir.y , -1.0f , 1.0f );
+    auto phi = std::atan2( dir.z , dir.x );
+    if( phi < 0.0f )
+        phi += TWO_PI;
+    return Vector2f( clamp( ( cos_theta + 1.0f ) * 0.5f , 0.0f , 1.0f ) , clamp( phi / TWO_PI , 0.0f , 1.0f ) );
+}
+
+Vector DirectionalTree::CanonicalToDir( const Vector2f& p ){
+    const auto cos_theta = 2.0f * p.x - 1.0f;
+    const auto sin_theta = std::sqrt( std::max( 0.0f , 1.0f - cos_theta * cos_theta ) );
+    const auto phi = TWO_PI * p.y;
+    return Vector( sin_theta * std::cos( phi ) , cos_theta , sin_theta * std::sin( phi ) );
+}
+
+void DirectionalTree::Record( const Vector& dir , float value ){
+    auto p = DirToCanonical( dir );
+    auto node = 0u;
+    while( true ){
+        const auto col = p.x >= 0.5f ? 1 : 0;
+        const auto row = p.y >= 0.5f ? 1 : 0;
+        const auto q = row * 2 + col;
+        m_nodes[node].sum[q].Add( value );
+        if( !m_nodes[node].child[q] )
+            break;
+        p = Vector2f( p.x * 2.0f - col , p.y * 2.0f - row );
+        node = m_nodes[node].child[q];
+    }
+}
+
+Vector DirectionalTree::Sample( const Vector2f& u_in , float& pdf ) const{
+    auto u = u_in;
+    auto origin = Vector2f( 0.0f , 0.0f );
+    auto size = 1.0f;
+    auto node = 0u;
+    pdf = INV_FOUR_PI;
+    while( true ){
+        const auto& n = m_nodes[node];
+        const float s[4] = { n.sum[0].Get() , n.sum[1].Get() , n.sum[2].Get() , n.sum[3].Get() };
+        const auto total = s[0] + s[1] + s[2] + s[3];
+        if( total <= 0.0f )
+            break;
+
+        // pick the row first, quadrant 0 and 1 are in the lower row
+        const auto lower = ( s[0] + s[1] ) / total;
+        auto row = 0;
+        if( u.y < lower ){
+            u.y /= lower;
+        }else{
+            row = 1;
+            u.y = ( u.y - lower ) / ( 1.0f - lower );
+        }
+
+        // then the quadrant in the row
+        const auto row_sum = s[2 * row] + s[2 * row + 1];
+        const auto left = row_sum > 0.0f ? s[2 * row] / row_sum : 0.5f;
+        auto col = 0;
+        if( u.x < left ){
+            u.x /= left;
+        }else{
+            col = 1;
+            u.x = ( u.x - left ) / ( 1.0f - left );
+        }
+        u = Vector2f( clamp( u.x , 0.0f , 0.99999994f ) , clamp( u.y , 0.0f , 0.99999994f ) );
+
+        const auto q = row * 2 + col;
+        pdf *= 4.0f * s[q] / total;
+
+        size *= 0.5f;
+        origin = Vector2f( origin.x + col * size , origin.y + row * size );
+        if( !n.child[q] )
+            break;
+        node = n.child[q];
+    }
+
+    // directions are uniformly distributed in the leaf quadrant
+    return CanonicalToDir( Vector2f( origin.x + u.x * size , origin.y + u.y * size ) );
+}
+
+float DirectionalTree::Pdf( const Vector& dir ) const{
+    auto p = DirToCanonical( dir );
+    auto node = 0u;
+    auto pdf = INV_FOUR_PI;
+    while( true ){
+        const auto& n = m_nodes[node];
+        const auto total = n.sum[0].Get() + n.sum[1].Get() + n.sum[2].Get() + n.sum[3].Get();
+        if( total <= 0.0f )
+            return pdf;
+
+        const auto col = p.x >= 0.5f ? 1 : 0;
+        const auto row = p.y >= 0.5f ? 1 : 0;
+        const auto q = row * 2 + col;
+        pdf *= 4.0f * n.sum[q].Get() / total;
+        if( !n.child[q] )
+            return pdf;
+        p = Vector2f( p.x * 2.0f - col , p.y * 2.0f - row );
+        node = n.child[q];
+    }
+}
+
+DirectionalTree DirectionalTree::Refine( float threshold , unsigned max_nodes ) const{
+    DirectionalTree tree;
+
+    const auto total = GetEnergy();
+    if( total <= 0.0f )
+        return tree;
+
+    // Nodes are created in breadth-first order so that the budget is not used up by a single branch.
+    // Quadrants that are leaves in this tree spread their energy evenly in sub-quadrants.
+    struct Item{
+        int         node;       // node in this tree, -1 if it is inside a leaf quadrant
+        float       energy;     // energy of the leaf quadrant containing it
+        unsigned    refined;    // node in the refined tree
+        unsigned    depth;      // depth of the node
+    };
+    std::vector<Item> queue = { { 0 , total , 0 , 1 } };
+    for( auto head = 0u ; head < queue.size() ; ++head ){
+        const auto item = queue[head];
+        if( item.depth >= DTREE_MAX_DEPTH )
+            continue;
+
+        for( auto q = 0 ; q < 4 ; ++q ){
+            const auto energy = item.node >= 0 ? m_nodes[item.node].sum[q].Get() : item.energy * 0.25f;
+            if( energy <= total * threshold || tree.m_nodes.size() >= max_nodes )
+                continue;
+
+            const auto child = (unsigned)tree.m_nodes.size();
+            tree.m_nodes.emplace_back();
+            tree.m_nodes[item.refined].child[q] = child;
+
+            const auto node = ( item.node >= 0 && m_nodes[item.node].child[q] ) ? (int)m_nodes[item.node].child[q] : -1;
+            queue.push_back( { node , energy , child , item.depth + 1 } );
+        }
+    }
+    return tree;
+}
+
+GuidingTree::GuidingTree( const BBox& bbox , size_t max_memory ) : m_maxMemory( max_memory ){
+    // The spatial tree splits a cube so that the leaves are cubes every three levels.
+    auto size = 0.0f;
+    for( auto i = 0u ; i < 3 ; ++i )
+        size = std::max( size , bbox.m_Max[i] - bbox.m_Min[i] );
+    size = size > 0.0f ? size * 1.01f : 1.0f;
+    const auto center = ( bbox.m_Min + bbox.m_Max ) * 0.5f;
+    m_origin = center - Vector( size * 0.5f );
+    m_invSize = 1.0f / size;
+
+    m_nodes.emplace_back();
+    m_leaves.emplace_back();
+}
+
+unsigned GuidingTree::lookup( const Point& p ) const{
+    float local[3];
+    for( auto i = 0u ; i < 3 ; ++i )
+        local[i] = clamp( ( p[i] - m_origin[i] ) * m_invSize , 0.0f , 1.0f );
+
+    auto node = 0u;
+    while( m_nodes[node].child[0] ){
+        const auto axis = m_nodes[node].axis;
+        if( local[axis] < 0.5f ){
+            local[axis] *= 2.0f;
+            node = m_nodes[node].child[0];
+        }else{
+            local[axis] = local[axis] * 2.0f - 1.0f;
+            node = m_nodes[node].child[1];
+        }
+    }
+    return m_nodes[node].leaf;
+}
+
+void GuidingTree::Record( const Point& p , const Vector& dir , float value ){
+    if( !std::isfinite( value ) || value < 0.0f )
+        return;
+
+    auto& leaf = m_leaves[lookup( p )];
+    leaf.building.Record( dir , value );
+    ++leaf.sampleCnt;
+}
+
+const DirectionalTree* GuidingTree::GetSamplingTree( const Point& p ) const{
+    const auto& leaf = m_leaves[lookup( p )];
+    return leaf.sampling.GetEnergy() > 0.0f ? &leaf.sampling : nullptr;
+}
+
+float GuidingTree::EstimateRadiance( const Point& p , const Vector& dir ) const{
+    const auto& leaf = m_leaves[lookup( p )];
+    const auto energy = leaf.sampling.GetEnergy();
+    if( energy <= 0.0f || leaf.samplingCnt == 0 )
+        return -1.0f;
+
+    // The energy over the number of samples estimates the integral of radiance over the sphere, the pdf distributes it.
+    return energy / leaf.samplingCnt * leaf.sampling.Pdf( dir );
+}
+
+void GuidingTree::Refine( unsigned iteration ){
+    // The number of samples is kept before splitting, children inherit it along with the recorded energy.
+    for( auto& leaf : m_leaves )
+        leaf.samplingCnt = leaf.sampleCnt;
+
+    // Split leaves with enough samples, the samples are considered evenly distributed in the two children.
+    // The children are visited later in the same loop, they are split again if they still have enough samples.
+    const auto threshold = (unsigned)( STREE_SPLIT_THRESHOLD * std::sqrt( std::pow( 2.0f , (float)iteration ) ) );
+    const auto max_leaves = std::max( (size_t)1 , m_maxMemory / ( 2 * DTREE_MIN_NODES * DirectionalTree::GetNodeSize() ) );
+    for( auto i = 0u ; i < m_nodes.size() && m_leaves.size() < max_leaves ; ++i ){
+        if( m_nodes[i].child[0] )
+            continue;
+
+        const auto leaf_id = m_nodes[i].leaf;
+        const auto sample_cnt = m_leaves[leaf_id].sampleCnt.load();
+        if( sample_cnt < threshold )
+            continue;
+
+        m_leaves[leaf_id].sampleCnt = sample_cnt / 2;
+        m_leaves.push_back( m_leaves[leaf_id] );
+
+        Node child[2];
+        child[0].axis = child[1].axis = ( m_nodes[i].axis + 1 ) % 3;
+        child[0].leaf = leaf_id;
+        child[1].leaf = (unsigned)m_leaves.size() - 1;
+
+        m_nodes[i].child[0] = (unsigned)m_nodes.size();
+        m_nodes[i].child[1] = (unsigned)m_nodes.size() + 1;
+        m_nodes.push_back( child[0] );
+        m_nodes.push_back( child[1] );
+    }
+
+    // The radiance learned in this iteration is used for sampling, new directional trees are refined based on it.
+    const auto max_nodes = (unsigned)std::max( (size_t)1 , m_maxMemory / ( 2 * m_leaves.size() * DirectionalTree::GetNodeSize() ) );
+    for( auto& leaf : m_leaves ){
+        leaf.sampling = leaf.building;
+        leaf.building = leaf.sampling.Refine( DTREE_SPLIT_THRESHOLD , max_nodes );
+        leaf.sampleCnt = 0;
+    }
+}
+
+unsigned GuidingTree::GetLeafCount() const{
+    return (unsigned)m_leaves.size();
+}
+
+size_t GuidingTree::GetMemoryUsage() const{
+    size_t memory = m_nodes.size() * sizeof( Node );
+    for( const auto& leaf : m_leaves )
+        memory += ( leaf.building.GetNodeCount() + leaf.sampling.GetNodeCount() ) * DirectionalTree::GetNodeSize();
+    return memory;
+}
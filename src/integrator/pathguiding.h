@@ -0,0 +1,204 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "math/bbox.h"
+#include "math/point.h"
+#include "math/vector2.h"
+#include "math/vector3.h"
+
+//! @brief  Float that multiple threads can accumulate into concurrently.
+class AtomicFloat{
+public:
+    AtomicFloat( float v = 0.0f ) : m_value( v ) {}
+    AtomicFloat( const AtomicFloat& v ) : m_value( v.Get() ) {}
+    AtomicFloat& operator = ( const AtomicFloat& v ){
+        m_value.store( v.Get() , std::memory_order_relaxed );
+        return *this;
+    }
+
+    //! @brief  Add a value to it.
+    void    Add( float v ){
+        auto cur = m_value.load( std::memory_order_relaxed );
+        while( !m_value.compare_exchange_weak( cur , cur + v , std::memory_order_relaxed ) );
+    }
+
+    //! @brief  Get the current value.
+    float   Get() const {
+        return m_value.load( std::memory_order_relaxed );
+    }
+
+private:
+    std::atomic<float>  m_value;
+};
+
+//! @brief  Quadtree learning the incident radiance over the sphere of directions at a region of the scene.
+/**
+ * Directions are mapped to the unit square with the cylindrical mapping, ( cos(theta) , phi ), which preserves
+ * area, so that the density in the square over 4PI is the density w.r.t solid angle. Each node keeps the
+ * energy recorded in its four quadrants, directions are sampled by descending the tree picking quadrants
+ * proportional to their energy. The tree is refined after each training iteration, quadrants with more than
+ * a fraction of the total energy are split and the others are merged.
+ */
+class DirectionalTree{
+public:
+    //! @brief  Default constructor, creating a tree with a single node.
+    DirectionalTree();
+
+    //! @brief  Record the radiance arriving from a direction.
+    //!
+    //! It is thread safe to record into the same tree from multiple threads.
+    //!
+    //! @param  dir     The normalized direction, pointing from the shading point.
+    //! @param  value   The radiance estimation divided by the pdf of sampling the direction.
+    void    Record( const Vector& dir , float value );
+
+    //! @brief  Sample a direction proportional to the recorded energy.
+    //!
+    //! @param  u       Two canonical random numbers.
+    //! @param  pdf     The pdf w.r.t solid angle of sampling the direction.
+    //! @return         The normalized direction.
+    Vector  Sample( const Vector2f& u , float& pdf ) const;
+
+    //! @brief  The pdf w.r.t solid angle of sampling a direction.
+    //!
+    //! @param  dir     The normalized direction.
+    //! @return         The pdf of sampling the direction by 'Sample'.
+    float   Pdf( const Vector& dir ) const;
+
+    //! @brief  Total energy recorded in the tree.
+    float   GetEnergy() const {
+        return m_nodes[0].sum[0].Get() + m_nodes[0].sum[1].Get() + m_nodes[0].sum[2].Get() + m_nodes[0].sum[3].Get();
+    }
+
+    //! @brief  Number of nodes in the tree.
+    unsigned    GetNodeCount() const {
+        return (unsigned)m_nodes.size();
+    }
+
+    //! @brief  Memory used by a node of the tree in bytes.
+    static size_t   GetNodeSize() {
+        return sizeof( Node );
+    }
+
+    //! @brief  Build a tree with the structure refined based on the energy recorded in this tree.
+    //!
+    //! All energy in the new tree is cleared.
+    //!
+    //! @param  threshold   Quadrants holding more than this fraction of the total energy are split.
+    //! @param  max_nodes   Maximum number of nodes in the new tree.
+    //! @return             The refined tree.
+    DirectionalTree Refine( float threshold , unsigned max_nodes ) const;
+
+    //! @brief  Map a direction to the unit square.
+    static Vector2f DirToCanonical( const Vector& dir );
+
+    //! @brief  Map a point in the unit square to a direction.
+    static Vector   CanonicalToDir( const Vector2f& p );
+
+private:
+    //! @brief  Node of the tree, child index of a quadrant is zero if it is a leaf.
+    struct Node{
+        AtomicFloat sum[4];             /**< Energy recorded in each quadrant. */
+        unsigned    child[4] = { 0 };   /**< Index of the node of each quadrant. */
+    };
+
+    std::vector<Node>   m_nodes;        /**< Nodes of the tree, the root is the first one. */
+};
+
+//! @brief  Spatial-directional tree for path guiding.
+/**
+ * This is the SD-tree in "Practical Path Guiding for Efficient Light-Transport Simulation" by Muller et al.
+ * The scene is subdivided by a binary tree, splitting along the three axes alternately. Each leaf holds two
+ * directional trees, one recording the radiance in the current training iteration and the other learned in
+ * the previous one for sampling. Leaves with many recorded samples are split after each iteration, so that
+ * regions reached by many paths get finer spatial resolution. Recording is thread safe, refining is not, it
+ * happens between iterations when no thread is recording.
+ */
+class GuidingTree{
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  bbox        Bounding box of the scene.
+    //! @param  max_memory  Memory budget of the tree in bytes, it bounds the number of nodes.
+    GuidingTree( const BBox& bbox , size_t max_memory );
+
+    //! @brief  Record the radiance arriving at a point from a direction.
+    //!
+    //! @param  p       The point in world space.
+    //! @param  dir     The normalized direction, pointing from the point.
+    //! @param  value   The radiance estimation divided by the pdf of sampling the direction.
+    void    Record( const Point& p , const Vector& dir , float value );
+
+    //! @brief  Get the directional tree learned at a point for sampling.
+    //!
+    //! @param  p       The point in world space.
+    //! @return         The directional tree, 'nullptr' if nothing was learned there.
+    const DirectionalTree*  GetSamplingTree( const Point& p ) const;
+
+    //! @brief  Estimate the radiance arriving at a point from a direction, based on what was learned.
+    //!
+    //! @param  p       The point in world space.
+    //! @param  dir     The normalized direction, pointing from the point.
+    //! @return         The estimated radiance, negative if nothing was learned at the point.
+    float   EstimateRadiance( const Point& p , const Vector& dir ) const;
+
+    //! @brief  Refine the tree at the end of a training iteration.
+    //!
+    //! The radiance learned in the iteration is used for sampling afterwards.
+    //!
+    //! @param  iteration   Index of the iteration, starting from zero. The number of samples per pixel is
+    //!                     supposed to double in each iteration.
+    void    Refine( unsigned iteration );
+
+    //! @brief  Number of leaves of the spatial tree.
+    unsigned    GetLeafCount() const;
+
+    //! @brief  Memory used by the directional trees in bytes.
+    size_t      GetMemoryUsage() const;
+
+private:
+    //! @brief  Leaf data of the spatial tree.
+    struct Leaf{
+        DirectionalTree             building;           /**< Tree recording radiance in the current iteration. */
+        DirectionalTree             sampling;           /**< Tree learned in the previous iteration for sampling. */
+        std::atomic<unsigned>       sampleCnt = { 0 };  /**< Number of samples recorded in the current iteration. */
+        unsigned                    samplingCnt = 0;    /**< Number of samples recorded in the sampling tree. */
+
+        Leaf() = default;
+        Leaf( const Leaf& leaf ) : building( leaf.building ) , sampling( leaf.sampling ) , sampleCnt( leaf.sampleCnt.load() ) , samplingCnt( leaf.samplingCnt ) {}
+    };
+
+    //! @brief  Node of the spatial tree.
+    struct Node{
+        unsigned    child[2] = { 0 };   /**< Index of the two children, zero for leaves. */
+        unsigned    axis = 0;           /**< Axis it splits along. */
+        unsigned    leaf = 0;           /**< Index of the leaf data, only valid for leaves. */
+    };
+
+    std::vector<Node>   m_nodes;        /**< Nodes of the spatial tree, the root is the first one. */
+    std::vector<Leaf>   m_leaves;       /**< Data of all leaves. */
+    Point               m_origin;       /**< Minimum corner of the cube bounding the scene. */
+    float               m_invSize;      /**< Reciprocal of the size of the cube. */
+    size_t              m_maxMemory;    /**< Memory budget in bytes. */
+
+    //! @brief  Find the leaf containing a point.
+    unsigned    lookup( const Point& p ) const;
+};
@@ -27,41 +27,326 @@
 #include "scatteringevent/scatteringevent.h"
 #include "medium/medium.h"
 #include "medium/phasefunction.h"
+#include "core/globalconfig.h"
+#include "sampler/random.h"
+#include "task/task.h"
 
 SORT_STATS_DEFINE_COUNTER(sTotalPathLength)
 SORT_STATS_DECLARE_COUNTER(sPrimaryRayCount)
+SORT_STATS_DEFINE_COUNTER(sGuidingLeafCount)
+SORT_STATS_DEFINE_COUNTER(sGuidingMemory)
 
 SORT_STATS_COUNTER("Path Tracing", "Primary Ray Count" , sPrimaryRayCount);
 SORT_STATS_AVG_COUNT("Path Tracing", "Average Length of Path", sTotalPathLength , sPrimaryRayCount);    // This also counts the case where ray hits sky
+SORT_STATS_COUNTER("Path Tracing", "Path Guiding Spatial Leaf Count" , sGuidingLeafCount);
+SORT_STATS_COUNTER("Path Tracing", "Path Guiding Memory (KB)" , sGuidingMemory);
+
+// Probability of sampling the bsdf instead of the guiding distribution at guided vertices.
+static constexpr float      GUIDING_BSDF_FRACTION = 0.5f;
+// Maximum number of vertices of a path recording radiance for path guiding, the rest are not recorded.
+static constexpr unsigned   GUIDING_MAX_VERTICES = 64;
+// Index of the first sample of training iterations, so that they don't share random numbers with rendering.
+static constexpr unsigned   GUIDING_FIRST_SAMPLE = 0x80000000u;
+
+// Number of samples per pixel to estimate pixels for russian roulette and splitting.
+static constexpr unsigned   ADRRS_ESTIMATE_SPP = 4;
+// Index of the first sample of pixel estimation.
+static constexpr unsigned   ADRRS_FIRST_SAMPLE = 0xC0000000u;
+// Radius of the box filter denoising the pixel estimation.
+static constexpr int        ADRRS_FILTER_RADIUS = 2;
+// Paths are killed or split once their expected contribution relative to the pixel is out of this window, the ratio
+// between the bounds is five, they are centered around one.
+static constexpr float      ADRRS_WINDOW_LOWER = 1.0f / 3.0f;
+static constexpr float      ADRRS_WINDOW_UPPER = 5.0f / 3.0f;
+// Maximum number of branches a path is split into at a vertex.
+static constexpr unsigned   ADRRS_MAX_SPLIT = 8;
+// Minimum probability for a path to survive russian roulette.
+static constexpr float      ADRRS_MIN_SURVIVAL = 0.05f;
+
+// Number of rows rendered by each task in a stage of pre-processing.
+static constexpr int        PREPASS_ROWS_PER_TASK = 16;
+
+// A vertex of a path continued by sampling a bsdf, the radiance arriving at it is recorded once the path is done.
+struct GuidingVertex{
+    Point       p;              // position of the vertex
+    Vector      wi;             // direction the path continues in
+    Spectrum    L;              // radiance gathered by the path before continuing
+    Spectrum    throughput;     // throughput of the path after continuing
+    float       pdf;            // pdf of sampling the direction
+};
+
+//! @brief  A task rendering rows of the image in a stage of pre-processing.
+class PrePassRows_Task : public Task {
+public:
+    //! @brief Constructor
+    //!
+    //! @param integrator   The integrator to be pre-processed.
+    //! @param scene        The scene to be evaluated.
+    //! @param first_sample Index of the first sample of pixels.
+    //! @param spp          Number of samples per pixel.
+    //! @param y0           The first row to be rendered.
+    //! @param y1           One past the last row to be rendered.
+    //! @param func         Function taking the coordinate of the pixel and the radiance of each sample.
+    PrePassRows_Task( PathTracing& integrator , const Scene& scene , unsigned int first_sample , unsigned int spp , int y0 , int y1 ,
+                      const std::function<void( int , int , const Spectrum& )>& func , const char* name , unsigned int priority ,
+                      const Task::Task_Container& dependencies ) :
+        Task( name , priority , dependencies ) , m_integrator(integrator) , m_scene(scene) , m_firstSample(first_sample) , m_spp(spp) ,
+        m_y0(y0) , m_y1(y1) , m_func(func) {}
+
+    //! @brief  Execute the task
+    void        Execute() override {
+        m_integrator.renderPrePass( m_scene , m_firstSample , m_spp , m_y0 , m_y1 , m_func );
+    }
+
+private:
+    PathTracing&    m_integrator;
+    const Scene&    m_scene;
+    unsigned int    m_firstSample;
+    unsigned int    m_spp;
+    int             m_y0;
+    int             m_y1;
+    std::function<void( int , int , const Spectrum& )>  m_func;
+};
+
+//! @brief  A task wrapping up a stage of pre-processing once all of its rows are rendered.
+class PreProcessStage_Task : public Task {
+public:
+    //! @brief Constructor
+    //!
+    //! @param integrator   The integrator to be pre-processed.
+    //! @param scene        The scene to be evaluated.
+    //! @param stage        Index of the stage.
+    PreProcessStage_Task( PathTracing& integrator , const Scene& scene , int stage , const char* name , unsigned int priority ,
+                          const Task::Task_Container& dependencies ) :
+        Task( name , priority , dependencies ) , m_integrator(integrator) , m_scene(scene) , m_stage(stage) {}
+
+    //! @brief  Execute the task
+    void        Execute() override {
+        m_integrator.finishPreProcessStage( m_scene , m_stage );
+    }
+
+private:
+    PathTracing&    m_integrator;
+    const Scene&    m_scene;
+    int             m_stage;
+};
+
+void PathTracing::PreProcess( const Scene& scene ){
+    // Mediums in the stack are allocated in an allocator of the integrator, the memory pool of this thread is
+    // recycled once it starts rendering.
+    if( !scene.GetPrimitivesVol().empty() && IS_PTR_VALID( scene.GetCamera() ) ){
+        MemoryAllocatorScope scope( m_cameraMediumMemory );
+        m_cameraMediumOrigin = scene.GetCamera()->GetEye();
+        scene.RestoreMediumStack( m_cameraMediumOrigin , m_cameraMediumStack );
+    }
+    m_cameraMediumCached = true;
+
+    if( m_pathGuiding )
+        m_guidingTree = std::make_unique<GuidingTree>( scene.GetBBox() , (size_t)std::max( 1 , m_guidingMemory ) << 20 );
+
+    schedulePreProcessStage( scene , 0 );
+}
+
+void PathTracing::schedulePreProcessStage( const Scene& scene , int stage ){
+    const auto guiding_iterations = m_pathGuiding ? m_guidingIterations : 0;
+    const auto estimation = stage == guiding_iterations && m_adrrs;
+    if( stage >= guiding_iterations && !estimation )
+        return;
+
+    const auto width = (int)g_resultResollution[0];
+    const auto height = (int)g_resultResollution[1];
+
+    std::function<void( int , int , const Spectrum& )> func = []( int x , int y , const Spectrum& li ){};
+    auto first_sample = ADRRS_FIRST_SAMPLE;
+    auto spp = ADRRS_ESTIMATE_SPP;
+    if( estimation ){
+        // each task writes to its own rows, there is no need for any lock
+        m_pixelEstimateSamples.assign( width * height , 0.0f );
+        func = [this,width]( int x , int y , const Spectrum& li ){
+            m_pixelEstimateSamples[ y * width + x ] += li.GetIntensity() / ADRRS_ESTIMATE_SPP;
+        };
+    }else{
+        m_guidingTraining = true;
+        spp = 1u << stage;
+        first_sample = GUIDING_FIRST_SAMPLE + spp - 1;
+    }
+
+    // The order of recording changes the learned radiance slightly due to floating point precision, all rows are
+    // rendered in a single task in deterministic mode.
+    const auto rows_per_task = g_deterministic ? height : PREPASS_ROWS_PER_TASK;
+    const auto priority = GetCurrentTask()->GetPriority();
+    const auto name = estimation ? "Pixel estimation" : "Path guiding training";
+    Task::Task_Container rows;
+    for( auto y = 0 ; y < height ; y += rows_per_task )
+        rows.insert( SCHEDULE_SUB_TASK<PrePassRows_Task>( name , priority , {} , *this , scene , first_sample , spp , y , std::min( height , y + rows_per_task ) , func ) );
+    SCHEDULE_SUB_TASK<PreProcessStage_Task>( "Pre-processing stage" , priority , rows , *this , scene , stage );
+}
+
+void PathTracing::finishPreProcessStage( const Scene& scene , int stage ){
+    const auto guiding_iterations = m_pathGuiding ? m_guidingIterations : 0;
+    if( stage < guiding_iterations ){
+        m_guidingTree->Refine( stage );
+
+        if( stage == guiding_iterations - 1 ){
+            m_guidingTraining = false;
+
+            SORT_STATS(sGuidingLeafCount = m_guidingTree->GetLeafCount());
+            SORT_STATS(sGuidingMemory = m_guidingTree->GetMemoryUsage() / 1024);
+        }
+    }else{
+        SORT_PROFILE("Pixel estimation filtering");
+
+        const auto width = (int)g_resultResollution[0];
+        const auto height = (int)g_resultResollution[1];
+
+        // The estimation is very noisy with a few samples, it is smoothed by a separable box filter.
+        std::vector<float> smoothed( width * height , 0.0f );
+        std::vector<float> estimate( width * height , 0.0f );
+        for( auto pass = 0 ; pass < 2 ; ++pass ){
+            const auto& src = pass == 0 ? m_pixelEstimateSamples : smoothed;
+            auto& dst = pass == 0 ? smoothed : estimate;
+            for( auto y = 0 ; y < height ; ++y ){
+                for( auto x = 0 ; x < width ; ++x ){
+                    auto total = 0.0f;
+                    auto cnt = 0;
+                    for( auto k = -ADRRS_FILTER_RADIUS ; k <= ADRRS_FILTER_RADIUS ; ++k ){
+                        const auto sx = pass == 0 ? x + k : x;
+                        const auto sy = pass == 0 ? y : y + k;
+                        if( sx < 0 || sx >= width || sy < 0 || sy >= height )
+                            continue;
+                        total += src[ sy * width + sx ];
+                        ++cnt;
+                    }
+                    dst[ y * width + x ] = total / cnt;
+                }
+            }
+        }
+        m_pixelEstimateWidth = width;
+        m_pixelEstimate = std::move( estimate );
+        m_pixelEstimateSamples = std::vector<float>();
+    }
+
+    schedulePreProcessStage( scene , stage + 1 );
+}
+
+void PathTracing::renderPrePass( const Scene& scene , unsigned first_sample , unsigned spp , int y0 , int y1 , const std::function<void( int , int , const Spectrum& )>& func ){
+    const auto camera = scene.GetCamera();
+    const auto width = (int)g_resultResollution[0];
+
+    RandomSampler sampler;
+    SampleStreamScope sample_stream( &sampler );
+    PixelSample ps;
+    for( auto y = y0 ; y < y1 ; ++y ){
+        for( auto x = 0 ; x < width ; ++x ){
+            sampler.StartPixel( x , y , first_sample );
+            for( auto k = 0u ; k < spp ; ++k ){
+                SORT_CLEAR_MEMPOOL();
+                sampler.StartSample( k );
+
+                ps.img_u = sort_canonical();
+                ps.img_v = sort_canonical();
+                ps.dof_u = sort_canonical();
+                ps.dof_v = sort_canonical();
+                ps.pixel_x = x;
+                ps.pixel_y = y;
+                func( x , y , Li( camera->GenerateRay( (float)x , (float)y , ps ) , ps , scene ) );
+            }
+        }
+    }
+}
+
+float PathTracing::pixelEstimate( const PixelSample& ps ) const{
+    if( m_pixelEstimate.empty() || ps.pixel_x < 0 || ps.pixel_y < 0 )
+        return 0.0f;
+    const auto height = (int)m_pixelEstimate.size() / m_pixelEstimateWidth;
+    return m_pixelEstimate[ std::min( ps.pixel_y , height - 1 ) * m_pixelEstimateWidth + std::min( ps.pixel_x , m_pixelEstimateWidth - 1 ) ];
+}
+
+Spectrum PathTracing::sampleContinuation( const ScatteringEvent& se , const Vector& wo , const Point& p , Vector& wi , float& pdf ) const{
+    const auto guiding = ( m_guidingTree && !se.HasDeltaBxdf() ) ? m_guidingTree->GetSamplingTree( p ) : nullptr;
+    if( !guiding )
+        return se.Sample_BSDF( wo , wi , BsdfSample(true) , pdf );
+
+    // One-sample MIS, the direction is sampled from the mixture of the bsdf and the learned incident radiance.
+    Spectrum f;
+    auto bsdf_pdf = 0.0f;
+    auto guiding_pdf = 0.0f;
+    if( sort_canonical() < GUIDING_BSDF_FRACTION ){
+        f = se.Sample_BSDF( wo , wi , BsdfSample(true) , bsdf_pdf );
+        if( bsdf_pdf > 0.0f )
+            guiding_pdf = guiding->Pdf( wi );
+    }else{
+        const auto u = sort_canonical();
+        const auto v = sort_canonical();
+        wi = guiding->Sample( Vector2f( u , v ) , guiding_pdf );
+        f = se.Evaluate_BSDF( wo , wi );
+        bsdf_pdf = se.Pdf_BSDF( wo , wi );
+    }
+    pdf = GUIDING_BSDF_FRACTION * bsdf_pdf + ( 1.0f - GUIDING_BSDF_FRACTION ) * guiding_pdf;
+    return f;
+}
 
 Spectrum PathTracing::Li( const Ray& ray , const PixelSample& ps , const Scene& scene) const{
 	MediumStack ms;
-	scene.RestoreMediumStack(ray.m_Ori, ms);
+	restoreMediumStack(ray.m_Ori, scene, ms);
+
+    return li( ray , ps , scene , 0 , false , 0 , false , ms , 1.0f );
+}
+
+void PathTracing::restoreMediumStack( const Point& p , const Scene& scene , MediumStack& ms ) const{
+    if( !m_cameraMediumCached ){
+        scene.RestoreMediumStack( p , ms );
+        return;
+    }
 
-    return li( ray , ps , scene , 0 , false , 0 , false , ms );
+    // there is no medium at all without volumes in the scene
+    if( scene.GetPrimitivesVol().empty() )
+        return;
+
+    // Rays of pinhole cameras all start from the viewing point. Rays starting from other points on the lens share
+    // the same medium stack as long as there is no surface between the point and the viewing point.
+    const auto delta = p - m_cameraMediumOrigin;
+    const auto dist = delta.Length();
+    if( dist > 0.0f ){
+        SurfaceInteraction intersection;
+        if( scene.GetIntersect( Ray( m_cameraMediumOrigin , delta / dist , 0 , 0.0f , dist ) , intersection ) ){
+            scene.RestoreMediumStack( p , ms );
+            return;
+        }
+    }
+    ms = m_cameraMediumStack;
 }
 
-Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene& scene , int bounces , bool indirectOnly , int bssrdfBounces , bool replaceSSS , MediumStack& ms ) const{
+Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene& scene , int bounces , bool indirectOnly , int bssrdfBounces , bool replaceSSS , MediumStack& ms , const Spectrum& weight ) const{
     SORT_PROFILE("Path tracing");
     SORT_STATS(++sPrimaryRayCount);
 
     Spectrum    L = 0.0f;
     Spectrum    throughput = 1.0f;
 
+    // vertices recording radiance are only needed in training iterations of path guiding
+    auto guiding_vertices = m_guidingTraining ? SORT_MALLOC_ARRAY(GuidingVertex, GUIDING_MAX_VERTICES) : nullptr;
+    auto guiding_vertex_cnt = 0u;
+
     int local_bounce = 0;
     auto    r = ray;
     while(true){
         // This introduces bias in the algorithm. 'max_recursive_depth' could be set very large to reduce the side-effect.
         if( bounces >= max_recursive_depth )
-            return L;
+            break;
 
         SORT_STATS(++sTotalPathLength);
 
         // get the intersection between the ray and the scene if it's a light , accumulate the radiance and break
         SurfaceInteraction inter;
         if( !scene.GetIntersect( r , inter ) ){
-            if( 0 == local_bounce )
-                return !indirectOnly ? scene.Le( r ) : 0.0f;
+            if( 0 == local_bounce ){
+                if( indirectOnly )
+                    return 0.0f;
+                const auto le = scene.Le( r );
+                RecordLightGroupAOV( ps.aov , scene.GetSkyLight() , weight * le );
+                return le;
+            }
             break;
         }
 
@@ -84,8 +369,12 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
 
             // evaluate direct light illumination
             float light_pdf = 0.0f;
-            const auto  light = scene.SampleLight(sort_canonical(), &light_pdf);
-            L += throughput * EvaluateDirect(pMi->intersect, pMi->phaseFunction, -r.m_Dir, scene, light, ms) / light_pdf;
+            const auto  light = scene.SampleLight(pMi->intersect, Vector(0.0f), sort_canonical(), &light_pdf);
+            if( light && light_pdf > 0.0f ){
+                const auto direct = throughput * EvaluateDirect(pMi->intersect, pMi->phaseFunction, -r.m_Dir, scene, light, ms) / light_pdf;
+                RecordLightGroupAOV( ps.aov , light , weight * direct );
+                L += direct;
+            }
 
             // update path weight
             throughput *= pf / pdf;
@@ -111,8 +400,11 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
             continue;
         }
 
-        if( local_bounce == 0 && !indirectOnly ) 
-            L += inter.Le(-r.m_Dir);
+        if( local_bounce == 0 && !indirectOnly ){
+            const auto le = inter.Le(-r.m_Dir);
+            RecordLightGroupAOV( ps.aov , inter.primitive ? inter.primitive->GetLight() : nullptr , weight * le );
+            L += le;
+        }
         
         // make sure there is intersected primitive
         sAssert(IS_PTR_VALID(inter.primitive), INTEGRATOR );
@@ -128,6 +420,9 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
         ScatteringEvent se(inter, seFlag);
         material->UpdateScatteringEvent(se);
 
+        if( local_bounce == 0 && !indirectOnly )
+            RecordSurfaceAOV( ps.aov , r , inter , se );
+
         SE_Flag scattering_type_flag;
         auto pdf_scattering_type = se.SampleScatteringType(scattering_type_flag);
 
@@ -136,9 +431,12 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
             auto        light_pdf = 0.0f;
             const auto  light_sample = LightSample(true);
             const auto  bsdf_sample = BsdfSample(true);
-            const auto  light = scene.SampleLight( light_sample.t , &light_pdf );
-            if( light_pdf > 0.0f )
-                L += throughput * EvaluateDirect( se , r , scene, light , light_sample , bsdf_sample , material , ms ) / light_pdf / pdf_scattering_type;
+            const auto  light = scene.SampleLight( inter.intersect , inter.normal , light_sample.t , &light_pdf );
+            if( light && light_pdf > 0.0f ){
+                const auto direct = throughput * EvaluateDirect( se , r , scene, light , light_sample , bsdf_sample , material , ms ) / light_pdf / pdf_scattering_type;
+                RecordLightGroupAOV( ps.aov , light , weight * direct );
+                L += direct;
+            }
         }else if(scattering_type_flag & SE_EVALUATE_BSSRDF) {
             BSSRDFIntersections bssrdf_inter;
             float               bssrdf_pdf = 0.0f;
@@ -150,16 +448,16 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
 
                 for( auto i = 0u ; i < bssrdf_inter.cnt ; ++i ){
                     const auto& pInter = bssrdf_inter.intersections[i];
-                    const auto& intersection = pInter->intersection;
+                    const auto& intersection = pInter.intersection;
 
                     // Create a temporary lambert model to account the cos factor
                     // Fresnel is totally ignored here due to two reasons, the lack of visual differences and most importantly,
                     // there will be a discontinuity introduced when mean free path approaches zero.
-                    ScatteringEvent se(pInter->intersection);
+                    ScatteringEvent se(pInter.intersection);
                     se.AddBxdf( SORT_MALLOC(Lambert)( WHITE_SPECTRUM , FULL_WEIGHT , DIR_UP ) );
 
                     // Accumulate the contribution from direct illumination
-                    total_bssrdf += SampleOneLight( se , r , intersection , scene , material , ms ) * pInter->weight;
+                    total_bssrdf += SampleOneLight( se , r , intersection , scene , material , ms ) * pInter.weight;
                 }
                 
                 L += total_bssrdf * throughput / pdf_scattering_type / bssrdf_pdf;
@@ -173,30 +471,73 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
             break;
 
         throughput /= pdf_scattering_type;
+        auto adrrs = false;
         if( scattering_type_flag & SE_EVALUATE_BXDF ){
             // sample the next direction using bsdf
             float       path_pdf;
             Vector      wi;
-            Spectrum f;
-            BsdfSample  _bsdf_sample = BsdfSample(true);
-            f = se.Sample_BSDF( -r.m_Dir , wi , _bsdf_sample , path_pdf);
+            const auto  f = sampleContinuation( se , -r.m_Dir , inter.intersect , wi , path_pdf );
             if( ( f.IsBlack() || path_pdf == 0.0f ) )
                 break;
 
             // as long as the ray is passing through the surface, it is necessary to update the medium stack.
-            const auto interaction_flag = update_interaction_flag(dot(wi,inter.gnormal), dot(-r.m_Dir,inter.gnormal));
-            if (SE_Interaction::SE_REFLECTION != interaction_flag) {
-                MediumInteraction mi;
-                mi.intersect = inter.intersect;
-                mi.mesh = inter.primitive->GetMesh();
-                material->UpdateMediumStack(mi, interaction_flag, ms);
-            }
+            const auto update_medium_stack = [&]( const Vector& dir , MediumStack& stack ){
+                const auto interaction_flag = update_interaction_flag(dot(dir,inter.gnormal), dot(-r.m_Dir,inter.gnormal));
+                if (SE_Interaction::SE_REFLECTION != interaction_flag) {
+                    MediumInteraction mi;
+                    mi.intersect = inter.intersect;
+                    mi.mesh = inter.primitive->GetMesh();
+                    material->UpdateMediumStack(mi, interaction_flag, stack);
+                }
+            };
 
             // update path weight
+            const auto vertex_throughput = throughput;
             throughput *= f / path_pdf;
 
             if( 0.0f == throughput.GetIntensity() )
                 break;
+
+            // Adjoint-driven russian roulette and splitting, the expected contribution of the path is compared with the
+            // estimated pixel. The radiance arriving at the vertex is estimated by path guiding if available, otherwise
+            // it is assumed to be similar to the pixel, in which case only the throughput matters.
+            const auto pixel_estimate = pixelEstimate( ps );
+            if( pixel_estimate > 0.0f ){
+                adrrs = true;
+
+                const auto learned = m_guidingTree ? m_guidingTree->EstimateRadiance( inter.intersect , wi ) : -1.0f;
+                const auto incident = learned >= 0.0f ? learned : pixel_estimate;
+                const auto ratio = ( weight * throughput ).GetIntensity() * incident / pixel_estimate;
+                if( ratio < ADRRS_WINDOW_LOWER ){
+                    const auto survival = std::max( ratio , ADRRS_MIN_SURVIVAL );
+                    if( sort_canonical() >= survival )
+                        break;
+                    throughput /= survival;
+                }else if( ratio > ADRRS_WINDOW_UPPER ){
+                    // All branches share the throughput evenly, the other branches are evaluated recursively.
+                    const auto split = std::min( (unsigned)std::ceil( ratio ) , ADRRS_MAX_SPLIT );
+                    throughput /= (float)split;
+
+                    for( auto i = 1u ; i < split ; ++i ){
+                        float       branch_pdf;
+                        Vector      branch_wi;
+                        const auto  branch_f = sampleContinuation( se , -r.m_Dir , inter.intersect , branch_wi , branch_pdf );
+                        if( branch_f.IsBlack() || branch_pdf == 0.0f )
+                            continue;
+
+                        MediumStack branch_ms = ms;
+                        update_medium_stack( branch_wi , branch_ms );
+
+                        const auto branch_throughput = vertex_throughput * branch_f / ( branch_pdf * split );
+                        L += branch_throughput * li( Ray( inter.intersect , branch_wi , 0 , 0.0001f ) , ps , scene , bounces + 1 , true , bssrdfBounces , false , branch_ms , weight * branch_throughput );
+                    }
+                }
+            }
+
+            update_medium_stack( wi , ms );
+
+            if( guiding_vertices && guiding_vertex_cnt < GUIDING_MAX_VERTICES )
+                guiding_vertices[guiding_vertex_cnt++] = { inter.intersect , wi , L , throughput , path_pdf };
             
             r.m_Ori = inter.intersect;
             r.m_Dir = wi;
@@ -217,31 +558,32 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
 
                 for( auto i = 0u ; i < bssrdf_inter.cnt ; ++i ){
                     const auto& pInter = bssrdf_inter.intersections[i];
-                    const auto& intersection = pInter->intersection;
+                    const auto& intersection = pInter.intersection;
 
                     // Create a temporary lambert model to account the cos factor
                     // Fresnel is totally ignored here due to two reasons
                     //  - the lack of visual differences 
                     //  - more importantly, there will be a discontinuity introduced when mean free path approaches zero.
-                    ScatteringEvent se(pInter->intersection, SE_Flag( SE_EVALUATE_ALL | SE_REPLACE_BSSRDF ));
+                    ScatteringEvent se(pInter.intersection, SE_Flag( SE_EVALUATE_ALL | SE_REPLACE_BSSRDF ));
                     se.AddBxdf( SORT_MALLOC(Lambert)( WHITE_SPECTRUM , FULL_WEIGHT , DIR_UP ) );
 
                     // Counts the light from indirect illumination recursively
                     float pdf = 0.0f;
                     Vector wi;
                     Spectrum f = se.Sample_BSDF( -r.m_Dir, wi, BsdfSample(true), pdf);
-                    if (!f.IsBlack() && pdf > 0.0f && !pInter->weight.IsBlack()) {
+                    if (!f.IsBlack() && pdf > 0.0f && !pInter.weight.IsBlack()) {
                         MediumStack ms_copy = ms;
-                        total_bssrdf += li(Ray(intersection.intersect, wi, 0, 0.0001f), PixelSample(), scene, bounces + 1, true, bssrdfBounces + 1, true, ms_copy) * f * pInter->weight / pdf;
+                        const auto bssrdf_weight = f * pInter.weight / pdf;
+                        total_bssrdf += li(Ray(intersection.intersect, wi, 0, 0.0001f), ps, scene, bounces + 1, true, bssrdfBounces + 1, true, ms_copy, weight * throughput * bssrdf_weight / bssrdf_pdf) * bssrdf_weight;
                     }
                 }
                 
                 L += total_bssrdf * throughput / bssrdf_pdf;
             }
-            return L;
+            break;
         }
 
-        if( bounces > 3 && throughput.GetMaxComponent() < 0.1f ){
+        if( !adrrs && bounces > 3 && throughput.GetMaxComponent() < 0.1f ){
             auto continueProperbility = std::max( 0.05f , 1.0f - throughput.GetMaxComponent() );
             if( sort_canonical() < continueProperbility )
                 break;
@@ -254,5 +596,15 @@ Spectrum PathTracing::li( const Ray& ray , const PixelSample& ps , const Scene&
         replaceSSS = false;
     }
 
+    // The radiance arriving at each vertex is what the rest of the path gathers, divided by the throughput up to it.
+    for( auto i = 0u ; i < guiding_vertex_cnt ; ++i ){
+        const auto& vertex = guiding_vertices[i];
+        const auto  radiance = L - vertex.L;
+        Spectrum    incident;
+        for( auto c = 0 ; c < 3 ; ++c )
+            incident[c] = vertex.throughput[c] > 0.0f ? radiance[c] / vertex.throughput[c] : 0.0f;
+        m_guidingTree->Record( vertex.p , vertex.wi , incident.GetIntensity() / vertex.pdf );
+    }
+
     return L;
 }
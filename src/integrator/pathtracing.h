@@ -17,7 +17,13 @@
 
 #pragma once
 
+#include <functional>
 #include "integrator.h"
+#include "pathguiding.h"
+#include "core/memory.h"
+#include "medium/medium.h"
+
+class ScatteringEvent;
 
 //! @brief  The core of path tracing algorithm, the most commonly used algorithm in SORT.
 /**
@@ -36,22 +42,117 @@ public:
     //! @return                 The radiance along the opposite direction that the ray points to.
     Spectrum    Li( const Ray& ray , const PixelSample& ps , const Scene& scene) const override;
 
+    //! @brief  Learn the incident radiance in the scene for path guiding and estimate pixels for russian roulette.
+    //!
+    //! The medium stack at the camera is restored first, it is shared by all camera rays.
+    //! A few training iterations are rendered with the number of samples doubling in each one. The radiance
+    //! recorded in one iteration guides the paths in the next one. Then a few samples per pixel are rendered
+    //! to estimate the pixels, which drives russian roulette and splitting.
+    //! Each of these stages is rendered in sub tasks of the pre-rendering task, rendering waits for all of them.
+    //!
+    //! @param  scene           The scene to be evaluated.
+    void    PreProcess( const Scene& scene ) override;
+
     //! @brief      Serializing data from stream
     //!
     //! @param      Stream where the serialization data comes from. Depending on different situation, it could come from different places.
     void    Serialize( IStreamBase& stream ) override {
         Integrator::Serialize( stream );
         stream >> m_maxBouncesInBSSRDFPath;
+        stream >> m_pathGuiding >> m_guidingIterations >> m_guidingMemory;
+        stream >> m_adrrs;
     }
 
     SORT_STATS_ENABLE( "Path Tracing" )
 
+    friend class PrePassRows_Task;
+    friend class PreProcessStage_Task;
+
 private:
     // Maximum bounces supported in BSSRDF path.
     // BSSRDF solutions usually makes aggressive approximations resulting in less accuracy, multiple BSSRDF bounces will even make it worse.
     // Most importantly, it kills the performance and introduces quite some fireflies with bounces more than 2.
     int     m_maxBouncesInBSSRDFPath;
 
+    // Path guiding samples directions based on the incident radiance learned in training iterations before rendering.
+    bool    m_pathGuiding = false;
+    // Number of training iterations, the first one takes one sample per pixel.
+    int     m_guidingIterations = 5;
+    // Memory budget of the guiding tree in mega bytes.
+    int     m_guidingMemory = 64;
+    // Whether paths are recording radiance in the guiding tree.
+    bool    m_guidingTraining = false;
+    // The spatial-directional tree learning the incident radiance.
+    std::unique_ptr<GuidingTree>    m_guidingTree;
+
+    // Adjoint-driven russian roulette and splitting, paths contributing little to the pixel are killed early and
+    // important ones are split, based on the pixel estimated before rendering and the radiance learned by path guiding.
+    bool    m_adrrs = false;
+    // Estimation of pixels for russian roulette and splitting.
+    std::vector<float>  m_pixelEstimate;
+    // Samples of pixels accumulated before they are filtered into the estimation.
+    std::vector<float>  m_pixelEstimateSamples;
+    // Width of the pixel estimation.
+    int     m_pixelEstimateWidth = 0;
+
+    // Medium stack at the viewing point of the camera, restored once before rendering.
+    MediumStack         m_cameraMediumStack;
+    // Viewing point where the medium stack of the camera is restored.
+    Point               m_cameraMediumOrigin;
+    // Whether the medium stack of the camera is restored.
+    bool                m_cameraMediumCached = false;
+    // Memory of mediums in the medium stack of the camera, it outlives samples.
+    MemoryAllocator     m_cameraMediumMemory;
+
+    //! @brief  Restore the medium stack at the origin of a camera ray.
+    //!
+    //! @param  p               The origin of the camera ray.
+    //! @param  scene           The scene to be evaluated.
+    //! @param  ms              The medium stack to be populated.
+    void    restoreMediumStack( const Point& p , const Scene& scene , MediumStack& ms ) const;
+
+    //! @brief  Schedule a stage of pre-processing in sub tasks of the current task.
+    //!
+    //! Rows of the image are rendered in separated sub tasks, the next stage is scheduled once all of them are done.
+    //!
+    //! @param  scene           The scene to be evaluated.
+    //! @param  stage           Index of the stage, training iterations come first, followed by pixel estimation.
+    void    schedulePreProcessStage( const Scene& scene , int stage );
+
+    //! @brief  Wrap up a stage of pre-processing after all of its rows are rendered.
+    //!
+    //! @param  scene           The scene to be evaluated.
+    //! @param  stage           Index of the stage.
+    void    finishPreProcessStage( const Scene& scene , int stage );
+
+    //! @brief  Render rows of the image with a few samples per pixel before rendering.
+    //!
+    //! @param  scene           The scene to be evaluated.
+    //! @param  first_sample    Index of the first sample of pixels, it keeps the random numbers apart from rendering.
+    //! @param  spp             Number of samples per pixel.
+    //! @param  y0              The first row to be rendered.
+    //! @param  y1              One past the last row to be rendered.
+    //! @param  func            Function taking the coordinate of the pixel and the radiance of each sample.
+    void    renderPrePass( const Scene& scene , unsigned first_sample , unsigned spp , int y0 , int y1 , const std::function<void( int , int , const Spectrum& )>& func );
+
+    //! @brief  Get the estimated pixel a sample belongs to.
+    //!
+    //! @param  ps              Pixel sample.
+    //! @return                 The estimated intensity of the pixel, zero if there is no estimation.
+    float   pixelEstimate( const PixelSample& ps ) const;
+
+    //! @brief  Sample the direction to continue a path at a surface.
+    //!
+    //! The bsdf is importance sampled, mixed with the learned incident radiance if path guiding is enabled.
+    //!
+    //! @param  se              The scattering event at the surface.
+    //! @param  wo              The direction the path comes from, pointing away from the surface.
+    //! @param  p               The position of the surface.
+    //! @param  wi              The sampled direction.
+    //! @param  pdf             The pdf w.r.t solid angle of sampling the direction.
+    //! @return                 The bsdf value of the sampled direction.
+    Spectrum    sampleContinuation( const ScatteringEvent& se , const Vector& wo , const Point& p , Vector& wi , float& pdf ) const;
+
     //! @brief  Evaluate the radiance along a specific direction.
     //!
     //! @param  ray             The ray to be tested with.
@@ -62,6 +163,7 @@ private:
     //! @param  bssrdfBounces   Bounces on BSSRDF surfaces in the path.
     //! @param  replaceSSS      Whether to replace SSS with lambert.
     //! @param  ms              Medium stack during radiance evaluation.
+    //! @param  weight          Throughput of the path before the ray, it scales radiance recorded in light groups and drives russian roulette and splitting.
     //! @return                 The radiance along the opposite direction that the ray points to.
-    Spectrum    li( const Ray& ray , const PixelSample& ps , const Scene& scene , int bounces , bool indirectOnly , int bssrdfBounces , bool replaceSSS , MediumStack& ms ) const;
+    Spectrum    li( const Ray& ray , const PixelSample& ps , const Scene& scene , int bounces , bool indirectOnly , int bssrdfBounces , bool replaceSSS , MediumStack& ms , const Spectrum& weight ) const;
 };
@@ -0,0 +1,192 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#include <cmath>
+#include "vcm.h"
+#include "core/globalconfig.h"
+#include "core/memory.h"
+#include "sampler/random.h"
+#include "task/task.h"
+
+SORT_STATS_DEFINE_COUNTER(sLightVertexCount)
+SORT_STATS_DEFINE_COUNTER(sMergingPassCount)
+
+SORT_STATS_COUNTER("Vertex Connection and Merging", "Light Vertices for Merging" , sLightVertexCount);
+SORT_STATS_AVG_COUNT("Vertex Connection and Merging", "Average Light Vertices per Pass" , sLightVertexCount , sMergingPassCount);
+
+// Index of the first sample of light paths for merging, so that they don't share random numbers with rendering.
+static constexpr unsigned   VCM_FIRST_SAMPLE = 0x80000000u;
+// Number of rows of light paths traced by each task.
+static constexpr int        VCM_ROWS_PER_TASK = 16;
+
+//! @brief  A task tracing light paths of rows of pixels for merging.
+class LightPathRows_Task : public Task {
+public:
+    //! @brief Constructor
+    //!
+    //! @param integrator   The integrator the light vertices belong to.
+    //! @param scene        The rendering scene.
+    //! @param pass         Index of the pass.
+    //! @param y0           The first row to be traced.
+    //! @param y1           One past the last row to be traced.
+    LightPathRows_Task( VertexConnectionMerging& integrator , const Scene& scene , unsigned int pass , int y0 , int y1 ,
+                        const char* name , unsigned int priority , const Task::Task_Container& dependencies ) :
+        Task( name , priority , dependencies ) , m_integrator(integrator) , m_scene(scene) , m_pass(pass) , m_y0(y0) , m_y1(y1) {}
+
+    //! @brief  Execute the task
+    void        Execute() override {
+        m_integrator.traceLightPaths( m_scene , m_pass , m_y0 , m_y1 );
+    }
+
+private:
+    VertexConnectionMerging&    m_integrator;
+    const Scene&                m_scene;
+    unsigned int                m_pass;
+    int                         m_y0;
+    int                         m_y1;
+};
+
+//! @brief  A task building the hash grid once all light paths of the pass are traced.
+class MergingGrid_Task : public Task {
+public:
+    //! @brief Constructor
+    //!
+    //! @param integrator   The integrator the light vertices belong to.
+    //! @param radius       Merging radius of the pass.
+    MergingGrid_Task( VertexConnectionMerging& integrator , float radius , const char* name , unsigned int priority ,
+                      const Task::Task_Container& dependencies ) :
+        Task( name , priority , dependencies ) , m_integrator(integrator) , m_radius(radius) {}
+
+    //! @brief  Execute the task
+    void        Execute() override {
+        m_integrator.buildMergingGrid( m_radius );
+    }
+
+private:
+    VertexConnectionMerging&    m_integrator;
+    float                       m_radius;
+};
+
+void VertexConnectionMerging::PreProcess( const Scene& scene ){
+    const auto& bbox = scene.GetBBox();
+    m_baseRadius = m_radiusFactor * ( bbox.m_Max - bbox.m_Min ).Length() * 0.5f;
+}
+
+void VertexConnectionMerging::PrePass( const Scene& scene , unsigned pass ){
+    const auto width = (int)g_resultResollutionWidth;
+    const auto height = (int)g_resultResollutionHeight;
+
+    // The kernel area shrinks by (i+1)^(alpha-1) so that both bias and variance vanish as passes accumulate.
+    const auto radius = m_baseRadius / std::pow( (float)( pass + 1 ) , 0.5f * ( 1.0f - m_radiusAlpha ) );
+    const auto light_path_cnt = (float)( width * height );
+    const auto eta = PI * radius * radius * light_path_cnt;
+    m_misVmWeightFactor = MIS( (double)eta );
+    m_misVcWeightFactor = MIS( 1.0 / eta );
+    m_vmNormalization = 1.0f / eta;
+
+    // Each pixel traces a light path in sub tasks, vertices of a row are kept together so that the order doesn't depend on threads.
+    m_rowVertices.assign( height , std::vector<MergingVertex>() );
+    m_rowPoints.assign( height , std::vector<Point>() );
+
+    const auto priority = GetCurrentTask()->GetPriority();
+    Task::Task_Container rows;
+    for( auto y = 0 ; y < height ; y += VCM_ROWS_PER_TASK )
+        rows.insert( SCHEDULE_SUB_TASK<LightPathRows_Task>( "Tracing light paths for merging" , priority , {} , *this , scene , pass , y , std::min( height , y + VCM_ROWS_PER_TASK ) ) );
+    SCHEDULE_SUB_TASK<MergingGrid_Task>( "Building hash grid for merging" , priority , rows , *this , radius );
+}
+
+void VertexConnectionMerging::traceLightPaths( const Scene& scene , unsigned pass , int y0 , int y1 ){
+    const auto width = (int)g_resultResollutionWidth;
+
+    RandomSampler sampler;
+    SampleStreamScope sample_stream( &sampler );
+    std::vector<BDPT_Vertex> light_path;
+    for( auto y = y0 ; y < y1 ; ++y ){
+        for( auto x = 0 ; x < width ; ++x ){
+            SORT_CLEAR_MEMPOOL();
+            sampler.StartPixel( x , y , VCM_FIRST_SAMPLE + pass );
+            sampler.StartSample( 0 );
+
+            float pdf;
+            light_path.clear();
+            if( !_TraceLightPath( light_path , pdf , false , scene ) )
+                continue;
+
+            // Paths can't be merged at vertices of delta bxdfs, since their bxdfs are zero for all other directions.
+            for( const auto& vert : light_path ){
+                if( vert.se->HasDeltaBxdf() )
+                    continue;
+
+                MergingVertex mv;
+                mv.wi = vert.wi;
+                mv.throughput = vert.throughput;
+                mv.vcm = vert.vcm;
+                mv.vm = vert.vm;
+                mv.rr = vert.rr;
+                mv.depth = vert.depth;
+                m_rowVertices[y].push_back( mv );
+                m_rowPoints[y].push_back( vert.p );
+            }
+        }
+    }
+}
+
+void VertexConnectionMerging::buildMergingGrid( float radius ){
+    m_lightVertices.clear();
+    std::vector<Point> points;
+    for( auto y = 0u ; y < m_rowVertices.size() ; ++y ){
+        m_lightVertices.insert( m_lightVertices.end() , m_rowVertices[y].begin() , m_rowVertices[y].end() );
+        points.insert( points.end() , m_rowPoints[y].begin() , m_rowPoints[y].end() );
+    }
+    m_rowVertices.clear();
+    m_rowPoints.clear();
+    m_grid.Build( std::move( points ) , radius );
+
+    SORT_STATS(sLightVertexCount += m_lightVertices.size());
+    SORT_STATS(++sMergingPassCount);
+}
+
+Spectrum VertexConnectionMerging::_MergeVertices( const BDPT_Vertex& eye_vertex ) const{
+    if( eye_vertex.se->HasDeltaBxdf() )
+        return 0.0f;
+
+    Spectrum li;
+    m_grid.Query( eye_vertex.p , [&]( unsigned index ){
+        const auto& light_vertex = m_lightVertices[index];
+        if( light_vertex.depth + eye_vertex.depth > max_recursive_depth )
+            return;
+
+        // The cosine at the eye vertex is part of the photon density already, it is taken out of the bsdf.
+        const auto cosAtEyeVertex = absDot( eye_vertex.n , light_vertex.wi );
+        if( cosAtEyeVertex == 0.0f )
+            return;
+        const auto bsdf = eye_vertex.se->Evaluate_BSDF( eye_vertex.wi , light_vertex.wi ) / cosAtEyeVertex;
+        if( bsdf.IsBlack() )
+            return;
+
+        // The light path would have continued with the russian roulette of the light vertex.
+        const auto eye_bsdf_pdfw = eye_vertex.se->Pdf_BSDF( eye_vertex.wi , light_vertex.wi ) * light_vertex.rr;
+        const auto eye_bsdf_rev_pdfw = eye_vertex.se->Pdf_BSDF( light_vertex.wi , eye_vertex.wi ) * eye_vertex.rr;
+
+        const double mis_light = light_vertex.vcm * m_misVcWeightFactor + light_vertex.vm * MIS( eye_bsdf_pdfw );
+        const double mis_eye = eye_vertex.vcm * m_misVcWeightFactor + eye_vertex.vm * MIS( eye_bsdf_rev_pdfw );
+        const auto weight = (float)( 1.0f / ( mis_light + 1.0f + mis_eye ) );
+
+        li += bsdf * light_vertex.throughput * weight;
+    });
+
+    return li * eye_vertex.throughput * m_vmNormalization;
+}
@@ -0,0 +1,109 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#pragma once
+
+#include "bidirpath.h"
+#include "hashgrid.h"
+
+//! @brief  Vertex connection and merging integrator.
+/**
+ * This is the algorithm in "Light Transport Simulation with Vertex Connection and Merging" by Georgiev et al.
+ * On top of bi-directional path tracing, camera vertices are also merged with light vertices close by, like photon
+ * mapping. Merging finds paths that can't be connected, like caustics seen through glass, and the MIS weights of
+ * both techniques are evaluated with the same recursion bi-directional path tracing uses.
+ * At the beginning of each pass of progressive rendering, a light path is traced for each pixel and their vertices
+ * are stored in a hash grid shared by all camera paths of the pass. The merging radius shrinks in each pass so that
+ * the result converges. Without progressive rendering, there is only one pass with a fixed radius.
+ */
+class VertexConnectionMerging : public BidirPathTracing{
+public:
+    DEFINE_RTTI( VertexConnectionMerging , Integrator );
+
+    //! @brief  Compute the initial merging radius based on the size of the scene.
+    //!
+    //! @param  scene       The rendering scene.
+    void    PreProcess( const Scene& scene ) override;
+
+    //! @brief  Light vertices are traced before each pass.
+    bool    NeedPrePass() const override {
+        return true;
+    }
+
+    //! @brief  Trace light paths for the pass and build the hash grid of their vertices.
+    //!
+    //! Rows of light paths are traced in sub tasks of the pre-pass task, followed by a sub task building the hash
+    //! grid, all tiles of the pass wait for them.
+    //!
+    //! @param  scene       The rendering scene.
+    //! @param  pass        Index of the pass, the merging radius shrinks with it.
+    void    PrePass( const Scene& scene , unsigned pass ) override;
+
+    //! @brief      Serializing data from stream
+    //!
+    //! @param      Stream where the serialization data comes from. Depending on different situation, it could come from different places.
+    void    Serialize( IStreamBase& stream ) override {
+        BidirPathTracing::Serialize( stream );
+        stream >> m_radiusFactor >> m_radiusAlpha;
+    }
+
+protected:
+    //! @brief  Merge an eye vertex with light vertices of the pass within the merging radius.
+    //!
+    //! @param  eye_vertex  The vertex of the camera path.
+    //! @return             The contribution of all merged paths.
+    Spectrum    _MergeVertices( const BDPT_Vertex& eye_vertex ) const override;
+
+private:
+    //! @brief  Light vertex kept for merging, only what merging needs is kept since there are a lot of them.
+    struct MergingVertex{
+        Vector      wi;             // in direction
+        Spectrum    throughput;     // through put
+        double      vcm = 0.0f;     // MIS factors
+        double      vm = 0.0f;
+        float       rr = 0.0f;      // russian roulette
+        int         depth = 0;      // depth of the vertex
+    };
+
+    float       m_radiusFactor = 0.003f;    /**< Initial merging radius relative to the radius of the scene. */
+    float       m_radiusAlpha = 0.75f;      /**< Radius reduction parameter, the area shrinks by (i+1)^(alpha-1) in the i-th pass. */
+    float       m_baseRadius = 0.0f;        /**< Merging radius of the first pass. */
+    float       m_vmNormalization = 0.0f;   /**< Normalization of merged contribution, the reciprocal of the kernel area times light path count. */
+
+    std::vector<MergingVertex>  m_lightVertices;    /**< Light vertices of the current pass. */
+    HashGrid                    m_grid;             /**< Hash grid of the light vertices. */
+
+    std::vector<std::vector<MergingVertex>> m_rowVertices;  /**< Light vertices of each row, before they are gathered in the grid. */
+    std::vector<std::vector<Point>>         m_rowPoints;    /**< Positions of light vertices of each row. */
+
+    //! @brief  Trace light paths of rows of pixels.
+    //!
+    //! @param  scene       The rendering scene.
+    //! @param  pass        Index of the pass.
+    //! @param  y0          The first row to be traced.
+    //! @param  y1          One past the last row to be traced.
+    void    traceLightPaths( const Scene& scene , unsigned pass , int y0 , int y1 );
+
+    //! @brief  Gather light vertices of all rows and build the hash grid.
+    //!
+    //! @param  radius      Merging radius of the pass.
+    void    buildMergingGrid( float radius );
+
+    friend class LightPathRows_Task;
+    friend class MergingGrid_Task;
+
+    SORT_STATS_ENABLE( "Vertex Connection and Merging" )
+};
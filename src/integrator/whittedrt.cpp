@@ -35,14 +35,18 @@ Spectrum WhittedRT::Li( const Ray& r , const PixelSample& ps , const Scene& scen
 
     // get the intersection between the ray and the scene
     SurfaceInteraction ip;
-    if( false == scene.GetIntersect( r , ip ) )
-        return scene.Le(r);
+    if( false == scene.GetIntersect( r , ip ) ){
+        const auto le = scene.Le(r);
+        RecordLightGroupAOV( ps.aov , scene.GetSkyLight() , le );
+        return le;
+    }
 
     Spectrum t;
 
     // no support for SSS in this integrator.
     ScatteringEvent se( ip , SE_EVALUATE_ALL_NO_SSS );
     ip.primitive->GetMaterial()->UpdateScatteringEvent(se);
+    RecordSurfaceAOV( ps.aov , r , ip , se );
 
     // lights
     Visibility visibility(scene);
@@ -66,12 +70,16 @@ Spectrum WhittedRT::Li( const Ray& r , const PixelSample& ps , const Scene& scen
             }
 #ifndef ENABLE_TRANSPARENT_SHADOW
             const auto visible = visibility.IsVisible();
-            if( visible )
+            if( visible ){
                 t += (ld * f / pdf);
+                RecordLightGroupAOV( ps.aov , *it , ld * f / pdf );
+            }
 #else
             const auto attenuation = visibility.GetAttenuation();
-            if( !attenuation.IsBlack() )
+            if( !attenuation.IsBlack() ){
                 t += (ld * f * attenuation / pdf );
+                RecordLightGroupAOV( ps.aov , *it , ld * f * attenuation / pdf );
+            }
 #endif
         }
         it++;
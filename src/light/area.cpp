@@ -105,3 +105,19 @@ bool AreaLight::Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum& r
 
     return result;
 }
+
+bool AreaLight::GetBounds( LightBounds& bounds ) const{
+    sAssert(IS_PTR_VALID(m_shape), LIGHT );
+    bounds.bounds = m_shape->GetBBox();
+    bounds.phi = Power().GetIntensity();
+    bounds.cosTheta_e = 0.0f;
+    if( m_shape->GetShapeType() == SHAPE_SPHERE ){
+        // normals of a sphere cover all directions
+        bounds.cosTheta_o = -1.0f;
+    }else{
+        // quads and disks emit in the hemisphere around the normal
+        bounds.w = normalize( m_shape->GetTransform().TransformNormal( DIR_UP ) );
+        bounds.cosTheta_o = 1.0f;
+    }
+    return true;
+}
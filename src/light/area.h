@@ -88,6 +88,12 @@ public:
     //! @return     Approximation of the light power.
     Spectrum Power() const override;
 
+    //! @brief  Get the spatial and directional bounds of the light.
+    //!
+    //! @param  bounds  The bounds of the light.
+    //! @return         Whether the light is bounded.
+    bool GetBounds( LightBounds& bounds ) const override;
+
     //! @brief  Whether area light is a delta light.
     //!
     //! @return     Always return 'False' for area light because it is not delta light.
@@ -21,6 +21,7 @@
 #include "math/transform.h"
 #include "core/scene.h"
 #include "math/vector3.h"
+#include "light/lightbvh.h"
 
 struct SurfaceInteraction;
 class LightSample;
@@ -102,6 +103,17 @@ public:
         return false;
     }
 
+    //! @brief  Get the spatial and directional bounds of the light.
+    //!
+    //! The bounds are used to build the light BVH so that lights are picked based on their importance
+    //! to shading points. Infinite lights are not bounded, they are picked separately.
+    //!
+    //! @param  bounds  The bounds of the light.
+    //! @return         Whether the light is bounded.
+    virtual bool        GetBounds( LightBounds& bounds ) const {
+        return false;
+    }
+
     //! @brief  Get the shape of light, if there is one.
     //!
     //! Some light source has shape attached to it, like area light.
@@ -163,6 +175,15 @@ public:
         return m_pickProp;
     }
 
+    //! @brief  Get the light group the light belongs to.
+    //!
+    //! Radiance contributed by lights of the same group is accumulated in a separated channel of the film.
+    //!
+    //! @return         Index of the light group.
+    SORT_FORCEINLINE int GetLightGroup() const {
+        return m_lightGroup;
+    }
+
     //! @brief  Get the radiance light starting from the light source and ending at the intersection point.
     //!
     //! It simply returns zero for delta function, meaning there is no way to pick a ray hitting the delta light source.
@@ -203,4 +224,7 @@ protected:
 
     /**< The pdf of picking the light. */
     float       m_pickProp;
+
+    /**< The light group the light belongs to. */
+    int         m_lightGroup = 0;
 };
@@ -0,0 +1,333 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <algorithm>
+#include "lightbvh.h"
+#include "math/utils.h"
+#include "core/sassert.h"
+
+namespace {
+    // number of buckets evaluated along each axis when splitting a node
+    constexpr unsigned  LIGHT_BVH_BUCKET_CNT = 12;
+    // splits deeper than this are done in the middle so that the path to a leaf fits in the bit trail
+    constexpr unsigned  LIGHT_BVH_MAX_SAOH_DEPTH = 48;
+    // number of bits in the bit trail, no leaf can be deeper than this
+    constexpr unsigned  LIGHT_BVH_MAX_DEPTH = 64;
+
+    // depth of the subtree built by splitting 'cnt' lights in the middle all the way down
+    SORT_FORCEINLINE unsigned medianSplitDepth( unsigned cnt ){
+        auto depth = 0u;
+        while( ( 1ull << depth ) < cnt )
+            ++depth;
+        return depth;
+    }
+
+    // cos( max( 0 , theta_a - theta_b ) )
+    SORT_FORCEINLINE float cosSubClamped( float sin_a , float cos_a , float sin_b , float cos_b ){
+        if( cos_a > cos_b )
+            return 1.0f;
+        return cos_a * cos_b + sin_a * sin_b;
+    }
+
+    // sin( max( 0 , theta_a - theta_b ) )
+    SORT_FORCEINLINE float sinSubClamped( float sin_a , float cos_a , float sin_b , float cos_b ){
+        if( cos_a > cos_b )
+            return 0.0f;
+        return sin_a * cos_b - cos_a * sin_b;
+    }
+
+    SORT_FORCEINLINE Point centroid( const BBox& bb ){
+        return bb.m_Min + ( bb.m_Max - bb.m_Min ) * 0.5f;
+    }
+
+    // rotate a vector around an axis, the axis is not necessarily normalized
+    SORT_FORCEINLINE Vector rotate( const Vector& v , const Vector& axis , float theta ){
+        const auto k = normalize( axis );
+        const auto c = cos( theta );
+        const auto s = sin( theta );
+        return v * c + cross( k , v ) * s + k * ( dot( k , v ) * ( 1.0f - c ) );
+    }
+
+    // Orientation measure of the bounds, it is the solid angle of the cone bounding emitting directions weighted by cos.
+    SORT_FORCEINLINE float orientationMeasure( const LightBounds& lb ){
+        const auto theta_o = acos( clamp( lb.cosTheta_o , -1.0f , 1.0f ) );
+        const auto theta_e = acos( clamp( lb.cosTheta_e , -1.0f , 1.0f ) );
+        const auto theta_w = std::min( theta_o + theta_e , PI );
+        const auto sin_o = ssqrt( 1.0f - lb.cosTheta_o * lb.cosTheta_o );
+        return TWO_PI * ( 1.0f - lb.cosTheta_o ) +
+               HALF_PI * ( 2.0f * theta_w * sin_o - cos( theta_o - 2.0f * theta_w ) - 2.0f * theta_o * sin_o + lb.cosTheta_o );
+    }
+
+    SORT_FORCEINLINE float cost( const LightBounds& lb , const BBox& parent , unsigned axis ){
+        const auto delta = parent.m_Max - parent.m_Min;
+        // splitting long and thin nodes across is discouraged
+        const auto kr = std::max( delta.x , std::max( delta.y , delta.z ) ) / std::max( delta[axis] , 1e-6f );
+        return lb.phi * orientationMeasure( lb ) * lb.bounds.SurfaceArea() * kr;
+    }
+}
+
+float LightBounds::Importance( const Point& p , const Vector& n ) const{
+    const auto pc = centroid( bounds );
+    const auto diagonal = bounds.m_Max - bounds.m_Min;
+    const auto dist2 = ( p - pc ).SquaredLength();
+    const auto d2 = std::max( std::max( dist2 , diagonal.Length() * 0.5f ) , 1e-6f );
+
+    // angle between the axis and the direction from the lights to the shading point
+    const auto wi = dist2 > 0.0f ? ( p - pc ) / sqrt( dist2 ) : w;
+    auto cos_w = dot( w , wi );
+    if( twoSided )
+        cos_w = fabs( cos_w );
+    const auto sin_w = ssqrt( 1.0f - cos_w * cos_w );
+
+    // angle bounding the box seen from the shading point
+    auto cos_b = -1.0f;
+    if( !bounds.IsInBBox( p , 0.0f ) ){
+        const auto radius2 = diagonal.SquaredLength() * 0.25f;
+        if( dist2 > radius2 )
+            cos_b = ssqrt( 1.0f - radius2 / dist2 );
+    }
+    const auto sin_b = ssqrt( 1.0f - cos_b * cos_b );
+
+    // the minimum angle between the emitting directions and the shading point
+    const auto sin_o = ssqrt( 1.0f - cosTheta_o * cosTheta_o );
+    const auto cos_x = cosSubClamped( sin_w , cos_w , sin_o , cosTheta_o );
+    const auto sin_x = sinSubClamped( sin_w , cos_w , sin_o , cosTheta_o );
+    const auto cos_p = cosSubClamped( sin_x , cos_x , sin_b , cos_b );
+    if( cos_p <= cosTheta_e )
+        return 0.0f;
+
+    auto importance = phi * cos_p / d2;
+
+    // the cos factor at the shading point
+    if( !isZero( n ) ){
+        const auto cos_i = fabs( dot( wi , n ) );
+        const auto sin_i = ssqrt( 1.0f - cos_i * cos_i );
+        importance *= cosSubClamped( sin_i , cos_i , sin_b , cos_b );
+    }
+
+    return std::max( importance , 0.0f );
+}
+
+LightBounds Union( const LightBounds& lb0 , const LightBounds& lb1 ){
+    if( lb0.phi == 0.0f )
+        return lb1;
+    if( lb1.phi == 0.0f )
+        return lb0;
+
+    LightBounds ret;
+    ret.bounds = Union( lb0.bounds , lb1.bounds );
+    ret.phi = lb0.phi + lb1.phi;
+    ret.cosTheta_e = std::min( lb0.cosTheta_e , lb1.cosTheta_e );
+    ret.twoSided = lb0.twoSided || lb1.twoSided;
+
+    // the cone bounding both cones of directions
+    const auto theta_a = acos( clamp( lb0.cosTheta_o , -1.0f , 1.0f ) );
+    const auto theta_b = acos( clamp( lb1.cosTheta_o , -1.0f , 1.0f ) );
+    const auto theta_d = acos( clamp( dot( lb0.w , lb1.w ) , -1.0f , 1.0f ) );
+    if( std::min( theta_d + theta_b , PI ) <= theta_a ){
+        ret.w = lb0.w;
+        ret.cosTheta_o = lb0.cosTheta_o;
+        return ret;
+    }
+    if( std::min( theta_d + theta_a , PI ) <= theta_b ){
+        ret.w = lb1.w;
+        ret.cosTheta_o = lb1.cosTheta_o;
+        return ret;
+    }
+
+    const auto theta_o = 0.5f * ( theta_a + theta_d + theta_b );
+    const auto axis = cross( lb0.w , lb1.w );
+    if( theta_o >= PI || axis.SquaredLength() == 0.0f ){
+        ret.w = lb0.w;
+        ret.cosTheta_o = -1.0f;
+        return ret;
+    }
+
+    ret.w = normalize( rotate( lb0.w , axis , theta_o - theta_a ) );
+    ret.cosTheta_o = cos( theta_o );
+    return ret;
+}
+
+void LightBVH::Build( const std::vector<LightBounds>& bounds ){
+    m_nodes.clear();
+    m_bitTrails.assign( bounds.size() , 0 );
+    m_inTree.assign( bounds.size() , false );
+
+    std::vector<std::pair<unsigned,LightBounds>> lights;
+    for( auto i = 0u ; i < bounds.size() ; ++i ){
+        if( bounds[i].phi > 0.0f )
+            lights.push_back( std::make_pair( i , bounds[i] ) );
+    }
+    if( lights.empty() )
+        return;
+
+    m_nodes.reserve( 2 * lights.size() - 1 );
+    build( lights , 0 , (unsigned)lights.size() , 0 , 0 );
+}
+
+unsigned LightBVH::build( std::vector<std::pair<unsigned,LightBounds>>& lights , unsigned start , unsigned end , unsigned long long bit_trail , unsigned depth ){
+    const auto node_index = (unsigned)m_nodes.size();
+    m_nodes.push_back( Node() );
+
+    if( end - start == 1 ){
+        const auto light = lights[start].first;
+        m_nodes[node_index].lb = lights[start].second;
+        m_nodes[node_index].index = light;
+        m_nodes[node_index].leaf = true;
+        m_bitTrails[light] = bit_trail;
+        m_inTree[light] = true;
+        return node_index;
+    }
+
+    BBox bounds , centroid_bounds;
+    for( auto i = start ; i < end ; ++i ){
+        const auto& lb = lights[i].second;
+        bounds = Union( bounds , lb.bounds );
+        centroid_bounds.Union( centroid( lb.bounds ) );
+    }
+
+    // pick the split with the minimum surface area orientation heuristic
+    auto min_cost = FLT_MAX;
+    auto min_axis = -1;
+    auto min_bucket = 0u;
+    // an unbalanced split could leave one child with all lights but one, only take it if the middle splits below it still fit in the bit trail
+    const auto saoh = depth < LIGHT_BVH_MAX_SAOH_DEPTH && depth + 1 + medianSplitDepth( end - start - 1 ) <= LIGHT_BVH_MAX_DEPTH;
+    for( auto axis = 0u ; axis < 3 && saoh ; ++axis ){
+        const auto delta = centroid_bounds.m_Max[axis] - centroid_bounds.m_Min[axis];
+        if( delta <= 0.0f )
+            continue;
+
+        LightBounds buckets[LIGHT_BVH_BUCKET_CNT];
+        for( auto i = start ; i < end ; ++i ){
+            const auto& lb = lights[i].second;
+            const auto b = std::min( (unsigned)( ( centroid( lb.bounds )[axis] - centroid_bounds.m_Min[axis] ) / delta * LIGHT_BVH_BUCKET_CNT ) , LIGHT_BVH_BUCKET_CNT - 1 );
+            buckets[b] = Union( buckets[b] , lb );
+        }
+
+        for( auto split = 0u ; split < LIGHT_BVH_BUCKET_CNT - 1 ; ++split ){
+            LightBounds b0 , b1;
+            for( auto i = 0u ; i <= split ; ++i )
+                b0 = Union( b0 , buckets[i] );
+            for( auto i = split + 1 ; i < LIGHT_BVH_BUCKET_CNT ; ++i )
+                b1 = Union( b1 , buckets[i] );
+            if( b0.phi == 0.0f || b1.phi == 0.0f )
+                continue;
+
+            const auto c = cost( b0 , bounds , axis ) + cost( b1 , bounds , axis );
+            if( c < min_cost ){
+                min_cost = c;
+                min_axis = axis;
+                min_bucket = split;
+            }
+        }
+    }
+
+    auto mid = start + ( end - start ) / 2;
+    if( min_axis >= 0 ){
+        const auto axis = (unsigned)min_axis;
+        const auto delta = centroid_bounds.m_Max[axis] - centroid_bounds.m_Min[axis];
+        const auto it = std::partition( lights.begin() + start , lights.begin() + end , [&]( const std::pair<unsigned,LightBounds>& l ){
+            const auto b = std::min( (unsigned)( ( centroid( l.second.bounds )[axis] - centroid_bounds.m_Min[axis] ) / delta * LIGHT_BVH_BUCKET_CNT ) , LIGHT_BVH_BUCKET_CNT - 1 );
+            return b <= min_bucket;
+        });
+        mid = (unsigned)( it - lights.begin() );
+    }
+    if( mid == start || mid == end ){
+        // lights are not separable by buckets, split them in the middle
+        mid = start + ( end - start ) / 2;
+        const auto axis = bounds.MaxAxisId();
+        std::nth_element( lights.begin() + start , lights.begin() + mid , lights.begin() + end , [&]( const std::pair<unsigned,LightBounds>& l0 , const std::pair<unsigned,LightBounds>& l1 ){
+            return centroid( l0.second.bounds )[axis] < centroid( l1.second.bounds )[axis];
+        });
+    }
+
+    sAssertMsg( depth < LIGHT_BVH_MAX_DEPTH , LIGHT , "Light BVH is too deep for its bit trail." );
+    const auto c0 = build( lights , start , mid , bit_trail , depth + 1 );
+    const auto c1 = build( lights , mid , end , bit_trail | ( 1ull << depth ) , depth + 1 );
+
+    m_nodes[node_index].lb = Union( m_nodes[c0].lb , m_nodes[c1].lb );
+    m_nodes[node_index].index = c1;
+    m_nodes[node_index].leaf = false;
+    return node_index;
+}
+
+int LightBVH::Sample( const Point& p , const Vector& n , float u , float* pmf ) const{
+    if( m_nodes.empty() )
+        return -1;
+
+    auto prob = 1.0f;
+    auto node_index = 0u;
+    while( true ){
+        const auto& node = m_nodes[node_index];
+        if( node.leaf ){
+            if( node_index > 0 || node.lb.Importance( p , n ) > 0.0f ){
+                if( pmf )
+                    *pmf = prob;
+                return (int)node.index;
+            }
+            return -1;
+        }
+
+        // pick a child based on their importance and reuse the random number
+        const auto c0 = node_index + 1;
+        const auto c1 = node.index;
+        const auto i0 = m_nodes[c0].lb.Importance( p , n );
+        const auto i1 = m_nodes[c1].lb.Importance( p , n );
+        if( i0 == 0.0f && i1 == 0.0f )
+            return -1;
+
+        const auto p0 = i0 / ( i0 + i1 );
+        if( u < p0 ){
+            node_index = c0;
+            u = std::min( u / p0 , 0.99999994f );
+            prob *= p0;
+        }else{
+            node_index = c1;
+            u = std::min( ( u - p0 ) / ( 1.0f - p0 ) , 0.99999994f );
+            prob *= 1.0f - p0;
+        }
+    }
+}
+
+float LightBVH::Pmf( const Point& p , const Vector& n , unsigned light ) const{
+    if( light >= m_inTree.size() || !m_inTree[light] )
+        return 0.0f;
+
+    // follow the path from the root to the light
+    auto bit_trail = m_bitTrails[light];
+    auto prob = 1.0f;
+    auto node_index = 0u;
+    while( !m_nodes[node_index].leaf ){
+        const auto& node = m_nodes[node_index];
+        const auto c0 = node_index + 1;
+        const auto c1 = node.index;
+        const auto i0 = m_nodes[c0].lb.Importance( p , n );
+        const auto i1 = m_nodes[c1].lb.Importance( p , n );
+        if( i0 == 0.0f && i1 == 0.0f )
+            return 0.0f;
+
+        const auto second = bit_trail & 1;
+        prob *= ( second ? i1 : i0 ) / ( i0 + i1 );
+        node_index = second ? c1 : c0;
+        bit_trail >>= 1;
+    }
+
+    // a single light in the tree is only picked if it could contribute
+    if( node_index == 0 && m_nodes[0].lb.Importance( p , n ) == 0.0f )
+        return 0.0f;
+    return prob;
+}
@@ -0,0 +1,109 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <vector>
+#include "math/bbox.h"
+#include "math/point.h"
+#include "math/vector3.h"
+
+//! @brief  Spatial and directional bounds of one or more lights.
+/**
+ * The emission of the lights is bounded by a cone of directions around the axis 'w'. 'cosTheta_o' bounds
+ * the normals, or emitting directions of delta lights, and 'cosTheta_e' bounds the emission around them,
+ * e.g. a one-sided area light emits in a hemisphere around its normal. For further detail, please refer
+ * to "Importance Sampling of Many Lights with Adaptive Tree Splitting" by Conty Estevez and Kulla.
+ */
+struct LightBounds{
+    BBox        bounds;                 /**< Spatial bounds of the lights. */
+    Vector      w = Vector( 0.0f , 1.0f , 0.0f );  /**< Axis of the cone bounding emitting directions. */
+    float       phi = 0.0f;             /**< Total power of the lights. */
+    float       cosTheta_o = 1.0f;      /**< Cos of the spread angle of the normals around the axis. */
+    float       cosTheta_e = 0.0f;      /**< Cos of the emission angle around the normals. */
+    bool        twoSided = false;       /**< Whether the lights emit on both sides of the surfaces. */
+
+    //! @brief  Importance of the lights to a shading point.
+    //!
+    //! It is a conservative estimation of the contribution of the lights, which is power over squared distance,
+    //! scaled by upper bounds of the cos at the lights and the cos at the shading point.
+    //!
+    //! @param  p       The shading point.
+    //! @param  n       The normal of the shading point, zero vector for points in media.
+    //! @return         The importance of the lights.
+    float       Importance( const Point& p , const Vector& n ) const;
+};
+
+//! @brief  Merge the bounds of two groups of lights.
+LightBounds Union( const LightBounds& lb0 , const LightBounds& lb1 );
+
+//! @brief  Bounding volume hierarchy of lights for importance sampling of many lights.
+/**
+ * At each shading point, the tree is traversed from the root stochastically. In each node, a child is picked
+ * with the probability proportional to its importance to the shading point, until a leaf with a single light
+ * is reached. Lights far away or facing away are rarely picked this way, the cost is logarithmic to the number
+ * of lights. Lights are identified by the index of their bounds passed to 'Build'.
+ */
+class LightBVH{
+public:
+    //! @brief  Build the tree.
+    //!
+    //! @param  bounds      Bounds of each light, lights with zero power are skipped.
+    void    Build( const std::vector<LightBounds>& bounds );
+
+    //! @brief  Whether there is any light in the tree.
+    bool    IsEmpty() const {
+        return m_nodes.empty();
+    }
+
+    //! @brief  Pick a light for a shading point.
+    //!
+    //! @param  p       The shading point.
+    //! @param  n       The normal of the shading point, zero vector for points in media.
+    //! @param  u       A canonical random number.
+    //! @param  pmf     The probability of picking the light.
+    //! @return         Index of the light, -1 if no light could contribute to the shading point.
+    int     Sample( const Point& p , const Vector& n , float u , float* pmf ) const;
+
+    //! @brief  The probability of picking a light for a shading point.
+    //!
+    //! @param  p       The shading point.
+    //! @param  n       The normal of the shading point, zero vector for points in media.
+    //! @param  light   Index of the light.
+    //! @return         The probability of picking the light by 'Sample'.
+    float   Pmf( const Point& p , const Vector& n , unsigned light ) const;
+
+    //! @brief  Number of nodes in the tree.
+    unsigned    GetNodeCount() const {
+        return (unsigned)m_nodes.size();
+    }
+
+private:
+    //! @brief  Node of the tree, the first child of an interior node is right after it.
+    struct Node{
+        LightBounds lb;                 /**< Bounds of all lights in the sub-tree. */
+        unsigned    index = 0;          /**< Index of the second child for interior nodes, index of the light for leaves. */
+        bool        leaf = false;       /**< Whether the node is a leaf. */
+    };
+
+    std::vector<Node>       m_nodes;        /**< Nodes of the tree in depth-first order. */
+    std::vector<unsigned long long> m_bitTrails;    /**< Path from the root to the leaf of each light, one bit for each level. */
+    std::vector<bool>       m_inTree;       /**< Whether the light is in the tree. */
+
+    //! @brief  Build a sub-tree recursively.
+    unsigned    build( std::vector<std::pair<unsigned,LightBounds>>& lights , unsigned start , unsigned end , unsigned long long bit_trail , unsigned depth );
+};
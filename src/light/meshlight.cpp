@@ -0,0 +1,277 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "meshlight.h"
+#include "sampler/sample.h"
+#include "core/primitive.h"
+#include "core/rand.h"
+
+// Spherical triangle sampling loses precision for tiny solid angles and for triangles covering most of the sphere,
+// area sampling is used instead in both cases.
+static constexpr float MIN_SPHERICAL_SAMPLE_AREA = 3e-4f;
+static constexpr float MAX_SPHERICAL_SAMPLE_AREA = 6.22f;
+
+// Maximum number of transparent surfaces to pass through while looking for the light along a ray.
+static constexpr unsigned MAX_TRANSPARENT_SURFACES = 16;
+
+static SORT_FORCEINLINE float solidAngle( const Point& p0 , const Point& p1 , const Point& p2 , const Point& p ){
+    return SphericalTriangleArea( normalize( p0 - p ) , normalize( p1 - p ) , normalize( p2 - p ) );
+}
+
+void MeshLight::AddTriangle( const Point& p0 , const Point& p1 , const Point& p2 , const Vector& n , const Spectrum& radiance , const Shape* shape ){
+    EmissiveTriangle tri;
+    tri.p[0] = p0;
+    tri.p[1] = p1;
+    tri.p[2] = p2;
+    tri.n = n;
+    tri.area = 0.5f * cross( p1 - p0 , p2 - p0 ).Length();
+    tri.radiance = radiance;
+    if( tri.area <= 0.0f )
+        return;
+
+    m_shapeIndex[shape] = (unsigned)m_triangles.size();
+    m_triangles.push_back( tri );
+}
+
+void MeshLight::Build(){
+    // a lambertian emitter emits radiance times pi for each unit area
+    std::vector<float> power( m_triangles.size() );
+    m_power = 0.0f;
+    for( auto i = 0u ; i < m_triangles.size() ; ++i ){
+        const auto& tri = m_triangles[i];
+        power[i] = tri.radiance.GetIntensity() * tri.area * PI;
+        m_power += tri.radiance * tri.area * PI;
+    }
+    m_aliasTable = std::make_unique<AliasTable>( power.data() , (unsigned)power.size() );
+}
+
+float MeshLight::trianglePdf( const EmissiveTriangle& tri , const Point& p , const Point& ps ) const{
+    const auto sa = solidAngle( tri.p[0] , tri.p[1] , tri.p[2] , p );
+    if( sa >= MIN_SPHERICAL_SAMPLE_AREA && sa <= MAX_SPHERICAL_SAMPLE_AREA )
+        return 1.0f / sa;
+
+    const auto delta = ps - p;
+    const auto cos = fabs( dot( normalize( delta ) , tri.n ) );
+    if( cos == 0.0f )
+        return 0.0f;
+    return delta.SquaredLength() / ( tri.area * cos );
+}
+
+Spectrum MeshLight::sample_l( const Point& ip , const LightSample* ls , Vector& dirToLight , float* distance , float* pdfW , float* emissionPdf , float* cosAtLight , Visibility& visibility ) const{
+    sAssert(IS_PTR_VALID(ls), LIGHT );
+    sAssert(IS_PTR_VALID(m_aliasTable), LIGHT );
+
+    if( pdfW ) *pdfW = 0.0f;
+
+    // 'ls->t' is already used to pick the light, a new random number is drawn to pick the triangle
+    auto pmf = 0.0f;
+    const auto id = m_aliasTable->Sample( sort_canonical() , &pmf );
+    if( id < 0 || pmf == 0.0f )
+        return 0.0f;
+    const auto& tri = m_triangles[id];
+
+    Point ps;
+    auto pdf = 0.0f;
+    const auto sa = solidAngle( tri.p[0] , tri.p[1] , tri.p[2] , ip );
+    if( sa >= MIN_SPHERICAL_SAMPLE_AREA && sa <= MAX_SPHERICAL_SAMPLE_AREA ){
+        // sample a direction uniformly in the solid angle subtended by the triangle
+        const auto wi = UniformSampleSphericalTriangle( normalize( tri.p[0] - ip ) , normalize( tri.p[1] - ip ) , normalize( tri.p[2] - ip ) , ls->u , ls->v , &pdf );
+        const auto d = dot( wi , tri.n );
+        if( pdf == 0.0f || d == 0.0f )
+            return 0.0f;
+        const auto t = dot( tri.p[0] - ip , tri.n ) / d;
+        if( t <= 0.0f )
+            return 0.0f;
+        ps = ip + wi * t;
+    }else{
+        // sample a point uniformly on the triangle
+        float b0 , b1;
+        UniformSampleTriangle( ls->u , ls->v , b0 , b1 );
+        ps = tri.p[0] * b0 + tri.p[1] * b1 + tri.p[2] * ( 1.0f - b0 - b1 );
+        pdf = trianglePdf( tri , ip , ps );
+        if( pdf == 0.0f )
+            return 0.0f;
+    }
+
+    const auto delta = ps - ip;
+    const auto len = delta.Length();
+    if( len == 0.0f )
+        return 0.0f;
+    dirToLight = delta / len;
+
+    // only the front side of the triangle emits light
+    const auto cos = dot( -dirToLight , tri.n );
+    if( cos <= 0.0f )
+        return 0.0f;
+
+    if( pdfW )
+        *pdfW = pmf * pdf;
+
+    if( cosAtLight )
+        *cosAtLight = cos;
+
+    if( distance )
+        *distance = len;
+
+    // product of pdf of sampling a point w.r.t surface area and a direction w.r.t direction
+    if( emissionPdf )
+        *emissionPdf = UniformHemispherePdf() * pmf / tri.area;
+
+    // setup visibility tester
+    const float delta_t = 0.01f;
+    visibility.ray = Ray( ip , dirToLight , 0 , delta_t , len - delta_t );
+
+    return tri.radiance;
+}
+
+Spectrum MeshLight::sample_l( const LightSample& ls , Ray& r , float* pdfW , float* pdfA , float* cosAtLight ) const{
+    sAssert(IS_PTR_VALID(m_aliasTable), LIGHT );
+
+    auto pmf = 0.0f;
+    const auto id = m_aliasTable->Sample( ls.t , &pmf );
+    if( id < 0 || pmf == 0.0f ){
+        if( pdfW ) *pdfW = 0.0f;
+        if( pdfA ) *pdfA = 0.0f;
+        return 0.0f;
+    }
+    const auto& tri = m_triangles[id];
+
+    float b0 , b1;
+    UniformSampleTriangle( ls.u , ls.v , b0 , b1 );
+
+    Vector t0 , t1;
+    coordinateSystem( tri.n , t0 , t1 );
+    const auto local = UniformSampleHemisphere( sort_canonical() , sort_canonical() );
+
+    r.m_Ori = tri.p[0] * b0 + tri.p[1] * b1 + tri.p[2] * ( 1.0f - b0 - b1 );
+    r.m_Dir = t0 * local.x + tri.n * local.y + t1 * local.z;
+    r.m_fMax = FLT_MAX;
+
+    if( pdfW )
+        *pdfW = UniformHemispherePdf() * pmf / tri.area;
+
+    if( pdfA )
+        *pdfA = pmf / tri.area;
+
+    if( cosAtLight )
+        *cosAtLight = satDot( r.m_Dir , tri.n );
+
+    // to avoid self intersection
+    r.m_fMin = 0.01f;
+
+    return tri.radiance;
+}
+
+int MeshLight::traceLight( const Ray& ray , SurfaceInteraction& intersect ) const{
+    sAssert(IS_PTR_VALID(m_scene), LIGHT );
+
+    // the ray may start on a surface, a small offset avoids self intersection
+    auto r = Ray( ray.m_Ori , ray.m_Dir , 0 , std::max( ray.m_fMin , 0.001f ) , ray.m_fMax );
+    for( auto i = 0u ; i < MAX_TRANSPARENT_SURFACES ; ++i ){
+        intersect = SurfaceInteraction();
+        if( !m_scene->GetIntersect( r , intersect ) || IS_PTR_INVALID(intersect.primitive) )
+            return -1;
+
+        if( intersect.primitive->GetLight() == this ){
+            const auto it = m_shapeIndex.find( intersect.primitive->GetShape() );
+            if( it == m_shapeIndex.end() )
+                return -1;
+            intersect.t = distance( ray.m_Ori , intersect.intersect );
+            return (int)it->second;
+        }
+
+        // opaque surfaces block the light, transparent ones are handled by the visibility test of the caller
+        if( !intersect.primitive->GetMaterial()->HasTransparency() )
+            return -1;
+
+        r.m_fMin = intersect.t + 0.001f;
+    }
+    return -1;
+}
+
+float MeshLight::Pdf( const Point& p , const Vector& wi ) const{
+    SurfaceInteraction inter;
+    const auto id = traceLight( Ray( p , wi ) , inter );
+    if( id < 0 )
+        return 0.0f;
+
+    const auto& tri = m_triangles[id];
+    if( dot( -wi , tri.n ) <= 0.0f )
+        return 0.0f;
+    return m_aliasTable->GetProperty( id ) * trianglePdf( tri , p , inter.intersect );
+}
+
+Spectrum MeshLight::Power() const{
+    return m_power;
+}
+
+Spectrum MeshLight::Le( const SurfaceInteraction& intersect , const Vector& wo , float* directPdfA , float* emissionPdf ) const{
+    if( IS_PTR_INVALID(intersect.primitive) )
+        return 0.0f;
+    const auto it = m_shapeIndex.find( intersect.primitive->GetShape() );
+    if( it == m_shapeIndex.end() )
+        return 0.0f;
+
+    const auto& tri = m_triangles[it->second];
+    if( dot( wo , tri.n ) <= 0.0f )
+        return 0.0f;
+
+    const auto pmf = m_aliasTable->GetProperty( it->second );
+    if( directPdfA )
+        *directPdfA = pmf / tri.area;
+
+    if( emissionPdf )
+        *emissionPdf = UniformHemispherePdf() * pmf / tri.area;
+
+    return tri.radiance;
+}
+
+bool MeshLight::Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum& radiance ) const{
+    SurfaceInteraction inter;
+    if( traceLight( ray , inter ) < 0 )
+        return false;
+
+    radiance = Le( inter , -ray.m_Dir , 0 , 0 );
+    if( intersect )
+        *intersect = inter;
+    return true;
+}
+
+bool MeshLight::GetBounds( LightBounds& bounds ) const{
+    if( m_triangles.empty() )
+        return false;
+
+    // the axis of the cone is the area weighted average normal
+    Vector axis;
+    for( const auto& tri : m_triangles ){
+        bounds.bounds.Union( tri.p[0] );
+        bounds.bounds.Union( tri.p[1] );
+        bounds.bounds.Union( tri.p[2] );
+        axis += tri.n * tri.area;
+    }
+
+    bounds.phi = m_power.GetIntensity();
+    bounds.cosTheta_e = 0.0f;
+    bounds.cosTheta_o = -1.0f;
+    if( axis.SquaredLength() > 0.0f ){
+        bounds.w = normalize( axis );
+        bounds.cosTheta_o = 1.0f;
+        for( const auto& tri : m_triangles )
+            bounds.cosTheta_o = std::min( bounds.cosTheta_o , dot( tri.n , bounds.w ) );
+    }
+    return true;
+}
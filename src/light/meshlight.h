@@ -0,0 +1,153 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "light.h"
+#include "core/samplemethod.h"
+
+//! @brief  Emissive triangles of a mesh.
+/**
+ * Triangles with emissive materials are gathered in a mesh light so that they can be sampled explicitly
+ * instead of relying on BSDF sampling to hit them. A triangle is picked with an alias table built on the
+ * emitted power of each triangle. A direction is then picked in the solid angle subtended by the triangle,
+ * unless the solid angle is too small or too large for it to be numerically robust, in which case the
+ * triangle is sampled uniformly by area.
+ */
+class   MeshLight : public Light{
+public:
+    //! @brief  Add an emissive triangle to the light.
+    //!
+    //! @param  p0          The first vertex of the triangle in world space.
+    //! @param  p1          The second vertex of the triangle in world space.
+    //! @param  p2          The third vertex of the triangle in world space.
+    //! @param  n           The normal of the emitting side of the triangle.
+    //! @param  radiance    The radiance emitted by the triangle.
+    //! @param  shape       The shape of the triangle, used to identify the triangle hit by rays.
+    void    AddTriangle( const Point& p0 , const Point& p1 , const Point& p2 , const Vector& n , const Spectrum& radiance , const Shape* shape );
+
+    //! @brief  Build the alias table after all triangles are added.
+    void    Build();
+
+    //! @brief  Whether there is any emissive triangle in the light.
+    //!
+    //! @return     True if there is no emissive triangle.
+    bool    IsEmpty() const {
+        return m_triangles.empty();
+    }
+
+    //! @brief  Sample a direction given the intersection.
+    //!
+    //! @param  ip              The point where we are interested in shading at.
+    //! @param  ls              The light sample information.
+    //! @param  dirToLight      The resulting direction goes from the intersection to light source.
+    //! @param  distance        The distance from the intersected point to the sampled point, which is the intersection
+    //!                         between the out-going direction and the light source.
+    //! @param  pdfw            The resulting pdf w.r.t solid angle to pick such a direction.
+    //! @param  emissionPdf     The pdf w.r.t solid angle if such a direction and position ( which is the intersection
+    //!                         between the resulting direction to the light source ) is picked by the light source.
+    //! @param  cosAtLight      The cos of the angle between the light out-going direction, the opposite of 'dirToLight'.
+    //! @param  visibility      The visibility data structured filled by the light source.
+    //! @return                 The radiance goes from the light source to the intersected point.
+    Spectrum sample_l(const Point& ip, const LightSample* ls , Vector& dirToLight , float* distance , float* pdfw , float* emissionPdf , float* cosAtLight , Visibility& visibility ) const override;
+
+    //! @brief      Sample a point and light out-going direction.
+    //!
+    //! @param  ls              The light sample.
+    //! @param  r               The resulting sampled ray.
+    //! @param  pdfA            The pdf w.r.t area of picking such a light out-going ray.
+    //! @param  cosAtLight      The cos of the angle between the light out-going direction, the opposite of 'dirToLight'.
+    //! @return                 The radiance goes from the light source to the intersected point.
+    Spectrum sample_l( const LightSample& ls , Ray& r , float* pdfW , float* pdfA , float* cosAtLight ) const override;
+
+    //! @brief  Get the radiance light starting from the light source and ending at the intersection point.
+    //!
+    //! @param  intersect       The intersection information.
+    //! @param  wo              The direction goes from the intersection to the light source.
+    //! @param  directPdfA      The pdf w.r.t area to pick the point, intersection between the direction and the light source.
+    //! @param  emissionPdf     The pdf w.r.t solid angle to pick to sample such a position and direction goes to the intersection.
+    //! @return                 The radiance goes from the light source to the intersection, black if there is no intersection.
+    Spectrum Le( const SurfaceInteraction& intersect , const Vector& wo , float* directPdfA , float* emissionPdf ) const override;
+
+    //! @brief  Given a ray, sample the light source if there is any intersection between the ray and the light source.
+    //!
+    //! The ray is traced against the scene since the triangles are only organized in the spatial data structure of the
+    //! scene. It fails if there is any opaque primitive in the way, in which case the light is not visible anyway.
+    //!
+    //! @param  ray             The ray to be evaluated.
+    //! @param  intersect       The intersection between the ray and the light source.
+    //! @param  radiance        The radiance goes from the light source to the ray origin.
+    //! @return                 Whether there is an intersection between the ray and the light source.
+    bool Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum& radiance ) const override;
+
+    //! @brief  Total power emitted by the triangles.
+    //!
+    //! @return     The power of the light.
+    Spectrum Power() const override;
+
+    //! @brief  Get the spatial and directional bounds of the light.
+    //!
+    //! @param  bounds  The bounds of the light.
+    //! @return         Whether the light is bounded.
+    bool GetBounds( LightBounds& bounds ) const override;
+
+    //! @brief  Whether mesh light is a delta light.
+    //!
+    //! @return     Always return 'False' for mesh light because it is not delta light.
+    bool    IsDelta() const override{
+        return false;
+    }
+
+    //! @brief  The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.
+    //!
+    //! @param  p       The point in world space to be shaded.
+    //! @param  wi      The direction pointing from the point.
+    //! @return         The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.
+    float Pdf( const Point& p , const Vector& wi ) const override;
+
+private:
+    //! @brief  An emissive triangle.
+    struct EmissiveTriangle{
+        Point       p[3];       /**< Vertices of the triangle in world space. */
+        Vector      n;          /**< Normal of the emitting side. */
+        float       area;       /**< Surface area of the triangle. */
+        Spectrum    radiance;   /**< Radiance emitted by the triangle. */
+    };
+
+    std::vector<EmissiveTriangle>               m_triangles;        /**< Emissive triangles of the light. */
+    std::unordered_map<const Shape*, unsigned>  m_shapeIndex;       /**< Index of the triangle of each shape. */
+    std::unique_ptr<AliasTable>                 m_aliasTable;       /**< Alias table for picking triangles based on their power. */
+    Spectrum                                    m_power;            /**< Total power of the light. */
+
+    //! @brief  The pdf w.r.t solid angle of picking a point on a triangle, given the triangle is picked.
+    //!
+    //! @param  tri     The triangle.
+    //! @param  p       The shading point.
+    //! @param  ps      The point on the triangle.
+    //! @return         The pdf w.r.t solid angle.
+    float   trianglePdf( const EmissiveTriangle& tri , const Point& p , const Point& ps ) const;
+
+    //! @brief  Find the first triangle of the light along a ray.
+    //!
+    //! @param  ray         The ray to be traced.
+    //! @param  intersect   The intersection with the triangle, 't' is the distance from the origin of the ray.
+    //! @return             Index of the triangle, -1 if the ray doesn't reach the light.
+    int     traceLight( const Ray& ray , SurfaceInteraction& intersect ) const;
+};
@@ -76,3 +76,13 @@ Spectrum PointLight::sample_l( const LightSample& ls , Ray& r , float* pdfW , fl
 
     return intensity;
 }
+
+bool PointLight::GetBounds( LightBounds& bounds ) const{
+    // it emits in all directions
+    const auto light_pos = Point( m_light2world.matrix.m[3] , m_light2world.matrix.m[7] , m_light2world.matrix.m[11] );
+    bounds.bounds = BBox( light_pos , light_pos );
+    bounds.phi = Power().GetIntensity();
+    bounds.cosTheta_o = -1.0f;
+    bounds.cosTheta_e = 0.0f;
+    return true;
+}
@@ -63,6 +63,12 @@ public:
         return 4 * PI * intensity;
     }
 
+    //! @brief  Get the spatial and directional bounds of the light.
+    //!
+    //! @param  bounds  The bounds of the light.
+    //! @return         Whether the light is bounded.
+    bool GetBounds( LightBounds& bounds ) const override;
+
     //! @brief  The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.'
     //!
     //! Instead of checking whether p and wi is valid, it always returns 1.0. It is higher level code's responsibility to
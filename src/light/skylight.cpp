@@ -20,9 +20,9 @@
 #include "core/samplemethod.h"
 
 Spectrum SkyLight::sample_l(const Point& ip, const LightSample* ls , Vector& dirToLight , float* distance , float* pdfw , float* emissionPdf , float* cosAtLight , Visibility& visibility ) const{
-    // sample a ray
+    // sample a ray, the samples are combined with BSDF samples through MIS
     float _pdfw = 0.0f;
-    const Vector localDir = sky.sample_v( ls->u , ls->v , &_pdfw , 0 );
+    const Vector localDir = sky.sample_v( ls->u , ls->v , &_pdfw , 0 , true );
     if( _pdfw == 0.0f )
         return 0.0f;
     dirToLight = m_light2world.TransformVector(localDir);
@@ -40,7 +40,7 @@ Spectrum SkyLight::sample_l(const Point& ip, const LightSample* ls , Vector& dir
     {
         const BBox& box = m_scene->GetBBox();
         const Vector delta = box.m_Max - box.m_Min;
-        *emissionPdf = _pdfw * 4.0f * INV_PI / delta.SquaredLength();
+        *emissionPdf = sky.Pdf( localDir ) * 4.0f * INV_PI / delta.SquaredLength();
     }
 
     // setup visibility tester
@@ -54,13 +54,14 @@ Spectrum SkyLight::Le( const SurfaceInteraction& intersect , const Vector& wo ,
     const BBox& box = m_scene->GetBBox();
     const Vector delta = box.m_Max - box.m_Min;
 
-    const float directPdf = sky.Pdf( m_light2world.GetInversed().TransformVector(-wo) );
+    // direct pdf matches sampling the light from shading points, emission pdf matches starting light paths from the light
+    const Vector localDir = m_light2world.GetInversed().TransformVector(-wo);
     const float positionPdf = 4.0f * INV_PI / delta.SquaredLength();
 
     if( directPdfA )
-        *directPdfA = directPdf;
+        *directPdfA = sky.Pdf( localDir , true );
     if( emissionPdf )
-        *emissionPdf = directPdf * positionPdf;
+        *emissionPdf = sky.Pdf( localDir ) * positionPdf;
 
     return sky.Evaluate( m_light2world.GetInversed().TransformVector(-wo) ) * intensity;
 }
@@ -91,7 +92,7 @@ Spectrum SkyLight::sample_l( const LightSample& ls , Ray& r , float* pdfW , floa
     if( cosAtLight )
         *cosAtLight = 1.0f;
     if( pdfA )
-        *pdfA = _pdfw;
+        *pdfA = sky.Pdf( -localDir , true );
 
     return sky.Evaluate( -localDir ) * intensity;
 }
@@ -113,5 +114,5 @@ bool SkyLight::Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum& ra
 }
 
 float SkyLight::Pdf( const Point& p , const Vector& wi ) const{
-    return sky.Pdf( m_light2world.GetInversed().TransformVector(wi) );
+    return sky.Pdf( m_light2world.GetInversed().TransformVector(wi) , true );
 }
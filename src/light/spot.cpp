@@ -99,4 +99,16 @@ Spectrum SpotLight::sample_l( const LightSample& ls , Ray& r , float* pdfW , flo
         return 0.0f;
 
     return intensity * d * d;
-}
\ No newline at end of file
+}
+
+bool SpotLight::GetBounds( LightBounds& bounds ) const{
+    // the cone of full intensity, the fall off region is covered by the emission angle
+    const auto light_dir = Vector3f( m_light2world.matrix.m[1] , m_light2world.matrix.m[5] , m_light2world.matrix.m[9] );
+    const auto light_pos = Point( m_light2world.matrix.m[3] , m_light2world.matrix.m[7] , m_light2world.matrix.m[11] );
+    bounds.bounds = BBox( light_pos , light_pos );
+    bounds.w = normalize( light_dir );
+    bounds.phi = Power().GetIntensity();
+    bounds.cosTheta_o = cos_falloff_start;
+    bounds.cosTheta_e = cos( acos( clamp( cos_total_range , -1.0f , 1.0f ) ) - acos( clamp( cos_falloff_start , -1.0f , 1.0f ) ) );
+    return true;
+}
@@ -53,6 +53,12 @@ public:
         return 4 * PI * intensity * ( 1.0f - 0.5f * ( cos_falloff_start + cos_total_range ) ) ;
     }
 
+    //! @brief  Get the spatial and directional bounds of the light.
+    //!
+    //! @param  bounds  The bounds of the light.
+    //! @return         Whether the light is bounded.
+    bool GetBounds( LightBounds& bounds ) const override;
+
     //! @brief      Sample a point and light out-going direction.
     //!
     //! The difference of this version the the above one is there is no intersection data given.
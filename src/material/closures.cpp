@@ -397,11 +397,20 @@ namespace {
 
          void Process(const Tsl_Namespace::ClosureParamPtr param, const Tsl_Namespace::float3 & w, ScatteringEvent & se) const override {
              const auto& params = *(const ClosureTypeDoubleSided*)param;
-             ScatteringEvent* se0 = SORT_MALLOC(ScatteringEvent)(se.GetInteraction(), SE_Flag( SE_EVALUATE_ALL | SE_SUB_EVENT | SE_REPLACE_BSSRDF ) );
-             ScatteringEvent* se1 = SORT_MALLOC(ScatteringEvent)(se.GetInteraction(), SE_Flag( SE_EVALUATE_ALL | SE_SUB_EVENT | SE_REPLACE_BSSRDF ) );
-             ProcessSurfaceClosure((const ClosureTreeNodeBase*)params.closure0, make_float3(1.0f, 1.0f, 1.0f), *se0);
-             ProcessSurfaceClosure((const ClosureTreeNodeBase*)params.closure1, make_float3(1.0f, 1.0f, 1.0f), *se1);
-             se.AddBxdf(SORT_MALLOC(DoubleSided)(se0, se1, w));
+
+             // Both sides are flattened into the scattering event. Inside one side of another double sided material, only
+             // the front side of this one can ever be reached since directions are already flipped to the front.
+             const auto side = se.GetLobeSide();
+             if (SE_BOTH_SIDES != side) {
+                 ProcessSurfaceClosure((const ClosureTreeNodeBase*)params.closure0, w, se);
+                 return;
+             }
+
+             se.SetLobeSide(SE_FRONT_SIDE);
+             ProcessSurfaceClosure((const ClosureTreeNodeBase*)params.closure0, w, se);
+             se.SetLobeSide(SE_BACK_SIDE);
+             ProcessSurfaceClosure((const ClosureTreeNodeBase*)params.closure1, w, se);
+             se.SetLobeSide(SE_BOTH_SIDES);
          }
      };
 
@@ -433,7 +442,8 @@ namespace {
 
              const auto weight = w;
 
-             if (SE_NONE == (se.GetFlag() & SE_REPLACE_BSSRDF)){
+             // bssrdf is not supported on one side of double sided materials either
+             if (SE_NONE == (se.GetFlag() & SE_REPLACE_BSSRDF) && SE_BOTH_SIDES == se.GetLobeSide()){
  #ifdef SSS_REPLACE_WITH_LAMBERT
                  auto sssBaseColor = params.base_color;
                  const auto pdf_weight = (weight.x + weight.y + weight.z) / 3.0f;
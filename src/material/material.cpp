@@ -16,6 +16,7 @@
  */
 
 #include <string.h>
+#include <unordered_set>
 #include <tsl_system.h>
 #include "material.h"
 #include "matmanager.h"
@@ -29,13 +30,6 @@
 
 USE_TSL_NAMESPACE
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-bool MaterialBase::IsMaterialBuilt() const{
-    // std::memory_order_acquire is needed to make sure compiler doesn't do crazy out-of-order execution thing.
-    return m_is_built.load(std::memory_order_acquire);
-}
-#endif
-
 void Material::BuildMaterial() {
     const auto message = "Build Material '" + m_name + "'";
     SORT_PROFILE(message);
@@ -61,6 +55,14 @@ void Material::BuildMaterial() {
         if (shader_valid) {
             shader_valid = false;
             trying_building_shader_type = true;
+
+            // materials with identical shader graphs share the same compiled shader
+            const auto key = prefix + shader_data.m_key;
+            if (auto cached_instance = MatManager::GetSingleton().FindShaderInstance(key)) {
+                shader_instance = cached_instance;
+                shader_valid = true;
+                return;
+            }
     
             for (const auto& shader : shader_data.m_sources)
                 shader_units[shader.name] = MatManager::GetSingleton().GetShaderUnitTemplate(shader.type);
@@ -122,6 +124,8 @@ void Material::BuildMaterial() {
             ret = shader_instance->resolve_shader_instance();
             if (TSL_Resolving_Status::TSL_Resolving_Succeed != ret)
                 return;
+
+            MatManager::GetSingleton().CacheShaderInstance(key, shader_instance);
     
             shader_valid = true;
         }
@@ -156,11 +160,6 @@ void Material::BuildMaterial() {
     // fake transparent mode if necessary
     if (m_special_transparent)
         m_hasTransparentNode = true;
-
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-    // indicate the material has been built
-    m_is_built.store(true, std::memory_order_release);
-#endif
 }
 
 void Material::Serialize(IStreamBase& stream){
@@ -170,16 +169,30 @@ void Material::Serialize(IStreamBase& stream){
     const auto message = "Parsing Material '" + m_name + "'";
     SORT_PROFILE(message.c_str());
 
+    const auto output_node_name = "ShaderOutput_" + m_name;
+
     auto parse_shader_type = [&](TSL_ShaderData& shader_data, bool& is_shader_valid) {
         is_shader_valid = true;
 
+        const auto append_key = [](std::string& key, const void* data, size_t size) {
+            key.append((const char*)&size, sizeof(size));
+            key.append((const char*)data, size);
+        };
+
         unsigned shader_unit_cnt = 0;
         stream >> shader_unit_cnt;
 
+        // description of each shader unit, its type and default values, used in the key of the shader graph
+        std::vector<ShaderSource> sources(shader_unit_cnt);
+        std::vector<std::vector<ShaderParamDefaultValue>> default_values(shader_unit_cnt);
+        std::vector<std::string> source_keys(shader_unit_cnt);
+
         for (auto i = 0u; i < shader_unit_cnt; ++i) {
             // parse surface shader
-            ShaderSource shader_source;
+            auto& shader_source = sources[i];
+            auto& source_key = source_keys[i];
             stream >> shader_source.name >> shader_source.type;
+            append_key(source_key, shader_source.type.c_str(), shader_source.type.size());
 
             auto parameter_cnt = 0u;
             stream >> parameter_cnt;
@@ -189,36 +202,88 @@ void Material::Serialize(IStreamBase& stream){
                 stream >> default_value.shader_unit_param_name;
                 int channel_num = 0;
                 stream >> channel_num;
+                append_key(source_key, default_value.shader_unit_param_name.c_str(), default_value.shader_unit_param_name.size());
+                append_key(source_key, &channel_num, sizeof(channel_num));
                 // currently only float and float3 are supported for now
                 if (channel_num == 1) {
                     float x;
                     stream >> x;
                     default_value.default_value = x;
+                    append_key(source_key, &x, sizeof(x));
                 }
                 else if (channel_num == 3) {
-                    float x, y, z;
-                    stream >> x >> y >> z;
-                    default_value.default_value = Tsl_Namespace::make_float3(x, y, z);
+                    float x[3];
+                    stream >> x[0] >> x[1] >> x[2];
+                    default_value.default_value = Tsl_Namespace::make_float3(x[0], x[1], x[2]);
+                    append_key(source_key, x, sizeof(x));
                 }
                 else if (channel_num == 4) { // this is fairly ugly, but it works, I will find time to refactor it later.
                     std::string str;
                     stream >> str;
                     default_value.default_value = make_tsl_global_ref(str);
+                    append_key(source_key, str.c_str(), str.size());
                 }
 
-                m_paramDefaultValues.push_back(default_value);
+                default_values[i].push_back(default_value);
             }
-
-            shader_data.m_sources.push_back(shader_source);
         }
 
+        std::vector<ShaderConnection> connections;
         auto connection_cnt = 0u;
         stream >> connection_cnt;
         for (auto i = 0u; i < connection_cnt; ++i) {
             ShaderConnection connection;
             stream >> connection.source_shader >> connection.source_property;
             stream >> connection.target_shader >> connection.target_property;
+            connections.push_back(connection);
+        }
+
+        // Shader units whose outputs never reach the output node of the material are dead, their results are thrown
+        // away during shading. They are stripped from the graph so that they are neither compiled nor executed for
+        // every hit, outputs of the remaining units only connected to dead units are skipped along with them.
+        std::unordered_set<std::string> live_units;
+        std::vector<std::string> pending = { output_node_name };
+        while (!pending.empty()) {
+            const auto target = pending.back();
+            pending.pop_back();
+            for (const auto& connection : connections) {
+                if (connection.target_shader == target && live_units.insert(connection.source_shader).second)
+                    pending.push_back(connection.source_shader);
+            }
+        }
+
+        // Shader unit names are unique across materials, the key of the shader graph refers to shader units by their
+        // indices instead so that materials with identical graphs have identical keys. Only the live part of the graph
+        // is in the key, materials that differ only in dead units share the same shader too.
+        std::unordered_map<std::string, unsigned> shader_unit_index;
+        auto& key = shader_data.m_key;
+        const auto append_name = [&](const std::string& name) {
+            const auto it = shader_unit_index.find(name);
+            const auto index = it == shader_unit_index.end() ? ~0u : it->second;
+            append_key(key, &index, sizeof(index));
+        };
+
+        for (auto i = 0u; i < shader_unit_cnt; ++i) {
+            if (!live_units.count(sources[i].name))
+                continue;
+
+            shader_unit_index[sources[i].name] = (unsigned)shader_data.m_sources.size();
+            key += source_keys[i];
+            m_paramDefaultValues.insert(m_paramDefaultValues.end(), default_values[i].begin(), default_values[i].end());
+            shader_data.m_sources.push_back(sources[i]);
+        }
+
+        for (const auto& connection : connections) {
+            if (!live_units.count(connection.source_shader) || (connection.target_shader != output_node_name && !live_units.count(connection.target_shader)))
+                continue;
+
             shader_data.m_connections.push_back(connection);
+
+            // the only target that is not a shader unit is the output node of the material
+            append_name(connection.source_shader);
+            append_key(key, connection.source_property.c_str(), connection.source_property.size());
+            append_name(connection.target_shader);
+            append_key(key, connection.target_property.c_str(), connection.target_property.size());
         }
     };
 
@@ -238,6 +303,8 @@ void Material::Serialize(IStreamBase& stream){
 
     stream >> m_volumeStep;
     stream >> m_volumeStepCnt;
+
+    stream >> m_emission;
 }
 
 void Material::UpdateScatteringEvent( ScatteringEvent& se ) const {
@@ -263,6 +330,11 @@ void Material::EvaluateMediumSample(const MediumInteraction& mi, MediumSample& m
         EvaluateVolumeSample(m_volume_shader.get(), mi, ms);
 }
 
+void Material::EvaluateMediumSample(const float density, MediumSample& ms) const {
+    if (m_volume_shader_valid)
+        EvaluateVolumeSample(m_volume_shader.get(), density, ms);
+}
+
 void MaterialProxy::UpdateScatteringEvent(ScatteringEvent& se) const {
     return m_material.UpdateScatteringEvent(se);
 }
@@ -275,6 +347,10 @@ void MaterialProxy::EvaluateMediumSample(const MediumInteraction& mi, MediumSamp
     return m_material.EvaluateMediumSample(mi, ms);
 }
 
+void MaterialProxy::EvaluateMediumSample(const float density, MediumSample& ms) const {
+    return m_material.EvaluateMediumSample(density, ms);
+}
+
 StringID  MaterialProxy::GetUniqueID() const {
     // Hopefully there is no conflict with the hash key constructed by the name of the material.
     const std::uintptr_t ret = (const std::uintptr_t)this;
@@ -303,4 +379,8 @@ float MaterialProxy::GetVolumeStep() const {
 
 unsigned int MaterialProxy::GetVolumeStepCnt() const {
     return m_material.GetVolumeStepCnt();
+}
+
+Spectrum MaterialProxy::GetEmission() const {
+    return m_material.GetEmission();
 }
\ No newline at end of file
@@ -24,10 +24,6 @@
 #include "stream/stream.h"
 #include "tsl_system.h"
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-#include <atomic>
-#endif
-
 struct SurfaceInteraction;
 struct MediumInteraction;
 class ScatteringEvent;
@@ -54,6 +50,8 @@ struct TSL_ShaderData {
     std::vector<ShaderSource>           m_sources;
     /**< Shader connections. */
     std::vector<ShaderConnection>       m_connections;
+    /**< Description of the shader graph with shader unit names replaced by their indices, identical graphs compile to identical shaders. */
+    std::string                         m_key;
 };
 
 //! @brief  Base interface for material.
@@ -82,6 +80,15 @@ public:
     //! @param      ms              Medium sample taken.
     virtual void       EvaluateMediumSample(const MediumInteraction& mi, MediumSample& ms) const = 0;
 
+    //! @brief      Evaluate the properties of the medium with a specific density.
+    //!
+    //! Volume shaders only see the density of the volume, this evaluates them without a position. It is used to
+    //! bound the extinction of heterogeneous volumes before rendering.
+    //!
+    //! @param      density         Density of the volume.
+    //! @param      ms              Medium sample taken.
+    virtual void       EvaluateMediumSample(const float density, MediumSample& ms) const = 0;
+
     //! @brief      Evaluate translucency.
     //!
     //! @param      intersection    The intersection.
@@ -123,16 +130,10 @@ public:
     //! @return     Maximum steps to march during ray marching.
     virtual unsigned int GetVolumeStepCnt() const = 0;
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-    //! @brief  Whether the material has been built.
+    //! @brief  Get the radiance emitted by surfaces with the material.
     //!
-    //! @return     True if the material has been built, even if it fails.
-    bool IsMaterialBuilt() const;
-
-protected:
-    /**< Whether the material has been built, even if it fails building, it is still considered built. */
-    std::atomic<bool>   m_is_built = false;
-#endif
+    //! @return     Emitted radiance, it is black for materials that don't emit light.
+    virtual Spectrum    GetEmission() const = 0;
 };
 
 //! @brief  A thin layer of material definition.
@@ -167,6 +168,12 @@ public:
     //! @param      ms              Medium sample taken.
     void        EvaluateMediumSample(const MediumInteraction& mi, MediumSample& ms) const override;
 
+    //! @brief      Evaluate the properties of the medium with a specific density.
+    //!
+    //! @param      density         Density of the volume.
+    //! @param      ms              Medium sample taken.
+    void        EvaluateMediumSample(const float density, MediumSample& ms) const override;
+
     //! @brief      Evaluate translucency.
     //!
     //! @param      intersection    The intersection.
@@ -233,6 +240,27 @@ public:
         return m_volumeStepCnt;
     }
 
+    //! @brief  Get the radiance emitted by surfaces with the material.
+    //!
+    //! @return Emitted radiance, it is black for materials that don't emit light.
+    Spectrum    GetEmission() const override{
+        return m_emission;
+    }
+
+    //! @brief  Get the shader graph of the surface shader.
+    //!
+    //! @return Shader units and connections of the surface shader.
+    const TSL_ShaderData& GetSurfaceShaderData() const {
+        return m_surface_shader_data;
+    }
+
+    //! @brief  Get the shader graph of the volume shader.
+    //!
+    //! @return Shader units and connections of the volume shader.
+    const TSL_ShaderData& GetVolumeShaderData() const {
+        return m_volume_shader_data;
+    }
+
 private:
     /**< Whether this is a valid material */
     bool                            m_surface_shader_valid = false;
@@ -267,6 +295,9 @@ private:
 
     float                           m_volumeStep = 0.1f;
     unsigned int                    m_volumeStepCnt = 1024;
+
+    /**< Radiance emitted by surfaces with the material. */
+    Spectrum                        m_emission;
 };
 
 //! @brief  MaterialProxy is nothing but a thin wrapper of another existed material.
@@ -301,6 +332,12 @@ public:
     //! @param      ms              Medium sample taken.
     void        EvaluateMediumSample(const MediumInteraction& mi, MediumSample& ms) const override;
 
+    //! @brief      Evaluate the properties of the medium with a specific density.
+    //!
+    //! @param      density         Density of the volume.
+    //! @param      ms              Medium sample taken.
+    void        EvaluateMediumSample(const float density, MediumSample& ms) const override;
+
     //! @brief  Just an empty interface, there is no serialization support for this type of material.
     //!
     //! @param  stream      Input stream for data.
@@ -347,6 +384,11 @@ public:
     //! @return Maximum steps to march during ray marching.
     unsigned int GetVolumeStepCnt() const override;
 
+    //! @brief  Get the radiance emitted by surfaces with the material.
+    //!
+    //! @return Emitted radiance, it is black for materials that don't emit light.
+    Spectrum    GetEmission() const override;
+
 private:
     /**< Material to be referred. */
     const MaterialBase& m_material;
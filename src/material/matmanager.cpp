@@ -25,42 +25,68 @@
 #include "scatteringevent/bsdf/merl.h"
 #include "scatteringevent/bsdf/fourierbxdf.h"
 #include "texture/imagetexture2d.h"
+#include "task/task.h"
 
 #ifdef ENABLE_ASYNC_TEXTURE_LOADING
 #include <future>
 #endif
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-#include "task/task.h"
-#endif
+//! @brief  A task for compiling a shader unit template.
+class CompileShaderUnit_Task : public Task {
+public:
+    //! @brief Constructor
+    //!
+    //! @param index        Index of the shader unit template in the material file.
+    CompileShaderUnit_Task(unsigned int index, const char* name, unsigned int priority,
+        const Task::Task_Container& dependencies) :
+        Task(name, priority, dependencies), m_index(index) {}
+
+    //! @brief  Execute the task
+    void        Execute() override {
+        MatManager::GetSingleton().CompileShaderUnitTemplate(m_index);
+    }
+
+private:
+    unsigned int m_index;
+};
+
+//! @brief  A task for compiling a shader group template.
+class CompileShaderGroup_Task : public Task {
+public:
+    //! @brief Constructor
+    //!
+    //! @param index        Index of the shader group template in the material file.
+    CompileShaderGroup_Task(unsigned int index, const char* name, unsigned int priority,
+        const Task::Task_Container& dependencies) :
+        Task(name, priority, dependencies), m_index(index) {}
+
+    //! @brief  Execute the task
+    void        Execute() override {
+        MatManager::GetSingleton().CompileShaderGroupTemplate(m_index);
+    }
+
+private:
+    unsigned int m_index;
+};
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-//! @brief  A task for compiling materials in a seperate thread
+//! @brief  A task for building a material.
 class CompileMaterial_Task : public Task {
 public:
     //! @brief Constructor
     //!
-    //! @param priority     New priority of the task.
+    //! @param material     Material to be built.
     CompileMaterial_Task(Material* material, const char* name, unsigned int priority,
         const Task::Task_Container& dependencies) :
-        Task(name, priority, dependencies), material(material) {}
+        Task(name, priority, dependencies), m_material(material) {}
 
     //! @brief  Execute the task
     void        Execute() override {
-        material->BuildMaterial();
+        m_material->BuildMaterial();
     }
 
 private:
-    Material* material;
+    Material* m_material;
 };
-#endif
-
-namespace {
-    struct ShaderResourceBinding {
-        std::string resource_handle_name;
-        std::string shader_resource_name;
-    };
-}
 
 #ifdef ENABLE_ASYNC_TEXTURE_LOADING
 static bool async_load_resource(Resource* resource, std::string filename) {
@@ -68,19 +94,10 @@ static bool async_load_resource(Resource* resource, std::string filename) {
 }
 #endif
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION_CHEAP
-static void async_build_material(MaterialBase* material) {
-    material->BuildMaterial();
-}
-#endif
-
 // parse material file and add the materials into the manager
 unsigned MatManager::ParseMatFile( IStreamBase& stream ){
     SORT_PROFILE("Parsing Materials");
 
-    const auto current_task = GetCurrentTask();
-    const auto dependencies = current_task->GetDependencies();
-
     auto resource_cnt = 0u;
     stream >> resource_cnt;
 
@@ -88,10 +105,6 @@ unsigned MatManager::ParseMatFile( IStreamBase& stream ){
     std::vector<std::future<bool>>      async_resource_reading;
 #endif
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION_CHEAP
-    std::vector<std::future<void>>      async_material_building;
-#endif
-
     for (auto i = 0u; i < resource_cnt; ++i) {
         std::string resource_file;
         StringID resource_type;
@@ -135,60 +148,32 @@ unsigned MatManager::ParseMatFile( IStreamBase& stream ){
         if (material_type == SID("End of Material"))
             break;
         else if (material_type == SID("ShaderUnitTemplate")) {
+            ShaderUnitTemplateData shader_unit;
+
             // shader type, maybe I should use string id here.
-            std::string shader_node_type;
-            stream >> shader_node_type;
+            stream >> shader_unit.name;
 
             // stream the shader source code
-            std::string source_code;
-            stream >> source_code;
-
-            /**< Shader reousrce binding. */
-            std::vector<ShaderResourceBinding>  m_shader_resources_binding;
+            stream >> shader_unit.source_code;
 
             unsigned int shader_resources = 0;
             stream >> shader_resources;
             for (auto i = 0u; i < shader_resources; ++i) {
-                ShaderResourceBinding srb;
-                stream >> srb.resource_handle_name >> srb.shader_resource_name;
-                m_shader_resources_binding.push_back(srb);
+                std::string resource_handle_name, shader_resource_name;
+                stream >> resource_handle_name >> shader_resource_name;
+                shader_unit.resources.push_back(std::make_pair(resource_handle_name, shader_resource_name));
             }
 
-            // compile the shader unit template
-            auto shading_context = GetShadingContext();
-
-            // allocate the shader unit template
-            const auto shader_unit_template = shading_context->begin_shader_unit_template(shader_node_type);
-            
-            // register tsl global
-            TslGlobal::shader_unit_register(shader_unit_template.get());
-
-            // bind shader resources
-            for (auto sr : m_shader_resources_binding) {
-                auto resource = MatManager::GetSingleton().GetResource(sr.shader_resource_name);
-                shader_unit_template->register_shader_resource(sr.resource_handle_name, (const Tsl_Namespace::ShaderResourceHandle*)resource);
-            }
-
-            // compile the shader unit
-            const auto ret = shader_unit_template->compile_shader_source(source_code.c_str());
-
-            // indicate the end of shader unit compilation
-            shading_context->end_shader_unit_template(shader_unit_template.get());
-
-            // push it if it compiles the shader successful
-            if( ret )
-                m_shader_units[shader_node_type] = shader_unit_template;
+            // the shader unit template will be compiled later in its own task
+            m_pending_shader_units.push_back(std::move(shader_unit));
         }
         else if (material_type == SID("ShaderGroupTemplate")) {
-            // The following logic is very similar with 
-            std::string shader_template_type;
-            stream >> shader_template_type;
+            ShaderGroupTemplateData shader_group;
+            stream >> shader_group.name;
 
             unsigned shader_unit_cnt = 0;
             stream >> shader_unit_cnt;
 
-            TSL_ShaderData shader_data;
-
             for (auto i = 0u; i < shader_unit_cnt; ++i) {
                 // parse surface shader
                 ShaderSource shader_source;
@@ -219,10 +204,10 @@ unsigned MatManager::ParseMatFile( IStreamBase& stream ){
                         default_value.default_value = Tsl_Namespace::make_tsl_global_ref(str);
                     }
 
-                    m_paramDefaultValues.push_back(default_value);
+                    shader_group.default_values.push_back(default_value);
                 }
 
-                shader_data.m_sources.push_back(shader_source);
+                shader_group.shader_data.m_sources.push_back(shader_source);
             }
 
             auto connection_cnt = 0u;
@@ -231,73 +216,32 @@ unsigned MatManager::ParseMatFile( IStreamBase& stream ){
                 ShaderConnection connection;
                 stream >> connection.source_shader >> connection.source_property;
                 stream >> connection.target_shader >> connection.target_property;
-                shader_data.m_connections.push_back(connection);
+                shader_group.shader_data.m_connections.push_back(connection);
             }
 
-            // compiling the shader group template
-            std::unordered_map<std::string, std::shared_ptr<Tsl_Namespace::ShaderUnitTemplate>> shader_units;
-            for (const auto& shader : shader_data.m_sources)
-                shader_units[shader.name] = MatManager::GetSingleton().GetShaderUnitTemplate(shader.type);
-
-            auto context = GetShadingContext();
-
-            // begin compiling shader group
-            auto shader_group = context->begin_shader_group_template(shader_template_type);
-            if (!shader_group)
-                continue;
-
-            // register tsl global
-            TslGlobal::shader_unit_register(shader_group.get());
-
-            // expose arguments in output node
-            std::string root_shader_name;
-            stream >> root_shader_name;
+            // arguments exposed in output node
+            stream >> shader_group.root_shader_name;
             unsigned int exposed_out_arg_cnt = 0;
             stream >> exposed_out_arg_cnt;
             for (auto i = 0u; i < exposed_out_arg_cnt; ++i) {
                 std::string arg_name;
                 stream >> arg_name;
-
-                // expose the shader interface
-                shader_group->expose_shader_argument(root_shader_name, arg_name);
+                shader_group.exposed_out_args.push_back(arg_name);
             }
 
-            std::string shader_group_input_name;
-            stream >> shader_group_input_name;
-
-            if (!shader_group_input_name.empty()) {
+            stream >> shader_group.input_shader_name;
+            if (!shader_group.input_shader_name.empty()) {
                 unsigned int exposed_in_arg_cnt = 0;
                 stream >> exposed_in_arg_cnt;
                 for (auto i = 0u; i < exposed_in_arg_cnt; ++i) {
                     std::string arg_name;
                     stream >> arg_name;
-
-                    // expose the shader interface
-                    shader_group->expose_shader_argument(shader_group_input_name, arg_name, false);
+                    shader_group.exposed_in_args.push_back(arg_name);
                 }
             }
 
-            for (auto su : shader_units) {
-                const auto is_root = (su.first == root_shader_name);
-                const auto ret = shader_group->add_shader_unit(su.first, su.second, is_root);
-                if (!ret)
-                    continue;
-            }
-
-            // connect the shader units
-            for (auto connection : shader_data.m_connections)
-                shader_group->connect_shader_units(connection.source_shader, connection.source_property, connection.target_shader, connection.target_property);
-
-            // update default values
-            for (const auto& dv : m_paramDefaultValues)
-                shader_group->init_shader_input(dv.shader_unit_name, dv.shader_unit_param_name, dv.default_value);
-
-            // end building the shader group
-            auto ret = context->end_shader_group_template(shader_group.get());
-
-            // push it if it compiles the shader successful
-            if (Tsl_Namespace::TSL_Resolving_Status::TSL_Resolving_Succeed == ret)
-                m_shader_units[shader_template_type] = shader_group;
+            // the shader group template will be compiled later in its own task
+            m_pending_shader_groups.push_back(std::move(shader_group));
         }
         else if (material_type == SID("Material")) {
             // allocate a new material
@@ -307,18 +251,10 @@ unsigned MatManager::ParseMatFile( IStreamBase& stream ){
             mat->Serialize(stream);
 
             if (LIKELY(!noMaterialSupport)) {
-         
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION_CHEAP
-                async_material_building.push_back(std::async(std::launch::async, async_build_material, mat.get()));
-#elif defined(ENABLE_MULTI_THREAD_SHADER_COMPILATION)
-                // build the material asynchronously
-                SCHEDULE_TASK<CompileMaterial_Task>("Compiling Material", DEFAULT_TASK_PRIORITY, {}, mat.get());
-#else
-                // build the material
-                mat->BuildMaterial();
-#endif
+                // the material will be built later in its own task
+                m_pending_materials.push_back(mat.get());
 
-                // push the compiled material in the pool
+                // push the material in the pool
                 m_matPool.push_back(std::move(mat));
             }
         }
@@ -331,17 +267,121 @@ unsigned MatManager::ParseMatFile( IStreamBase& stream ){
     std::for_each(async_resource_reading.begin(), async_resource_reading.end(), [](std::future<bool>& promise) { promise.wait(); });
 #endif
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION_CHEAP
-    std::for_each(async_material_building.begin(), async_material_building.end(), [](std::future<void>& promise) { promise.wait(); });
-#endif
+    return (unsigned int)m_matPool.size();
+}
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-    // this is only a temporary solution before I have job system that is more robust and flexible to support spawning jobs inside other jobs.
-    // wait for all materials to be built before moving forward
-    MatManager::GetSingleton().WaitForMaterialBuilding();
-#endif
+void MatManager::BuildMaterials() {
+    SORT_PROFILE("Scheduling Shader Compilation");
 
-    return (unsigned int)m_matPool.size();
+    // tasks compiling each shader template, shader groups and materials wait for the templates they use
+    std::unordered_map<std::string, const Task*> template_tasks;
+    auto collect_dependencies = [&](const TSL_ShaderData& shader_data, Task::Task_Container& dependencies) {
+        for (const auto& source : shader_data.m_sources) {
+            const auto it = template_tasks.find(source.type);
+            if (it != template_tasks.end())
+                dependencies.insert(it->second);
+        }
+    };
+
+    for (auto i = 0u; i < m_pending_shader_units.size(); ++i)
+        template_tasks[m_pending_shader_units[i].name] = SCHEDULE_SUB_TASK<CompileShaderUnit_Task>("Compiling Shader Unit", DEFAULT_TASK_PRIORITY, {}, i);
+
+    // shader groups could be made of shader groups defined earlier in the material file
+    for (auto i = 0u; i < m_pending_shader_groups.size(); ++i) {
+        Task::Task_Container dependencies;
+        collect_dependencies(m_pending_shader_groups[i].shader_data, dependencies);
+        template_tasks[m_pending_shader_groups[i].name] = SCHEDULE_SUB_TASK<CompileShaderGroup_Task>("Compiling Shader Group", DEFAULT_TASK_PRIORITY, dependencies, i);
+    }
+
+    for (auto material : m_pending_materials) {
+        Task::Task_Container dependencies;
+        collect_dependencies(material->GetSurfaceShaderData(), dependencies);
+        collect_dependencies(material->GetVolumeShaderData(), dependencies);
+        SCHEDULE_SUB_TASK<CompileMaterial_Task>("Compiling Material", DEFAULT_TASK_PRIORITY, dependencies, material);
+    }
+    m_pending_materials.clear();
+}
+
+void MatManager::CompileShaderUnitTemplate(unsigned int index) {
+    const auto& shader_unit = m_pending_shader_units[index];
+
+    // compile the shader unit template
+    auto shading_context = GetShadingContext();
+
+    // allocate the shader unit template
+    const auto shader_unit_template = shading_context->begin_shader_unit_template(shader_unit.name);
+
+    // register tsl global
+    TslGlobal::shader_unit_register(shader_unit_template.get());
+
+    // bind shader resources
+    for (const auto& sr : shader_unit.resources) {
+        auto resource = GetResource(sr.second);
+        shader_unit_template->register_shader_resource(sr.first, (const Tsl_Namespace::ShaderResourceHandle*)resource);
+    }
+
+    // compile the shader unit
+    const auto ret = shader_unit_template->compile_shader_source(shader_unit.source_code.c_str());
+
+    // indicate the end of shader unit compilation
+    shading_context->end_shader_unit_template(shader_unit_template.get());
+
+    // push it if it compiles the shader successful
+    if (ret) {
+        std::lock_guard<std::mutex> lock(m_shader_units_mutex);
+        m_shader_units[shader_unit.name] = shader_unit_template;
+    }
+}
+
+void MatManager::CompileShaderGroupTemplate(unsigned int index) {
+    const auto& group = m_pending_shader_groups[index];
+
+    // compiling the shader group template
+    std::unordered_map<std::string, std::shared_ptr<Tsl_Namespace::ShaderUnitTemplate>> shader_units;
+    for (const auto& shader : group.shader_data.m_sources)
+        shader_units[shader.name] = GetShaderUnitTemplate(shader.type);
+
+    auto context = GetShadingContext();
+
+    // begin compiling shader group
+    auto shader_group = context->begin_shader_group_template(group.name);
+    if (!shader_group)
+        return;
+
+    // register tsl global
+    TslGlobal::shader_unit_register(shader_group.get());
+
+    // expose arguments in output node
+    for (const auto& arg_name : group.exposed_out_args)
+        shader_group->expose_shader_argument(group.root_shader_name, arg_name);
+
+    // expose arguments in input node
+    for (const auto& arg_name : group.exposed_in_args)
+        shader_group->expose_shader_argument(group.input_shader_name, arg_name, false);
+
+    for (auto su : shader_units) {
+        const auto is_root = (su.first == group.root_shader_name);
+        const auto ret = shader_group->add_shader_unit(su.first, su.second, is_root);
+        if (!ret)
+            continue;
+    }
+
+    // connect the shader units
+    for (const auto& connection : group.shader_data.m_connections)
+        shader_group->connect_shader_units(connection.source_shader, connection.source_property, connection.target_shader, connection.target_property);
+
+    // update default values
+    for (const auto& dv : group.default_values)
+        shader_group->init_shader_input(dv.shader_unit_name, dv.shader_unit_param_name, dv.default_value);
+
+    // end building the shader group
+    auto ret = context->end_shader_group_template(shader_group.get());
+
+    // push it if it compiles the shader successful
+    if (Tsl_Namespace::TSL_Resolving_Status::TSL_Resolving_Succeed == ret) {
+        std::lock_guard<std::mutex> lock(m_shader_units_mutex);
+        m_shader_units[group.name] = shader_group;
+    }
 }
 
 const Resource* MatManager::GetResource(const std::string& name) const {
@@ -357,18 +397,22 @@ const MaterialBase* MatManager::CreateMaterialProxy(const MaterialBase& material
 }
 
 std::shared_ptr<Tsl_Namespace::ShaderUnitTemplate> MatManager::GetShaderUnitTemplate(const std::string& name_id) const {
+    std::lock_guard<std::mutex> lock(m_shader_units_mutex);
     auto it = m_shader_units.find(name_id);
     if (it == m_shader_units.end())
         return nullptr;
     return it->second;
 }
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-void MatManager::WaitForMaterialBuilding() const {
-    std::for_each(m_matPool.begin(), m_matPool.end(), [](const std::unique_ptr<MaterialBase>& mat) {
-        while (!mat->IsMaterialBuilt()) {
-            _mm_pause();
-        }
-    });
+std::shared_ptr<Tsl_Namespace::ShaderInstance> MatManager::FindShaderInstance(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(m_shader_instances_mutex);
+    auto it = m_shader_instances.find(key);
+    if (it == m_shader_instances.end())
+        return nullptr;
+    return it->second;
+}
+
+void MatManager::CacheShaderInstance(const std::string& key, const std::shared_ptr<Tsl_Namespace::ShaderInstance>& instance) {
+    std::lock_guard<std::mutex> lock(m_shader_instances_mutex);
+    m_shader_instances.emplace(key, instance);
 }
-#endif
\ No newline at end of file
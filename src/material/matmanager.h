@@ -21,6 +21,7 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <mutex>
 #include "core/singleton.h"
 #include "material/material.h"
 #include "core/resource.h"
@@ -61,6 +62,16 @@ public:
     // result           : the number of materials in the file
     unsigned    ParseMatFile( class IStreamBase& stream );
 
+    //! @brief  Compile shaders and build materials parsed from the material file.
+    //!
+    //! Nothing is compiled here, each shader unit template, shader group template and material is compiled in
+    //! a sub task of the current task. Shader group templates depend on the templates they are made of and
+    //! materials depend on the templates used in their shader graphs, so that independent shaders are compiled
+    //! by different threads, each with its own shading context. Tasks depending on the current task won't start
+    //! before all materials are built.
+    //! This can only be called inside a task.
+    void        BuildMaterials();
+
     //! @brief  Get resource data based on index.
     //!
     //! @param  name        Name of the resource.
@@ -73,20 +84,66 @@ public:
     //! @return             The shader unit template returned, nullptr if it doesn't exist.
     std::shared_ptr<Tsl_Namespace::ShaderUnitTemplate> GetShaderUnitTemplate(const std::string& name) const;
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-    //! @brief  Wait for all materials to be built before moving forward
-    void WaitForMaterialBuilding() const;
-#endif
+    //! @brief  Find a shader instance compiled from an identical shader graph.
+    //!
+    //! It is thread safe to call this function while materials are built in multiple threads.
+    //!
+    //! @param  key         Description of the shader graph with shader units referred by indices.
+    //! @return             The shader instance, nullptr if no identical shader graph has been compiled.
+    std::shared_ptr<Tsl_Namespace::ShaderInstance> FindShaderInstance(const std::string& key) const;
+
+    //! @brief  Keep a compiled shader instance so that identical shader graphs don't need to be compiled again.
+    //!
+    //! @param  key         Description of the shader graph with shader units referred by indices.
+    //! @param  instance    The compiled shader instance.
+    void CacheShaderInstance(const std::string& key, const std::shared_ptr<Tsl_Namespace::ShaderInstance>& instance);
+
+    //! @brief  Compile a shader unit template parsed from the material file.
+    //!
+    //! @param  index           Index of the shader unit template in the material file.
+    void CompileShaderUnitTemplate(unsigned int index);
+
+    //! @brief  Compile a shader group template parsed from the material file.
+    //!
+    //! @param  index           Index of the shader group template in the material file.
+    void CompileShaderGroupTemplate(unsigned int index);
 
 private:
+    //! @brief  Description of a shader group template parsed from the material file.
+    struct ShaderGroupTemplateData {
+        std::string                             name;               /**< Type of the shader group template. */
+        TSL_ShaderData                          shader_data;        /**< Shader units and connections in the group. */
+        std::vector<ShaderParamDefaultValue>    default_values;     /**< Default values of the shader unit inputs. */
+        std::string                             root_shader_name;   /**< Name of the shader unit whose outputs are exposed. */
+        std::vector<std::string>                exposed_out_args;   /**< Exposed output arguments. */
+        std::string                             input_shader_name;  /**< Name of the shader unit whose inputs are exposed, it could be empty. */
+        std::vector<std::string>                exposed_in_args;    /**< Exposed input arguments. */
+    };
+
+    //! @brief  Description of a shader unit template parsed from the material file.
+    struct ShaderUnitTemplateData {
+        std::string                                         name;           /**< Type of the shader unit template. */
+        std::string                                         source_code;    /**< Source code of the shader. */
+        std::vector<std::pair<std::string, std::string>>    resources;      /**< Resource handle names and names of resources bound to them. */
+    };
+
     std::vector<std::unique_ptr<MaterialBase>>       m_matPool;         /**< Material pool holding all materials. */
 
     std::unordered_map<std::string, std::unique_ptr<Resource>>  m_resources;       /**< Resources used during BXDF evaluation. */
 
     std::unordered_map<std::string, std::shared_ptr<Tsl_Namespace::ShaderUnitTemplate>>     m_shader_units;
-
-    /**< Shader unit default values. */
-    std::vector<ShaderParamDefaultValue>        m_paramDefaultValues;
+    /**< Mutex protecting the compiled shader templates. */
+    mutable std::mutex                          m_shader_units_mutex;
+
+    /**< Shader templates and materials parsed from the material file, waiting to be compiled. */
+    std::vector<ShaderUnitTemplateData>         m_pending_shader_units;
+    std::vector<ShaderGroupTemplateData>        m_pending_shader_groups;
+    std::vector<Material*>                      m_pending_materials;
+
+    /**< Compiled shader instances keyed by the description of their shader graphs. */
+    std::unordered_map<std::string, std::shared_ptr<Tsl_Namespace::ShaderInstance>>    m_shader_instances;
+    /**< Mutex protecting the compiled shader instances. */
+    mutable std::mutex                          m_shader_instances_mutex;
 
     friend class Singleton<MatManager>;
 };
@@ -68,12 +68,8 @@ public:
 static std::vector<std::shared_ptr<ShadingContext>>    g_contexts;
 
 std::shared_ptr<Tsl_Namespace::ShadingContext> GetShadingContext() {
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION_CHEAP
-    // this is by no means a good approach, but I'll live with it before I have a proper job system.
-    return ShadingSystem::get_instance().make_shading_context();
-#else
+    // each worker thread compiles shaders with its own shading context
     return g_contexts[ThreadId()];
-#endif
 }
 
 void ExecuteSurfaceShader( Tsl_Namespace::ShaderInstance* shader , ScatteringEvent& se ){
@@ -106,8 +102,12 @@ void ExecuteVolumeShader(Tsl_Namespace::ShaderInstance* shader, const MediumInte
 }
 
 void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const MediumInteraction& mi, MediumSample& ms) {
+    EvaluateVolumeSample(shader, mi.mesh->SampleVolumeDensity(mi.intersect), ms);
+}
+
+void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const float density, MediumSample& ms) {
     TslGlobal global;
-    global.density = mi.mesh->SampleVolumeDensity(mi.intersect);
+    global.density = density;
 
     ClosureTreeNodeBase* closure = nullptr;
     auto raw_function = (void(*)(ClosureTreeNodeBase**, TslGlobal*))shader->get_function();
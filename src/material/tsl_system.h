@@ -73,6 +73,13 @@ void ExecuteVolumeShader(Tsl_Namespace::ShaderInstance* shader, const MediumInte
 //! @param  ms          The medium sample to be returned.
 void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const MediumInteraction& mi, MediumSample& ms);
 
+//! @brief  Evaluate the properties of the volume with a specific density.
+//!
+//! @param  shader      The tsl shader to be executed.
+//! @param  density     The density of the volume.
+//! @param  ms          The medium sample to be returned.
+void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const float density, MediumSample& ms);
+
 //! @brief  Evaluate the transparency of the intersection.
 //!
 //! @param  shader          The tsl shader to be evaluated.
@@ -19,6 +19,7 @@
 #include "math/ray.h"
 #include "core/samplemethod.h"
 #include "core/memory.h"
+#include "task/task.h"
 
 // evaluate value from sky
 Spectrum Sky::Evaluate( const Vector& wi ) const
@@ -39,36 +40,78 @@ Spectrum Sky::GetAverage() const
 }
 
 // generate 2d distribution
-void Sky::_generateDistribution2D()
+void Sky::_generateDistribution2D(bool mis_compensation)
 {
     auto nu = m_sky.GetWidth();
     auto nv = m_sky.GetHeight();
     sAssert( nu != 0 && nv != 0 , LIGHT );
-    auto data = std::make_unique<float[]>(nu*nv);
-    for( auto i = 0 ; i < nv ; i++ )
-    {
-        auto offset = i * nu;
-        float sin_theta = sin( (float)i / (float)nv * PI );
 
-        for( auto j = 0 ; j < nu ; j++ )
-            data[offset+j] = std::max( 0.0f , m_sky.GetColor( (int)j , (int)i ).GetIntensity() * sin_theta );
-    }
+    // texels are weighted by the solid angle they cover, the average radiance is accumulated along the way
+    auto data = std::make_unique<float[]>(nu*nv);
+    auto row_sum = std::make_unique<double[]>(nv);
+    auto row_weight = std::make_unique<double[]>(nv);
+    ParallelForRows( nv , [&]( int v0 , int v1 ){
+        for( auto i = v0 ; i < v1 ; i++ )
+        {
+            auto offset = i * nu;
+            float sin_theta = sin( ( (float)i + 0.5f ) / (float)nv * PI );
+
+            row_sum[i] = 0.0;
+            for( auto j = 0 ; j < nu ; j++ ){
+                data[offset+j] = std::max( 0.0f , m_sky.GetColor( (int)j , (int)i ).GetIntensity() * sin_theta );
+                row_sum[i] += data[offset+j];
+            }
+            row_weight[i] = (double)sin_theta * nu;
+        }
+    });
 
     distribution.reset();
     distribution = std::make_unique<Distribution2D>( data.get() , nu , nv );
+
+    // The MIS compensation comes from "MIS Compensation: Optimizing Sampling Techniques in Multiple Importance Sampling" by Karlik et al.
+    // Texels darker than the average are mostly left to BSDF sampling. They are not totally dropped though, since lights are also
+    // sampled without MIS in some cases, like single scattering in media, where a zero pdf would mean losing their contribution.
+    compensatedDistribution.reset();
+    if( mis_compensation ){
+        auto total = 0.0 , total_weight = 0.0;
+        for( auto i = 0 ; i < nv ; i++ ){
+            total += row_sum[i];
+            total_weight += row_weight[i];
+        }
+        if( total_weight <= 0.0 || total <= 0.0 )
+            return;
+        const auto average = (float)( total / total_weight );
+
+        static constexpr float min_ratio = 1.0f / 16.0f;
+        ParallelForRows( nv , [&]( int v0 , int v1 ){
+            for( auto i = v0 ; i < v1 ; i++ )
+            {
+                auto offset = i * nu;
+                float sin_theta = sin( ( (float)i + 0.5f ) / (float)nv * PI );
+                for( auto j = 0 ; j < nu ; j++ ){
+                    const auto l = std::max( 0.0f , m_sky.GetColor( (int)j , (int)i ).GetIntensity() );
+                    data[offset+j] = std::max( l - average , l * min_ratio ) * sin_theta;
+                }
+            }
+        });
+        compensatedDistribution = std::make_unique<Distribution2D>( data.get() , nu , nv );
+    }
 }
 
 // sample direction
-Vector Sky::sample_v( float u , float v , float* pdf , float* area_pdf ) const
+Vector Sky::sample_v( float u , float v , float* pdf , float* area_pdf , bool mis ) const
 {
-    sAssert( distribution != 0 , LIGHT );
+    const auto dist = _getDistribution( mis );
+    sAssert( dist != 0 , LIGHT );
 
     float uv[2] ;
     float apdf = 0.0f;
-    distribution->SampleContinuous( u , v , uv , &apdf );
+    dist->SampleContinuous( u , v , uv , &apdf );
     if( area_pdf ) *area_pdf = apdf;
-    if( apdf == 0.0f )
+    if( apdf == 0.0f ){
+        if( pdf ) *pdf = 0.0f;
         return Vector();
+    }
 
     float theta = PI * ( 1.0f - uv[1] );
     float phi = TWO_PI * uv[0];
@@ -88,7 +131,7 @@ Vector Sky::sample_v( float u , float v , float* pdf , float* area_pdf ) const
 }
 
 // get the pdf
-float Sky::Pdf( const Vector& lwi ) const
+float Sky::Pdf( const Vector& lwi , bool mis ) const
 {
     float sin_theta = sinTheta(lwi);
     if( sin_theta == 0.0f ) return 0.0f;
@@ -98,5 +141,5 @@ float Sky::Pdf( const Vector& lwi ) const
     v = 1.0f - theta * INV_PI;
     u = phi * INV_TWOPI;
 
-    return distribution->Pdf( u , v ) / ( TWO_PI * PI * sin_theta );
+    return _getDistribution( mis )->Pdf( u , v ) / ( TWO_PI * PI * sin_theta );
 }
@@ -36,21 +36,32 @@ public:
     Spectrum GetAverage() const;
 
     // sample direction
-    Vector sample_v(float u, float v, float* pdf, float* area_pdf) const;
+    // para 'mis' : whether to sample the MIS compensated distribution, it should only be used when
+    //              the samples are combined with BSDF samples through multiple importance sampling
+    Vector sample_v(float u, float v, float* pdf, float* area_pdf, bool mis = false) const;
 
     // get the pdf
-    float Pdf(const Vector& wi) const;
+    // para 'mis' : whether to evaluate the pdf of the MIS compensated distribution
+    float Pdf(const Vector& wi, bool mis = false) const;
 
     // load image file
-    void Load(const std::string& str) {
+    // para 'mis_compensation' : whether to build the MIS compensated distribution
+    void Load(const std::string& str, bool mis_compensation = true) {
         m_sky.LoadResource(str);
-        _generateDistribution2D();
+        _generateDistribution2D(mis_compensation);
     }
 
 private:
     ImageTexture2D    m_sky;
     std::unique_ptr<class Distribution2D>   distribution = nullptr;
+    // distribution with the average radiance subtracted, it is left to BSDF sampling to cover the dim regions
+    std::unique_ptr<class Distribution2D>   compensatedDistribution = nullptr;
 
     // generate 2d distribution
-    void _generateDistribution2D();
+    void _generateDistribution2D(bool mis_compensation);
+
+    // get the distribution to be used
+    const Distribution2D* _getDistribution(bool mis) const {
+        return ( mis && compensatedDistribution ) ? compensatedDistribution.get() : distribution.get();
+    }
 };
@@ -15,9 +15,15 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include "heterogeneous.h"
 #include "core/rand.h"
 #include "core/memory.h"
+#include "core/mesh.h"
+#include "core/log.h"
+#include "medium/majorantgrid.h"
 #include "material/material.h"
 #include "phasefunction.h"
 
@@ -29,105 +35,126 @@ IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float, scattering)
 IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float, anisotropy)
 IMPLEMENT_CLOSURE_TYPE_END(ClosureTypeHeterogenous)
 
-Spectrum HeterogenousMedium::Tr(const Ray& ray, const float max_t) const {
-    // get the step size and count
-    auto        step_size = m_material->GetVolumeStep();
-    const auto  step_cnt = m_material->GetVolumeStepCnt();
-
-    auto t = 0.0f;
-    Spectrum exponent(0.0f);
+// Ratio tracking is terminated by russian roulette once the transmittance drops below this.
+static constexpr float  RATIO_TRACKING_RR_THRESHOLD = 0.1f;
 
-    // ray marching
-    for (auto i = 0u; i < step_cnt; ++i) {
-        const auto dt = t + step_size <= max_t ? step_size : max_t - t;
-        const auto new_t = t + dt * sort_canonical();
+MediumSample HeterogenousMedium::evaluate(const Point& p) const {
+    MediumSample ms;
+    MediumInteraction mi;
+    mi.intersect = p;
+    mi.mesh = m_mesh;
+    m_material->EvaluateMediumSample(mi, ms);
+    return ms;
+}
 
-        // take a sample in the medium
-        MediumSample ms;
-        MediumInteraction tmp_mi;
-        tmp_mi.intersect = ray(new_t);
-        tmp_mi.mesh = m_mesh;
-        m_material->EvaluateMediumSample(tmp_mi, ms);
+// Warn only once about extinction exceeding the majorant.
+static std::atomic<bool> g_majorantExceeded(false);
+
+// The majorant grid is padded, but an arbitrary volume shader could still exceed it, making weights of tracking negative.
+// Coefficients of channels above the majorant are scaled down to it in this case. This is biased, so it is reported
+// instead of being silently ignored.
+static Spectrum clampToMajorant(const Spectrum& extinction, const float majorant) {
+    Spectrum scale(1.0f);
+    for (auto i = 0u; i < RGBSPECTRUM_SAMPLE; ++i) {
+        if (extinction[i] > majorant) {
+            scale[i] = majorant / extinction[i];
+            if (!g_majorantExceeded.exchange(true))
+                slog(WARNING, VOLUME, "Extinction %f exceeds the majorant %f, it is clamped.", extinction[i], majorant);
+        }
+    }
+    return scale;
+}
 
-        exponent -= ms.basecolor * ms.extinction * dt;
+Spectrum RatioTracking(const MajorantGrid& grid, const Point& ori, const Vector& dir, const float max_t, const MediumEvaluator& evaluate) {
+    Spectrum tr(1.0f);
+    grid.Traverse(ori, dir, max_t, [&](float t0, float t1, float majorant) {
+        if (majorant <= 0.0f)
+            return true;
+
+        for (auto t = t0 - std::log(1.0f - sort_canonical()) / majorant; t < t1; t -= std::log(1.0f - sort_canonical()) / majorant) {
+            const auto ms = evaluate(t);
+            const auto extinction = ms.basecolor * ms.extinction;
+            tr *= 1.0f - extinction * clampToMajorant(extinction, majorant) / majorant;
+
+            const auto max_tr = tr.GetMaxComponent();
+            if (max_tr < RATIO_TRACKING_RR_THRESHOLD) {
+                const auto survive = max_tr / RATIO_TRACKING_RR_THRESHOLD;
+                if (sort_canonical() >= survive) {
+                    tr = 0.0f;
+                    return false;
+                }
+                tr /= survive;
+            }
+        }
+        return true;
+    });
+    return tr;
+}
 
-        t += dt;
+Spectrum DeltaTracking(const MajorantGrid& grid, const Point& ori, const Vector& dir, const float max_t, const MediumEvaluator& evaluate,
+                       float& t, MediumSample& ms, Spectrum& emission) {
+    emission = 0.0f;
+    t = -1.0f;
 
-        if (t >= max_t)
-            break;
-    }
+    Spectrum weight(1.0f);
+    grid.Traverse(ori, dir, max_t, [&](float t0, float t1, float majorant) {
+        if (majorant <= 0.0f)
+            return true;
 
-    return exponent.Exp();
-}
+        for (auto tc = t0 - std::log(1.0f - sort_canonical()) / majorant; tc < t1; tc -= std::log(1.0f - sort_canonical()) / majorant) {
+            const auto sample = evaluate(tc);
 
-Spectrum HeterogenousMedium::Sample(const Ray& ray, const float max_t, MediumInteraction*& mi, Spectrum& emission) const {
-    // Distance Sample, Jan Novak
-    // https://cs.dartmouth.edu/~wjarosz/publications/novak18monte-slides-3-distance-sampling.pdf
-
-    // get the step size and count
-    auto        step_size = m_material->GetVolumeStep();
-    const auto  step_cnt = m_material->GetVolumeStepCnt();
-
-    // always start from 0.0 regardless the min_t value setup in ray
-    auto t = 0.0f;
-
-    // a random value
-    auto r = sort_canonical();
-
-    // accumulative transmittance
-    auto accum_transmittance = Spectrum(1.0f);
-
-    // maybe a better sampling algorithm for channel picking later
-    const auto ch = clamp((int)(sort_canonical() * RGBSPECTRUM_SAMPLE), 0, RGBSPECTRUM_SAMPLE - 1);
-
-    // ray marching
-    for (auto i = 0u; i < step_cnt; ++i) {
-        const auto dt = t + step_size <= max_t ? step_size : max_t - t;
-        const auto new_t = t + dt * sort_canonical();
-
-        // take a sample in the medium
-        MediumSample ms;
-        MediumInteraction tmp_mi;
-        tmp_mi.intersect = ray(new_t);
-        tmp_mi.mesh = m_mesh;
-        m_material->EvaluateMediumSample(tmp_mi, ms);
-
-        // beam transmittance along the ray through the short distance
-        const auto extinction = ms.basecolor * ms.extinction;
-        const auto exponent = -dt * extinction;
-        const auto beam_transmitancy = exponent.Exp();
-
-        if (1.0f - r >= beam_transmitancy[ch]) {
-            // sample a medium and scatter the ray
-            const auto new_dt = -log(1.0f - r) / extinction[ch];
-
-            mi = SORT_MALLOC(MediumInteraction)();
-            mi->intersect = ray(t + new_dt);
-            mi->phaseFunction = SORT_MALLOC(HenyeyGreenstein)(ms.anisotropy);
-            
-            const auto new_exponent = -new_dt * extinction;
-            const auto new_beam_transmitancy = new_exponent.Exp();
-            accum_transmittance *= new_beam_transmitancy;
-            const auto new_pdf = accum_transmittance * extinction;
-            const auto pdf = (new_pdf[0] + new_pdf[1] + new_pdf[2]) / 3.0f;
-            accum_transmittance /= pdf;
+            auto extinction = sample.basecolor * sample.extinction;
+            const auto scale = clampToMajorant(extinction, majorant);
+            extinction *= scale;
 
             // This model is what is used in PBRT and different from 'Production Volume Rendering' by Disney.
-            emission = ms.emission * ms.basecolor * ms.absorption * accum_transmittance;
-
-            return accum_transmittance * ms.scattering * ms.basecolor;
-        } else {
-            accum_transmittance *= beam_transmitancy;
-            r = 1.0f - (1.0f - r) / beam_transmitancy[ch];
+            emission += weight * sample.emission * sample.basecolor * scale * sample.absorption / majorant;
+
+            // with extinction clamped, the scattering probability never exceeds one
+            const auto scattering = sample.basecolor * scale * sample.scattering;
+            const auto avg_scattering = (scattering[0] + scattering[1] + scattering[2]) / 3.0f;
+            const auto scatter_pdf = avg_scattering / majorant;
+            if (sort_canonical() < scatter_pdf) {
+                t = tc;
+                ms = sample;
+                weight *= scattering / avg_scattering;
+                return false;
+            }
+
+            weight *= (majorant - extinction) / (majorant * (1.0f - scatter_pdf));
         }
+        return true;
+    });
 
-        t += dt;
+    return weight;
+}
 
-        if (t >= max_t)
-            break;
-    }
+Spectrum HeterogenousMedium::Tr(const Ray& ray, const float max_t) const {
+    const auto grid = m_mesh ? m_mesh->GetMajorantGrid() : nullptr;
+    if (IS_PTR_INVALID(grid))
+        return 1.0f;
 
-    // sampling the surface behind the volume instead of the volume itself.
-    const auto pdf = (accum_transmittance[0] + accum_transmittance[1] + accum_transmittance[2]) / 3.0f;
-    return accum_transmittance / pdf;
-}
\ No newline at end of file
+    const auto& w2v = m_mesh->GetWorldToVolume();
+    return RatioTracking(*grid, w2v.TransformPoint(ray.m_Ori), w2v.TransformVector(ray.m_Dir), max_t, [&](float t) { return evaluate(ray(t)); });
+}
+
+Spectrum HeterogenousMedium::Sample(const Ray& ray, const float max_t, MediumInteraction*& mi, Spectrum& emission) const {
+    emission = 0.0f;
+
+    const auto grid = m_mesh ? m_mesh->GetMajorantGrid() : nullptr;
+    if (IS_PTR_INVALID(grid))
+        return 1.0f;
+
+    const auto& w2v = m_mesh->GetWorldToVolume();
+    auto t = -1.0f;
+    MediumSample ms;
+    const auto weight = DeltaTracking(*grid, w2v.TransformPoint(ray.m_Ori), w2v.TransformVector(ray.m_Dir), max_t, [&](float t) { return evaluate(ray(t)); },
+                                      t, ms, emission);
+    if (t >= 0.0f) {
+        mi = SORT_MALLOC(MediumInteraction)();
+        mi->intersect = ray(t);
+        mi->phaseFunction = SORT_MALLOC(HenyeyGreenstein)(ms.anisotropy);
+    }
+    return weight;
+}
@@ -17,9 +17,12 @@
 
 #pragma once
 
+#include <functional>
 #include "core/define.h"
 #include "medium.h"
 
+class MajorantGrid;
+
 DECLARE_CLOSURE_TYPE_BEGIN(ClosureTypeHeterogenous, "medium_heterogeneous")
 DECLARE_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float3, base_color)
 DECLARE_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float, emission)
@@ -28,6 +31,41 @@ DECLARE_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float, scattering)
 DECLARE_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float, anisotropy)
 DECLARE_CLOSURE_TYPE_END(ClosureTypeHeterogenous)
 
+//! @brief  Properties of a medium at a distance along a ray.
+using MediumEvaluator = std::function<MediumSample(float)>;
+
+//! @brief  Estimate the transmittance along a ray by ratio tracking through a majorant grid.
+//!
+//! "Residual Ratio Tracking for Estimating Attenuation in Participating Media" by Novak et al. It is terminated by
+//! russian roulette once the transmittance is low. Extinction above the majorant is clamped to it.
+//!
+//! @param  grid        The majorant grid of the medium.
+//! @param  ori         Origin of the ray in volume space.
+//! @param  dir         Direction of the ray in volume space, distance along it is the same as in world space.
+//! @param  max_t       The maximum distance to be considered.
+//! @param  evaluate    Properties of the medium at a distance along the ray.
+//! @return             The estimated transmittance of each spectrum channel.
+Spectrum    RatioTracking(const MajorantGrid& grid, const Point& ori, const Vector& dir, const float max_t, const MediumEvaluator& evaluate);
+
+//! @brief  Sample a real collision along a ray by delta tracking through a majorant grid.
+//!
+//! At each tentative collision, the event is picked with the average coefficients of all channels, the weight of each
+//! channel is the ratio between its own coefficient and the average, so that all channels are unbiased with a single
+//! walk. Absorption and null collisions are merged into one event that only attenuates the weight. Extinction above
+//! the majorant is clamped to it.
+//!
+//! @param  grid        The majorant grid of the medium.
+//! @param  ori         Origin of the ray in volume space.
+//! @param  dir         Direction of the ray in volume space, distance along it is the same as in world space.
+//! @param  max_t       The maximum distance to be considered.
+//! @param  evaluate    Properties of the medium at a distance along the ray.
+//! @param  t           Distance of the scattering event sampled, it is negative if the ray passes through.
+//! @param  ms          Properties of the medium at the scattering event.
+//! @param  emission    The emission contribution in RTE.
+//! @return             The weight of the path, including the beam transmittance.
+Spectrum    DeltaTracking(const MajorantGrid& grid, const Point& ori, const Vector& dir, const float max_t, const MediumEvaluator& evaluate,
+                          float& t, MediumSample& ms, Spectrum& emission);
+
 //! @brief  HomogeneousMedium has equal scattering, absorption co-efficient everywhere.
 /**
  * Unlike homogeneous medium, heterogeneous medium allows variation of scattering/absorption
@@ -53,6 +91,8 @@ public:
     //!
     //! Beam transmittance is how much percentage of radiance get attenuated during
     //! traveling through the medium. It is a spectrum dependent attenuation.
+    //! It is estimated by ratio tracking through the majorant grid, which is unbiased regardless of the
+    //! distance, empty cells are skipped without evaluating the volume.
     //!
     //! @param  ray         The ray, which it uses to evaluate beam transmittance.
     //! @param  max_t       The maximum distance to be considered, usually this is the distance the ray travels before it hits a surface.
@@ -61,8 +101,9 @@ public:
 
     //! @brief  Importance sampling a point along the ray in the medium.
     //!
-    //! This is no way to use Delta-Tracking algorithm due to the lack of context of maximum density because
-    //! density is a shader driven property, there is no way to explictly evaluate the maximum value.
+    //! Tentative collisions are sampled with the majorant of the cells of the majorant grid, real collisions
+    //! are picked among them based on the average coefficients of all channels, this is delta tracking with
+    //! spectral weights.
     //!
     //! @param ray          The ray we use to take sample.
     //! @param max_t        The maximum distance to be considered, usually this is the distance the ray travels before it hits a surface.
@@ -73,4 +114,7 @@ public:
 
 private:
     const Mesh* m_mesh;
+
+    //! @brief  Evaluate the properties of the medium at a point.
+    MediumSample    evaluate(const Point& p) const;
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#include "majorantgrid.h"
+#include "mediumdata.h"
+#include "task/task.h"
+
+// Number of texels covered by a cell of the majorant grid along each axis.
+static constexpr unsigned   MAJORANT_CELL_TEXELS = 8;
+// Number of intervals the range of densities is divided into when tabulating the extinction.
+static constexpr unsigned   MAJORANT_TABLE_SIZE = 256;
+// Scale applied on the tabulated extinction, it accounts for extinction that is not monotonic between table entries.
+static constexpr float      MAJORANT_PADDING = 1.1f;
+
+void MajorantGrid::Build( const MediumDensity* density , const std::function<float(float)>& extinction ){
+    m_outside = std::max( 0.0f , extinction( 0.0f ) );
+    m_majorants.clear();
+    m_res[0] = m_res[1] = m_res[2] = 0;
+    if( IS_PTR_INVALID(density) || !density->IsValid() )
+        return;
+
+    float min_density , max_density;
+    density->GetRange( Point( 0.0f , 0.0f , 0.0f ) , Point( 1.0f , 1.0f , 1.0f ) , min_density , max_density );
+
+    // The volume shader is only evaluated here in the current thread, cells are filled in parallel with the table.
+    float table[MAJORANT_TABLE_SIZE + 1];
+    const auto table_step = ( max_density - min_density ) / MAJORANT_TABLE_SIZE;
+    for( auto i = 0u ; i <= MAJORANT_TABLE_SIZE ; ++i )
+        table[i] = std::max( 0.0f , extinction( min_density + table_step * i ) );
+
+    const unsigned dim[3] = { density->GetWidth() , density->GetHeight() , density->GetDepth() };
+    for( auto i = 0u ; i < 3 ; ++i )
+        m_res[i] = ( dim[i] + MAJORANT_CELL_TEXELS - 1 ) / MAJORANT_CELL_TEXELS;
+    m_majorants.resize( m_res[0] * m_res[1] * m_res[2] );
+
+    ParallelForRows( (int)m_res[2] , [&]( int z0 , int z1 ){
+        for( auto z = (unsigned)z0 ; z < (unsigned)z1 ; ++z ){
+            for( auto y = 0u ; y < m_res[1] ; ++y ){
+                for( auto x = 0u ; x < m_res[0] ; ++x ){
+                    const Point lo( (float)x / m_res[0] , (float)y / m_res[1] , (float)z / m_res[2] );
+                    const Point hi( (float)( x + 1 ) / m_res[0] , (float)( y + 1 ) / m_res[1] , (float)( z + 1 ) / m_res[2] );
+                    float cell_min , cell_max;
+                    density->GetRange( lo , hi , cell_min , cell_max );
+
+                    auto i0 = 0u , i1 = 0u;
+                    if( table_step > 0.0f ){
+                        i0 = (unsigned)std::min( (float)MAJORANT_TABLE_SIZE , std::floor( ( cell_min - min_density ) / table_step ) );
+                        i1 = (unsigned)std::min( (float)MAJORANT_TABLE_SIZE , std::ceil( ( cell_max - min_density ) / table_step ) );
+                    }
+                    auto majorant = 0.0f;
+                    for( auto i = i0 ; i <= i1 ; ++i )
+                        majorant = std::max( majorant , table[i] );
+                    m_majorants[ ( z * m_res[1] + y ) * m_res[0] + x ] = majorant * MAJORANT_PADDING;
+                }
+            }
+        }
+    });
+}
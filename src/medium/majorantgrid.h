@@ -0,0 +1,140 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <vector>
+#include "core/define.h"
+#include "math/point.h"
+#include "math/vector3.h"
+
+class MediumDensity;
+
+//! @brief  Coarse grid of upper bounds of the extinction in a heterogeneous volume.
+/**
+ * Each cell covers a few texels of the density volume and keeps the maximum extinction that could be found in it.
+ * Delta tracking and ratio tracking sample tentative collisions with the majorant of the cell they are in, instead
+ * of marching the whole volume with a fixed step. Cells with zero majorant, which is common in smoke and clouds,
+ * are skipped without evaluating the volume shader at all.
+ * The grid lives in the volume texture space, which is an affine transformation of the world space. Rays are
+ * transformed without normalizing their direction, so that the distance along the ray is the same in both spaces.
+ */
+class MajorantGrid{
+public:
+    //! @brief  Build the grid.
+    //!
+    //! Properties of heterogeneous volumes only depend on the density, the extinction is tabulated over the range
+    //! of densities in the volume. The majorant of a cell is the maximum tabulated extinction over the range of
+    //! densities in the cell, padded so that it is still an upper bound when the extinction is not monotonic between
+    //! table entries. A volume shader varying faster than the table could still exceed it, which tracking handles by
+    //! clamping the extinction to the majorant.
+    //!
+    //! @param  density     The density of the volume, it could be 'nullptr' if the volume has no density data.
+    //! @param  extinction  The maximum extinction of all channels with a specific density.
+    void    Build( const MediumDensity* density , const std::function<float(float)>& extinction );
+
+    //! @brief  Visit the cells a ray goes through in order.
+    //!
+    //! Parts of the ray outside the volume are visited with the extinction of zero density.
+    //!
+    //! @param  ori     Origin of the ray in volume space.
+    //! @param  dir     Direction of the ray in volume space.
+    //! @param  max_t   Maximum distance along the ray.
+    //! @param  func    Functor called with the range of distance in a cell and its majorant, it returns false to stop.
+    template<class Func>
+    void    Traverse( const Point& ori , const Vector& dir , float max_t , Func&& func ) const;
+
+    //! @brief  Number of cells along each axis.
+    SORT_FORCEINLINE unsigned   GetResolution( unsigned axis ) const {
+        return m_res[axis];
+    }
+
+    //! @brief  Majorant of a cell.
+    SORT_FORCEINLINE float      GetMajorant( unsigned x , unsigned y , unsigned z ) const {
+        return m_majorants[ ( z * m_res[1] + y ) * m_res[0] + x ];
+    }
+
+private:
+    std::vector<float>  m_majorants;                /**< Majorant of all cells. */
+    unsigned            m_res[3] = { 0 , 0 , 0 };   /**< Number of cells along each axis. */
+    float               m_outside = 0.0f;           /**< Extinction outside the volume, where the density is zero. */
+};
+
+template<class Func>
+void MajorantGrid::Traverse( const Point& ori , const Vector& dir , float max_t , Func&& func ) const{
+    // range of the ray inside the volume, [0,1]^3 in volume space
+    auto t_enter = 0.0f;
+    auto t_exit = max_t;
+    for( auto i = 0u ; i < 3 && !m_majorants.empty() ; ++i ){
+        if( dir[i] == 0.0f ){
+            if( ori[i] < 0.0f || ori[i] > 1.0f )
+                t_exit = -1.0f;
+            continue;
+        }
+        const auto inv_dir = 1.0f / dir[i];
+        const auto t0 = ( 0.0f - ori[i] ) * inv_dir;
+        const auto t1 = ( 1.0f - ori[i] ) * inv_dir;
+        t_enter = std::max( t_enter , std::min( t0 , t1 ) );
+        t_exit = std::min( t_exit , std::max( t0 , t1 ) );
+    }
+
+    if( m_majorants.empty() || t_enter >= t_exit ){
+        func( 0.0f , max_t , m_outside );
+        return;
+    }
+
+    if( t_enter > 0.0f && !func( 0.0f , t_enter , m_outside ) )
+        return;
+
+    // 3D-DDA through the cells
+    int cell[3] , step[3];
+    float next_t[3] , delta_t[3];
+    for( auto i = 0u ; i < 3 ; ++i ){
+        const auto p = ori[i] + dir[i] * t_enter;
+        cell[i] = std::min( std::max( (int)std::floor( p * m_res[i] ) , 0 ) , (int)m_res[i] - 1 );
+        if( dir[i] == 0.0f ){
+            step[i] = 0;
+            next_t[i] = FLT_MAX;
+            delta_t[i] = FLT_MAX;
+            continue;
+        }
+        step[i] = dir[i] > 0.0f ? 1 : -1;
+        const auto boundary = (float)( dir[i] > 0.0f ? cell[i] + 1 : cell[i] ) / m_res[i];
+        next_t[i] = ( boundary - ori[i] ) / dir[i];
+        delta_t[i] = 1.0f / ( m_res[i] * std::fabs( dir[i] ) );
+    }
+
+    auto t = t_enter;
+    while( t < t_exit ){
+        const auto axis = ( next_t[0] < next_t[1] ) ? ( next_t[0] < next_t[2] ? 0 : 2 ) : ( next_t[1] < next_t[2] ? 1 : 2 );
+        const auto t_next = std::min( next_t[axis] , t_exit );
+        if( t_next > t && !func( t , t_next , GetMajorant( cell[0] , cell[1] , cell[2] ) ) )
+            return;
+        t = t_next;
+
+        cell[axis] += step[axis];
+        if( cell[axis] < 0 || cell[axis] >= (int)m_res[axis] )
+            break;
+        next_t[axis] += delta_t[axis];
+    }
+
+    if( t_exit < max_t )
+        func( t_exit , max_t , m_outside );
+}
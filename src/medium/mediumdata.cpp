@@ -15,35 +15,36 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <cfloat>
+#include <cmath>
 #include "mediumdata.h"
 #include "math/point.h"
-#include "stream/stream.h"
+#include "math/utils.h"
 
 float MediumDensity::Sample(const Point& uvw) const {
-    return ImageTexture3D::Sample(uvw[0], uvw[1], uvw[2]);
+    return SparseTexture3D::Sample(uvw[0], uvw[1], uvw[2]);
 }
 
-void MediumDensity::Serialize(IStreamBase& stream) {
-    stream >> m_width >> m_height >> m_depth;
-
-    // make sure the dimension is valid.
-    if (m_width == 0 || m_height == 0 || m_depth == 0)
-        return;
-
-    const auto tex_cnt = m_width * m_height * m_depth;
-
-    m_memory = std::make_unique<ImgMemory<float>>();
-    m_memory->m_texel = std::make_unique<float[]>(tex_cnt);
-    stream.Load((char*)m_memory->m_texel.get(), sizeof(float) * tex_cnt);
+void MediumDensity::GetRange(const Point& lo, const Point& hi, float& min_density, float& max_density) const {
+    min_density = FLT_MAX;
+    max_density = -FLT_MAX;
+
+    // A sample interpolates the texel at floor(u * width - 0.5) and the next one.
+    const auto texel_range = [](float lo, float hi, unsigned res, int& t0, int& t1) {
+        t0 = clamp((int)std::floor(lo * res - 0.5f), 0, (int)res - 1);
+        t1 = clamp((int)std::floor(hi * res - 0.5f) + 1, 0, (int)res - 1);
+    };
+    int x0, x1, y0, y1, z0, z1;
+    texel_range(lo.x, hi.x, m_width, x0, x1);
+    texel_range(lo.y, hi.y, m_height, y0, y1);
+    texel_range(lo.z, hi.z, m_depth, z0, z1);
+
+    VisitTexels(x0, y0, z0, x1, y1, z1, [&](float density) {
+        min_density = std::min(min_density, density);
+        max_density = std::max(max_density, density);
+    });
 }
 
 Spectrum MediumColor::Sample(const Point& uvw) const {
-    // pos needs to be transformed from world space to local space before taking a sample.
-    // to be implemented
-    return 0.0f;
+    return SparseTexture3D::Sample(uvw[0], uvw[1], uvw[2]);
 }
-
-void MediumColor::Serialize(IStreamBase& stream) {
-    // do nothing for now
-    //stream >> m_width >> m_height >> m_depth;
-}
\ No newline at end of file
@@ -18,16 +18,15 @@
 #pragma once
 
 #include "core/define.h"
-#include "texture/imagetexture3d.h"
+#include "texture/sparsetexture3d.h"
 
 struct Point;
-class IStreamBase;
 
 //! @brief  Medium density data structure allows variation of density inside a medium volume.
 /**
- * Medium density is essentially a 3D texture.
+ * Medium density is essentially a 3D texture, it is stored sparsely since most of the volume is usually empty.
  */
-class MediumDensity : public ImageTexture3D<float> {
+class MediumDensity : public SparseTexture3D<float> {
 public:
     //! @brief  Take a sample in 3D texture.
     //!
@@ -35,25 +34,23 @@ public:
     //! @return         The density at the position related to the object.
     float   Sample( const Point& uvw) const;
 
-    //! @brief      Serializing data from stream.
+    //! @brief  Range of densities returned by sampling inside a box of the volume.
     //!
-    //! @param  Stream  where the serialization data comes from. Depending on different situation,
-    //!                 it could come from different places.
-    void    Serialize(IStreamBase& stream);
+    //! All texels that could be interpolated by a sample in the box are considered.
+    //!
+    //! @param  lo              Minimum corner of the box in volume space.
+    //! @param  hi              Maximum corner of the box in volume space.
+    //! @param  min_density     Minimum density in the box.
+    //! @param  max_density     Maximum density in the box.
+    void    GetRange( const Point& lo , const Point& hi , float& min_density , float& max_density ) const;
 };
 
 //! @brief  Medium color data structure allows variation of color inside a medium volume.
-class MediumColor : public ImageTexture3D<Spectrum> {
+class MediumColor : public SparseTexture3D<Spectrum> {
 public:
     //! @brief  Take a sample in 3D texture.
     //!
     //! @param  uvw     Texture coordinate in volume space.
     //! @return         The color at the position related to the object.
     Spectrum Sample(const Point& uvw) const;
-
-    //! @brief      Serializing data from stream.
-    //!
-    //! @param  Stream  where the serialization data comes from. Depending on different situation,
-    //!                 it could come from different places.
-    void    Serialize(IStreamBase& stream);
 };
\ No newline at end of file
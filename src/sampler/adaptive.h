@@ -0,0 +1,92 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include "core/define.h"
+#include "stream/stream.h"
+
+//! @brief  Settings of adaptive sampling.
+//!
+//! With adaptive sampling, pixels are rendered in rounds. The first round takes 'min_spp' samples, each of
+//! the following rounds takes 'batch_spp' more. A pixel stops taking samples once the relative standard error
+//! of its luminance drops below 'threshold', or the sample per pixel set in the global configuration is reached.
+struct AdaptiveSamplingConfig {
+    bool            enabled = false;        /**< Whether adaptive sampling is enabled. */
+    unsigned int    min_spp = 16;           /**< Number of samples taken before any error estimation. */
+    unsigned int    batch_spp = 8;          /**< Number of samples taken in each round after the first one. */
+    float           threshold = 0.02f;      /**< Target relative standard error of the pixel luminance. */
+
+    //! @brief  Serializing data from stream
+    //!
+    //! @param  stream      Stream where the serialization data comes from.
+    void    Serialize( IStreamBase& stream ){
+        stream >> enabled >> min_spp >> batch_spp >> threshold;
+        min_spp = std::max( min_spp , 2u );
+        batch_spp = std::max( batch_spp , 1u );
+    }
+};
+
+//! @brief  PixelVariance tracks running mean and variance of the luminance of samples in a pixel.
+//!
+//! Welford's online algorithm is used so that it is numerically stable, there is no need to keep samples around.
+class PixelVariance {
+public:
+    //! @brief  Add a sample.
+    //!
+    //! @param  v       Luminance of the sample.
+    SORT_FORCEINLINE void Add( float v ){
+        ++m_count;
+        const auto delta = v - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * ( v - m_mean );
+    }
+
+    //! @brief  Number of samples added so far.
+    SORT_FORCEINLINE unsigned int GetCount() const {
+        return m_count;
+    }
+
+    //! @brief  Mean of the samples.
+    SORT_FORCEINLINE float GetMean() const {
+        return m_mean;
+    }
+
+    //! @brief  Relative standard error of the mean.
+    //!
+    //! Very dark pixels are measured against a small floor value instead of their mean, so that a handful
+    //! of samples with tiny radiance doesn't keep the pixel sampling forever. Pixels with nothing but black
+    //! samples so far are never considered converged, a small light source or a caustic could simply be
+    //! missed by the first few samples.
+    //!
+    //! @return     Standard error of the mean divided by the mean, infinite if there are not enough samples
+    //!             or the mean is not positive.
+    SORT_FORCEINLINE float GetRelativeError() const {
+        if( m_count < 2 || m_mean <= 0.0f )
+            return FLT_MAX;
+        const auto variance_of_mean = m_m2 / ( ( m_count - 1 ) * (float)m_count );
+        return sqrt( variance_of_mean ) / std::max( m_mean , 1e-3f );
+    }
+
+private:
+    unsigned int    m_count = 0;        /**< Number of samples. */
+    float           m_mean = 0.0f;      /**< Running mean. */
+    float           m_m2 = 0.0f;        /**< Sum of squared differences from the current mean. */
+};
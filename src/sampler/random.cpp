@@ -24,8 +24,9 @@ void RandomSampler::Generate1D( float* sample , unsigned num , bool accept_unifo
 {
     sAssert( sample != 0 , SAMPLING );
 
-    for( unsigned i = 0 ; i < num ; ++i )
-        sample[i] = sort_canonical();
+    // the same dimension of all samples in the pixel is one stream, which is generated in batch
+    const auto key = sort_hash_combine( m_pixelSeed , m_arrayDimension++ );
+    sort_hash_canonical_batch( key , m_firstSample , sample , num );
 }
 
 // generate sample in two dimension
@@ -33,10 +34,34 @@ void RandomSampler::Generate2D( float* sample , unsigned num , bool accept_unifo
 {
     sAssert( sample != 0 , SAMPLING );
 
-    int count = 2 * num;
-    for( int i = 0 ; i < count ; i += 2 )
+    const auto key0 = sort_hash_combine( m_pixelSeed , m_arrayDimension++ );
+    const auto key1 = sort_hash_combine( m_pixelSeed , m_arrayDimension++ );
+    for( unsigned i = 0 ; i < num ; ++i )
     {
-        sample[i] = sort_canonical();
-        sample[i+1] = sort_canonical();
+        sample[2 * i] = sort_hash_canonical( key0 , m_firstSample + i );
+        sample[2 * i + 1] = sort_hash_canonical( key1 , m_firstSample + i );
     }
 }
+
+// start taking samples in a new pixel
+void RandomSampler::StartPixel( int x , int y , unsigned first_sample )
+{
+    m_pixelSeed = sort_hash_combine( sort_hash( (unsigned)x ) , (unsigned)y );
+    m_firstSample = first_sample;
+    m_sampleIndex = 0;
+    m_dimension = 0;
+    m_arrayDimension = 0;
+}
+
+// start a new sample in the current pixel
+void RandomSampler::StartSample( unsigned index )
+{
+    m_sampleIndex = index;
+    m_dimension = m_arrayDimension;
+}
+
+// get the next dimension of the current sample
+float RandomSampler::Next1D()
+{
+    return sort_hash_canonical( sort_hash_combine( m_pixelSeed , m_dimension++ ) , m_firstSample + m_sampleIndex );
+}
@@ -21,16 +21,40 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 // definition of random sampler
+// Random numbers are generated by a counter-based generator keyed by the pixel, the sample
+// index and the dimension. There is no state shared between pixels, so the samples don't
+// depend on which thread renders the pixel.
 class RandomSampler : public Sampler
 {
 public:
     // generate sample in one dimension
     // para 'sample' : the memory to save the sampled data
     // para 'num'    : the number of samples to be generated
-    virtual void Generate1D( float* sample , unsigned num , bool accept_uniform = false ) const;
+    void Generate1D( float* sample , unsigned num , bool accept_uniform = false ) const override;
 
     // generate sample in two dimension
     // para 'sample' : the memory to save the sampled data
     // para 'num'    : the number of samples to be generated
-    virtual void Generate2D( float* sample , unsigned num , bool accept_uniform = false ) const;
-};
\ No newline at end of file
+    void Generate2D( float* sample , unsigned num , bool accept_uniform = false ) const override;
+
+    // start taking samples in a new pixel
+    // para 'x'             : x coordinate of the pixel
+    // para 'y'             : y coordinate of the pixel
+    // para 'first_sample'  : index of the first sample of the pixel
+    void StartPixel( int x , int y , unsigned first_sample = 0 ) override;
+
+    // start a new sample in the current pixel
+    // para 'index'  : index of the sample, relative to the first sample of the pixel
+    void StartSample( unsigned index ) override;
+
+    // get the next dimension of the current sample
+    // result        : a canonical number in [0,1)
+    float Next1D() override;
+
+private:
+    unsigned            m_pixelSeed = 0;            // seed of the current pixel
+    unsigned            m_firstSample = 0;          // index of the first sample of the current pixel
+    unsigned            m_sampleIndex = 0;          // index of the current sample
+    unsigned            m_dimension = 0;            // the next dimension to be drawn by the current sample
+    mutable unsigned    m_arrayDimension = 0;       // dimensions consumed by samples generated for the whole pixel
+};
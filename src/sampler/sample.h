@@ -23,6 +23,8 @@
 #include "core/rand.h"
 #include "core/define.h"
 
+class   AOVSample;
+
 // Light Sample
 class   LightSample
 {
@@ -93,6 +95,9 @@ public:
     std::vector<unsigned>           light_dimension;
     std::vector<unsigned>           bsdf_dimension;
     std::unique_ptr<float[]>        data;       // the data to used
+    AOVSample*                      aov = nullptr;  // arbitrary output variables of the sample, it is not owned by the pixel sample
+    int                             pixel_x = -1;   // coordinate of the pixel the sample belongs to, negative if unknown
+    int                             pixel_y = -1;
 
     // request more samples
     unsigned RequestMoreLightSample( unsigned num )
@@ -107,4 +112,4 @@ public:
         bsdf_dimension.push_back( num );
         return offset;
     }
-};
\ No newline at end of file
+};
\ No newline at end of file
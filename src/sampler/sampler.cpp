@@ -16,6 +16,9 @@
  */
 
 #include "sampler.h"
+#include "random.h"
+#include "sobol.h"
+#include "core/rand.h"
 
 // default constructor
 Sampler::Sampler()
@@ -26,3 +29,35 @@ Sampler::Sampler()
 Sampler::~Sampler()
 {
 }
+
+// get the next dimension of the current sample
+float Sampler::Next1D()
+{
+    // Not going through 'sort_canonical', which would draw from the bound sampler again.
+    return ( sort_rand() & 0xffffff ) / float( 1 << 24 );
+}
+
+// create a sampler
+std::unique_ptr<Sampler> MakeSampler( SamplerType type )
+{
+    switch( type ){
+    case SAMPLER_SOBOL:
+        return std::make_unique<SobolSampler>();
+    case SAMPLER_PMJ02:
+        return std::make_unique<PMJ02Sampler>();
+    default:
+        return std::make_unique<RandomSampler>();
+    }
+}
+
+// bind the sampler
+SampleStreamScope::SampleStreamScope( Sampler* sampler )
+{
+    m_previous = sort_bind_sampler( sampler );
+}
+
+// restore the previous bound sampler
+SampleStreamScope::~SampleStreamScope()
+{
+    sort_bind_sampler( m_previous );
+}
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <vector>
+#include <memory>
 #include "core/define.h"
 #include "sample.h"
 #include "core/memory.h"
@@ -28,6 +29,13 @@
 //          The whole sampler implementation will be redesigned later.
 //          But the priority is relatively low for now.
 
+// type of samplers, the value is serialized from the global configuration
+enum SamplerType : int{
+    SAMPLER_RANDOM = 0,     // independent random numbers
+    SAMPLER_SOBOL ,         // Owen-scrambled Sobol sequence, padded in groups of four dimensions
+    SAMPLER_PMJ02           // Owen-scrambled (0,2) sequence, padded in groups of two dimensions
+};
+
 /////////////////////////////////////////////////////////////////////////////////
 // definitation of the sampler
 class   Sampler
@@ -53,4 +61,42 @@ public:
     // para 'sample' : the memory to save the sampled data
     // para 'num'    : the number of samples to be generated
     virtual void Generate2D( float* sample , unsigned num , bool accept_uniform = false ) const = 0;
+
+    // start taking samples in a new pixel
+    // para 'x'             : x coordinate of the pixel
+    // para 'y'             : y coordinate of the pixel
+    // para 'first_sample'  : index of the first sample of the pixel, it is not zero in later passes of progressive rendering
+    // note : samples generated by 'Generate1D' and 'Generate2D' after it belong to this pixel
+    virtual void StartPixel( int x , int y , unsigned first_sample = 0 ) {}
+
+    // start a new sample in the current pixel
+    // para 'index'  : index of the sample, relative to the first sample of the pixel
+    virtual void StartSample( unsigned index ) {}
+
+    // get the next dimension of the current sample
+    // result        : a canonical number in [0,1)
+    virtual float Next1D();
+};
+
+// create a sampler
+// para 'type'   : type of the sampler
+// result        : the sampler, random sampler is the fallback of unknown types
+std::unique_ptr<Sampler> MakeSampler( SamplerType type );
+
+/////////////////////////////////////////////////////////////////////////////////
+// Bind a sampler to the current thread during the life time of the object.
+// While a sampler is bound, 'sort_canonical' draws the next dimension of its
+// current sample, so that lights, bxdfs and integrators consume dimensions of
+// the sample without knowing about the sampler.
+class SampleStreamScope
+{
+public:
+    // bind the sampler
+    // para 'sampler' : the sampler to be bound to the current thread
+    SampleStreamScope( Sampler* sampler );
+    // restore the previous bound sampler
+    ~SampleStreamScope();
+
+private:
+    Sampler*    m_previous = nullptr;
 };
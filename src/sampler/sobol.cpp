@@ -0,0 +1,168 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "sobol.h"
+#include "core/sassert.h"
+#include "core/rand.h"
+
+namespace {
+    // number of bits of each sample
+    constexpr unsigned SOBOL_BITS = 32;
+    // maximum number of dimensions in a group
+    constexpr unsigned SOBOL_DIMS = 4;
+
+    // Direction numbers of the first four dimensions of Sobol sequence, generated from primitive polynomials.
+    struct SobolDirections{
+        unsigned v[SOBOL_DIMS][SOBOL_BITS];
+
+        SobolDirections(){
+            // degree, coefficients and initial direction numbers of the primitive polynomials, from Joe and Kuo.
+            const unsigned s[SOBOL_DIMS] = { 0 , 1 , 2 , 3 };
+            const unsigned a[SOBOL_DIMS] = { 0 , 0 , 1 , 1 };
+            const unsigned m[SOBOL_DIMS][3] = { { 0 , 0 , 0 } , { 1 , 0 , 0 } , { 1 , 3 , 0 } , { 1 , 3 , 1 } };
+
+            // the first dimension is van der Corput sequence
+            for( auto i = 0u ; i < SOBOL_BITS ; ++i )
+                v[0][i] = 1u << ( SOBOL_BITS - 1 - i );
+
+            for( auto d = 1u ; d < SOBOL_DIMS ; ++d ){
+                for( auto i = 0u ; i < SOBOL_BITS ; ++i ){
+                    if( i < s[d] ){
+                        v[d][i] = m[d][i] << ( SOBOL_BITS - 1 - i );
+                        continue;
+                    }
+                    v[d][i] = v[d][i - s[d]] ^ ( v[d][i - s[d]] >> s[d] );
+                    for( auto k = 1u ; k < s[d] ; ++k )
+                        v[d][i] ^= ( ( a[d] >> ( s[d] - 1 - k ) ) & 1 ) * v[d][i - k];
+                }
+            }
+        }
+    };
+    static const SobolDirections directions;
+
+    SORT_FORCEINLINE unsigned sobol( unsigned index , unsigned dim ){
+        auto x = 0u;
+        for( auto bit = 0u ; index ; index >>= 1 , ++bit )
+            if( index & 1 )
+                x ^= directions.v[dim][bit];
+        return x;
+    }
+
+    SORT_FORCEINLINE unsigned reverseBits( unsigned x ){
+        x = ( ( x >> 1 ) & 0x55555555u ) | ( ( x & 0x55555555u ) << 1 );
+        x = ( ( x >> 2 ) & 0x33333333u ) | ( ( x & 0x33333333u ) << 2 );
+        x = ( ( x >> 4 ) & 0x0f0f0f0fu ) | ( ( x & 0x0f0f0f0fu ) << 4 );
+        x = ( ( x >> 8 ) & 0x00ff00ffu ) | ( ( x & 0x00ff00ffu ) << 8 );
+        return ( x >> 16 ) | ( x << 16 );
+    }
+
+    // Laine-Karras style permutation with improved constants from Burley.
+    SORT_FORCEINLINE unsigned laineKarrasPermutation( unsigned x , unsigned seed ){
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return x;
+    }
+
+    SORT_FORCEINLINE unsigned nestedUniformScramble( unsigned x , unsigned seed ){
+        return reverseBits( laineKarrasPermutation( reverseBits( x ) , seed ) );
+    }
+
+    SORT_FORCEINLINE float toCanonical( unsigned x ){
+        return ( x >> 8 ) / float( 1 << 24 );
+    }
+
+    // one dimension of a sample in a padded group, the index is shuffled with the same scrambling so that each group is decorrelated from the others
+    SORT_FORCEINLINE float owenScrambledSobol( unsigned index , unsigned d , unsigned group_seed , unsigned dim_seed ){
+        return toCanonical( nestedUniformScramble( sobol( nestedUniformScramble( index , group_seed ) , d ) , dim_seed ) );
+    }
+}
+
+SobolSampler::SobolSampler( unsigned group_dim ) : m_groupDim( std::min( std::max( group_dim , 2u ) , SOBOL_DIMS ) )
+{
+}
+
+float SobolSampler::Evaluate( unsigned index , unsigned dim , unsigned seed ) const
+{
+    const auto group_seed = sort_hash_combine( seed , dim / m_groupDim );
+    const auto d = dim % m_groupDim;
+    return owenScrambledSobol( index , d , group_seed , sort_hash_combine( group_seed , d ) );
+}
+
+void SobolSampler::StartPixel( int x , int y , unsigned first_sample )
+{
+    m_pixelSeed = sort_hash_combine( sort_hash( (unsigned)x ) , (unsigned)y );
+    m_firstSample = first_sample;
+    m_sampleIndex = 0;
+    m_dimension = 0;
+    m_arrayDimension = 0;
+}
+
+void SobolSampler::StartSample( unsigned index )
+{
+    m_sampleIndex = index;
+
+    // dimensions of the sample start from the group right after the ones taken by pixel samples
+    m_dimension = ( m_arrayDimension + m_groupDim - 1 ) / m_groupDim * m_groupDim;
+}
+
+float SobolSampler::Next1D()
+{
+    return Evaluate( m_firstSample + m_sampleIndex , m_dimension++ , m_pixelSeed );
+}
+
+unsigned SobolSampler::allocArrayDimension( unsigned cnt ) const
+{
+    // dimensions of a 2D sample never cross two groups
+    if( m_arrayDimension % m_groupDim + cnt > m_groupDim )
+        m_arrayDimension = ( m_arrayDimension + m_groupDim - 1 ) / m_groupDim * m_groupDim;
+
+    const auto dim = m_arrayDimension;
+    m_arrayDimension += cnt;
+    return dim;
+}
+
+void SobolSampler::Generate1D( float* sample , unsigned num , bool accept_uniform ) const
+{
+    sAssert( sample != 0 , SAMPLING );
+
+    // seeds are the same for all samples of the pixel
+    const auto dim = allocArrayDimension( 1 );
+    const auto group_seed = sort_hash_combine( m_pixelSeed , dim / m_groupDim );
+    const auto d = dim % m_groupDim;
+    const auto dim_seed = sort_hash_combine( group_seed , d );
+    for( unsigned i = 0 ; i < num ; ++i )
+        sample[i] = owenScrambledSobol( m_firstSample + i , d , group_seed , dim_seed );
+}
+
+void SobolSampler::Generate2D( float* sample , unsigned num , bool accept_uniform ) const
+{
+    sAssert( sample != 0 , SAMPLING );
+
+    // both dimensions are in the same group, seeds are the same for all samples of the pixel
+    const auto dim = allocArrayDimension( 2 );
+    const auto group_seed = sort_hash_combine( m_pixelSeed , dim / m_groupDim );
+    const auto d = dim % m_groupDim;
+    const auto seed0 = sort_hash_combine( group_seed , d );
+    const auto seed1 = sort_hash_combine( group_seed , d + 1 );
+    for( unsigned i = 0 ; i < num ; ++i ){
+        sample[2 * i] = owenScrambledSobol( m_firstSample + i , d , group_seed , seed0 );
+        sample[2 * i + 1] = owenScrambledSobol( m_firstSample + i , d + 1 , group_seed , seed1 );
+    }
+}
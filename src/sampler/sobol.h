@@ -0,0 +1,94 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "sampler.h"
+
+/////////////////////////////////////////////////////////////////////////////////
+// Owen-scrambled Sobol sampler
+//
+// Samples of a pixel are taken from an Owen-scrambled Sobol sequence with
+// hash-based scrambling, as described in "Practical Hash-based Owen Scrambling"
+// by Brent Burley. Dimensions are padded in groups, each group takes its own
+// shuffled and scrambled sequence seeded by the pixel and the group index, so
+// that there is no limitation on the number of dimensions consumed by a sample.
+// Since everything is derived from hashes, no table needs to be stored other
+// than the direction numbers of the first four dimensions.
+class SobolSampler : public Sampler
+{
+public:
+    // constructor
+    // para 'group_dim' : number of dimensions in a group, it is between two and four
+    SobolSampler( unsigned group_dim = 4 );
+
+    // generate sample in one dimension
+    // para 'sample' : the memory to save the sampled data
+    // para 'num'    : the number of samples to be generated
+    void Generate1D( float* sample , unsigned num , bool accept_uniform = false ) const override;
+
+    // generate sample in two dimension
+    // para 'sample' : the memory to save the sampled data
+    // para 'num'    : the number of samples to be generated
+    void Generate2D( float* sample , unsigned num , bool accept_uniform = false ) const override;
+
+    // start taking samples in a new pixel
+    // para 'x'             : x coordinate of the pixel
+    // para 'y'             : y coordinate of the pixel
+    // para 'first_sample'  : index of the first sample of the pixel
+    void StartPixel( int x , int y , unsigned first_sample = 0 ) override;
+
+    // start a new sample in the current pixel
+    // para 'index'  : index of the sample, relative to the first sample of the pixel
+    void StartSample( unsigned index ) override;
+
+    // get the next dimension of the current sample
+    // result        : a canonical number in [0,1)
+    float Next1D() override;
+
+    // evaluate one dimension of a sample
+    // para 'index'  : index of the sample in the pixel
+    // para 'dim'    : the dimension to be evaluated
+    // para 'seed'   : seed of the pixel
+    // result        : a canonical number in [0,1)
+    float Evaluate( unsigned index , unsigned dim , unsigned seed ) const;
+
+protected:
+    const unsigned      m_groupDim;                 // number of dimensions in each padded group
+    unsigned            m_pixelSeed = 0;            // seed of the current pixel
+    unsigned            m_firstSample = 0;          // index of the first sample of the current pixel
+    unsigned            m_sampleIndex = 0;          // index of the current sample
+    unsigned            m_dimension = 0;            // the next dimension to be drawn by the current sample
+    mutable unsigned    m_arrayDimension = 0;       // dimensions consumed by samples generated for the whole pixel
+
+    // take the next dimensions for generating samples of the whole pixel
+    unsigned    allocArrayDimension( unsigned cnt ) const;
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+// PMJ02 sampler
+//
+// The first two dimensions of Sobol sequence form a (0,2)-sequence, with Owen
+// scrambling it has the same progressive multi-jittered stratification as PMJ02
+// samples, without the need of pre-generated tables. Dimensions are padded in
+// pairs so that every 2D sample, like picking a direction, is well stratified.
+class PMJ02Sampler : public SobolSampler
+{
+public:
+    // constructor
+    PMJ02Sampler() : SobolSampler( 2 ) {}
+};
@@ -118,6 +118,16 @@ public:
         return m_type;
     }
 
+    //! @brief  Whether the bxdf is a Dirac delta function.
+    //!
+    //! Directions not sampled by a delta bxdf itself always have zero value and zero pdf, so sampling
+    //! strategies other than the bxdf's own can't be used on it.
+    //!
+    //! @return         Whether the bxdf is a delta function.
+    virtual bool    IsDelta() const {
+        return false;
+    }
+
 protected:
     //! @brief Evaluate the BRDF.
     //!
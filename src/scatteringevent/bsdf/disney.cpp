@@ -74,6 +74,37 @@ constexpr static float burley_max_r_d = 16.0f;
 constexpr static float burley_max_cdf = burley_max_cdf_calc( burley_max_r_d );
 constexpr static float burley_inv_max_cdf = 1.0f / burley_max_cdf;
 
+//! @brief  Radial profile of Burley, exp(-x) + exp(-x/3), tabulated over the distance normalized by the shape parameter.
+/**
+ * The shape of the profile only depends on the normalized distance, a single table serves all bssrdfs no matter how their
+ * parameters vary across surfaces. The profile is evaluated for each channel, each axis and each hit of probe rays, the
+ * table replaces all of the exponentials with a lookup. Distances beyond the sampling range are rarely evaluated and fall
+ * back to the exact profile.
+ */
+class BurleyProfileTable{
+public:
+    BurleyProfileTable(){
+        for( auto i = 0u ; i <= TABLE_SIZE ; ++i ){
+            const auto x = burley_max_r_d * i / TABLE_SIZE;
+            m_profile[i] = exp( -x ) + exp( -x / 3.0f );
+        }
+    }
+
+    SORT_FORCEINLINE float operator()( float x ) const {
+        const auto fi = x * ( TABLE_SIZE / burley_max_r_d );
+        if( fi >= TABLE_SIZE )
+            return exp( -x ) + exp( -x / 3.0f );
+        const auto i = (unsigned)fi;
+        const auto t = fi - i;
+        return m_profile[i] * ( 1.0f - t ) + m_profile[i+1] * t;
+    }
+
+private:
+    static constexpr unsigned TABLE_SIZE = 1024;
+    float   m_profile[TABLE_SIZE + 1];
+};
+static const BurleyProfileTable burley_profile;
+
 float ClearcoatGGX::D(const Vector& h) const {
     // D(h) = ( alpha^2 - 1 ) / ( 2 * PI * ln(alpha) * ( 1 + ( alpha^2 - 1 ) * cos(\theta) ^ 2 )
 
@@ -153,8 +184,9 @@ Spectrum DisneyBssrdf::S( const Vector& wo , const Point& po , const Vector& wi
 
 Spectrum DisneyBssrdf::Sr( float r ) const{
     r = ( r < 0.000001f ) ? 0.000001f : r;
-    constexpr auto EIGHT_PI = 4.0 * TWO_PI;
-    return R * ( ( Spectrum( -r ) / d ).Exp() + ( Spectrum( -r ) / ( 3.0f * d ) ).Exp() ) / ( EIGHT_PI * d * r );
+    constexpr auto EIGHT_PI = 4.0f * TWO_PI;
+    const auto profile = Spectrum( burley_profile( r / d[0] ) , burley_profile( r / d[1] ) , burley_profile( r / d[2] ) );
+    return R * profile / ( EIGHT_PI * d * r );
 }
 
 float DisneyBssrdf::Sample_Sr(int ch, float r) const{
@@ -167,11 +199,12 @@ float DisneyBssrdf::Sample_Sr(int ch, float r) const{
     return ( ret > burley_max_r_d * d[ch] ) ? -1.0f : ret;
 }
 
-float DisneyBssrdf::Pdf_Sr(int ch, float r) const{
+Spectrum DisneyBssrdf::Pdf_Sr(float r) const{
     // Sr(ch,r) = ( 0.25f * exp( -r / d[ch] ) / ( TWO_PI * d[ch] * r ) + 0.75f * exp( -r / ( 3.0f * d[ch] ) ) / ( SIX_PI * d[ch] * r )
     constexpr auto EIGHT_PI = 4.0f * TWO_PI;
     r = ( r < 0.000001f ) ? 0.000001f : r;
-    return ( exp( -r / d[ch] ) + exp( -r / ( 3.0f * d[ch] ) ) ) / ( EIGHT_PI * d[ch] * r ) * burley_inv_max_cdf;
+    const auto profile = Spectrum( burley_profile( r / d[0] ) , burley_profile( r / d[1] ) , burley_profile( r / d[2] ) );
+    return profile / ( EIGHT_PI * d * r ) * burley_inv_max_cdf;
 }
 
 float DisneyBssrdf::Max_Sr(int ch) const{
@@ -271,11 +271,10 @@ protected:
     
     //! @brief  Pdf of sampling such a distance based on the reflectance profile.
     //!
-    //! @param  ch          Spectrum channel.
     //! @param  d           Distance from the extant point.
-    //! @return             Pdf of sampling it.
-    float       Pdf_Sr(int ch, float d) const override;
+    //! @return             Pdf of sampling it in each channel.
+    Spectrum    Pdf_Sr(float d) const override;
 
 private:
     Spectrum    d;
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -18,48 +18,13 @@
 #pragma once
 
 #include "bxdf.h"
-#include "core/sassert.h"
-#include "scatteringevent/scatteringevent.h"
 
 DECLARE_CLOSURE_TYPE_BEGIN(ClosureTypeDoubleSided, "double_sided")
 DECLARE_CLOSURE_TYPE_VAR(ClosureTypeDoubleSided, Tsl_closure, closure0)
 DECLARE_CLOSURE_TYPE_VAR(ClosureTypeDoubleSided, Tsl_closure, closure1)
 DECLARE_CLOSURE_TYPE_END(ClosureTypeDoubleSided)
 
-//! @brief DoubleSided BRDF.
-/**
- * This is a BXDF wrapper shows double sided BRDF.
- * Note there may be unknown behavior if this bxdf is fed with a BTDF, which is not suggested!
- */
-class DoubleSided : public Bxdf{
-public:
-    //! Constructor
-    //! @param bxdf0        Bxdf0.
-    //! @param bxdf1        Bxdf1.
-    //! @param weight       Weight of the BXDF.
-    DoubleSided(const ScatteringEvent* se0 , const ScatteringEvent* se1 , const Spectrum& weight ) : Bxdf(weight, (BXDF_TYPE)(BXDF_ALL_TYPES), DIR_UP, false), m_se0(se0), m_se1(se1) {}
-
-    //! Evaluate the BRDF
-    //! @param wo   Exitant direction in shading coordinate.
-    //! @param wi   Incident direction in shading coordinate.
-    //! @return     The Evaluated BRDF value.
-    Spectrum f( const Vector& wo , const Vector& wi ) const override;
-
-    //! @brief Importance sampling for the fresnel BRDF.
-    //! @param wo   Exitant direction in shading coordinate.
-    //! @param wi   Incident direction in shading coordinate.
-    //! @param bs   Sample for bsdf that holds some random variables.
-    //! @param pdf  Probability density of the selected direction.
-    //! @return     The Evaluated BRDF value.
-    Spectrum sample_f( const Vector& wo , Vector& wi , const BsdfSample& bs , float* pdf ) const override;
-
-    //! @brief Evaluate the pdf of an exitant direction given the Incident direction.
-    //! @param wo   Exitant direction in shading coordinate.
-    //! @param wi   Incident direction in shading coordinate.
-    //! @return     The probability of choosing the out-going direction based on the Incident direction.
-    float pdf( const Vector& wo , const Vector& wi ) const override;
-
-private:
-    const ScatteringEvent* m_se0;      /**< Scattering event on the front side of the surface. */
-    const ScatteringEvent* m_se1;      /**< Scattering event on the back side of the surface. */
-};
+// There is no bxdf for double sided materials. The bxdfs of both sides are added to the scattering event directly,
+// each responding only to directions on its own side of the surface, check 'ScatteringEvent::SetLobeSide' for
+// further detail.
+// Note there may be unknown behavior if this is fed with a BTDF, which is not suggested!
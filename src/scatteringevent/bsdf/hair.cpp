@@ -53,14 +53,44 @@ SORT_STATIC_FORCEINLINE float I0(const float x) {
     return val;
 }
 
-SORT_STATIC_FORCEINLINE float LogI0(float x) {
-    return (x > 12) ? x + 0.5f * (-log(TWO_PI) + log(1 / x) + 1 / (8 * x)) : log(I0(x));
-}
+//! @brief  Logarithm of the modified Bessel function of the first kind.
+/**
+ * Evaluating the series of I0 takes most of the time spent in 'Mp', which is evaluated for every lobe in
+ * every evaluation of the bxdf. Log(I0) is very smooth, a linearly interpolated table is accurate enough
+ * for it. Arguments beyond the table fall back to the asymptotic expansion, which is cheap already.
+ */
+class LogI0Table{
+public:
+    LogI0Table(){
+        for( auto i = 0u ; i <= TABLE_SIZE ; ++i )
+            m_table[i] = log( I0( MAX_X * i / TABLE_SIZE ) );
+    }
+
+    SORT_FORCEINLINE float operator()( float x ) const {
+        const auto fi = x * ( TABLE_SIZE / MAX_X );
+        if( fi >= TABLE_SIZE )
+            return x + 0.5f * (-log(TWO_PI) + log(1 / x) + 1 / (8 * x));
+        const auto i = (unsigned)fi;
+        const auto t = fi - i;
+        return m_table[i] * ( 1.0f - t ) + m_table[i+1] * t;
+    }
+
+private:
+    static constexpr unsigned TABLE_SIZE = 1024;
+    static constexpr float    MAX_X = 12.0f;
+    float   m_table[TABLE_SIZE + 1];
+};
+static const LogI0Table LogI0;
 
-SORT_STATIC_FORCEINLINE float Mp( const float cosThetaI , const float cosThetaO , const float sinThetaI , const float sinThetaO , const float v ){
+// 'logNorm' is the logarithm of the normalization factor of the lobe, it only depends on 'v'.
+SORT_STATIC_FORCEINLINE float Mp( const float cosThetaI , const float cosThetaO , const float sinThetaI , const float sinThetaO , const float v , const float logNorm ){
     const auto a = cosThetaI * cosThetaO / v;
     const auto b = sinThetaI * sinThetaO / v;
-    return (v <= .1) ? (exp(LogI0(a) - b - 1 / v + 0.6931f + log(1 / (2 * v)))) : (exp(-b) * I0(a)) / (sinh(1 / v) * 2 * v);
+    return exp( LogI0(a) - b + logNorm );
+}
+
+SORT_STATIC_FORCEINLINE float MpLogNorm( const float v ){
+    return (v <= .1) ? ( -1 / v + 0.6931f + log(1 / (2 * v)) ) : -log( sinh(1 / v) * 2 * v );
 }
 
 SORT_STATIC_FORCEINLINE float Phi( const int p , const float gammaO , const float gammaT ){
@@ -68,29 +98,26 @@ SORT_STATIC_FORCEINLINE float Phi( const int p , const float gammaO , const floa
 }
 
 SORT_STATIC_FORCEINLINE float Logistic( float x , const float scale ){
-    x = abs(x);
-    return exp( -x / scale ) / ( scale * SQR( 1.0f + exp( -x / scale ) ) );
+    const auto e = exp( -abs(x) / scale );
+    return e / ( scale * SQR( 1.0f + e ) );
 }
 
 SORT_STATIC_FORCEINLINE float LogisticCDF( const float x , const float scale ){
     return 1.0f / ( 1.0f + exp( -x / scale ) );
 }
 
-SORT_STATIC_FORCEINLINE float TrimmedLogistic( const float x , const float scale , const float a , const float b ){
-    return Logistic( x , scale ) / ( LogisticCDF( b , scale ) - LogisticCDF( a , scale ) );
-}
-
 SORT_STATIC_FORCEINLINE float SampleTrimmedLogistic(const float r, const float scale, const float a, const float b) {
     const auto k = LogisticCDF(b, scale) - LogisticCDF(a, scale);
     const auto x = -scale * log(1 / (r * k + LogisticCDF(a, scale)) - 1);
     return clamp(x, a, b);
 }
 
-SORT_STATIC_FORCEINLINE float Np( const float phi , const int p , const float scale , const float gammaO , const float gammaT ){
+// 'invNorm' is the reciprocal of the integral of the logistic function over [-PI,PI], it only depends on 'scale'.
+SORT_STATIC_FORCEINLINE float Np( const float phi , const int p , const float scale , const float invNorm , const float gammaO , const float gammaT ){
     float dphi = phi - Phi( p , gammaO , gammaT );
     while( dphi > PI ) dphi -= TWO_PI;
     while( dphi < -PI ) dphi += TWO_PI;
-    return TrimmedLogistic( dphi, scale, -PI, PI);
+    return Logistic( dphi , scale ) * invNorm;
 }
 
 SORT_STATIC_FORCEINLINE void ComputeApPdf(const float cosThetaO , const float cosThetaT ,
@@ -135,10 +162,27 @@ Hair::Hair(const Spectrum& absorption, const float lRoughness, const float aRoug
     constexpr auto SqrtPiOver8 = 0.626657069f; //sqrt( PI / 8.0f );
     m_scale = SqrtPiOver8 * (0.265f * m_aRoughness + 1.194f * SQR(m_aRoughness) + 5.372f * Pow<22>(m_aRoughness));
 
+    // terms only depending on the roughness are evaluated once here instead of for each lobe in each evaluation
+    for( auto p = 0 ; p <= PMAX ; ++p )
+        m_logNorm[p] = MpLogNorm( m_v[p] );
+    m_npInvNorm = 1.0f / ( LogisticCDF( PI , m_scale ) - LogisticCDF( -PI , m_scale ) );
+
     m_etaSqr = SQR( m_eta );
 }
 
 Spectrum Hair::f( const Vector& wo , const Vector& wi ) const{
+    return evaluate( wo , wi , nullptr );
+}
+
+float Hair::pdf( const Vector& wo , const Vector& wi ) const{
+    float pdf = 0.0f;
+    evaluate( wo , wi , &pdf );
+    return pdf;
+}
+
+Spectrum Hair::evaluate( const Vector& wo , const Vector& wi , float* pPdf ) const{
+    if( pPdf )
+        *pPdf = 0.0f;
     if( wo.y <= 0.0f || wi.y == 0.0f )
         return 0.0f;
 
@@ -173,7 +217,20 @@ Spectrum Hair::f( const Vector& wo , const Vector& wi ) const{
     Spectrum ap[PMAX + 1];
     Ap( cosThetaO , m_eta , cosGammaO , expT , ap );
 
+    // the pdf shares the longitudinal and azimuthal terms with the bxdf, only the lobes are weighted differently
+    float apPdf[PMAX + 1] = { 0.0f };
+    if( pPdf ){
+        auto sumY = 0.0f;
+        for( auto i = 0 ; i <= PMAX ; ++i ){
+            apPdf[i] = ap[i].GetIntensity();
+            sumY += apPdf[i];
+        }
+        for( auto i = 0 ; i <= PMAX ; ++i )
+            apPdf[i] /= sumY;
+    }
+
     Spectrum fsum(0.0f);
+    auto pdf = 0.0f;
     for( auto p = 0 ; p < PMAX ; ++p ){
 #ifndef DISABLE_ANGLE_TILT
         float sinThetaIp , cosThetaIp;
@@ -191,13 +248,19 @@ Spectrum Hair::f( const Vector& wo , const Vector& wi ) const{
             cosThetaIp = cosThetaI;
         }
         cosThetaIp = abs( cosThetaIp );
-        fsum += Mp( cosThetaIp , cosThetaO , sinThetaIp , sinThetaO , m_v[p] ) * ap[p] * Np( phi, p, m_scale, gammaO, gammaT );
+        const auto mn = Mp( cosThetaIp , cosThetaO , sinThetaIp , sinThetaO , m_v[p] , m_logNorm[p] ) * Np( phi, p, m_scale, m_npInvNorm, gammaO, gammaT );
 #else
-        fsum += Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[p] ) * ap[p] * Np( phi, p, m_scale, gammaO, gammaT );
+        const auto mn = Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[p] , m_logNorm[p] ) * Np( phi, p, m_scale, m_npInvNorm, gammaO, gammaT );
 #endif
+        fsum += mn * ap[p];
+        pdf += mn * apPdf[p];
     }
-    fsum += Mp( cosThetaI, cosThetaO, sinThetaI, sinThetaO, m_v[PMAX] ) * ap[PMAX] * INV_TWOPI;
+    const auto m = Mp( cosThetaI, cosThetaO, sinThetaI, sinThetaO, m_v[PMAX], m_logNorm[PMAX] ) * INV_TWOPI;
+    fsum += m * ap[PMAX];
+    pdf += m * apPdf[PMAX];
 
+    if( pPdf )
+        *pPdf = pdf;
     return fsum;
 }
 
@@ -265,87 +328,5 @@ Spectrum Hair::sample_f(const Vector& wo, Vector& wi, const BsdfSample& bs, floa
     const auto phiI = phiO + dphi;
     wi = Vector3f( sinThetaI , cosThetaI * sin( phiI ) , cosThetaI * cos( phiI ) );
 
-    if( pPdf ){
-        *pPdf = 0.0f;
-        for( auto p = 0 ; p < PMAX ; ++p ){
-#ifndef DISABLE_ANGLE_TILT
-            float sinThetaIp , cosThetaIp;
-            if( p == 0 ){
-                sinThetaIp = sinThetaI * m_cos2kAlpha[1] + cosThetaI * m_sin2kAlpha[1];
-                cosThetaIp = cosThetaI * m_cos2kAlpha[1] - sinThetaI * m_sin2kAlpha[1];
-            }else if( p == 1 ){
-                sinThetaIp = sinThetaI * m_cos2kAlpha[0] - cosThetaI * m_sin2kAlpha[0];
-                cosThetaIp = cosThetaI * m_cos2kAlpha[0] + sinThetaI * m_sin2kAlpha[0];
-            }else if( p == 2 ){
-                sinThetaIp = sinThetaI * m_cos2kAlpha[2] - cosThetaI * m_sin2kAlpha[2];
-                cosThetaIp = cosThetaI * m_cos2kAlpha[2] + sinThetaI * m_sin2kAlpha[2];
-            }else{
-                sinThetaIp = sinThetaI;
-                cosThetaIp = cosThetaI;
-            }
-            cosThetaIp = abs( cosThetaIp );
-            *pPdf += Mp( cosThetaIp , cosThetaO , sinThetaIp , sinThetaO , m_v[p] ) * apPdf[p] * Np( dphi, p, m_scale, gammaO, gammaT );
-#else
-            *pPdf += Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[p] ) * apPdf[p] * Np( dphi, p, m_scale, gammaO, gammaT );
-#endif
-        }
-        *pPdf += Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[PMAX] ) * apPdf[PMAX] * INV_TWOPI;
-    }
-    return f( wo , wi );
-}
-
-float Hair::pdf( const Vector& wo , const Vector& wi ) const{
-    if( wo.y <= 0.0f || wi.y == 0.0f )
-        return 0.0f;
-
-    const auto sinThetaO = wo.x;
-    const auto cosThetaO = ssqrt( 1.0f - SQR(sinThetaO) );
-    const auto phiO = atan2(wo.y, wo.z);
-
-    const auto sinThetaI = wi.x;
-    const auto cosThetaI = ssqrt( 1.0f - SQR(sinThetaI) );
-    const auto phiI = atan2(wi.y, wi.z);
-
-    const auto sinThetaT = sinThetaO / m_eta;
-    const auto cosThetaT = ssqrt( 1.0f - SQR(sinThetaT) );
-
-    const auto etap = sqrt( m_etaSqr - SQR( sinThetaO ) ) / cosThetaO;
-
-    const auto cosGammaO = wo.y / cosThetaO;
-    const auto sinGammaO = wo.z / cosThetaO;
-    const auto gammaO = asin( clamp( sinGammaO , -1.0f , 1.0f ) );
-
-    const auto sinGammaT = sinGammaO / etap;
-    const auto cosGammaT = ssqrt( 1.0f - SQR(sinGammaT) );
-    const auto gammaT = asin( clamp( sinGammaT , -1.0f , 1.0f ) );
-
-    float apPdf[PMAX + 1] = {0.0f};
-    ComputeApPdf( cosThetaO , cosThetaT , cosGammaO , cosGammaT , m_eta , m_sigma , apPdf );
-
-    auto phi = phiI - phiO;
-    auto pdf = 0.0f;
-    for( auto p = 0 ; p < PMAX ; ++p ){
-#ifndef DISABLE_ANGLE_TILT
-        float sinThetaIp , cosThetaIp;
-        if( p == 0 ){
-            sinThetaIp = sinThetaI * m_cos2kAlpha[1] + cosThetaI * m_sin2kAlpha[1];
-            cosThetaIp = cosThetaI * m_cos2kAlpha[1] - sinThetaI * m_sin2kAlpha[1];
-        }else if( p == 1 ){
-            sinThetaIp = sinThetaI * m_cos2kAlpha[0] - cosThetaI * m_sin2kAlpha[0];
-            cosThetaIp = cosThetaI * m_cos2kAlpha[0] + sinThetaI * m_sin2kAlpha[0];
-        }else if( p == 2 ){
-            sinThetaIp = sinThetaI * m_cos2kAlpha[2] - cosThetaI * m_sin2kAlpha[2];
-            cosThetaIp = cosThetaI * m_cos2kAlpha[2] + sinThetaI * m_sin2kAlpha[2];
-        }else{
-            sinThetaIp = sinThetaI;
-            cosThetaIp = cosThetaI;
-        }
-        cosThetaIp = abs( cosThetaIp );
-        pdf += Mp( cosThetaIp , cosThetaO , sinThetaIp , sinThetaO , m_v[p] ) * apPdf[p] * Np( phi, p, m_scale, gammaO, gammaT );
-#else
-        pdf += Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[p] ) * apPdf[p] * Np( phi, p, m_scale, gammaO, gammaT );
-#endif
-    }
-    pdf += Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[PMAX] ) * apPdf[PMAX] * INV_TWOPI;
-    return pdf;
+    return evaluate( wo , wi , pPdf );
 }
@@ -82,8 +82,20 @@ private:
     float           m_v[PMAX+1];          /**< Some pre-calculated cached data. */
     float           m_scale;              /**< Azimuhthal logisitic scale factor. */
     float           m_etaSqr;             /**< Squared eta. */
+    float           m_logNorm[PMAX+1];    /**< Logarithm of the normalization factor of the longitudinal term of each lobe. */
+    float           m_npInvNorm;          /**< Reciprocal of the normalization factor of the azimuthal term. */
 #ifndef DISABLE_ANGLE_TILT
     float           m_cos2kAlpha[PMAX];   /**< Some pre-calculated cached data, cos( 2 ^ k ). */
     float           m_sin2kAlpha[PMAX];   /**< Some pre-calculated cached data, sin( 2 ^ k ). */
 #endif
+
+    //! @brief  Evaluate the BRDF and the pdf of sampling the incident direction at once.
+    //!
+    //! Both are sums of the same longitudinal and azimuthal terms, only weighted differently for each lobe.
+    //!
+    //! @param wo   Exitant direction in shading coordinate.
+    //! @param wi   Incident direction in shading coordinate.
+    //! @param pdf  The pdf of sampling the incident direction, it is not evaluated if it is 'nullptr'.
+    //! @return     The Evaluated BRDF value.
+    Spectrum evaluate( const Vector& wo , const Vector& wi , float* pdf ) const;
 };
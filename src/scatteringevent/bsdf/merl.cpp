@@ -21,8 +21,11 @@
 #include "core/define.h"
 #include "core/memory.h"
 #include "core/path.h"
+#include "core/samplemethod.h"
 #include "math/vector3.h"
+#include "sampler/sample.h"
 #include "material/matmanager.h"
+#include "task/task.h"
 
 IMPLEMENT_CLOSURE_TYPE_BEGIN(ClosureTypeMERL)
 IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeMERL, Tsl_resource, merl_data)
@@ -38,6 +41,14 @@ static const double MERL_RED_SCALE = 0.0006666666666667;
 static const double MERL_GREEN_SCALE = 0.000766666666666667;
 static const double MERL_BLUE_SCALE = 0.0011066666666666667;
 
+// resolution of the importance sampling table, the reflected energy is tabulated for each range of exitant elevation
+// over the incident elevation and the azimuth relative to the exitant direction.
+static const unsigned MERL_TABLE_RES_THETA_O = 16;
+static const unsigned MERL_TABLE_RES_THETA_I = 32;
+static const unsigned MERL_TABLE_RES_PHI = 64;
+// probability of sampling the table instead of the cosine weighted hemisphere
+static const float MERL_TABLE_SAMPLE_RATIO = 0.8f;
+
 // Load data from file
 bool MerlData::LoadResource( const std::string filename )
 {
@@ -60,21 +71,24 @@ bool MerlData::LoadResource( const std::string filename )
         return false;
     }
 
-    // allocate data
+    // the raw data is stored in double precision with the three channels in separate blocks, it is converted to
+    // single precision with the channels of a sample next to each other, which halves the memory and keeps a lookup
+    // in one cache line.
     auto trunksize = dims[0] * dims[1] * dims[2];
     auto size = 3u * trunksize;
-    m_data = std::make_unique<double[]>(size);
-    file.read( (char*)m_data.get() , sizeof( double ) * size );
+    auto raw = std::make_unique<double[]>(size);
+    file.read( (char*)raw.get() , sizeof( double ) * size );
+    file.close();
 
-    unsigned offset = 0;
-    for(auto i = 0u ; i < trunksize ; i++ )
-        m_data[offset++] *= MERL_RED_SCALE;
-    for(auto i = 0u ; i < trunksize ; i++ )
-        m_data[offset++] *= MERL_GREEN_SCALE;
-    for(auto i = 0u ; i < trunksize ; i++ )
-        m_data[offset++] *= MERL_BLUE_SCALE;
+    // negative values mark samples that were not measured
+    const double scale[3] = { MERL_RED_SCALE , MERL_GREEN_SCALE , MERL_BLUE_SCALE };
+    m_data = std::make_unique<float[]>(size);
+    for( auto c = 0u ; c < 3u ; ++c ){
+        for( auto i = 0u ; i < trunksize ; ++i )
+            m_data[ 3u * i + c ] = (float)std::max( 0.0 , raw[ c * trunksize + i ] * scale[c] );
+    }
 
-    file.close();
+    buildSamplingTable();
     return true;
 }
 
@@ -120,16 +134,97 @@ Spectrum MerlData::f( const Vector& Wo , const Vector& Wi ) const
     // calculate the index
     auto index = wdPhiIndex + MERL_SAMPLING_RES_PHI_D * (wdThetaIndex + whThetaIndex * MERL_SAMPLING_RES_THETA_D);
 
-    const auto r = (float)( m_data[ index ] );
-    index += MERL_SAMPLING_COUNT;
-    const auto g = (float)( m_data[ index ] );
-    index += MERL_SAMPLING_COUNT;
-    const auto b = (float)( m_data[ index ] );
+    const auto data = m_data.get() + 3u * index;
+    return Spectrum( data[0] , data[1] , data[2] );
+}
+
+// tabulate the reflected energy
+void MerlData::buildSamplingTable()
+{
+    constexpr auto table_size = MERL_TABLE_RES_THETA_I * MERL_TABLE_RES_PHI;
+    auto data = std::make_unique<float[]>( MERL_TABLE_RES_THETA_O * table_size );
+
+    // each row is one incident elevation for one exitant elevation, the brdf is evaluated at the center of the cells,
+    // weighted by the cosine and the solid angle of the cell.
+    ParallelForRows( MERL_TABLE_RES_THETA_O * MERL_TABLE_RES_THETA_I , [&]( int r0 , int r1 ){
+        for( auto r = r0 ; r < r1 ; ++r ){
+            const auto o = r / MERL_TABLE_RES_THETA_I;
+            const auto i = r % MERL_TABLE_RES_THETA_I;
+            const auto theta_o = ( (float)o + 0.5f ) / (float)MERL_TABLE_RES_THETA_O * HALF_PI;
+            const auto theta_i = ( (float)i + 0.5f ) / (float)MERL_TABLE_RES_THETA_I * HALF_PI;
+            const auto wo = sphericalVec( theta_o , 0.0f );
+            const auto weight = cos( theta_i ) * sin( theta_i );
+
+            auto row = data.get() + o * table_size + i * MERL_TABLE_RES_PHI;
+            for( auto j = 0u ; j < MERL_TABLE_RES_PHI ; ++j ){
+                const auto phi = ( (float)j + 0.5f ) / (float)MERL_TABLE_RES_PHI * TWO_PI;
+                row[j] = f( wo , sphericalVec( theta_i , phi ) ).GetIntensity() * weight;
+            }
+        }
+    });
+
+    m_sampling.clear();
+    m_sampling.reserve( MERL_TABLE_RES_THETA_O );
+    for( auto o = 0u ; o < MERL_TABLE_RES_THETA_O ; ++o )
+        m_sampling.emplace_back( data.get() + o * table_size , MERL_TABLE_RES_PHI , MERL_TABLE_RES_THETA_I );
+}
+
+// get the distribution for the exitant direction
+const Distribution2D& MerlData::getDistribution( const Vector& wo ) const
+{
+    const auto o = (unsigned)( sphericalTheta( wo ) * INV_PI * 2.0f * MERL_TABLE_RES_THETA_O );
+    return m_sampling[ std::min( o , MERL_TABLE_RES_THETA_O - 1 ) ];
+}
+
+// sample an incident direction
+Vector MerlData::Sample( const Vector& wo , float u , float v ) const
+{
+    float uv[2];
+    getDistribution( wo ).SampleContinuous( u , v , uv , nullptr );
+    return sphericalVec( uv[1] * HALF_PI , uv[0] * TWO_PI + sphericalPhi( wo ) );
+}
+
+// pdf of sampling an incident direction
+float MerlData::Pdf( const Vector& wo , const Vector& wi ) const
+{
+    const auto sin_theta = sinTheta( wi );
+    if( wi.y <= 0.0f || sin_theta <= 0.0f )
+        return 0.0f;
+
+    auto phi = sphericalPhi( wi ) - sphericalPhi( wo );
+    if( phi < 0.0f )
+        phi += TWO_PI;
 
-    return Spectrum( r , g , b );
+    // the table is parameterized by ( phi , theta ) over [0,2PI)x[0,PI/2), which takes 'PI * PI * sin(theta)' to convert to solid angle
+    const auto pdf_uv = getDistribution( wo ).Pdf( phi * INV_TWOPI , sphericalTheta( wi ) * INV_PI * 2.0f );
+    return pdf_uv / ( PI * PI * sin_theta );
 }
 
  Merl::Merl(const ClosureTypeMERL& params, const Spectrum& weight, bool doubleSided)
      : Bxdf(weight, BXDF_ALL, params.normal, doubleSided), m_data((MerlData*)params.merl_data)
  {
- }
\ No newline at end of file
+ }
+
+Spectrum Merl::sample_f( const Vector& wo , Vector& wi , const BsdfSample& bs , float* pPdf ) const
+{
+    // the measured data has nothing below the surface
+    if( wo.y <= 0.0f )
+        return Bxdf::sample_f( wo , wi , bs , pPdf );
+
+    if( bs.u < MERL_TABLE_SAMPLE_RATIO )
+        wi = m_data->Sample( wo , bs.u / MERL_TABLE_SAMPLE_RATIO , bs.v );
+    else
+        wi = CosSampleHemisphere( ( bs.u - MERL_TABLE_SAMPLE_RATIO ) / ( 1.0f - MERL_TABLE_SAMPLE_RATIO ) , bs.v );
+
+    if( pPdf ) *pPdf = pdf( wo , wi );
+    return f( wo , wi );
+}
+
+float Merl::pdf( const Vector& wo , const Vector& wi ) const
+{
+    if( wo.y <= 0.0f )
+        return Bxdf::pdf( wo , wi );
+    if( !SameHemiSphere(wo, wi) ) return 0.0f;
+    if( !doubleSided && !PointingUp(wo) ) return 0.0f;
+    return MERL_TABLE_SAMPLE_RATIO * m_data->Pdf( wo , wi ) + ( 1.0f - MERL_TABLE_SAMPLE_RATIO ) * CosHemispherePdf( wi );
+}
@@ -17,8 +17,10 @@
 
 #pragma once
 
+#include <vector>
 #include "bxdf.h"
 #include "core/resource.h"
+#include "core/samplemethod.h"
 #include "scatteringevent/bsdf/bxdf_utils.h"
 
 DECLARE_CLOSURE_TYPE_BEGIN(ClosureTypeMERL, "merl")
@@ -53,8 +55,30 @@ public:
     //! @return True if data is valid, otherwise it will return false.
     bool    IsValid() { return m_data != 0; }
 
+    //! @brief  Importance sample an incident direction based on the tabulated reflectance.
+    //!
+    //! @param wo   Exitant direction in shading coordinate, it needs to be pointing up.
+    //! @param u    A canonical random variable.
+    //! @param v    A canonical random variable.
+    //! @return     The sampled incident direction in shading coordinate.
+    Vector  Sample( const Vector& wo , float u , float v ) const;
+
+    //! @brief  Pdf w.r.t solid angle of sampling an incident direction with 'Sample'.
+    //!
+    //! @param wo   Exitant direction in shading coordinate, it needs to be pointing up.
+    //! @param wi   Incident direction in shading coordinate.
+    //! @return     The pdf of sampling the incident direction.
+    float   Pdf( const Vector& wo , const Vector& wi ) const;
+
 private:
-    std::unique_ptr<double[]>    m_data = nullptr;   /**< The actual data of MERL brdf. */
+    std::unique_ptr<float[]>        m_data = nullptr;   /**< The actual data of MERL brdf, RGB of each sample are stored next to each other. */
+    std::vector<Distribution2D>     m_sampling;         /**< Distribution of reflected energy over incident directions, one for each range of exitant elevation. */
+
+    //! @brief  Tabulate the reflected energy for importance sampling.
+    void    buildSamplingTable();
+
+    //! @brief  Find the distribution used for sampling with an exitant direction.
+    const Distribution2D&   getDistribution( const Vector& wo ) const;
 };
 
 //! @brief  MERL brdf.
@@ -62,11 +86,12 @@ private:
  * MERL is short for Mitsubishi Electric Research Laboratories. They provide some measured
  * brdf on the website http://www.merl.com/brdf/. Merl class is responsible for loading
  * and displaying the brdf they provided in the renderer.\n
- * There is no importance sampling for this brdf. With the default sampling method, the
- * convergence rage is extremely low.
  * The paper <a href="http://csbio.unc.edu/mcmillan/pubs/sig03_matusik.pdf">
  * "A Data-Driven Reflectance Model"</a> didn't propose an importance sampling method
- * for it. Further research is needed before it can be practical to be used.
+ * for it. Since the brdf is isotropic, the reflected energy is tabulated over incident
+ * directions relative to the azimuth of the exitant direction, for a few ranges of exitant
+ * elevation, when the data is loaded. Directions are sampled from the table most of the time,
+ * the rest are sampled with cosine weighted sampling to cover what the coarse table misses.
  */
 class Merl : public Bxdf
 {
@@ -87,6 +112,20 @@ public:
         return m_data->f(wo,wi) * absCosTheta(wi);
     }
 
+    //! @brief Importance sampling for the MERL brdf.
+    //! @param wo   Exitant direction in shading coordinate.
+    //! @param wi   Incident direction in shading coordinate.
+    //! @param bs   Sample for bsdf that holds some random variables.
+    //! @param pdf  Probability density of the selected direction.
+    //! @return     The Evaluated BRDF value.
+    Spectrum sample_f( const Vector& wo , Vector& wi , const BsdfSample& bs , float* pdf ) const override;
+
+    //! @brief Evaluate the pdf of an existance direction given the Incident direction.
+    //! @param wo   Exitant direction in shading coordinate.
+    //! @param wi   Incident direction in shading coordinate.
+    //! @return     The probability of choosing the out-going direction based on the Incident direction.
+    float pdf( const Vector& wo , const Vector& wi ) const override;
+
 private:
     const MerlData* m_data;   /**< The actual data of MERL brdf. */
 };
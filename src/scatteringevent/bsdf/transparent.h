@@ -66,6 +66,11 @@ public:
     //! @return     The probability of choosing the out-going direction based on the Incident direction.
     float pdf( const Vector& wo , const Vector& wi ) const override;
 
+    //! @brief  Transparent bxdf only passes light straight through.
+    bool IsDelta() const override {
+        return true;
+    }
+
 private:
     const Spectrum A;         /**< Attenuation of radiance. */
 };
\ No newline at end of file
@@ -67,13 +67,11 @@ void SeparableBssrdf::Sample_S( const Scene& scene , const Vector& wo , const Po
     scene.GetIntersect( ray , inter , intersection->primitive->GetMaterial()->GetUniqueID() );
 
     for( auto i = 0u ; i < inter.cnt ; ++i ){
-        sAssert(IS_PTR_VALID(inter.intersections[i]), MATERIAL );
-
-        auto pIntersection = inter.intersections[i];
-        const auto bssrdf = Sr( distance( po , pIntersection->intersection.intersect ) );
-        const auto pdf = Pdf_Sp( po , pIntersection->intersection.intersect , pIntersection->intersection.gnormal );
+        auto& hit = inter.intersections[i];
+        const auto bssrdf = Sr( distance( po , hit.intersection.intersect ) );
+        const auto pdf = Pdf_Sp( po , hit.intersection.intersect , hit.intersection.gnormal );
         if( pdf > 0.0f && !bssrdf.IsBlack() )
-            pIntersection->weight = bssrdf / pdf * GetEvalWeight();
+            hit.weight = bssrdf / pdf * GetEvalWeight();
     }
 }
 
@@ -89,13 +87,16 @@ float SeparableBssrdf::Pdf_Sp( const Point& po , const Point& pi , const Vector&
     constexpr float axisProb[3] = { 0.25f , 0.5f , 0.25f };
     auto pdf = 0.0f ;
     for( auto axis = 0 ; axis < 3 ; ++axis ){
+        const auto pdf_sr = Pdf_Sr( rProj[axis] );
+        auto pdf_axis = 0.0f;
         for( auto ch = 0 ; ch < SPECTRUM_SAMPLE ; ++ch ){
             #ifdef SSS_REPLACE_WITH_LAMBERT
             if( R[ch] == 0.0f )
                 continue;
             #endif
-            pdf += Pdf_Sr( ch , rProj[axis] ) * std::abs( nLocal[axis] ) * axisProb[axis];
+            pdf_axis += pdf_sr[ch];
         }
+        pdf += pdf_axis * std::abs( nLocal[axis] ) * axisProb[axis];
     }
     pdf /= channels;
     return pdf;
@@ -37,9 +37,10 @@ struct BSSRDFIntersection{
 
 /**
  * BSSRDFIntersection may have multiple, up to 4, intersections if needed.
+ * Intersections are kept inline, spatial data structures fill them in place without allocating anything.
  */ 
 struct BSSRDFIntersections{
-    BSSRDFIntersection*     intersections[TOTAL_SSS_INTERSECTION_CNT] = { nullptr };
+    BSSRDFIntersection      intersections[TOTAL_SSS_INTERSECTION_CNT];
     unsigned                cnt = 0;
 
     // following field is only used for spatial data structure to evaluate intersections
@@ -48,9 +49,9 @@ struct BSSRDFIntersections{
     //! @brief  Resoved the maximum depth of all intersections.
     void    ResolveMaxDepth() {
         maxt = 0.0f;
-        maxt = std::max(intersections[0]->intersection.t, intersections[1]->intersection.t);
-        maxt = std::max(maxt, intersections[2]->intersection.t);
-        maxt = std::max(maxt, intersections[3]->intersection.t);
+        maxt = std::max(intersections[0].intersection.t, intersections[1].intersection.t);
+        maxt = std::max(maxt, intersections[2].intersection.t);
+        maxt = std::max(maxt, intersections[3].intersection.t);
     }
 };
 
@@ -147,10 +148,11 @@ protected:
 
     //! @brief  Pdf of sampling such a distance based on the reflectance profile.
     //!
-    //! @param  ch      Spectrum channel.
+    //! All channels are evaluated at once, the pdf of sampling a point takes all of them into account.
+    //!
     //! @param  d       Distance from the extant point.
-    //! @return         Pdf of sampling it.
-    virtual float       Pdf_Sr(int ch, float d) const = 0;
+    //! @return         Pdf of sampling it in each channel.
+    virtual Spectrum    Pdf_Sr(float d) const = 0;
 
     //! @brief  Get maximum profile sampling distance
     //!
@@ -171,4 +173,4 @@ protected:
     Spectrum    R;      /**< Reflectance of the BSSRDF. */
 
     const SurfaceInteraction*   intersection;   /**< Intersection that spawns the BSSRDF. */
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -59,13 +59,17 @@ Vector ScatteringEvent::localToWorld( const Vector& v ) const{
 }
 
 float ScatteringEvent::SampleScatteringType( SE_Flag& flag ) const{
-    if (UNLIKELY(m_bxdfTotalSampleWeight == 0.0f && m_bssrdfTotalSampleWeight == 0.0f)) {
+    // lobes on the other side of a double sided material can't scatter 'wo', counting them would favor bxdf over bssrdf
+    const auto side = cosTheta( worldToLocal( m_intersection.view ) ) < 0.0f ? SE_BACK_SIDE : SE_FRONT_SIDE;
+    const auto bxdf_weight = m_sideSampleWeight[ side - 1 ];
+
+    if (UNLIKELY(bxdf_weight == 0.0f && m_bssrdfTotalSampleWeight == 0.0f)) {
         flag = SE_Flag::SE_NONE;
         return 0.0f;
     }
 
     // handling common cases where there is either BSSRDF or BSDF.
-    if( m_bxdfTotalSampleWeight == 0.0f ){
+    if( bxdf_weight == 0.0f ){
         flag = SE_EVALUATE_BSSRDF;
         return 1.0f;
     }else if( m_bssrdfTotalSampleWeight == 0.0f ){
@@ -73,57 +77,100 @@ float ScatteringEvent::SampleScatteringType( SE_Flag& flag ) const{
         return 1.0f;
     }
 
-    const auto pdf_bxdf = m_bxdfTotalSampleWeight / ( m_bxdfTotalSampleWeight + m_bssrdfTotalSampleWeight );
+    const auto pdf_bxdf = bxdf_weight / ( bxdf_weight + m_bssrdfTotalSampleWeight );
     const auto r = sort_canonical();
     flag = ( r < pdf_bxdf ) ? SE_EVALUATE_BXDF : SE_EVALUATE_BSSRDF;
     return flag == SE_EVALUATE_BXDF ? pdf_bxdf : 1.0f - pdf_bxdf;
 }
 
+// whether a lobe responds to the exitant direction on the given side
+SORT_STATIC_FORCEINLINE bool lobeVisible( const ScatteringLobe& lobe , const SE_LobeSide side ){
+    return lobe.side == SE_BOTH_SIDES || lobe.side == side;
+}
+
+// evaluate a lobe, sided lobes only scatter between directions on their own side
+SORT_STATIC_FORCEINLINE Spectrum evaluateLobe( const ScatteringLobe& lobe , const Vector& wo , const Vector& wi ){
+    if( lobe.side == SE_BOTH_SIDES )
+        return lobe.bxdf->F( wo , wi ) * lobe.evalWeight;
+    const auto back_o = cosTheta(wo) < 0.0f;
+    const auto back_i = cosTheta(wi) < 0.0f;
+    if( back_o != back_i || back_o != ( lobe.side == SE_BACK_SIDE ) )
+        return 0.0f;
+    return ( back_o ? lobe.bxdf->F( -wo , -wi ) : lobe.bxdf->F( wo , wi ) ) * lobe.evalWeight;
+}
+
+// pdf of sampling a lobe, without the probability of picking it
+SORT_STATIC_FORCEINLINE float pdfLobe( const ScatteringLobe& lobe , const Vector& wo , const Vector& wi ){
+    if( lobe.side == SE_BOTH_SIDES )
+        return lobe.bxdf->Pdf( wo , wi );
+    const auto back_o = cosTheta(wo) < 0.0f;
+    const auto back_i = cosTheta(wi) < 0.0f;
+    if( back_o != back_i || back_o != ( lobe.side == SE_BACK_SIDE ) )
+        return 0.0f;
+    return back_o ? lobe.bxdf->Pdf( -wo , -wi ) : lobe.bxdf->Pdf( wo , wi );
+}
+
 Spectrum ScatteringEvent::Evaluate_BSDF( const Vector& wo , const Vector& wi ) const{
     const auto swo = worldToLocal( wo );
     const auto swi = worldToLocal( wi );
-    Spectrum r;
-    for( auto i = 0u ; i < m_bxdfCnt ; ++i )
-        r += m_bxdfs[i]->F( swo , swi ) * m_bxdfs[i]->GetEvalWeight();
+    const auto side = cosTheta(swo) < 0.0f ? SE_BACK_SIDE : SE_FRONT_SIDE;
 
+    Spectrum r;
+    for( auto i = 0u ; i < m_bxdfCnt ; ++i ){
+        if( lobeVisible( m_lobes[i] , side ) )
+            r += evaluateLobe( m_lobes[i] , swo , swi );
+    }
     return r;
 }
 
 Spectrum ScatteringEvent::Sample_BSDF( const Vector& wo , Vector& wi , const class BsdfSample& bs , float& pdf ) const{
     pdf = 0.0f;
 
-    Spectrum ret;
-    if( m_bxdfCnt == 0 )
-        return ret;
-
-    // randomly pick a bxdf
-    float bxdf_pdf = 0.0f;
-    sAssert( m_bxdfTotalSampleWeight > 0.0f , MATERIAL );
-    const Bxdf* bxdf = pickScattering<Bxdf>( m_bxdfs , m_bxdfCnt , m_bxdfTotalSampleWeight , bxdf_pdf );
-
     // transform the 'wo' from world space to shading coordinate
-    auto swo = worldToLocal( wo );
+    const auto swo = worldToLocal( wo );
+    const auto side = cosTheta(swo) < 0.0f ? SE_BACK_SIDE : SE_FRONT_SIDE;
+    const auto total_weight = m_sideSampleWeight[ side - 1 ];
+    if( total_weight <= 0.0f )
+        return 0.0f;
+
+    // randomly pick a bxdf among the ones responding to this side
+    auto picked = 0u;
+    auto r = sort_canonical() * total_weight;
+    for( auto i = 0u ; i < m_bxdfCnt ; ++i ){
+        if( !lobeVisible( m_lobes[i] , side ) )
+            continue;
+        picked = i;
+        if( r <= m_lobes[i].sampleWeight )
+            break;
+        r -= m_lobes[i].sampleWeight;
+    }
+    const auto& lobe = m_lobes[picked];
 
-    // sample the direction
-    ret = bxdf->Sample_F( swo , wi , bs , &pdf ) * bxdf->GetEvalWeight();
+    // sample the direction, lobes of the back side see the directions flipped
+    Vector swi;
+    const auto flip = lobe.side == SE_BACK_SIDE;
+    auto ret = lobe.bxdf->Sample_F( flip ? -swo : swo , swi , bs , &pdf ) * lobe.evalWeight;
+    if( flip )
+        swi = -swi;
 
     // if there is no probability of sampling that direction , just return 0.0f
-    if( pdf == 0.0f )
+    if( pdf == 0.0f || ( lobe.side != SE_BOTH_SIDES && ( cosTheta(swi) < 0.0f ) != flip ) ){
+        pdf = 0.0f;
         return 0.0f;
-    
-    // update the pdf
-    pdf *= bxdf_pdf;
+    }
 
-    // setup pdf
+    // the pdf is the combination of all lobes that could have sampled the direction
+    pdf *= lobe.sampleWeight;
     for( auto i = 0u; i < m_bxdfCnt ; ++i ){
-        if( m_bxdfs[i] != bxdf ){
-            ret += m_bxdfs[i]->F(wo,wi) * m_bxdfs[i]->GetEvalWeight();
-            pdf += m_bxdfs[i]->Pdf(wo,wi) * m_bxdfs[i]->GetSampleWeight();
-        }
+        if( i == picked || !lobeVisible( m_lobes[i] , side ) )
+            continue;
+        ret += evaluateLobe( m_lobes[i] , swo , swi );
+        pdf += pdfLobe( m_lobes[i] , swo , swi ) * m_lobes[i].sampleWeight;
     }
+    pdf /= total_weight;
 
     // transform the direction back
-    wi = localToWorld( wi );
+    wi = localToWorld( swi );
     
     return ret;
 }
@@ -131,11 +178,17 @@ Spectrum ScatteringEvent::Sample_BSDF( const Vector& wo , Vector& wi , const cla
 float ScatteringEvent::Pdf_BSDF( const Vector& wo , const Vector& wi ) const{
     const auto lwo = worldToLocal( wo );
     const auto lwi = worldToLocal( wi );
+    const auto side = cosTheta(lwo) < 0.0f ? SE_BACK_SIDE : SE_FRONT_SIDE;
+    const auto total_weight = m_sideSampleWeight[ side - 1 ];
+    if( total_weight <= 0.0f )
+        return 0.0f;
 
     auto pdf = 0.0f;
-    for( auto i = 0u ; i < m_bxdfCnt ; ++i )
-        pdf += m_bxdfs[i]->Pdf( lwo , lwi ) * m_bxdfs[i]->GetSampleWeight();
-    return pdf;
+    for( auto i = 0u ; i < m_bxdfCnt ; ++i ){
+        if( lobeVisible( m_lobes[i] , side ) )
+            pdf += pdfLobe( m_lobes[i] , lwo , lwi ) * m_lobes[i].sampleWeight;
+    }
+    return pdf / total_weight;
 }
 
 void ScatteringEvent::Sample_BSSRDF( const Scene& scene , const Vector& wo , const Point& po , BSSRDFIntersections& inter , float& pdf ) const{
@@ -145,4 +198,4 @@ void ScatteringEvent::Sample_BSSRDF( const Scene& scene , const Vector& wo , con
 
     // importance sampling the bssrdf
     bssrdf->Sample_S( scene , wo , po , inter );
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -36,9 +36,29 @@ enum SE_Flag : unsigned int{
 #define SE_MAX_BXDF_COUNT          16      // Maximum number of bxdf in a material is 16 by default
 #define SE_MAX_BSSRDF_COUNT        4       // Maximum number of bssrdf in a material is 4 by default 
 
+//! @brief  Side of the surface a lobe responds to.
+enum SE_LobeSide : unsigned int{
+    SE_BOTH_SIDES       = 0,                                            // The bxdf decides how to handle both sides itself
+    SE_FRONT_SIDE       = 1,                                            // Only directions on the front side of the surface are scattered
+    SE_BACK_SIDE        = 2,                                            // Only directions on the back side are scattered, the bxdf sees them flipped to the front
+};
+
 class Bxdf;
 class MediumStack;
 
+//! @brief  Flattened record of a bxdf in a scattering event.
+/**
+ * All bxdfs in a scattering event are kept in a compact array of lobes, including the ones coming from both
+ * sides of a double sided material. The weights are copied next to the bxdf so that looping through the lobes
+ * doesn't need to touch the bxdfs that are not evaluated.
+ */
+struct ScatteringLobe{
+    const Bxdf*     bxdf = nullptr;             /**< The bxdf of the lobe. */
+    Spectrum        evalWeight;                 /**< Evaluation weight of the bxdf. */
+    float           sampleWeight = 0.0f;        /**< Sample weight of the bxdf. */
+    SE_LobeSide     side = SE_BOTH_SIDES;       /**< Side of the surface the lobe responds to. */
+};
+
 //! @brief  ScatteringEvent is a bsdf/bssrdf holder that could hold multiple of each.
 /**
  * ScatteringEvent is the new 'BSDF' class, which not only holds BRDF/BTDF, but also holds BSSRDF for sub-surface 
@@ -69,8 +89,40 @@ public:
     SORT_FORCEINLINE  void    AddBxdf( const Bxdf* bxdf ){
         if( m_bxdfCnt == SE_MAX_BXDF_COUNT || IS_PTR_INVALID(bxdf) || bxdf->GetEvalWeight().IsBlack() )
             return;
-        m_bxdfs[m_bxdfCnt++] = bxdf;
-        m_bxdfTotalSampleWeight += bxdf->GetSampleWeight();
+        auto& lobe = m_lobes[m_bxdfCnt++];
+        lobe.bxdf = bxdf;
+        lobe.evalWeight = bxdf->GetEvalWeight();
+        lobe.sampleWeight = bxdf->GetSampleWeight();
+        lobe.side = m_lobeSide;
+        if( m_lobeSide != SE_BACK_SIDE )
+            m_sideSampleWeight[0] += lobe.sampleWeight;
+        if( m_lobeSide != SE_FRONT_SIDE )
+            m_sideSampleWeight[1] += lobe.sampleWeight;
+        m_hasDeltaBxdf |= bxdf->IsDelta();
+    }
+
+    //! @brief  Set the side of the surface that bxdfs added afterward respond to.
+    //!
+    //! This is how double sided materials are flattened into the scattering event, bxdfs of each side are added
+    //! with the side set, instead of being held by separate scattering events.
+    //!
+    //! @param  side        The side of the surface.
+    SORT_FORCEINLINE void   SetLobeSide( const SE_LobeSide side ){
+        m_lobeSide = side;
+    }
+
+    //! @brief  Get the side of the surface that bxdfs added now respond to.
+    //!
+    //! @return  The side of the surface.
+    SORT_FORCEINLINE SE_LobeSide    GetLobeSide() const {
+        return m_lobeSide;
+    }
+
+    //! @brief  Whether there is any delta bxdf in the scattering event.
+    //!
+    //! @return  Whether directions can only be sampled by the bxdfs themselves.
+    SORT_FORCEINLINE bool   HasDeltaBxdf() const {
+        return m_hasDeltaBxdf;
     }
 
     //! @brief  Add a bssrdf in the scattering event, there will be at most 4 bssrdf in it.
@@ -104,6 +156,8 @@ public:
 
     //! @brief  Randomly pick between bxdf and bssrdf
     //!
+    //! Only the bxdfs responding to the side the view direction is on compete with the bssrdfs.
+    //!
     //! @param  flag        Which catagory it picks, it could be SE_EVALUATE_BXDF/SE_EVALUATE_BSSRDF.
     //! @return             The properbility of picking the bxdf/bssrdf.
     float       SampleScatteringType( SE_Flag& flag ) const;
@@ -144,9 +198,11 @@ public:
     void        Sample_BSSRDF( const Scene& scene , const Vector& wo , const Point& po , BSSRDFIntersections& inter , float& pdf ) const;
 
 private:
-    const Bxdf*         m_bxdfs[SE_MAX_BXDF_COUNT]      = { nullptr };     /**< All bsdfs in the scattering event. */
+    ScatteringLobe      m_lobes[SE_MAX_BXDF_COUNT];                        /**< All bsdfs in the scattering event. */
     unsigned            m_bxdfCnt                       = 0;               /**< Number of bxdfs in the scattering event. */
-    float               m_bxdfTotalSampleWeight         = 0.0f;            /**< Total weight of BXDF. */
+    float               m_sideSampleWeight[2]           = { 0.0f };        /**< Total weight of BXDF responding to the front and the back side. */
+    SE_LobeSide         m_lobeSide                      = SE_BOTH_SIDES;   /**< Side of the surface that bxdfs added now respond to. */
+    bool                m_hasDeltaBxdf                  = false;           /**< Whether there is any delta bxdf. */
     const Bssrdf*       m_bssrdfs[SE_MAX_BSSRDF_COUNT]  = { nullptr };     /**< All bssrdfs in the scattering event. */
     unsigned            m_bssrdfCnt                     = 0;               /**< Number of bssrdfs in the scattering event. */
     float               m_bssrdfTotalSampleWeight       = 0.0f;            /**< Total weight of BSSRDF. */
@@ -169,4 +225,4 @@ private:
     //! @param v        A vector in shading coordinate.
     //! @return         The corresponding vector in world coordinate.
     SORT_FORCEINLINE Vector localToWorld( const Vector& v ) const;
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -134,6 +134,11 @@ public:
     //! @param transform    The new transform of the shape to be set.
     virtual void    SetTransform( const Transform& transform ) { m_transform = transform; }
 
+    //! @brief      Get transform of the shape.
+    //!
+    //! @return     Transform of the shape from local space to world space.
+    const Transform& GetTransform() const { return m_transform; }
+
     //! @brief      Get the type of the shape
     //!
     //! @return     The type of the shape.
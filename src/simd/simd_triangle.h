@@ -433,19 +433,18 @@ SORT_FORCEINLINE void intersectTriangleMulti_SIMD(const Ray& ray, const Simd_Ray
             continue;
 
         if (intersections.cnt < TOTAL_SSS_INTERSECTION_CNT) {
-            intersections.intersections[intersections.cnt] = SORT_MALLOC(BSSRDFIntersection)();
-            setupIntersection(tri_simd, ray, t_simd, u_simd, v_simd, res_i, &intersections.intersections[intersections.cnt++]->intersection);
+            setupIntersection(tri_simd, ray, t_simd, u_simd, v_simd, res_i, &intersections.intersections[intersections.cnt++].intersection);
         } else {
             auto picked_i = -1;
             auto t = 0.0f;
             for (auto i = 0; i < TOTAL_SSS_INTERSECTION_CNT; ++i) {
-                if (t < intersections.intersections[i]->intersection.t) {
-                    t = intersections.intersections[i]->intersection.t;
+                if (t < intersections.intersections[i].intersection.t) {
+                    t = intersections.intersections[i].intersection.t;
                     picked_i = i;
                 }
             }
             if( picked_i >= 0 )
-                setupIntersection(tri_simd, ray, t_simd, u_simd, v_simd, res_i, &intersections.intersections[picked_i]->intersection);
+                setupIntersection(tri_simd, ray, t_simd, u_simd, v_simd, res_i, &intersections.intersections[picked_i].intersection);
 
             intersections.ResolveMaxDepth();
         }
@@ -461,20 +460,19 @@ SORT_FORCEINLINE void intersectTriangleMulti_SIMD(const Ray& ray, const Simd_Ray
         const auto intersected = primitive->GetIntersect(ray, &intersection);
         if (intersected) {
             if (intersections.cnt < TOTAL_SSS_INTERSECTION_CNT) {
-                intersections.intersections[intersections.cnt] = SORT_MALLOC(BSSRDFIntersection)();
-                intersections.intersections[intersections.cnt++]->intersection = intersection;
+                intersections.intersections[intersections.cnt++].intersection = intersection;
             }
             else {
                 auto picked_i = -1;
                 auto t = 0.0f;
                 for (auto i = 0; i < TOTAL_SSS_INTERSECTION_CNT; ++i) {
-                    if (t < intersections.intersections[i]->intersection.t) {
-                        t = intersections.intersections[i]->intersection.t;
+                    if (t < intersections.intersections[i].intersection.t) {
+                        t = intersections.intersections[i].intersection.t;
                         picked_i = i;
                     }
                 }
                 if (picked_i >= 0)
-                    intersections.intersections[picked_i]->intersection = intersection;
+                    intersections.intersections[picked_i].intersection = intersection;
 
                 intersections.ResolveMaxDepth();
             }
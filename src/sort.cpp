@@ -15,6 +15,7 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <climits>
 #include "sort.h"
 #include "core/globalconfig.h"
 #include "thirdparty/gtest/gtest.h"
@@ -39,7 +40,8 @@ void SchedulTasks( Scene& scene , IStreamBase& stream ){
 
     auto loading_task       = SCHEDULE_TASK<Loading_Task>( "Loading" , DEFAULT_TASK_PRIORITY, {} , scene, stream);
     auto sac_task           = SCHEDULE_TASK<SpatialAccelerationConstruction_Task>( "Spatial Data Structure Construction" , DEFAULT_TASK_PRIORITY, {loading_task} , scene);
-    auto savc_task          = SCHEDULE_TASK<SpatialAccelerationVolConstruction_Task>( "Spatial Data Structure (Volume) Construction" , DEFAULT_TASK_PRIORITY, {loading_task} , scene);
+    auto material_task      = SCHEDULE_TASK<BuildMaterials_Task>( "Building Materials" , DEFAULT_TASK_PRIORITY, {loading_task} );
+    auto savc_task          = SCHEDULE_TASK<SpatialAccelerationVolConstruction_Task>( "Spatial Data Structure (Volume) Construction" , DEFAULT_TASK_PRIORITY, {loading_task, material_task} , scene);
     auto pre_render_task    = SCHEDULE_TASK<PreRender_Task>( "Pre rendering pass" , DEFAULT_TASK_PRIORITY, {sac_task, savc_task} , scene);
 
     // Push render task into the queue
@@ -50,35 +52,62 @@ void SchedulTasks( Scene& scene , IStreamBase& stream ){
     // get the number of total task
     Vector2i tile_num = Vector2i( (int)ceil(width / (float)tilesize) , (int)ceil(height / (float)tilesize) );
 
-    // start tile from center instead of top-left corner
-    Vector2i cur_pos( tile_num / 2 );
-    int cur_dir = 0;
-    int cur_len = 0;
-    int cur_dir_len = 1;
+    // In progressive rendering, the whole frame is rendered in multiple passes, each with a few samples per pixel.
+    // Passes are pushed in order with decreasing priority so that a full image comes out after the first pass.
+    const auto pass_cnt = g_passCnt;
+    const auto pass_spp = g_progressiveSpp > 0 ? g_progressiveSpp : g_samplePerPixel;
     const Vector2i dir[4] = { Vector2i( 0 , -1 ) , Vector2i( -1 , 0 ) , Vector2i( 0 , 1 ) , Vector2i( 1 , 0 ) };
 
-    unsigned int priority = DEFAULT_TASK_PRIORITY;
-    while (true){
-        // only process node inside the image region
-        if (cur_pos.x >= 0 && cur_pos.x < tile_num.x && cur_pos.y >= 0 && cur_pos.y < tile_num.y ){
-            Vector2i tl( cur_pos.x * tilesize , cur_pos.y * tilesize );
-            Vector2i size( (tilesize < (width - tl.x)) ? tilesize : (width - tl.x) ,
-                           (tilesize < (height - tl.y)) ? tilesize : (height - tl.y) );
-
-            SCHEDULE_TASK<Render_Task>( "render task" , priority-- , {pre_render_task} , tl , size , scene );
-        }
-
-        // turn to the next direction
-        if (cur_len >= cur_dir_len){
-            cur_dir = (cur_dir + 1) % 4;
-            cur_len = 0;
-            cur_dir_len += 1 - cur_dir % 2;
+    // Integrators preparing data for each pass render passes one after another, each pass starts with a pre-pass task
+    // depending on all tiles of the previous pass.
+    const auto pre_pass = IS_PTR_VALID(g_integrator) && g_integrator->NeedPrePass();
+    Task::Task_Container pass_dependencies = { pre_render_task };
+
+    // Priorities decrease in the order tasks are pushed. They start from the number of tasks to be pushed so that they
+    // never wrap around no matter how many passes there are, otherwise the last passes would be picked first.
+    const auto tile_cnt = (unsigned int)( tile_num.x * tile_num.y );
+    const auto render_task_cnt = (unsigned long long)pass_cnt * ( tile_cnt + ( pre_pass ? 1u : 0u ) );
+    sAssertMsg( render_task_cnt < (unsigned long long)UINT_MAX , GENERAL , "Too many render tasks." );
+    unsigned int priority = std::max( (unsigned int)DEFAULT_TASK_PRIORITY , (unsigned int)render_task_cnt );
+    unsigned int sequence = 0;
+    for( auto pass = 0u ; pass < pass_cnt ; ++pass ){
+        const auto spp = std::min( pass_spp , g_samplePerPixel - pass * pass_spp );
+
+        if( pre_pass )
+            pass_dependencies = { SCHEDULE_TASK<PrePass_Task>( "Pre pass" , priority-- , pass_dependencies , pass , scene ) };
+        Task::Task_Container pass_tasks;
+
+        // start tile from center instead of top-left corner
+        Vector2i cur_pos( tile_num / 2 );
+        int cur_dir = 0;
+        int cur_len = 0;
+        int cur_dir_len = 1;
+
+        while (true){
+            // only process node inside the image region
+            if (cur_pos.x >= 0 && cur_pos.x < tile_num.x && cur_pos.y >= 0 && cur_pos.y < tile_num.y ){
+                Vector2i tl( cur_pos.x * tilesize , cur_pos.y * tilesize );
+                Vector2i size( (tilesize < (width - tl.x)) ? tilesize : (width - tl.x) ,
+                               (tilesize < (height - tl.y)) ? tilesize : (height - tl.y) );
+
+                pass_tasks.insert( SCHEDULE_TASK<Render_Task>( "render task" , priority-- , pass_dependencies , tl , size , sequence++ , pass * pass_spp , spp , scene ) );
+            }
+
+            // turn to the next direction
+            if (cur_len >= cur_dir_len){
+                cur_dir = (cur_dir + 1) % 4;
+                cur_len = 0;
+                cur_dir_len += 1 - cur_dir % 2;
+            }
+
+            cur_pos += dir[cur_dir];
+            ++cur_len;
+            if( (cur_pos.x < 0 || cur_pos.x >= tile_num.x ) && (cur_pos.y < 0 || cur_pos.y >= tile_num.y ) )
+                break;
         }
 
-        cur_pos += dir[cur_dir];
-        ++cur_len;
-        if( (cur_pos.x < 0 || cur_pos.x >= tile_num.x ) && (cur_pos.y < 0 || cur_pos.y >= tile_num.y ) )
-            break;
+        if( pre_pass )
+            pass_dependencies = std::move( pass_tasks );
     }
 }
 
@@ -96,6 +125,7 @@ int RunSORT( int argc , char** argv ){
         slog(INFO, GENERAL, "  --blendermode        SORT is triggered from Blender.");
         slog(INFO, GENERAL, "  --unittest           Run unit tests.");
         slog(INFO, GENERAL, "  --nomaterial         Disable materials in SORT.");
+        slog(INFO, GENERAL, "  --deterministic      Bitwise identical result across runs, regardless of thread count.");
         slog(INFO, GENERAL, "  --profiling:<on|off> Toggling profiling option, false by default.");
         return -1;
     }else{
@@ -21,6 +21,7 @@
 #include "material/matmanager.h"
 #include "core/globalconfig.h"
 #include "core/scene.h"
+#include "core/mesh.h"
 
 SORT_STATS_DEFINE_COUNTER(sPreprocessTimeMS)
 SORT_STATS_TIME("Performance", "Pre-processing Time", sPreprocessTimeMS);
@@ -35,6 +36,10 @@ void Loading_Task::Execute(){
     m_scene.LoadScene(m_stream);
 }
 
+void BuildMaterials_Task::Execute(){
+    MatManager::GetSingleton().BuildMaterials();
+}
+
 void SpatialAccelerationConstruction_Task::Execute(){
     SORT_STATS( TIMING_EVENT_STAT( "Spatial acceleration structure construction" , sPreprocessTimeMS ) );
 
@@ -47,4 +52,10 @@ void SpatialAccelerationVolConstruction_Task::Execute() {
 
 	sAssert(g_acceleratorVol, SPATIAL_ACCELERATOR );
 	g_acceleratorVol->Build(m_scene.GetPrimitivesVol(), m_scene.GetBBoxVol());
+
+	// Majorants of heterogeneous volumes need the volume shaders, which are ready once materials are built.
+	for (const auto primitive : m_scene.GetPrimitivesVol()) {
+		if (IS_PTR_VALID(primitive->GetMesh()))
+			primitive->GetMesh()->BuildMajorantGrid(primitive->GetMaterial());
+	}
 }
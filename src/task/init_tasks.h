@@ -38,6 +38,22 @@ private:
     class IStreamBase&      m_stream;
 };
 
+//! @brief  BuildMaterials_Task compiles shaders of all materials loaded.
+/**
+ * Shader templates and materials are compiled in sub tasks of this task so that they are compiled in multiple
+ * threads, tasks depending on this one won't start before all materials are built. Nothing else in the loading
+ * needs the compiled shaders, spatial data structures can be built while shaders are compiled.
+ */
+class BuildMaterials_Task : public Task{
+public:
+    //! @brief Constructor.
+    BuildMaterials_Task( const char* name , unsigned int priority , const Task::Task_Container& dependencies ) :
+        Task( name , priority , dependencies ) {}
+
+    //! @brief  Schedule compilation of shaders.
+    void        Execute() override;
+};
+
 //! @brief  Spatial acceleration data structure construction pass.
 class SpatialAccelerationConstruction_Task : public Task{
 public:
@@ -22,14 +22,20 @@
 #include "core/globalconfig.h"
 #include "core/scene.h"
 #include "core/profile.h"
-#include "sampler/random.h"
 #include "medium/medium.h"
+#include "imagesensor/aov.h"
+#include "sampler/adaptive.h"
+#include "sampler/random.h"
+
+SORT_STATS_DEFINE_COUNTER(sTotalSampleCount)
+SORT_STATS_DEFINE_COUNTER(sSavedSampleCount)
 
-Render_Task::Render_Task(const Vector2i& ori , const Vector2i& size , const Scene& scene ,
+SORT_STATS_COUNTER("Statistics", "Total Camera Sample Count", sTotalSampleCount);
+SORT_STATS_COUNTER("Statistics", "Camera Samples Saved by Adaptive Sampling", sSavedSampleCount);
+
+Render_Task::Render_Task(const Vector2i& ori , const Vector2i& size , unsigned int sequence , unsigned int first_sample , unsigned int spp , const Scene& scene ,
             const char* name , unsigned int priority , const Task::Task_Container& dependencies ) :
-            Task( name , priority , dependencies ), m_coord(ori), m_size(size), m_scene(scene){
-    m_sampler = std::make_unique<RandomSampler>();
-    m_pixelSamples = std::make_unique<PixelSample[]>(g_samplePerPixel);
+            Task( name , priority , dependencies ), m_coord(ori), m_size(size), m_sequence(sequence), m_firstSample(first_sample), m_spp(spp), m_scene(scene){
 }
 
 void Render_Task::Execute(){
@@ -38,54 +44,130 @@ void Render_Task::Execute(){
 
     auto camera = m_scene.GetCamera();
 
+    // Samples are allocated only when the task is executed, there could be lots of tasks waiting in progressive rendering.
+    auto sampler = MakeSampler( g_samplerType );
+    auto pixel_samples = std::make_unique<PixelSample[]>(m_spp);
+    auto sample_buffer = std::make_unique<float[]>(4 * m_spp);
+
+    // all random numbers drawn by the integrator, lights and bxdfs come from the sample stream of the current pixel sample
+    SampleStreamScope sample_stream( sampler.get() );
+
     // request samples
-    g_integrator->RequestSample( m_sampler.get() , m_pixelSamples.get() , g_samplePerPixel);
+    g_integrator->RequestSample( sampler.get() , pixel_samples.get() , m_spp);
 
     Vector2i rb = m_coord + m_size;
 
+    const auto& aov_registry = g_aovRegistry;
+
+    // samples are splatted locally in the tile, including an apron for pixels of neighbor tiles covered by the filter,
+    // filtered arbitrary output variables go with the radiance so that they are reconstructed the same way
+    FilmTile film_tile( g_filter , m_coord , m_size , aov_registry.GetFilteredFloatCnt() );
+
+    // other arbitrary output variables are accumulated locally in the tile before merging into the film
+    const auto has_aov = !aov_registry.IsEmpty();
+    std::unique_ptr<AOVTile> aov_tile = has_aov ? std::make_unique<AOVTile>( aov_registry , m_size.x , m_size.y ) : nullptr;
+    AOVSample aov_sample( aov_registry );
+    for( unsigned k = 0 ; k < m_spp; ++k )
+        pixel_samples[k].aov = has_aov ? &aov_sample : nullptr;
+
+    // Adaptive sampling needs all samples of a pixel in one place, it is not supported in progressive rendering.
+    const auto& adaptive = g_adaptiveSampling;
+    const auto adaptive_enabled = adaptive.enabled && 0 == g_progressiveSpp;
+
     for( int i = m_coord.y ; i < rb.y ; i++ ){
         for( int j = m_coord.x ; j < rb.x ; j++ ){
             // generate samples to be used later
-            g_integrator->GenerateSample( m_sampler.get() , m_pixelSamples.get(), g_samplePerPixel, m_scene );
-
-            // the radiance
-            Spectrum radiance;
-
-            auto valid_pixel_cnt = g_samplePerPixel;
-            for( unsigned k = 0 ; k < g_samplePerPixel; ++k ){
-                // clear managed memory after each pixel
-                SORT_CLEAR_MEMPOOL();
-
-                // generate rays
-                auto r = camera->GenerateRay( (float)j , (float)i , m_pixelSamples[k] );
-                // accumulate the radiance
-                auto li = g_integrator->Li( r , m_pixelSamples[k] , m_scene );
-                if( g_clammping > 0.0f )
-                    li = li.Clamp( 0.0f , g_clammping );
+            sampler->StartPixel( j , i , m_firstSample );
+            g_integrator->GenerateSample( sampler.get() , pixel_samples.get(), m_spp, sample_buffer.get(), m_scene );
+
+            // Without adaptive sampling, all samples are taken in a single round.
+            PixelVariance variance;
+            auto taken = 0u;
+            while( taken < m_spp ){
+                const auto round_end = !adaptive_enabled ? m_spp :
+                                       std::min( m_spp , taken + ( taken == 0 ? adaptive.min_spp : adaptive.batch_spp ) );
+                for( unsigned k = taken ; k < round_end; ++k ){
+                    // clear managed memory after each pixel
+                    SORT_CLEAR_MEMPOOL();
+
+                    if( has_aov )
+                        aov_sample.Reset();
+
+                    sampler->StartSample( k );
+
+                    pixel_samples[k].pixel_x = j;
+                    pixel_samples[k].pixel_y = i;
+
+                    // generate rays
+                    auto r = camera->GenerateRay( (float)j , (float)i , pixel_samples[k] );
+                    // accumulate the radiance
+                    auto li = g_integrator->Li( r , pixel_samples[k] , m_scene );
+                    if( g_clammping > 0.0f ){
+                        const auto clamped = li.Clamp( 0.0f , g_clammping );
+
+                        // light groups are scaled by the same ratio so that they still sum up to the beauty pass
+                        if( has_aov ){
+                            const auto ratio = []( float c , float l ){ return l > 0.0f ? c / l : 0.0f; };
+                            aov_sample.ScaleLightGroups( Spectrum( ratio( clamped.r , li.r ) , ratio( clamped.g , li.g ) , ratio( clamped.b , li.b ) ) );
+                        }
+                        li = clamped;
+                    }
                 
-                sAssert( li.IsValid() , GENERAL );
+                    sAssert( li.IsValid() , GENERAL );
                 
-                if( li.IsValid() )
-                    radiance += li;
-                else
-                    --valid_pixel_cnt;
+                    if( li.IsValid() ){
+                        film_tile.AddSample( j + pixel_samples[k].img_u , i + pixel_samples[k].img_v , li , has_aov ? aov_sample.GetFiltered() : nullptr );
+                        variance.Add( li.GetIntensity() );
+                        if( has_aov )
+                            aov_tile->Accumulate( j - m_coord.x , i - m_coord.y , aov_sample );
+                    }
+                }
+                taken = round_end;
+
+                // stop taking samples once the pixel converges
+                if( adaptive_enabled && variance.GetRelativeError() < adaptive.threshold )
+                    break;
             }
 
-            if( valid_pixel_cnt > 0 )
-                radiance /= (float)valid_pixel_cnt;
-            
-            // store the pixel
-            g_imageSensor->StorePixel( j , i , radiance , *this );
+            SORT_STATS(sTotalSampleCount += taken);
+            SORT_STATS(sSavedSampleCount += m_spp - taken);
         }
     }
 
+    // in deterministic mode, it waits until all tiles scheduled before this one are merged
+    g_imageSensor->BeginTileMerge( m_sequence );
+
+    g_imageSensor->StoreFilmTile( film_tile , *this );
+
+    if( has_aov )
+        g_imageSensor->StoreAOVTile( *aov_tile , *this );
+
+    g_imageSensor->FlushSplats();
+
     if( g_integrator->NeedRefreshTile() ){
         auto x_off = m_coord.x / g_tileSize;
         auto y_off = (g_resultResollutionHeight - 1 - m_coord.y ) / g_tileSize ;
         g_imageSensor->FinishTile( x_off, y_off, *this );
     }
+
+    g_imageSensor->EndTileMerge( m_sequence );
 }
 
 void PreRender_Task::Execute(){
+    // random numbers of pre-processing come from a fixed stream, it doesn't matter which thread picks up the task
+    RandomSampler sampler;
+    sampler.StartPixel( -1 , -1 );
+    sampler.StartSample( 0 );
+    SampleStreamScope sample_stream( &sampler );
+
     g_integrator->PreProcess(m_scene);
 }
+
+void PrePass_Task::Execute(){
+    RandomSampler sampler;
+    sampler.StartPixel( -1 , -1 , m_pass );
+    sampler.StartSample( 0 );
+    SampleStreamScope sample_stream( &sampler );
+
+    g_integrator->PrePass( m_scene , m_pass );
+}
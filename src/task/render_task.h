@@ -31,8 +31,14 @@ class Render_Task : public Task{
 public:
     //! @brief Constructor
     //!
+    //! @param ori          Top-left corner of the tile.
+    //! @param size         Size of the tile.
+    //! @param sequence     Index of the task in the order of scheduling, tiles are merged in this order in deterministic mode.
+    //! @param first_sample Index of the first sample of pixels in this task, it is not zero in later passes of progressive rendering.
+    //! @param spp          Number of samples per pixel to take in this task, it is less than the total in progressive rendering.
+    //! @param scene        Scene to be rendered.
     //! @param priority     New priority of the task.
-    Render_Task(const Vector2i& ori , const Vector2i& size , const Scene& scene ,
+    Render_Task(const Vector2i& ori , const Vector2i& size , unsigned int sequence , unsigned int first_sample , unsigned int spp , const Scene& scene ,
                 const char* name , unsigned int priority , const Task::Task_Container& dependencies );
 
     //! @brief  Execute the task
@@ -55,9 +61,10 @@ public:
 private:
     Vector2i                            m_coord;            /**< Top-left corner of the current tile. */
     Vector2i                            m_size;             /**< Size of the current tile to be rendered. */
+    unsigned int                        m_sequence;         /**< Index of the task in the order of scheduling. */
+    unsigned int                        m_firstSample;      /**< Index of the first sample of pixels in this task. */
+    unsigned int                        m_spp;              /**< Number of samples per pixel to take in this task. */
     const Scene&                        m_scene;            /**< Scene for ray tracing. */
-    std::unique_ptr<Sampler>            m_sampler;          /**< Sampler for taking samples. Currently not used. */
-    std::unique_ptr<PixelSample[]>      m_pixelSamples;     /**< Samples to take. Currently not used. */
 };
 
 //! @brief  PreRender_Task provides a chance for integrators to preprocess some data before rendering.
@@ -78,4 +85,26 @@ public:
 
 private:
     const Scene&   m_scene;
-};
\ No newline at end of file
+};
+
+//! @brief  PrePass_Task provides a chance for integrators to prepare data shared by all tiles of a pass.
+//!
+//! Vertex connection and merging, for example, traces light paths and stores their vertices at the beginning of
+//! each pass, so that all camera paths in the pass can merge with them.
+class PrePass_Task : public Task {
+public:
+    //! @brief Constructor
+    //!
+    //! @param pass         Index of the pass.
+    //! @param priority     New priority of the task.
+    PrePass_Task( unsigned int pass , const Scene& scene , const char* name , unsigned int priority ,
+                  const Task::Task_Container& dependencies ) :
+                  Task( name , priority , dependencies ), m_pass(pass), m_scene(scene){}
+
+    //! @brief  Execute the task
+    void        Execute() override;
+
+private:
+    unsigned int    m_pass;
+    const Scene&    m_scene;
+};
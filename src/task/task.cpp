@@ -15,12 +15,53 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <atomic>
+#include <climits>
+#include <future>
+#include <thread>
 #include "task.h"
 #include "core/sassert.h"
 #include "core/profile.h"
+#include "core/globalconfig.h"
 
 thread_local static const Task* g_currentTask = nullptr;
 
+namespace {
+    // number of rows taken by a thread at a time in 'ParallelForRows'
+    constexpr int PARALLEL_ROWS_PER_CHUNK = 16;
+
+    // Chunks of rows shared by all threads working on a 'ParallelForRows' job.
+    struct ParallelRows{
+        std::function<void( int , int )>    func;
+        int                                 h = 0;
+        int                                 chunk_cnt = 0;
+        std::atomic<int>                    next_chunk{ 0 };
+        std::atomic<int>                    finished_chunk{ 0 };
+
+        // keep taking chunks until all of them are taken
+        void Run(){
+            for( auto chunk = next_chunk++ ; chunk < chunk_cnt ; chunk = next_chunk++ ){
+                func( chunk * PARALLEL_ROWS_PER_CHUNK , std::min( h , ( chunk + 1 ) * PARALLEL_ROWS_PER_CHUNK ) );
+                ++finished_chunk;
+            }
+        }
+    };
+
+    // A task helping with a 'ParallelForRows' job, it does nothing if all chunks are taken by the time it starts.
+    class ParallelRows_Task : public Task{
+    public:
+        ParallelRows_Task( const std::shared_ptr<ParallelRows>& job , const char* name , unsigned int priority , const Task::Task_Container& dependencies ) :
+            Task( name , priority , dependencies ) , m_job(job) {}
+
+        void Execute() override {
+            m_job->Run();
+        }
+
+    private:
+        std::shared_ptr<ParallelRows>   m_job;
+    };
+}
+
 class UpdateCurrentTaskWrapper{
 public:
     //! Update current task
@@ -63,8 +104,12 @@ Task* Scheduler::Schedule( std::unique_ptr<Task> task ){
     m_tasks[taskID] = std::move(task);
 
     const auto task_ptr = m_tasks[taskID].get();
-    if(task_ptr->NoDependency() )
+    if(task_ptr->NoDependency() ){
         m_availbleTasks.push(task_ptr);
+
+        // Notify one waiting thread to pick up task.
+        m_cv.notify_one();
+    }
     else{
         auto dependencies = task_ptr->GetDependencies();
         for (auto dep : dependencies) {
@@ -76,6 +121,41 @@ Task* Scheduler::Schedule( std::unique_ptr<Task> task ){
     return task_ptr;
 }
 
+Task* Scheduler::ScheduleSubTask( std::unique_ptr<Task> task ){
+    if(IS_PTR_INVALID(task))
+        return nullptr;
+
+    const auto parent = const_cast<Task*>(g_currentTask);
+    sAssertMsg(IS_PTR_VALID(parent), GENERAL, "Sub tasks can only be scheduled inside a task.");
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto taskID = task->GetTaskID();
+    m_tasks[taskID] = std::move(task);
+
+    const auto task_ptr = m_tasks[taskID].get();
+
+    // The parent task is still running, none of its dependents could have started. They need to wait for the sub task too,
+    // except the other sub tasks of the parent.
+    for (auto dependent : parent->GetDependents()) {
+        if (dependent->GetParent() == parent)
+            continue;
+        dependent->GetDependencies().insert(task_ptr);
+        task_ptr->AddDependent(dependent);
+    }
+
+    // The sub task starts after its parent, this also keeps its dependencies alive since they are sub tasks of the same parent.
+    task_ptr->SetParent(parent);
+    task_ptr->GetDependencies().insert(parent);
+    for (auto dep : task_ptr->GetDependencies()) {
+        auto no_const_dep = const_cast<Task*>(dep);
+        no_const_dep->AddDependent(task_ptr);
+    }
+    m_backupTasks.insert(task_ptr);
+
+    return task_ptr;
+}
+
 Task* Scheduler::PickTask(){
     std::unique_lock<std::mutex> lock(m_mutex);
 
@@ -102,6 +182,10 @@ void Scheduler::TaskFinished( const Task* task ){
         // Remove its dependencies.
         dep->RemoveDependency( task );
 
+        // The parent is about to be destroyed.
+        if( dep->GetParent() == task )
+            dep->SetParent( nullptr );
+
         // There is no dependent task of this 'dep' task anymore, push it into the heap and remove it from the backup tasks.
         if( dep->NoDependency() ){
             m_backupTasks.erase( dep );
@@ -131,4 +215,36 @@ void    EXECUTING_TASKS(){
 
 const Task* GetCurrentTask(){
     return g_currentTask;
-}
\ No newline at end of file
+}
+
+void ParallelForRows( int h , const std::function<void( int , int )>& func ){
+    const auto job = std::make_shared<ParallelRows>();
+    job->func = func;
+    job->h = h;
+    job->chunk_cnt = ( h + PARALLEL_ROWS_PER_CHUNK - 1 ) / PARALLEL_ROWS_PER_CHUNK;
+
+    const auto helper_cnt = std::min( job->chunk_cnt , (int)std::max( 1u , g_threadCnt ) ) - 1;
+    if( helper_cnt <= 0 ){
+        func( 0 , h );
+        return;
+    }
+
+    if( GetCurrentTask() ){
+        // Helpers have the highest priority so that idle workers pick them first, the ones starting late simply find nothing left.
+        for( auto i = 0 ; i < helper_cnt ; ++i )
+            SCHEDULE_TASK<ParallelRows_Task>( "Parallel rows" , UINT_MAX , {} , job );
+        job->Run();
+
+        // the last chunks could still be in progress on other threads
+        while( job->finished_chunk < job->chunk_cnt )
+            std::this_thread::yield();
+        return;
+    }
+
+    std::vector<std::future<void>> helpers;
+    for( auto i = 0 ; i < helper_cnt ; ++i )
+        helpers.push_back( std::async( std::launch::async , [&](){ job->Run(); } ) );
+    job->Run();
+    for( auto& helper : helpers )
+        helper.wait();
+}
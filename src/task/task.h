@@ -122,12 +122,27 @@ public:
         return m_dependencies;
     }
 
+    //! @brief  Get the task that spawned this task.
+    //!
+    //! @return The parent task, nullptr if this is not a sub task.
+    SORT_FORCEINLINE const Task* GetParent() const {
+        return m_parent;
+    }
+
+    //! @brief  Set the task that spawned this task.
+    //!
+    //! @param  parent      The parent task.
+    SORT_FORCEINLINE void SetParent( const Task* parent ){
+        m_parent = parent;
+    }
+
 private:
     Task_Container              m_dependencies;     /**< Tasks this task depends on. */
     DependentTask_Container     m_dependents;       /**< Tasks depending on this task. */
     unsigned int                m_priority;         /**< Priority of the task. */
     const std::string           m_name;             /**< Name of the task. */
     TaskID                      m_taskId;           /**< This is to identify the task with id. */
+    const Task*                 m_parent = nullptr; /**< The task that spawned this task as a sub task. */
 };
 
 //! @brief  Scheduler for scheduling tasks.
@@ -157,6 +172,18 @@ public:
     //! @param              Raw pointer to the task.
     Task*    Schedule( std::unique_ptr<Task> task );
 
+    //! @brief  Schedule a sub task of the task being executed on the current thread.
+    //!
+    //! A sub task starts only after the current task is finished, tasks depending on the current task won't
+    //! start before the sub task is finished either. This allows a task to spawn more tasks that the rest of
+    //! the graph waits for. Since none of the sub tasks of a task starts before it is finished, they can
+    //! safely depend on each other.
+    //! This can only be called inside a task.
+    //!
+    //! @param  task        Task to be scheduled.
+    //! @param              Raw pointer to the task.
+    Task*    ScheduleSubTask( std::unique_ptr<Task> task );
+
     //! @brief  Pick a task with highest priority, but no dependencies.
     //!
     //! The scheduler will try picking a task with highest priority, but no dependencies.
@@ -197,8 +224,25 @@ SORT_FORCEINLINE Task*  SCHEDULE_TASK( const char* name , unsigned int priority
     return Scheduler::GetSingleton().Schedule( std::move(ret) );
 }
 
+//! @brief      Schedule a sub task of the current ongoing task in task scheduler.
+template<class T, typename... Args>
+SORT_FORCEINLINE Task*  SCHEDULE_SUB_TASK( const char* name , unsigned int priority , const Task::Task_Container& dependencies , Args&&... args ){
+    auto ret = std::make_unique<T>(args..., name, priority, dependencies);
+    return Scheduler::GetSingleton().ScheduleSubTask( std::move(ret) );
+}
+
 //! @brief      Executing tasks. It will exit if there is no other tasks.
 void        EXECUTING_TASKS();
 
 //! @brief      Get the current ongoing task.
-const Task* GetCurrentTask();
\ No newline at end of file
+const Task* GetCurrentTask();
+
+//! @brief      Run a job on rows, like rows of an image, across multiple threads.
+//!
+//! Rows are split in chunks. Inside a task, the calling thread keeps taking chunks while idle worker threads of
+//! the scheduler join through helper tasks, it returns once all chunks are done. Outside of any task, where there
+//! is no scheduler running, the job is spread over no more threads than the configured thread count.
+//!
+//! @param  h           Number of rows in total.
+//! @param  func        Job to be executed, taking the first and the one past the last row to be processed.
+void        ParallelForRows( int h , const std::function<void( int , int )>& func );
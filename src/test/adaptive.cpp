@@ -0,0 +1,58 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "thirdparty/gtest/gtest.h"
+#include "sampler/adaptive.h"
+#include "core/rand.h"
+
+TEST(AdaptiveSampling, PixelVariance) {
+    PixelVariance variance;
+    EXPECT_EQ( variance.GetRelativeError() , FLT_MAX );
+
+    // Constant samples converge right away.
+    for( auto i = 0 ; i < 4 ; ++i )
+        variance.Add( 0.5f );
+    EXPECT_FLOAT_EQ( variance.GetMean() , 0.5f );
+    EXPECT_EQ( variance.GetRelativeError() , 0.0f );
+
+    // Samples of 0 and 1, variance is 1/4, the standard error of the mean is 1/(2*sqrt(n)).
+    PixelVariance coin;
+    for( auto i = 0 ; i < 1024 ; ++i )
+        coin.Add( (float)( i % 2 ) );
+    const auto expected = sqrt( 1024.0f / 1023.0f * 0.25f / 1024.0f ) / 0.5f;
+    EXPECT_NEAR( coin.GetRelativeError() , expected , 1e-4f );
+
+    // Black samples say nothing about the pixel, it keeps sampling until something is found.
+    PixelVariance black;
+    for( auto i = 0 ; i < 64 ; ++i )
+        black.Add( 0.0f );
+    EXPECT_EQ( black.GetRelativeError() , FLT_MAX );
+    black.Add( 1.0f );
+    EXPECT_LT( black.GetRelativeError() , FLT_MAX );
+}
+
+TEST(AdaptiveSampling, ErrorDecreasesWithSamples) {
+    PixelVariance variance;
+    auto last_error = FLT_MAX;
+    for( auto round = 0 ; round < 8 ; ++round ){
+        for( auto i = 0 ; i < 256 ; ++i )
+            variance.Add( sort_canonical() );
+        EXPECT_LT( variance.GetRelativeError() , last_error );
+        last_error = variance.GetRelativeError();
+    }
+    EXPECT_LT( last_error , 0.02f );
+}
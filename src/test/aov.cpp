@@ -0,0 +1,108 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "thirdparty/gtest/gtest.h"
+#include "imagesensor/aov.h"
+
+TEST(AOV, Registry) {
+    AOVConfig config;
+    config.depth = true;
+    config.albedo = true;
+    config.light_group_cnt = 2;
+
+    AOVRegistry registry;
+    EXPECT_TRUE( registry.IsEmpty() );
+
+    // Channels are packed in the order of their types, disabled channels take no space.
+    registry.Setup( config );
+    EXPECT_EQ( registry.GetChannels().size() , 4u );
+    EXPECT_EQ( registry.GetFloatCnt() , 1u + 3u + 3u * 2u );
+    EXPECT_EQ( registry.GetOffset( AOV_DEPTH ) , 0 );
+    EXPECT_EQ( registry.GetOffset( AOV_ALBEDO ) , 1 );
+    EXPECT_EQ( registry.GetOffset( AOV_LIGHT_GROUP + 1 ) , 7 );
+    EXPECT_EQ( registry.GetPixelFloatCnt() , 1u + 3u );
+    EXPECT_EQ( registry.GetFilteredFloatCnt() , 3u * 2u );
+    EXPECT_FALSE( registry.IsEnabled( AOV_NORMAL ) );
+    EXPECT_FALSE( registry.IsEnabled( AOV_LIGHT_GROUP + 2 ) );
+}
+
+TEST(AOV, TileAccumulation) {
+    AOVConfig config;
+    config.depth = true;
+    config.sample_count = true;
+    config.light_group_cnt = 1;
+
+    AOVRegistry registry;
+    registry.Setup( config );
+
+    AOVTile tile( registry , 2 , 2 );
+    AOVSample sample( registry );
+
+    sample.Set( AOV_DEPTH , 3.0f );
+    sample.AddLightGroup( 0 , Spectrum( 1.0f ) );
+    sample.AddLightGroup( 1 , Spectrum( 8.0f ) );     // not enabled, ignored
+    tile.Accumulate( 1 , 0 , sample );
+
+    sample.Reset();
+    sample.Set( AOV_DEPTH , 2.0f );
+    sample.AddLightGroup( 0 , Spectrum( 0.5f ) );
+    tile.Accumulate( 1 , 0 , sample );
+
+    // A sample with nothing recorded leaves depth untouched.
+    sample.Reset();
+    tile.Accumulate( 1 , 0 , sample );
+
+    const auto depth = registry.GetOffset( AOV_DEPTH );
+    const auto count = registry.GetOffset( AOV_SAMPLE_COUNT );
+    const auto group = registry.GetOffset( AOV_LIGHT_GROUP );
+    EXPECT_EQ( tile.GetPlane( depth )[1] , 2.0f );
+    EXPECT_EQ( tile.GetPlane( depth )[0] , FLT_MAX );
+    EXPECT_EQ( tile.GetPlane( count )[1] , 3.0f );
+    EXPECT_EQ( tile.GetCountPlane()[1] , 3.0f );
+    EXPECT_EQ( tile.GetCountPlane()[0] , 0.0f );
+
+    // Light groups are not in the tile, they are splatted through the reconstruction filter with the beauty pass.
+    sample.Reset();
+    sample.AddLightGroup( 0 , Spectrum( 0.5f ) );
+    EXPECT_EQ( group , (int)registry.GetPixelFloatCnt() );
+    EXPECT_EQ( sample.GetFiltered()[0] , 0.5f );
+}
+
+TEST(AOV, ScaleLightGroups) {
+    AOVConfig config;
+    config.depth = true;
+    config.light_group_cnt = 2;
+
+    AOVRegistry registry;
+    registry.Setup( config );
+
+    AOVSample sample( registry );
+    sample.Set( AOV_DEPTH , 3.0f );
+    sample.AddLightGroup( 0 , Spectrum( 4.0f ) );
+    sample.AddLightGroup( 1 , Spectrum( 2.0f ) );
+
+    // Only light groups are scaled, each channel by its own ratio.
+    sample.ScaleLightGroups( Spectrum( 0.5f , 0.25f , 0.0f ) );
+
+    const auto group0 = registry.GetOffset( AOV_LIGHT_GROUP );
+    const auto group1 = registry.GetOffset( AOV_LIGHT_GROUP + 1 );
+    EXPECT_EQ( sample.Get( registry.GetOffset( AOV_DEPTH ) ) , 3.0f );
+    EXPECT_EQ( sample.Get( group0 ) , 2.0f );
+    EXPECT_EQ( sample.Get( group0 + 1 ) , 1.0f );
+    EXPECT_EQ( sample.Get( group0 + 2 ) , 0.0f );
+    EXPECT_EQ( sample.Get( group1 ) , 1.0f );
+}
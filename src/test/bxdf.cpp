@@ -32,6 +32,7 @@
 #include "scatteringevent/bsdf/dielectric.h"
 #include "scatteringevent/bsdf/hair.h"
 #include "scatteringevent/bsdf/fabric.h"
+#include "scatteringevent/scatteringevent.h"
 
 // A physically based BRDF should obey the rule of reciprocity
 void checkReciprocity(const Bxdf* bxdf) {
@@ -290,3 +291,80 @@ TEST(BXDF, DISABLED_HairSamplingConsistance) {
         }
     }
 }
+
+// Lobes of a double sided material only scatter light on their own side, the pdf of sampling should match the evaluated one.
+TEST(BXDF, DoubleSidedLobes) {
+    SurfaceInteraction inter;
+    inter.normal = DIR_UP;
+    inter.tangent = Vector( 1.0f , 0.0f , 0.0f );
+
+    const Lambert front( Spectrum( 1.0f , 0.0f , 0.0f ) , FULL_WEIGHT , DIR_UP );
+    const Lambert back( Spectrum( 0.0f , 0.0f , 1.0f ) , FULL_WEIGHT , DIR_UP );
+
+    // sub-event skips the transformation, all directions are in shading coordinate
+    ScatteringEvent se( inter , SE_Flag( SE_EVALUATE_ALL | SE_SUB_EVENT ) );
+    se.SetLobeSide( SE_FRONT_SIDE );
+    se.AddBxdf( &front );
+    se.SetLobeSide( SE_BACK_SIDE );
+    se.AddBxdf( &back );
+    se.SetLobeSide( SE_BOTH_SIDES );
+
+    for( auto i = 0 ; i < 1024 ; ++i ){
+        const auto wo = UniformSampleSphere( sort_canonical() , sort_canonical() );
+        const auto wi = UniformSampleSphere( sort_canonical() , sort_canonical() );
+        const auto f = se.Evaluate_BSDF( wo , wi );
+        if( ( wo.y < 0.0f ) != ( wi.y < 0.0f ) )
+            EXPECT_TRUE( f.IsBlack() );
+        else if( wo.y < 0.0f )
+            EXPECT_NEAR( f.b , back.F( -wo , -wi ).b , 0.0001f );
+        else
+            EXPECT_NEAR( f.r , front.F( wo , wi ).r , 0.0001f );
+
+        Vector swi;
+        float pdf = 0.0f;
+        const auto sf = se.Sample_BSDF( wo , swi , BsdfSample(true) , pdf );
+        if( pdf > 0.0f ){
+            EXPECT_EQ( wo.y < 0.0f , swi.y < 0.0f );
+            EXPECT_NEAR( pdf , se.Pdf_BSDF( wo , swi ) , 0.001f * pdf );
+            EXPECT_NEAR( sf.GetIntensity() , se.Evaluate_BSDF( wo , swi ).GetIntensity() , 0.0001f );
+        }
+    }
+}
+
+// A bssrdf that never scatters, only its sample weight matters when picking the scattering type.
+class DummyBssrdf : public Bssrdf{
+public:
+    DummyBssrdf() : Bssrdf( FULL_WEIGHT , 1.0f ){}
+    Spectrum S( const Vector& wo , const Point& po , const Vector& wi , const Point& pi ) const override { return 0.0f; }
+    void Sample_S( const Scene& scene , const Vector& wo , const Point& po , BSSRDFIntersections& inter ) const override {}
+};
+
+// Only the lobes on the side of 'wo' compete with bssrdf, a double sided pair shouldn't double the chance of picking bxdf.
+TEST(BXDF, DoubleSidedScatteringType) {
+    SurfaceInteraction inter;
+    inter.normal = DIR_UP;
+    inter.tangent = Vector( 1.0f , 0.0f , 0.0f );
+
+    const Lambert front( Spectrum( 1.0f , 0.0f , 0.0f ) , FULL_WEIGHT , DIR_UP );
+    const Lambert back( Spectrum( 0.0f , 0.0f , 1.0f ) , FULL_WEIGHT , DIR_UP );
+    const DummyBssrdf bssrdf;
+
+    for( const auto wo : { DIR_UP , -DIR_UP } ){
+        inter.view = wo;
+        ScatteringEvent se( inter , SE_Flag( SE_EVALUATE_ALL | SE_SUB_EVENT ) );
+        se.SetLobeSide( SE_FRONT_SIDE );
+        se.AddBxdf( &front );
+        se.SetLobeSide( SE_BACK_SIDE );
+        se.AddBxdf( &back );
+        se.SetLobeSide( SE_BOTH_SIDES );
+        se.AddBssrdf( &bssrdf );
+
+        const auto bxdf_weight = wo.y > 0.0f ? front.GetSampleWeight() : back.GetSampleWeight();
+        const auto pdf_bxdf = bxdf_weight / ( bxdf_weight + bssrdf.GetSampleWeight() );
+        for( auto i = 0 ; i < 64 ; ++i ){
+            SE_Flag flag;
+            const auto pdf = se.SampleScatteringType( flag );
+            EXPECT_NEAR( pdf , ( flag & SE_EVALUATE_BXDF ) ? pdf_bxdf : 1.0f - pdf_bxdf , 0.0001f );
+        }
+    }
+}
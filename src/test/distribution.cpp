@@ -74,3 +74,83 @@ TEST(DISTRIBUTION, ClearcoatGGX) {
     checkAll(&cggx);
 }
 #endif
+
+// Buckets are picked with probabilities proportional to their weights.
+TEST(DISTRIBUTION, AliasTable) {
+    const float weights[] = { 1.0f , 0.0f , 3.0f , 6.0f , 2.5f , 0.5f };
+    const AliasTable table( weights , 6 );
+
+    constexpr auto N = 200000u;
+    unsigned cnt[6] = { 0 };
+    for( auto i = 0u ; i < N ; ++i ){
+        auto pmf = 0.0f;
+        const auto id = table.Sample( sort_hash_canonical( 0x5eedu , i ) , &pmf );
+        ASSERT_GE( id , 0 );
+        EXPECT_FLOAT_EQ( pmf , weights[id] / 13.0f );
+        ++cnt[id];
+    }
+    EXPECT_EQ( cnt[1] , 0u );
+    for( auto i = 0u ; i < 6 ; ++i )
+        EXPECT_NEAR( (float)cnt[i] / N , weights[i] / 13.0f , 0.005f );
+}
+
+// Directions sampled in a spherical triangle all point to the triangle, the solid angle matches an estimation by area sampling.
+TEST(DISTRIBUTION, SphericalTriangle) {
+    const Point p( 0.3f , -0.2f , 0.1f );
+    const Point v0( 1.0f , 2.0f , 0.0f ) , v1( -1.5f , 2.5f , 0.5f ) , v2( 0.5f , 1.5f , 2.0f );
+    const auto sa = SphericalTriangleArea( normalize( v0 - p ) , normalize( v1 - p ) , normalize( v2 - p ) );
+    const auto n = normalize( cross( v1 - v0 , v2 - v0 ) );
+    const auto area = 0.5f * cross( v1 - v0 , v2 - v0 ).Length();
+
+    constexpr auto N = 100000u;
+    auto estimation = 0.0;
+    for( auto i = 0u ; i < N ; ++i ){
+        const auto u = sort_hash_canonical( 1u , i ) , v = sort_hash_canonical( 2u , i );
+
+        auto pdf = 0.0f;
+        const auto wi = UniformSampleSphericalTriangle( normalize( v0 - p ) , normalize( v1 - p ) , normalize( v2 - p ) , u , v , &pdf );
+        EXPECT_NEAR( pdf , 1.0f / sa , 1e-3f / sa );
+
+        // the direction hits the triangle
+        const auto ps = p + wi * ( dot( v0 - p , n ) / dot( wi , n ) );
+        const auto b0 = dot( cross( v1 - ps , v2 - ps ) , n ) / ( 2.0f * area );
+        const auto b1 = dot( cross( v2 - ps , v0 - ps ) , n ) / ( 2.0f * area );
+        EXPECT_GE( b0 , -1e-3f );
+        EXPECT_GE( b1 , -1e-3f );
+        EXPECT_GE( 1.0f - b0 - b1 , -1e-3f );
+
+        // solid angle estimated by area sampling
+        float c0 , c1;
+        UniformSampleTriangle( u , v , c0 , c1 );
+        const auto pa = v0 * c0 + v1 * c1 + v2 * ( 1.0f - c0 - c1 );
+        const auto delta = pa - p;
+        estimation += fabs( dot( normalize( delta ) , n ) ) * area / delta.SquaredLength();
+    }
+    EXPECT_NEAR( estimation / N , sa , 0.01f * sa );
+}
+
+// Points sampled from a 2D distribution have the pdf evaluated at them, cells are picked proportional to their weights.
+TEST(DISTRIBUTION, Distribution2D) {
+    constexpr auto nu = 8u , nv = 4u;
+    float data[nu * nv];
+    auto sum = 0.0f;
+    for( auto i = 0u ; i < nu * nv ; ++i ){
+        data[i] = ( i % 5 == 0 ) ? 0.0f : (float)( i % 7 ) + 0.5f;
+        sum += data[i];
+    }
+    const Distribution2D dist( data , nu , nv );
+
+    constexpr auto N = 200000u;
+    unsigned cnt[nu * nv] = { 0 };
+    for( auto i = 0u ; i < N ; ++i ){
+        float uv[2] , pdf = 0.0f;
+        dist.SampleContinuous( sort_hash_canonical( 3u , i ) , sort_hash_canonical( 4u , i ) , uv , &pdf );
+        ASSERT_GT( pdf , 0.0f );
+        EXPECT_NEAR( pdf , dist.Pdf( uv[0] , uv[1] ) , 1e-3f * pdf );
+        ++cnt[ (unsigned)( uv[1] * nv ) * nu + (unsigned)( uv[0] * nu ) ];
+    }
+    for( auto i = 0u ; i < nu * nv ; ++i ){
+        EXPECT_NEAR( (float)cnt[i] / N , data[i] / sum , 0.005f );
+        EXPECT_NEAR( dist.Pdf( ( ( i % nu ) + 0.5f ) / nu , ( ( i / nu ) + 0.5f ) / nv ) , data[i] / sum * nu * nv , 1e-4f );
+    }
+}
@@ -0,0 +1,82 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "thirdparty/gtest/gtest.h"
+#include "imagesensor/filter.h"
+
+TEST(Filter, BoxFilterStaysInPixel) {
+    Filter filter;
+    EXPECT_EQ( filter.GetApron() , 0 );
+
+    FilmTile tile( filter , Vector2i( 4 , 4 ) , Vector2i( 2 , 2 ) );
+    tile.AddSample( 4.0f , 4.0f , Spectrum( 1.0f ) );
+    tile.AddSample( 4.99f , 4.5f , Spectrum( 3.0f ) );
+
+    // Both samples land in the first pixel, it is the same with averaging samples in the pixel.
+    const auto w = tile.GetPlane(3);
+    EXPECT_EQ( w[0] , 2.0f );
+    EXPECT_EQ( w[1] + w[2] + w[3] , 0.0f );
+    EXPECT_EQ( tile.GetPlane(0)[0] / w[0] , 2.0f );
+}
+
+TEST(Filter, SplatAcrossTileBorder) {
+    const FilterType types[] = { FilterType::GAUSSIAN , FilterType::MITCHELL , FilterType::BLACKMAN_HARRIS };
+    for( const auto type : types ){
+        Filter filter;
+        filter.Setup( type , 2.0f );
+        EXPECT_EQ( filter.GetApron() , 2 );
+
+        // Filters are symmetric and peak at the center.
+        EXPECT_EQ( filter.Evaluate( 0.3f , -0.7f ) , filter.Evaluate( -0.3f , 0.7f ) );
+        EXPECT_GT( filter.Evaluate( 0.0f , 0.0f ) , filter.Evaluate( 1.0f , 0.0f ) );
+        EXPECT_EQ( filter.Evaluate( 2.1f , 0.0f ) , 0.0f );
+
+        // A sample at the corner of the tile reaches pixels in the apron.
+        FilmTile tile( filter , Vector2i( 0 , 0 ) , Vector2i( 4 , 4 ) );
+        EXPECT_EQ( tile.GetOrigin().x , -2 );
+        EXPECT_EQ( tile.GetExtent().x , 8 );
+        tile.AddSample( 0.5f , 0.5f , Spectrum( 1.0f ) );
+
+        const auto w = tile.GetPlane(3);
+        const auto stride = tile.GetExtent().x;
+        const auto center = 2 * stride + 2;
+        EXPECT_GT( w[center] , 0.0f );
+        EXPECT_NE( w[center - 1] , 0.0f );
+        EXPECT_EQ( w[center - 1] , w[center + 1] );
+        EXPECT_EQ( w[center - stride] , w[center + stride] );
+    }
+}
+
+TEST(Filter, ExtraValuesShareWeights) {
+    Filter filter;
+    filter.Setup( FilterType::MITCHELL , 1.5f );
+
+    FilmTile tile( filter , Vector2i( 0 , 0 ) , Vector2i( 4 , 4 ) , 2 );
+    EXPECT_EQ( tile.GetPlaneCnt() , 6 );
+
+    // Extra values are reconstructed with the same weights as radiance.
+    const float extra0[] = { 0.5f , 2.0f };
+    const float extra1[] = { 1.0f , 4.0f };
+    tile.AddSample( 1.3f , 2.6f , Spectrum( 1.0f ) , extra0 );
+    tile.AddSample( 2.2f , 1.7f , Spectrum( 2.0f ) , extra1 );
+
+    const auto plane_size = tile.GetExtent().x * tile.GetExtent().y;
+    for( auto k = 0 ; k < plane_size ; ++k ){
+        EXPECT_NEAR( tile.GetPlane(4)[k] , 0.5f * tile.GetPlane(0)[k] , 0.0001f );
+        EXPECT_NEAR( tile.GetPlane(5)[k] , 2.0f * tile.GetPlane(0)[k] , 0.0001f );
+    }
+}
@@ -0,0 +1,49 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#include <algorithm>
+#include "thirdparty/gtest/gtest.h"
+#include "integrator/hashgrid.h"
+#include "core/rand.h"
+
+// Queries find exactly the points within the radius, each of them only once.
+TEST(HashGrid, QueryMatchesBruteForce) {
+    constexpr auto N = 20000u;
+    constexpr auto radius = 0.05f;
+
+    std::vector<Point> points( N );
+    for( auto i = 0u ; i < N ; ++i )
+        points[i] = Point( sort_hash_canonical( 3u , 3 * i ) * 2.0f - 1.0f , sort_hash_canonical( 3u , 3 * i + 1 ) * 2.0f - 1.0f , sort_hash_canonical( 3u , 3 * i + 2 ) );
+
+    HashGrid grid;
+    grid.Build( points , radius );
+    EXPECT_EQ( grid.GetPointCount() , N );
+
+    for( auto k = 0u ; k < 200 ; ++k ){
+        const auto p = Point( sort_hash_canonical( 5u , 3 * k ) * 2.0f - 1.0f , sort_hash_canonical( 5u , 3 * k + 1 ) * 2.0f - 1.0f , sort_hash_canonical( 5u , 3 * k + 2 ) );
+
+        std::vector<unsigned> found;
+        grid.Query( p , [&]( unsigned index ){ found.push_back( index ); } );
+        std::sort( found.begin() , found.end() );
+
+        std::vector<unsigned> expected;
+        for( auto i = 0u ; i < N ; ++i ){
+            if( ( points[i] - p ).SquaredLength() <= radius * radius )
+                expected.push_back( i );
+        }
+        EXPECT_EQ( found , expected );
+    }
+}
@@ -0,0 +1,112 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "thirdparty/gtest/gtest.h"
+#include "light/lightbvh.h"
+#include "core/rand.h"
+
+namespace {
+    // A grid of point lights and quad lights facing up.
+    std::vector<LightBounds> makeLights(){
+        std::vector<LightBounds> lights;
+        for( auto i = 0 ; i < 64 ; ++i ){
+            const auto p = Point( (float)( i % 8 ) * 2.0f , (float)( i / 8 % 2 ) , (float)( i / 8 ) * 2.0f );
+            LightBounds lb;
+            lb.bounds = BBox( p , p );
+            lb.phi = 1.0f + (float)( i % 3 );
+            if( i % 2 ){
+                lb.bounds = BBox( p - Vector( 0.5f , 0.0f , 0.5f ) , p + Vector( 0.5f , 0.0f , 0.5f ) );
+                lb.cosTheta_o = 1.0f;
+                lb.cosTheta_e = 0.0f;
+            }else{
+                lb.cosTheta_o = -1.0f;
+                lb.cosTheta_e = 0.0f;
+            }
+            lights.push_back( lb );
+        }
+        return lights;
+    }
+}
+
+// The probabilities of picking all lights sum up to one.
+TEST(LightBVH, PmfNormalization) {
+    LightBVH bvh;
+    bvh.Build( makeLights() );
+    ASSERT_FALSE( bvh.IsEmpty() );
+
+    const Point points[] = { Point( 3.0f , 4.0f , 5.0f ) , Point( -10.0f , 0.5f , 2.0f ) , Point( 7.0f , 0.5f , 7.0f ) };
+    for( const auto& p : points ){
+        auto total = 0.0f;
+        for( auto i = 0u ; i < 64 ; ++i )
+            total += bvh.Pmf( p , Vector( 0.0f , 1.0f , 0.0f ) , i );
+        EXPECT_NEAR( total , 1.0f , 1e-4f );
+    }
+}
+
+// The frequency of picking each light matches its probability.
+TEST(LightBVH, SampleMatchesPmf) {
+    LightBVH bvh;
+    bvh.Build( makeLights() );
+
+    const auto p = Point( 3.0f , 3.0f , 5.0f );
+    const auto n = Vector( 0.0f );
+    constexpr auto N = 200000u;
+    std::vector<unsigned> cnt( 64 , 0 );
+    for( auto k = 0u ; k < N ; ++k ){
+        float pmf = 0.0f;
+        const auto id = bvh.Sample( p , n , sort_hash_canonical( 0x1234u , k ) , &pmf );
+        ASSERT_GE( id , 0 );
+        EXPECT_NEAR( pmf , bvh.Pmf( p , n , id ) , 1e-5f );
+        ++cnt[id];
+    }
+    for( auto i = 0u ; i < 64 ; ++i )
+        EXPECT_NEAR( (float)cnt[i] / N , bvh.Pmf( p , n , i ) , 0.005f );
+}
+
+// Nearby lights are picked more often than distant ones with the same power.
+TEST(LightBVH, ImportanceFavorsNearbyLights) {
+    LightBVH bvh;
+    bvh.Build( makeLights() );
+
+    const auto p = Point( 0.0f , 2.0f , 0.0f );
+    const auto n = Vector( 0.0f , -1.0f , 0.0f );
+    // light 0 sits right below the shading point, light 63 sits at the far corner, light 6 has the same power as light 0.
+    EXPECT_GT( bvh.Pmf( p , n , 0 ) , bvh.Pmf( p , n , 63 ) );
+    EXPECT_GT( bvh.Pmf( p , n , 0 ) , bvh.Pmf( p , n , 6 ) );
+}
+
+// Lights spread out exponentially are split one at a time, the tree still fits in the bit trail.
+TEST(LightBVH, DeepTreePmfNormalization) {
+    std::vector<LightBounds> lights;
+    for( auto i = 0 ; i < 100 ; ++i ){
+        const auto p = Point( std::pow( 1.5f , (float)i ) , 0.0f , 0.0f );
+        LightBounds lb;
+        lb.bounds = BBox( p , p );
+        lb.phi = 1.0f;
+        lb.cosTheta_o = -1.0f;
+        lb.cosTheta_e = 0.0f;
+        lights.push_back( lb );
+    }
+
+    LightBVH bvh;
+    bvh.Build( lights );
+
+    auto total = 0.0f;
+    for( auto i = 0u ; i < 100 ; ++i )
+        total += bvh.Pmf( Point( 0.0f , 1.0f , 0.0f ) , Vector( 0.0f ) , i );
+    EXPECT_NEAR( total , 1.0f , 1e-4f );
+}
@@ -0,0 +1,155 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+*/
+
+
+#include <cmath>
+#include <vector>
+#include "thirdparty/gtest/gtest.h"
+#include "medium/majorantgrid.h"
+#include "medium/mediumdata.h"
+#include "medium/heterogeneous.h"
+#include "core/rand.h"
+
+namespace {
+    constexpr unsigned N = 24;
+
+    // Random densities in [0,2] on one half of the volume, the other half is empty.
+    void makeDensity(MediumDensity& density) {
+        std::vector<float> data(N * N * N, 0.0f);
+        for (auto z = 0u; z < N; ++z)
+            for (auto y = 0u; y < N; ++y)
+                for (auto x = N / 2; x < N; ++x)
+                    data[(z * N + y) * N + x] = 2.0f * sort_hash_canonical(3u, (z * N + y) * N + x);
+        density.Build(N, N, N, data.data(), false);
+    }
+
+    // Extinction that is not monotonic in density, it peaks in the middle of the range.
+    float extinction(float density) {
+        return 3.0f * density * (2.0f - density);
+    }
+
+    float minComponent(const Spectrum& s) {
+        return std::min(s[0], std::min(s[1], s[2]));
+    }
+}
+
+// The majorant of a cell bounds the extinction everywhere in it, empty cells have zero majorant.
+TEST(MajorantGrid, Build) {
+    MediumDensity density;
+    makeDensity(density);
+
+    MajorantGrid grid;
+    grid.Build(&density, extinction);
+    ASSERT_EQ(grid.GetResolution(0), 3u);
+
+    for (auto i = 0u; i < 16384; ++i) {
+        const Point p(sort_hash_canonical(5u, 3 * i), sort_hash_canonical(5u, 3 * i + 1), sort_hash_canonical(5u, 3 * i + 2));
+        const auto x = std::min((unsigned)(p.x * 3), 2u), y = std::min((unsigned)(p.y * 3), 2u), z = std::min((unsigned)(p.z * 3), 2u);
+        EXPECT_LE(extinction(density.Sample(p)), grid.GetMajorant(x, y, z));
+    }
+
+    for (auto z = 0u; z < 3; ++z)
+        for (auto y = 0u; y < 3; ++y)
+            EXPECT_EQ(grid.GetMajorant(0, y, z), 0.0f);
+}
+
+// Cells are visited in order without gaps, each with its own majorant.
+TEST(MajorantGrid, Traverse) {
+    MediumDensity density;
+    makeDensity(density);
+
+    MajorantGrid grid;
+    grid.Build(&density, extinction);
+
+    for (auto i = 0u; i < 1024; ++i) {
+        const Point ori(3.0f * sort_hash_canonical(7u, 6 * i) - 1.0f, 3.0f * sort_hash_canonical(7u, 6 * i + 1) - 1.0f, 3.0f * sort_hash_canonical(7u, 6 * i + 2) - 1.0f);
+        const Vector dir(2.0f * sort_hash_canonical(7u, 6 * i + 3) - 1.0f, 2.0f * sort_hash_canonical(7u, 6 * i + 4) - 1.0f, 2.0f * sort_hash_canonical(7u, 6 * i + 5) - 1.0f);
+        const auto max_t = 4.0f;
+
+        auto last_t = 0.0f;
+        grid.Traverse(ori, dir, max_t, [&](float t0, float t1, float majorant) {
+            EXPECT_NEAR(t0, last_t, 1e-4f);
+            EXPECT_GE(t1, t0);
+            last_t = t1;
+
+            const auto p = ori + dir * (0.5f * (t0 + t1));
+            auto expected = 0.0f;
+            if (p.x >= 0.0f && p.x <= 1.0f && p.y >= 0.0f && p.y <= 1.0f && p.z >= 0.0f && p.z <= 1.0f)
+                expected = grid.GetMajorant(std::min((unsigned)(p.x * 3), 2u), std::min((unsigned)(p.y * 3), 2u), std::min((unsigned)(p.z * 3), 2u));
+            EXPECT_EQ(majorant, expected);
+            return true;
+        });
+        EXPECT_NEAR(last_t, max_t, 1e-4f);
+    }
+}
+
+// Ratio tracking and delta tracking in a homogeneous medium match the analytical transmittance and collision probability.
+TEST(MajorantGrid, TrackingHomogeneous) {
+    constexpr auto absorption = 0.5f, scattering = 1.5f, max_t = 2.0f;
+    constexpr auto sample_cnt = 100000u;
+
+    MediumDensity density;
+    makeDensity(density);
+
+    MajorantGrid grid;
+    grid.Build(&density, [](float) { return absorption + scattering; });
+
+    const MediumSample homogeneous(WHITE_SPECTRUM, 0.0f, absorption, scattering, 0.0f);
+    const auto evaluate = [&](float) { return homogeneous; };
+    const Point ori(0.5f, 0.5f, -0.5f);
+    const Vector dir(0.0f, 0.0f, 1.0f);
+
+    const auto tr = std::exp(-(absorption + scattering) * max_t);
+
+    auto ratio = 0.0f, pass = 0.0f, scatter = 0.0f;
+    for (auto i = 0u; i < sample_cnt; ++i) {
+        ratio += RatioTracking(grid, ori, dir, max_t, evaluate)[0];
+
+        float t;
+        MediumSample ms;
+        Spectrum emission;
+        const auto weight = DeltaTracking(grid, ori, dir, max_t, evaluate, t, ms, emission)[0];
+        (t < 0.0f ? pass : scatter) += weight;
+    }
+
+    EXPECT_NEAR(ratio / sample_cnt, tr, 0.002f);
+    EXPECT_NEAR(pass / sample_cnt, tr, 0.002f);
+    EXPECT_NEAR(scatter / sample_cnt, scattering / (absorption + scattering) * (1.0f - tr), 0.01f);
+}
+
+// Extinction above the majorant is clamped, weights never go negative.
+TEST(MajorantGrid, TrackingExceedingMajorant) {
+    MediumDensity density;
+    makeDensity(density);
+
+    MajorantGrid grid;
+    grid.Build(&density, [](float) { return 1.0f; });
+
+    const MediumSample dense(WHITE_SPECTRUM, 0.0f, 4.0f, 4.0f, 0.0f);
+    const auto evaluate = [&](float) { return dense; };
+    const Point ori(0.5f, 0.5f, -0.5f);
+    const Vector dir(0.0f, 0.0f, 1.0f);
+
+    for (auto i = 0u; i < 1024; ++i) {
+        EXPECT_GE(minComponent(RatioTracking(grid, ori, dir, 2.0f, evaluate)), 0.0f);
+
+        float t;
+        MediumSample ms;
+        Spectrum emission;
+        EXPECT_GE(minComponent(DeltaTracking(grid, ori, dir, 2.0f, evaluate, t, ms, emission)), 0.0f);
+    }
+}
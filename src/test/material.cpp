@@ -0,0 +1,67 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+*/
+
+
+#include <string>
+#include <vector>
+#include "thirdparty/gtest/gtest.h"
+#include "material/material.h"
+#include "stream/mstream.h"
+
+namespace {
+    //! @brief  Stream a material with a surface shader made of the given shader units.
+    //!
+    //! Each shader unit has a float input, connections are pairs of shader units, the output node of the
+    //! material is named 'ShaderOutput_' followed by the name of the material.
+    void streamMaterial(StreamBase& stream, const std::string& name, const std::vector<std::pair<std::string, std::string>>& units,
+                        const std::vector<std::pair<std::string, std::string>>& connections) {
+        stream << name;
+        stream << SID("Surface Shader");
+        stream << (unsigned)units.size();
+        for (const auto& unit : units) {
+            stream << unit.first << unit.second;
+            stream << 1u << std::string("Value") << 1 << 0.5f;
+        }
+        stream << (unsigned)connections.size();
+        for (const auto& connection : connections)
+            stream << connection.first << std::string("Result") << connection.second << std::string("Surface");
+        stream << SID("No Volume Shader");
+        stream << false << false;
+        stream << 0.1f << 1024u;
+        stream << Spectrum(0.0f);
+    }
+}
+
+// Shader units that don't reach the output node are stripped, the rest of the graph is what identifies the shader.
+TEST(Material, DeadShaderUnits) {
+    IMemoryStream istream;
+    streamMaterial(istream, "A", { { "A_Diffuse", "Diffuse" } , { "A_Noise", "Noise" } , { "A_Mix", "Mix" } },
+                   { { "A_Diffuse", "ShaderOutput_A" } , { "A_Noise", "A_Mix" } });
+    streamMaterial(istream, "B", { { "B_Diffuse", "Diffuse" } }, { { "B_Diffuse", "ShaderOutput_B" } });
+
+    OMemoryStream ostream(istream);
+    Material a, b;
+    a.Serialize(ostream);
+    b.Serialize(ostream);
+
+    const auto& data = a.GetSurfaceShaderData();
+    ASSERT_EQ(data.m_sources.size(), 1u);
+    EXPECT_EQ(data.m_sources[0].name, "A_Diffuse");
+    ASSERT_EQ(data.m_connections.size(), 1u);
+    EXPECT_EQ(data.m_connections[0].target_shader, "ShaderOutput_A");
+    EXPECT_EQ(data.m_key, b.GetSurfaceShaderData().m_key);
+}
@@ -47,4 +47,20 @@ TEST(Memory, AlignedAllocation_ZeroInput) {
 
     // this line should do nothing.
     free_aligned( ret );
-}
\ No newline at end of file
+}
+
+TEST(Memory, AllocatorScope) {
+    MemoryAllocator allocator;
+    int* persistent = nullptr;
+    {
+        MemoryAllocatorScope scope( allocator );
+        persistent = SORT_MALLOC(int)( 1234 );
+    }
+
+    // recycling the per-thread memory pool doesn't touch memory allocated in the scope
+    SORT_CLEAR_MEMPOOL();
+    auto* recycled = SORT_MALLOC(int)( 5678 );
+    EXPECT_NE( persistent , recycled );
+    EXPECT_EQ( *persistent , 1234 );
+    SORT_CLEAR_MEMPOOL();
+}
@@ -0,0 +1,99 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "thirdparty/gtest/gtest.h"
+#include "integrator/pathguiding.h"
+#include "core/rand.h"
+#include "core/samplemethod.h"
+
+namespace {
+    // A directional tree learned from radiance concentrated around a direction, refined a few times.
+    DirectionalTree makeTree(){
+        const auto peak = normalize( Vector( 1.0f , 2.0f , 0.5f ) );
+        DirectionalTree tree;
+        for( auto iteration = 0u ; iteration < 4 ; ++iteration ){
+            for( auto k = 0u ; k < 20000 ; ++k ){
+                const auto dir = DirectionalTree::CanonicalToDir( Vector2f( sort_hash_canonical( iteration , 2 * k ) , sort_hash_canonical( iteration , 2 * k + 1 ) ) );
+                const auto d = std::max( 0.0f , dot( dir , peak ) );
+                tree.Record( dir , 0.1f + d * d * d * d * 10.0f );
+            }
+            if( iteration < 3 )
+                tree = tree.Refine( 0.01f , 1024 );
+        }
+        return tree;
+    }
+}
+
+// Mapping directions to the unit square is invertible.
+TEST(PathGuiding, CanonicalMapping) {
+    for( auto k = 0u ; k < 1000 ; ++k ){
+        const auto p = Vector2f( sort_hash_canonical( 7u , 2 * k ) , sort_hash_canonical( 7u , 2 * k + 1 ) );
+        const auto q = DirectionalTree::DirToCanonical( DirectionalTree::CanonicalToDir( p ) );
+        EXPECT_NEAR( p.x , q.x , 1e-4f );
+        EXPECT_NEAR( p.y , q.y , 1e-4f );
+    }
+}
+
+// The pdf returned by sampling matches the evaluated one and integrates to one over the sphere.
+TEST(PathGuiding, SamplePdf) {
+    const auto tree = makeTree();
+    EXPECT_GT( tree.GetNodeCount() , 1u );
+
+    // directions sampled right at the border of quadrants may fall into the neighbors due to precision
+    constexpr auto N = 200000u;
+    auto integral = 0.0f;
+    auto mismatch = 0u;
+    for( auto k = 0u ; k < N ; ++k ){
+        float pdf = 0.0f;
+        const auto dir = tree.Sample( Vector2f( sort_hash_canonical( 3u , 2 * k ) , sort_hash_canonical( 3u , 2 * k + 1 ) ) , pdf );
+        if( fabs( pdf - tree.Pdf( dir ) ) > pdf * 1e-3f )
+            ++mismatch;
+
+        // uniform sphere estimation of the integral of the pdf
+        const auto uniform = UniformSampleSphere( sort_hash_canonical( 4u , 2 * k ) , sort_hash_canonical( 4u , 2 * k + 1 ) );
+        integral += tree.Pdf( uniform ) / UniformSpherePdf();
+    }
+    EXPECT_LT( mismatch , N / 1000 );
+    EXPECT_NEAR( integral / N , 1.0f , 0.02f );
+}
+
+// Refining respects the node budget.
+TEST(PathGuiding, RefineBudget) {
+    const auto tree = makeTree();
+    EXPECT_LE( tree.Refine( 0.0001f , 100 ).GetNodeCount() , 100u );
+}
+
+// Radiance learned from uniform incident radiance is estimated correctly everywhere.
+TEST(PathGuiding, EstimateRadiance) {
+    GuidingTree tree( BBox( Point( 0.0f ) , Point( 1.0f ) ) , 1 << 20 );
+    EXPECT_LT( tree.EstimateRadiance( Point( 0.5f ) , Vector( 0.0f , 1.0f , 0.0f ) ) , 0.0f );
+
+    constexpr auto N = 100000u;
+    for( auto k = 0u ; k < N ; ++k ){
+        const auto p = Point( sort_hash_canonical( 5u , 3 * k ) , sort_hash_canonical( 5u , 3 * k + 1 ) , sort_hash_canonical( 5u , 3 * k + 2 ) );
+        const auto dir = UniformSampleSphere( sort_hash_canonical( 6u , 2 * k ) , sort_hash_canonical( 6u , 2 * k + 1 ) );
+        tree.Record( p , dir , 2.0f / UniformSpherePdf() );
+    }
+    tree.Refine( 0 );
+
+    EXPECT_GT( tree.GetLeafCount() , 1u );
+    for( auto k = 0u ; k < 16 ; ++k ){
+        const auto p = Point( sort_hash_canonical( 8u , 3 * k ) , sort_hash_canonical( 8u , 3 * k + 1 ) , sort_hash_canonical( 8u , 3 * k + 2 ) );
+        const auto dir = UniformSampleSphere( sort_hash_canonical( 9u , 2 * k ) , sort_hash_canonical( 9u , 2 * k + 1 ) );
+        EXPECT_NEAR( tree.EstimateRadiance( p , dir ) , 2.0f , 0.5f );
+    }
+}
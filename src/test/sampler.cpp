@@ -0,0 +1,258 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "thirdparty/gtest/gtest.h"
+#include "sampler/sobol.h"
+#include "sampler/random.h"
+#include "core/rand.h"
+#include "core/timer.h"
+#include "core/log.h"
+#include "integrator/integrator.h"
+
+namespace {
+    // Every elementary interval of size 1/n of a (0,2)-net holds exactly one of the first n points.
+    void checkElementaryIntervals( const float* u , const float* v , unsigned n ){
+        for( auto nx = 1u ; nx <= n ; nx *= 2 ){
+            const auto ny = n / nx;
+            std::vector<int> cnt( n , 0 );
+            for( auto i = 0u ; i < n ; ++i )
+                ++cnt[ (unsigned)( u[i] * nx ) * ny + (unsigned)( v[i] * ny ) ];
+            for( auto c : cnt )
+                EXPECT_EQ( c , 1 );
+        }
+    }
+}
+
+TEST(Sampler, PMJ02Stratification) {
+    constexpr unsigned n = 64;
+    float u[n] , v[n];
+
+    // pairs of dimensions drawn from the sample stream are stratified, no matter how deep the dimension is
+    PMJ02Sampler sampler;
+    for( auto pair = 0u ; pair < 8 ; ++pair ){
+        sampler.StartPixel( 17 , 3 );
+        for( auto i = 0u ; i < n ; ++i ){
+            sampler.StartSample( i );
+            for( auto k = 0u ; k < pair ; ++k )
+                sampler.Next1D() , sampler.Next1D();
+            u[i] = sampler.Next1D();
+            v[i] = sampler.Next1D();
+        }
+        checkElementaryIntervals( u , v , 16 );
+        checkElementaryIntervals( u , v , n );
+    }
+}
+
+TEST(Sampler, SobolStratification) {
+    constexpr unsigned n = 256;
+    float data[2 * n] , u[n] , v[n];
+
+    SobolSampler sampler;
+    sampler.StartPixel( 5 , 9 );
+    sampler.Generate2D( data , n );
+    for( auto i = 0u ; i < n ; ++i ){
+        u[i] = data[2 * i];
+        v[i] = data[2 * i + 1];
+    }
+    checkElementaryIntervals( u , v , n );
+
+    // later passes of progressive rendering continue the sequence of the pixel
+    sampler.StartPixel( 5 , 9 , n / 2 );
+    sampler.Generate2D( data , n / 2 );
+    for( auto i = 0u ; i < n / 2 ; ++i ){
+        EXPECT_EQ( data[2 * i] , u[i + n / 2] );
+        EXPECT_EQ( data[2 * i + 1] , v[i + n / 2] );
+    }
+}
+
+TEST(Sampler, SampleStream) {
+    SobolSampler sampler;
+    sampler.StartPixel( 1 , 2 );
+    sampler.StartSample( 3 );
+    const auto expected0 = sampler.Next1D();
+    const auto expected1 = sampler.Next1D();
+
+    // 'sort_canonical' draws from the bound sampler and falls back to random numbers once it is unbound
+    {
+        SampleStreamScope scope( &sampler );
+        sampler.StartSample( 3 );
+        EXPECT_EQ( sort_canonical() , expected0 );
+        EXPECT_EQ( sort_canonical() , expected1 );
+    }
+    EXPECT_EQ( sort_bind_sampler( nullptr ) , nullptr );
+
+    // different pixels are decorrelated
+    sampler.StartPixel( 2 , 1 );
+    sampler.StartSample( 3 );
+    EXPECT_NE( sampler.Next1D() , expected0 );
+}
+
+TEST(Sampler, CounterBasedRandom) {
+    constexpr unsigned n = 1 << 16;
+    std::vector<float> batch( n );
+    sort_hash_canonical_batch( 7 , 100 , batch.data() , n );
+
+    auto sum = 0.0;
+    for( auto i = 0u ; i < n ; ++i ){
+        EXPECT_EQ( batch[i] , sort_hash_canonical( 7 , 100 + i ) );
+        EXPECT_GE( batch[i] , 0.0f );
+        EXPECT_LT( batch[i] , 1.0f );
+        sum += batch[i];
+    }
+    EXPECT_NEAR( sum / n , 0.5 , 0.01 );
+
+    // samples of a pixel don't depend on the pixels rendered before it
+    RandomSampler s0 , s1;
+    s0.StartPixel( 4 , 4 );
+    s0.StartSample( 2 );
+    s0.Next1D();
+    s1.StartPixel( 8 , 1 , 16 );
+    s1.StartSample( 5 );
+    s0.StartPixel( 8 , 1 , 16 );
+    s0.StartSample( 5 );
+    for( auto i = 0 ; i < 16 ; ++i )
+        EXPECT_EQ( s0.Next1D() , s1.Next1D() );
+}
+
+namespace {
+    // an integrator that only generates samples
+    class SampleOnlyIntegrator : public Integrator{
+    public:
+        Spectrum Li( const Ray& ray , const PixelSample& ps , const Scene& scene ) const override {
+            return 0.0f;
+        }
+    };
+}
+
+// Seeds hoisted out of the batch loops give the same samples as evaluating each of them on its own.
+TEST(Sampler, SobolBatchMatchesEvaluate) {
+    constexpr unsigned spp = 64;
+    constexpr unsigned first_sample = 128;
+
+    SobolSampler sampler;
+    sampler.StartPixel( 5 , 9 , first_sample );
+    const auto seed = sort_hash_combine( sort_hash( 5u ) , 9u );
+
+    // the first 1D sample takes dimension zero, the 2D samples take dimensions one and two, then four and five
+    float s1d[spp] , s2d0[2 * spp] , s2d1[2 * spp];
+    sampler.Generate1D( s1d , spp );
+    sampler.Generate2D( s2d0 , spp );
+    sampler.Generate2D( s2d1 , spp );
+    for( auto i = 0u ; i < spp ; ++i ){
+        EXPECT_EQ( s1d[i] , sampler.Evaluate( first_sample + i , 0 , seed ) );
+        EXPECT_EQ( s2d0[2 * i] , sampler.Evaluate( first_sample + i , 1 , seed ) );
+        EXPECT_EQ( s2d0[2 * i + 1] , sampler.Evaluate( first_sample + i , 2 , seed ) );
+        EXPECT_EQ( s2d1[2 * i] , sampler.Evaluate( first_sample + i , 4 , seed ) );
+        EXPECT_EQ( s2d1[2 * i + 1] , sampler.Evaluate( first_sample + i , 5 , seed ) );
+    }
+}
+
+// Camera samples of a pixel match values recorded from the generation with memory allocated for each pixel.
+TEST(Sampler, GenerateSampleExpectedValues) {
+    // image u, image v, lens u and lens v of the first four samples of pixel ( 3 , 7 )
+    const float expected[2][4][4] = {
+        {   // random sampler
+            { 0.738445818f , 0.113456488f , 0.431670606f , 0.188072383f } ,
+            { 0.865241587f , 0.0428975821f , 0.135327637f , 0.594656348f } ,
+            { 0.289907336f , 0.56482935f , 0.605648994f , 0.888815403f } ,
+            { 0.0520487428f , 0.784047067f , 0.00733488798f , 0.0906153321f } ,
+        } ,
+        {   // sobol sampler
+            { 0.208769917f , 0.741665781f , 0.617625892f , 0.328519046f } ,
+            { 0.56919843f , 0.1203987f , 0.225960433f , 0.922621012f } ,
+            { 0.96377331f , 0.943495214f , 0.81829083f , 0.0283487439f } ,
+            { 0.294014513f , 0.303270042f , 0.378713131f , 0.631981969f } ,
+        }
+    };
+
+    Scene scene;
+    SampleOnlyIntegrator integrator;
+    float buffer[16];
+    PixelSample samples[4];
+
+    RandomSampler random;
+    SobolSampler sobol;
+    Sampler* samplers[] = { &random , &sobol };
+    for( auto k = 0 ; k < 2 ; ++k ){
+        samplers[k]->StartPixel( 3 , 7 );
+        integrator.GenerateSample( samplers[k] , samples , 4 , buffer , scene );
+        for( auto i = 0 ; i < 4 ; ++i ){
+            EXPECT_EQ( samples[i].img_u , expected[k][i][0] );
+            EXPECT_EQ( samples[i].img_v , expected[k][i][1] );
+            EXPECT_EQ( samples[i].dof_u , expected[k][i][2] );
+            EXPECT_EQ( samples[i].dof_v , expected[k][i][3] );
+        }
+    }
+}
+
+// Microbenchmark of generating camera samples of pixels, the result is checked against the previous generation.
+TEST(Sampler, GenerateSampleOverhead) {
+    constexpr unsigned spp = 64;
+    constexpr unsigned pixel_cnt = 1 << 15;
+
+    Scene scene;
+    SampleOnlyIntegrator integrator;
+    RandomSampler sampler;
+    auto samples = std::make_unique<PixelSample[]>( spp );
+
+    // The way camera samples used to be generated, two heap allocations and a shuffle of lens samples for each pixel.
+    // Samples of the last pixel are kept for comparison.
+    auto previous = std::make_unique<PixelSample[]>( spp );
+    Timer timer;
+    for( auto p = 0u ; p < pixel_cnt ; ++p ){
+        sampler.StartPixel( p % 256 , p / 256 );
+        auto data = std::make_unique<float[]>( 2 * spp );
+        sampler.Generate2D( data.get() , spp , true );
+        for( auto i = 0u ; i < spp ; ++i ){
+            previous[i].img_u = data[2 * i];
+            previous[i].img_v = data[2 * i + 1];
+        }
+        auto shuffle = std::make_unique<unsigned[]>( spp );
+        for( auto i = 0u ; i < spp ; ++i )
+            shuffle[i] = i;
+        std::shuffle( shuffle.get() , shuffle.get() + spp , std::default_random_engine( sort_rand() ) );
+        sampler.Generate2D( data.get() , spp );
+        for( auto i = 0u ; i < spp ; ++i ){
+            previous[i].dof_u = data[2 * shuffle[i]];
+            previous[i].dof_v = data[2 * shuffle[i] + 1];
+        }
+    }
+    const auto before = timer.GetElapsedTime();
+
+    timer.Reset();
+    auto buffer = std::make_unique<float[]>( 4 * spp );
+    for( auto p = 0u ; p < pixel_cnt ; ++p ){
+        sampler.StartPixel( p % 256 , p / 256 );
+        integrator.GenerateSample( &sampler , samples.get() , spp , buffer.get() , scene );
+    }
+    const auto after = timer.GetElapsedTime();
+
+    slog( INFO , GENERAL , "Generating %d camera samples per pixel costs %.1f ns per pixel before, %.1f ns per pixel after." ,
+          spp , before * 1e6f / pixel_cnt , after * 1e6f / pixel_cnt );
+
+    // Image samples are the same, lens samples are the same set without the shuffle.
+    std::vector<std::pair<float,float>> dof_previous , dof_after;
+    for( auto i = 0u ; i < spp ; ++i ){
+        EXPECT_EQ( samples[i].img_u , previous[i].img_u );
+        EXPECT_EQ( samples[i].img_v , previous[i].img_v );
+        dof_previous.push_back( std::make_pair( previous[i].dof_u , previous[i].dof_v ) );
+        dof_after.push_back( std::make_pair( samples[i].dof_u , samples[i].dof_v ) );
+    }
+    std::sort( dof_previous.begin() , dof_previous.end() );
+    std::sort( dof_after.begin() , dof_after.end() );
+    EXPECT_EQ( dof_previous , dof_after );
+}
@@ -0,0 +1,95 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#include <cmath>
+#include "thirdparty/gtest/gtest.h"
+#include "texture/sparsetexture3d.h"
+#include "core/rand.h"
+
+namespace {
+    constexpr unsigned W = 21, H = 13, D = 17;
+
+    // A blob in the middle of an empty volume, the size isn't a multiple of the brick size on purpose.
+    std::vector<float> makeVolume() {
+        std::vector<float> data(W * H * D, 0.0f);
+        for (auto z = 4u; z < 12u; ++z)
+            for (auto y = 3u; y < 10u; ++y)
+                for (auto x = 9u; x < 20u; ++x)
+                    data[(z * H + y) * W + x] = sort_hash_canonical(7u, (z * H + y) * W + x) * 4.0f;
+        return data;
+    }
+
+    // Trilinear interpolation of dense texels, the same filtering that SparseTexture3D is supposed to have.
+    float denseSample(const std::vector<float>& data, float u, float v, float w) {
+        const auto texel = [&](unsigned x, unsigned y, unsigned z) {
+            return data[(std::min(z, D - 1) * H + std::min(y, H - 1)) * W + std::min(x, W - 1)];
+        };
+        const auto fx = std::max(0.0f, u * W - 0.5f), fy = std::max(0.0f, v * H - 0.5f), fz = std::max(0.0f, w * D - 0.5f);
+        const auto x = (unsigned)fx, y = (unsigned)fy, z = (unsigned)fz;
+        const auto dx = fx - x, dy = fy - y, dz = fz - z;
+        const auto lerp = [](float a, float b, float t) { return a * (1.0f - t) + b * t; };
+        const auto t0 = lerp(lerp(texel(x, y, z), texel(x + 1, y, z), dx), lerp(texel(x, y + 1, z), texel(x + 1, y + 1, z), dx), dy);
+        const auto t1 = lerp(lerp(texel(x, y, z + 1), texel(x + 1, y, z + 1), dx), lerp(texel(x, y + 1, z + 1), texel(x + 1, y + 1, z + 1), dx), dy);
+        return lerp(t0, t1, dz);
+    }
+}
+
+// Only bricks touching the blob keep their texels, samples match the dense volume.
+TEST(SparseTexture3D, MatchesDenseVolume) {
+    const auto data = makeVolume();
+
+    SparseTexture3D<float> tex;
+    tex.Build(W, H, D, data.data(), false);
+    EXPECT_EQ(tex.GetDenseBrickCount(), 2u * 2u * 2u);
+    EXPECT_LT(tex.GetMemoryUsage(), data.size() * sizeof(float));
+
+    for (auto i = 0u; i < 4096; ++i) {
+        const auto u = sort_hash_canonical(11u, 3 * i), v = sort_hash_canonical(11u, 3 * i + 1), w = sort_hash_canonical(11u, 3 * i + 2);
+        EXPECT_NEAR(tex.Sample(u, v, w), denseSample(data, u, v, w), 1e-5f);
+    }
+    for (auto z = 0u; z < D; ++z)
+        for (auto y = 0u; y < H; ++y)
+            for (auto x = 0u; x < W; ++x)
+                EXPECT_EQ(tex.Sample((int)x, (int)y, (int)z), data[(z * H + y) * W + x]);
+}
+
+// Quantized texels are within half a quantization step of the original ones.
+TEST(SparseTexture3D, Quantization) {
+    const auto data = makeVolume();
+
+    SparseTexture3D<float> tex;
+    tex.Build(W, H, D, data.data(), true);
+    for (auto z = 0u; z < D; ++z)
+        for (auto y = 0u; y < H; ++y)
+            for (auto x = 0u; x < W; ++x)
+                EXPECT_NEAR(tex.Sample((int)x, (int)y, (int)z), data[(z * H + y) * W + x], 4.0f / 65535.0f);
+
+    // multiple channels are quantized separately
+    std::vector<float> color(W * H * D * 3);
+    for (auto i = 0u; i < W * H * D; ++i) {
+        color[3 * i] = data[i];
+        color[3 * i + 1] = data[i] * 0.001f;
+        color[3 * i + 2] = 1.0f;
+    }
+    SparseTexture3D<Spectrum> color_tex;
+    color_tex.Build(W, H, D, color.data(), true);
+    for (auto i = 0u; i < W * H * D; ++i) {
+        const auto c = color_tex.Sample((int)(i % W), (int)(i / W % H), (int)(i / (W * H)));
+        EXPECT_NEAR(c[0], color[3 * i], 4.0f / 65535.0f);
+        EXPECT_NEAR(c[1], color[3 * i + 1], 0.004f / 65535.0f);
+        EXPECT_EQ(c[2], 1.0f);
+    }
+}
@@ -0,0 +1,95 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+*/
+
+
+#include <functional>
+#include <vector>
+#include "thirdparty/gtest/gtest.h"
+#include "task/task.h"
+
+namespace {
+    //! @brief  A task executing a function.
+    class Function_Task : public Task {
+    public:
+        Function_Task(const std::function<void()>& func, const char* name, unsigned int priority, const Task::Task_Container& dependencies)
+            : Task(name, priority, dependencies), m_func(func) {}
+
+        void Execute() override {
+            m_func();
+        }
+
+    private:
+        std::function<void()> m_func;
+    };
+}
+
+// Sub tasks start after their parent and tasks depending on the parent wait for them, regardless of priority.
+TEST(Task, SubTask) {
+    std::vector<int> order;
+
+    auto parent = SCHEDULE_TASK<Function_Task>("Parent", DEFAULT_TASK_PRIORITY, {}, [&]() {
+        order.push_back(0);
+        const auto sub_task = SCHEDULE_SUB_TASK<Function_Task>("Sub Task 0", DEFAULT_TASK_PRIORITY + 1, {}, [&]() { order.push_back(2); });
+        SCHEDULE_SUB_TASK<Function_Task>("Sub Task 1", DEFAULT_TASK_PRIORITY + 2, { sub_task }, [&]() { order.push_back(3); });
+        order.push_back(1);
+    });
+    SCHEDULE_TASK<Function_Task>("Dependent", DEFAULT_TASK_PRIORITY + 3, { parent }, [&]() { order.push_back(4); });
+
+    EXECUTING_TASKS();
+
+    EXPECT_EQ(order, std::vector<int>({ 0, 1, 2, 3, 4 }));
+}
+
+// A sub task could spawn sub tasks of its own, tasks depending on the root task wait for the whole chain.
+TEST(Task, NestedSubTask) {
+    std::vector<int> order;
+
+    auto parent = SCHEDULE_TASK<Function_Task>("Parent", DEFAULT_TASK_PRIORITY, {}, [&]() {
+        order.push_back(0);
+        SCHEDULE_SUB_TASK<Function_Task>("Sub Task", DEFAULT_TASK_PRIORITY, {}, [&]() {
+            order.push_back(1);
+            SCHEDULE_SUB_TASK<Function_Task>("Nested Sub Task", DEFAULT_TASK_PRIORITY, {}, [&]() { order.push_back(2); });
+        });
+    });
+    SCHEDULE_TASK<Function_Task>("Dependent", DEFAULT_TASK_PRIORITY + 1, { parent }, [&]() { order.push_back(3); });
+
+    EXECUTING_TASKS();
+
+    EXPECT_EQ(order, std::vector<int>({ 0, 1, 2, 3 }));
+}
+
+// Every row is processed exactly once, no matter whether the job runs inside a task or not.
+TEST(Task, ParallelForRows) {
+    constexpr int h = 1000;
+    std::vector<int> in_task( h , 0 ) , outside( h , 0 );
+
+    SCHEDULE_TASK<Function_Task>("Parallel", DEFAULT_TASK_PRIORITY, {}, [&]() {
+        ParallelForRows( h , [&]( int y0 , int y1 ){
+            for( auto y = y0 ; y < y1 ; ++y )
+                ++in_task[y];
+        });
+    });
+    EXECUTING_TASKS();
+
+    ParallelForRows( h , [&]( int y0 , int y1 ){
+        for( auto y = y0 ; y < y1 ; ++y )
+            ++outside[y];
+    });
+
+    EXPECT_EQ( in_task , std::vector<int>( h , 1 ) );
+    EXPECT_EQ( outside , std::vector<int>( h , 1 ) );
+}
@@ -0,0 +1,201 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <regex>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include "imageoutput.h"
+#include "core/log.h"
+#include "core/sassert.h"
+#include "task/task.h"
+#include "thirdparty/tiny_exr/tinyexr.h"
+
+// The PNG encoder comes with miniz embedded in tinyexr, whose implementation is compiled in imagetexture2d.cpp.
+namespace tinyexr { namespace miniz { extern "C" {
+    void*   tdefl_write_image_to_png_file_in_memory_ex(const void *pImage, int w, int h, int num_chans, size_t *pLen_out, unsigned int level, int flip);
+    void    mz_free(void *p);
+} } }
+
+namespace {
+    // Find a channel by name, it returns the first channel if there is no such a channel.
+    const float* findChannel( const std::vector<ImageChannel>& channels , const char* name ){
+        for( const auto& channel : channels )
+            if( channel.name == name )
+                return channel.data;
+        return channels.front().data;
+    }
+
+    // Convert linear radiance to 8 bits sRGB value.
+    SORT_FORCEINLINE unsigned char toSRGB8( float v ){
+        v = std::min( 1.0f , std::max( 0.0f , v ) );
+        v = ( v <= 0.0031308f ) ? 12.92f * v : 1.055f * std::pow( v , 1.0f / 2.4f ) - 0.055f;
+        return (unsigned char)( v * 255.0f + 0.5f );
+    }
+
+    // Convert linear radiance to Radiance RGBE format.
+    SORT_FORCEINLINE void toRGBE( float r , float g , float b , unsigned char* rgbe ){
+        const auto v = std::max( r , std::max( g , b ) );
+        if( v < 1e-32f ){
+            rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+            return;
+        }
+
+        int e;
+        const auto scale = std::frexp( v , &e ) * 256.0f / v;
+        rgbe[0] = (unsigned char)( std::max( 0.0f , r ) * scale );
+        rgbe[1] = (unsigned char)( std::max( 0.0f , g ) * scale );
+        rgbe[2] = (unsigned char)( std::max( 0.0f , b ) * scale );
+        rgbe[3] = (unsigned char)( e + 128 );
+    }
+
+    bool saveEXR( const std::string& filename , int w , int h , std::vector<ImageChannel>& channels , const ImageOutputConfig& config ){
+        // Most EXR viewers expect channels sorted by names.
+        std::sort( channels.begin() , channels.end() , []( const ImageChannel& c0 , const ImageChannel& c1 ){ return c0.name < c1.name; } );
+
+        const auto channel_cnt = channels.size();
+        std::vector<EXRChannelInfo> channel_infos( channel_cnt );
+        std::vector<const float*>   images( channel_cnt );
+        std::vector<int>            pixel_types( channel_cnt , TINYEXR_PIXELTYPE_FLOAT );
+        std::vector<int>            requested_pixel_types( channel_cnt , config.exr_half ? TINYEXR_PIXELTYPE_HALF : TINYEXR_PIXELTYPE_FLOAT );
+        for( auto i = 0u ; i < channel_cnt ; ++i ){
+            memset( &channel_infos[i] , 0 , sizeof( EXRChannelInfo ) );
+            strncpy( channel_infos[i].name , channels[i].name.c_str() , 255 );
+            images[i] = channels[i].data;
+        }
+
+        // Planes are handed to tinyexr directly, they are converted and compressed per scanline block in parallel.
+        EXRImage image;
+        InitEXRImage( &image );
+        image.num_channels = (int)channel_cnt;
+        image.images = (unsigned char**)( images.data() );
+        image.width = w;
+        image.height = h;
+
+        EXRHeader header;
+        InitEXRHeader( &header );
+        header.num_channels = (int)channel_cnt;
+        header.channels = channel_infos.data();
+        header.pixel_types = pixel_types.data();
+        header.requested_pixel_types = requested_pixel_types.data();
+        header.compression_type = (int)config.exr_compression;
+
+        const char* err = nullptr;
+        const auto ret = SaveEXRImageToFile( &image , &header , filename.c_str() , &err );
+        if( TINYEXR_SUCCESS != ret ){
+            slog( WARNING , IMAGE , "Fail to save image file %s, %s" , filename.c_str() , err ? err : "" );
+            FreeEXRErrorMessage( err );
+            return false;
+        }
+        return true;
+    }
+
+    bool savePNG( const std::string& filename , int w , int h , const std::vector<ImageChannel>& channels ){
+        const auto r = findChannel( channels , "R" );
+        const auto g = findChannel( channels , "G" );
+        const auto b = findChannel( channels , "B" );
+
+        // This is an 8 bits buffer, it is a quarter of the size of the float planes.
+        const auto pixels = std::make_unique<unsigned char[]>( 3 * w * h );
+        ParallelForRows( h , [&]( int y0 , int y1 ){
+            for( auto i = y0 * w ; i < y1 * w ; ++i ){
+                pixels[3 * i]     = toSRGB8( r[i] );
+                pixels[3 * i + 1] = toSRGB8( g[i] );
+                pixels[3 * i + 2] = toSRGB8( b[i] );
+            }
+        });
+
+        size_t size = 0;
+        auto png = tinyexr::miniz::tdefl_write_image_to_png_file_in_memory_ex( pixels.get() , w , h , 3 , &size , 6 , 0 );
+        if( IS_PTR_INVALID(png) ){
+            slog( WARNING , IMAGE , "Fail to encode png file %s" , filename.c_str() );
+            return false;
+        }
+
+        auto file = fopen( filename.c_str() , "wb" );
+        const auto ret = IS_PTR_VALID(file) && fwrite( png , 1 , size , file ) == size;
+        if( IS_PTR_VALID(file) )
+            fclose( file );
+        tinyexr::miniz::mz_free( png );
+
+        if( !ret )
+            slog( WARNING , IMAGE , "Fail to save image file %s" , filename.c_str() );
+        return ret;
+    }
+
+    bool saveHDR( const std::string& filename , int w , int h , const std::vector<ImageChannel>& channels ){
+        const auto r = findChannel( channels , "R" );
+        const auto g = findChannel( channels , "G" );
+        const auto b = findChannel( channels , "B" );
+
+        // Flat scanlines are written, which every reader of the format supports.
+        const auto pixels = std::make_unique<unsigned char[]>( 4 * w * h );
+        ParallelForRows( h , [&]( int y0 , int y1 ){
+            for( auto i = y0 * w ; i < y1 * w ; ++i )
+                toRGBE( r[i] , g[i] , b[i] , pixels.get() + 4 * i );
+        });
+
+        auto file = fopen( filename.c_str() , "wb" );
+        if( IS_PTR_INVALID(file) ){
+            slog( WARNING , IMAGE , "Fail to save image file %s" , filename.c_str() );
+            return false;
+        }
+        fprintf( file , "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n" , h , w );
+        const auto size = (size_t)( 4 * w * h );
+        const auto ret = fwrite( pixels.get() , 1 , size , file ) == size;
+        fclose( file );
+
+        if( !ret )
+            slog( WARNING , IMAGE , "Fail to save image file %s" , filename.c_str() );
+        return ret;
+    }
+}
+
+ImageFileFormat GetImageFileFormat( const std::string& filename ){
+    static const std::regex exr_reg(".*\\.exr$", std::regex_constants::icase);
+    static const std::regex png_reg(".*\\.png$", std::regex_constants::icase);
+    static const std::regex hdr_reg(".*\\.hdr$", std::regex_constants::icase);
+    if( std::regex_match( filename , exr_reg ) )
+        return ImageFileFormat::EXR;
+    if( std::regex_match( filename , png_reg ) )
+        return ImageFileFormat::PNG;
+    if( std::regex_match( filename , hdr_reg ) )
+        return ImageFileFormat::HDR;
+    return ImageFileFormat::UNKNOWN;
+}
+
+bool SaveImage( const std::string& filename , int w , int h , std::vector<ImageChannel> channels , const ImageOutputConfig& config ){
+    if( channels.empty() || w <= 0 || h <= 0 ){
+        slog( WARNING , IMAGE , "No data to be saved in image file %s" , filename.c_str() );
+        return false;
+    }
+
+    switch( GetImageFileFormat( filename ) ){
+    case ImageFileFormat::EXR:
+        return saveEXR( filename , w , h , channels , config );
+    case ImageFileFormat::PNG:
+        return savePNG( filename , w , h , channels );
+    case ImageFileFormat::HDR:
+        return saveHDR( filename , w , h , channels );
+    default:
+        break;
+    }
+
+    sAssertMsg( false , IMAGE , "SORT doesn't support exporting file %s" , filename.c_str() );
+    return false;
+}
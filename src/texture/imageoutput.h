@@ -0,0 +1,74 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "core/define.h"
+
+//! @brief  Image file formats SORT is able to write to disk.
+enum class ImageFileFormat {
+    EXR = 0 ,       /**< OpenEXR, scanline based, half or full float precision. */
+    PNG ,           /**< 8 bits sRGB encoded PNG, mainly for previewing. */
+    HDR ,           /**< Radiance RGBE. */
+    UNKNOWN
+};
+
+//! @brief  Compression methods of OpenEXR output, values match the definition of tinyexr.
+enum class ExrCompression : int {
+    NONE = 0 ,
+    RLE  = 1 ,
+    ZIPS = 2 ,
+    ZIP  = 3 ,
+    PIZ  = 4
+};
+
+//! @brief  Settings of image output.
+struct ImageOutputConfig {
+    bool            exr_half = true;                        /**< Whether to store EXR channels in half precision. */
+    ExrCompression  exr_compression = ExrCompression::ZIP;  /**< Compression method of EXR output. */
+};
+
+//! @brief  A single channel of an image to be written.
+//!
+//! Channels point to existing row major planes of pixels, top row comes first. There is no copy
+//! of the plane made during output, as long as the format is capable of storing float data.
+struct ImageChannel {
+    std::string     name;               /**< Name of the channel, like 'R' or 'diffuse.R'. */
+    const float*    data = nullptr;     /**< Plane of the channel, it needs to be 'width * height' floats. */
+};
+
+//! @brief  Deduce the image format from the extension of a file name.
+//!
+//! @param  filename    Name of the file.
+//! @return             Format of the image, UNKNOWN if it is not supported.
+ImageFileFormat GetImageFileFormat( const std::string& filename );
+
+//! @brief  Save planes of an image to a file.
+//!
+//! EXR output stores all channels in the file, sorted by name as OpenEXR requires. PNG and HDR
+//! output only store the 'R', 'G' and 'B' channels, the first channel is used as a gray image
+//! if any of them is missing. Conversion is done in parallel across multiple threads.
+//!
+//! @param  filename    Name of the output file, the extension decides the format.
+//! @param  w           Width of the image.
+//! @param  h           Height of the image.
+//! @param  channels    Channels to be written.
+//! @param  config      Output settings.
+//! @return             Whether the image is saved successfully.
+bool SaveImage( const std::string& filename , int w , int h , std::vector<ImageChannel> channels , const ImageOutputConfig& config = ImageOutputConfig() );
@@ -20,6 +20,7 @@
 #include "core/sassert.h"
 
 #define TINYEXR_IMPLEMENTATION
+#define TINYEXR_USE_THREAD  1
 #include "thirdparty/tiny_exr/tinyexr.h"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -57,6 +58,20 @@ float ImageTexture2D::GetAlpha( int x , int y ) const{
     return m_memory->m_a[ offset ];
 }
 
+Spectrum ImageTexture2D::GetColorFromUV( float u , float v ) const{
+    // constant textures are folded to their average color
+    if( m_constantColor )
+        return m_average;
+    return Texture2DBase::GetColorFromUV( u , v );
+}
+
+float ImageTexture2D::GetAlphaFromtUV( float u , float v ) const{
+    // constant textures are folded to their alpha
+    if( m_constantAlpha )
+        return m_constantAlphaValue;
+    return Texture2DBase::GetAlphaFromtUV( u , v );
+}
+
 // load image from file
 bool ImageTexture2D::LoadResource( const std::string str ){
     static const std::regex exr_reg(".*\\.exr$", std::regex_constants::icase);
@@ -137,15 +152,31 @@ void ImageTexture2D::average(){
     if(IS_PTR_INVALID(m_memory) || IS_PTR_INVALID(m_memory->m_rgb))
         return;
 
+    const auto& first = m_memory->m_rgb[0];
+    m_constantColor = true;
+
     Spectrum average;
     for (auto i = 0; i < m_iTexHeight; ++i) {
         for (auto j = 0; j < m_iTexWidth; ++j) {
             // get the offset
             int offset = i * m_iTexWidth + j;
             // get the color
-            average += m_memory->m_rgb[offset];
+            const auto& color = m_memory->m_rgb[offset];
+            average += color;
+            m_constantColor &= ( color.r == first.r && color.g == first.g && color.b == first.b );
         }
     }
 
-    m_average = average / (float)( m_iTexWidth * m_iTexHeight );
+    // the average of a constant texture is exactly its color, summing may introduce precision issues.
+    m_average = m_constantColor ? first : average / (float)( m_iTexWidth * m_iTexHeight );
+
+    // textures without alpha channel are fully opaque
+    m_constantAlpha = true;
+    m_constantAlphaValue = 1.0f;
+    if(IS_PTR_VALID(m_memory->m_a)){
+        const auto total = m_iTexWidth * m_iTexHeight;
+        m_constantAlphaValue = m_memory->m_a[0];
+        for (auto i = 1; i < total && m_constantAlpha; ++i)
+            m_constantAlpha = ( m_memory->m_a[i] == m_constantAlphaValue );
+    }
 }
@@ -48,6 +48,24 @@ public:
     //! @return             The alpha at the specific position, it will return 1.0 for textures without alpha channel.
     float GetAlpha( int x , int y ) const override;
 
+    //! @brief  Get the color at a specific uv coordinate.
+    //!
+    //! Textures with all texels of the same color are folded to that color, no filtering is done for them.
+    //!
+    //! @param  u           U coordinate.
+    //! @param  v           V coordinate.
+    //! @return             The filtered color at the uv coordinate.
+    Spectrum GetColorFromUV( float u , float v ) const override;
+
+    //! @brief  Get the alpha at a specific uv coordinate.
+    //!
+    //! Textures with all texels of the same alpha are folded to that alpha, no filtering is done for them.
+    //!
+    //! @param  u           U coordinate.
+    //! @param  v           V coordinate.
+    //! @return             The filtered alpha at the uv coordinate.
+    float GetAlphaFromtUV( float u , float v ) const override;
+
     //! @brief  Whether the 2d texture is valid or not.
     //!
     //! @return             True if the texture is valid.
@@ -73,6 +91,13 @@ private:
     // the average radiance of the texture
     Spectrum    m_average;
 
+    // alpha of all texels, it is only valid when the alpha is constant
+    float       m_constantAlphaValue = 1.0f;
+
+    // whether all texels have the same color and the same alpha
+    bool        m_constantColor = false;
+    bool        m_constantAlpha = false;
+
     // texture name
     std::string m_name;
 
@@ -15,6 +15,7 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <algorithm>
 #include "imagetexture3d.h"
 
 template class ImageTexture3D<float>;
@@ -41,9 +42,10 @@ T ImageTexture3D<T>::Sample(float u, float v, float w) const{
     const auto height   = Texture3DBase<T>::m_height;
     const auto depth    = Texture3DBase<T>::m_depth;
 
-    const auto fx = u * width - 0.5f;
-    const auto fy = v * height - 0.5f;
-    const auto fz = w * depth - 0.5f;
+    // Samples within half a texel from the lower borders take the border texels, instead of extrapolating them.
+    const auto fx = std::max(0.0f, u * width - 0.5f);
+    const auto fy = std::max(0.0f, v * height - 0.5f);
+    const auto fz = std::max(0.0f, w * depth - 0.5f);
 
     const auto x = (unsigned)(fx);
     const auto y = (unsigned)(fy);
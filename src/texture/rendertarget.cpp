@@ -27,10 +27,13 @@ void RenderTarget::SetColor( int x , int y , const Spectrum& color ){
     texCoordFilter( x , y );
 
     // get the offset
-    unsigned offset = y * m_iTexWidth + x;
+    const auto offset = y * m_iTexWidth + x;
+    const auto plane_size = m_iTexWidth * m_iTexHeight;
 
     // set the color
-    m_pData[offset] = color;
+    m_pData[offset] = color.r;
+    m_pData[offset + plane_size] = color.g;
+    m_pData[offset + 2 * plane_size] = color.b;
 }
 
 Spectrum RenderTarget::GetColor( int x , int y ) const{
@@ -40,7 +43,8 @@ Spectrum RenderTarget::GetColor( int x , int y ) const{
     texCoordFilter( x , y );
 
     // get the offset
-    int offset = y * m_iTexWidth + x;
+    const auto offset = y * m_iTexWidth + x;
+    const auto plane_size = m_iTexWidth * m_iTexHeight;
 
-    return m_pData[offset];
+    return Spectrum( m_pData[offset] , m_pData[offset + plane_size] , m_pData[offset + 2 * plane_size] );
 }
\ No newline at end of file
@@ -20,15 +20,44 @@
 #include <memory>
 #include "texturebase.h"
 
+//! @brief  Render target holding the result of rendering.
+/**
+ * Pixels are stored in three separate planes, one for each channel. This allows image output to
+ * hand the data to image writers directly without converting the whole image first.
+ */
 class   RenderTarget : public Texture2DBase{
 public:
+    //! @brief  Constructor taking the size of the render target.
+    //!
+    //! @param  w       Width of the render target.
+    //! @param  h       Height of the render target.
     RenderTarget( int w , int h ) : Texture2DBase( w , h ){
-        m_pData = std::make_unique<Spectrum[]>( w * h );
+        m_pData = std::make_unique<float[]>( 3 * w * h );
     }
 
+    //! @brief  Set the color of a pixel.
+    //!
+    //! @param  x       X coordinate. If out of range, it will be filtered.
+    //! @param  y       Y coordinate. If out of range, it will be filtered.
+    //! @param  c       Color of the pixel.
     void SetColor( int x , int y , const Spectrum& c );
-    Spectrum GetColor( int x , int y ) const;
+
+    //! @brief  Get the color of a pixel.
+    //!
+    //! @param  x       X coordinate. If out of range, it will be filtered.
+    //! @param  y       Y coordinate. If out of range, it will be filtered.
+    //! @return         Color of the pixel.
+    Spectrum GetColor( int x , int y ) const override;
+
+    //! @brief  Get the plane of a channel.
+    //!
+    //! @param  channel     Index of the channel, 0 for red, 1 for green and 2 for blue.
+    //! @return             The plane of the channel.
+    const float* GetPlane( int channel ) const override {
+        return ( channel >= 0 && channel < 3 && m_pData ) ? m_pData.get() + channel * m_iTexWidth * m_iTexHeight : nullptr;
+    }
 
 private:
-    std::unique_ptr<Spectrum[]> m_pData;
+    /**< Pixel data, red, green and blue planes are stored one after another. */
+    std::unique_ptr<float[]> m_pData;
 };
@@ -0,0 +1,215 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cmath>
+#include "sparsetexture3d.h"
+#include "stream/stream.h"
+#include "math/utils.h"
+
+template class SparseTexture3D<float>;
+template class SparseTexture3D<Spectrum>;
+
+template<class T>
+T SparseTexture3D<T>::Sample(int x, int y, int z) const {
+    if (x < 0 || x >= (int)Texture3DBase<T>::m_width || y < 0 || y >= (int)Texture3DBase<T>::m_height || z < 0 || z >= (int)Texture3DBase<T>::m_depth)
+        return 0.0f;
+    return texel(x, y, z);
+}
+
+template<class T>
+T SparseTexture3D<T>::Sample(float u, float v, float w) const {
+    if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f || w < 0.0f || w >= 1.0f || !Texture3DBase<T>::IsValid())
+        return 0.0f;
+
+    const auto width    = Texture3DBase<T>::m_width;
+    const auto height   = Texture3DBase<T>::m_height;
+    const auto depth    = Texture3DBase<T>::m_depth;
+
+    // Samples within half a texel from the lower borders take the border texels, instead of extrapolating them.
+    const auto fx = std::max(0.0f, u * width - 0.5f);
+    const auto fy = std::max(0.0f, v * height - 0.5f);
+    const auto fz = std::max(0.0f, w * depth - 0.5f);
+
+    const auto x0 = (unsigned)fx, x1 = std::min(x0 + 1, width - 1);
+    const auto y0 = (unsigned)fy, y1 = std::min(y0 + 1, height - 1);
+    const auto z0 = (unsigned)fz, z1 = std::min(z0 + 1, depth - 1);
+
+    const auto dx = fx - x0;
+    const auto dy = fy - y0;
+    const auto dz = fz - z0;
+
+    T t[8];
+    const auto b = brick(x0, y0, z0);
+    if (((x0 ^ x1) | (y0 ^ y1) | (z0 ^ z1)) <= BRICK_MASK) {
+        // All texels are in the same brick, which is the case for most samples, there is no need to interpolate
+        // inside a uniform brick at all.
+        if (b & UNIFORM_BRICK)
+            return m_uniform[b & ~UNIFORM_BRICK];
+        t[0] = fetch(b, local(x0, y0, z0));
+        t[1] = fetch(b, local(x1, y0, z0));
+        t[2] = fetch(b, local(x0, y1, z0));
+        t[3] = fetch(b, local(x1, y1, z0));
+        t[4] = fetch(b, local(x0, y0, z1));
+        t[5] = fetch(b, local(x1, y0, z1));
+        t[6] = fetch(b, local(x0, y1, z1));
+        t[7] = fetch(b, local(x1, y1, z1));
+    } else {
+        t[0] = texel(x0, y0, z0);
+        t[1] = texel(x1, y0, z0);
+        t[2] = texel(x0, y1, z0);
+        t[3] = texel(x1, y1, z0);
+        t[4] = texel(x0, y0, z1);
+        t[5] = texel(x1, y0, z1);
+        t[6] = texel(x0, y1, z1);
+        t[7] = texel(x1, y1, z1);
+    }
+
+    const auto t00 = slerp(t[0], t[1], dx);
+    const auto t10 = slerp(t[2], t[3], dx);
+    const auto t01 = slerp(t[4], t[5], dx);
+    const auto t11 = slerp(t[6], t[7], dx);
+
+    const auto t0 = slerp(t00, t10, dy);
+    const auto t1 = slerp(t01, t11, dy);
+
+    return slerp(t0, t1, dz);
+}
+
+template<class T>
+void SparseTexture3D<T>::Build(unsigned width, unsigned height, unsigned depth, const float* data, bool quantize) {
+    initialize(width, height, depth, quantize);
+    if (!Texture3DBase<T>::IsValid())
+        return;
+
+    const auto slice = (size_t)width * height * TexelChannels<T>::COUNT;
+    for (auto bz = 0u; bz < m_bricks[2]; ++bz)
+        addBricks(bz, data + slice * (bz << BRICK_SHIFT));
+}
+
+template<class T>
+void SparseTexture3D<T>::Serialize(IStreamBase& stream) {
+    unsigned width, height, depth;
+    bool quantize;
+    stream >> width >> height >> depth >> quantize;
+
+    initialize(width, height, depth, quantize);
+
+    // make sure the dimension is valid.
+    if (!Texture3DBase<T>::IsValid())
+        return;
+
+    // Only the slices covered by a row of bricks are loaded at a time.
+    const auto slice = (size_t)width * height * TexelChannels<T>::COUNT;
+    std::vector<float> slices(slice * BRICK_SIZE);
+    for (auto bz = 0u; bz < m_bricks[2]; ++bz) {
+        const auto slice_cnt = std::min(BRICK_SIZE, depth - (bz << BRICK_SHIFT));
+        stream.Load((char*)slices.data(), (int)(sizeof(float) * slice * slice_cnt));
+        addBricks(bz, slices.data());
+    }
+}
+
+template<class T>
+size_t SparseTexture3D<T>::GetMemoryUsage() const {
+    return m_index.size() * sizeof(unsigned) + m_uniform.size() * sizeof(T) + m_texels.size() * sizeof(T) +
+           m_quantized.size() * sizeof(uint16_t) + ( m_brickMin.size() + m_brickScale.size() ) * sizeof(T);
+}
+
+template<class T>
+void SparseTexture3D<T>::initialize(unsigned width, unsigned height, unsigned depth, bool quantize) {
+    Texture3DBase<T>::m_width = width;
+    Texture3DBase<T>::m_height = height;
+    Texture3DBase<T>::m_depth = depth;
+    m_quantize = quantize;
+
+    m_bricks[0] = (width + BRICK_MASK) >> BRICK_SHIFT;
+    m_bricks[1] = (height + BRICK_MASK) >> BRICK_SHIFT;
+    m_bricks[2] = (depth + BRICK_MASK) >> BRICK_SHIFT;
+
+    m_index.clear();
+    m_uniform.clear();
+    m_texels.clear();
+    m_quantized.clear();
+    m_brickMin.clear();
+    m_brickScale.clear();
+    m_index.reserve((size_t)m_bricks[0] * m_bricks[1] * m_bricks[2]);
+}
+
+template<class T>
+void SparseTexture3D<T>::addBricks(unsigned bz, const float* slices) {
+    constexpr auto channels = TexelChannels<T>::COUNT;
+    const auto width    = Texture3DBase<T>::m_width;
+    const auto height   = Texture3DBase<T>::m_height;
+    const auto depth    = Texture3DBase<T>::m_depth;
+
+    T texels[BRICK_TEXELS];
+    for (auto by = 0u; by < m_bricks[1]; ++by) {
+        for (auto bx = 0u; bx < m_bricks[0]; ++bx) {
+            // Texels out of the texture are padded with the border ones, they are never sampled.
+            auto uniform = true;
+            for (auto z = 0u; z < BRICK_SIZE; ++z) {
+                const auto sz = std::min(z, depth - 1 - (bz << BRICK_SHIFT));
+                for (auto y = 0u; y < BRICK_SIZE; ++y) {
+                    const auto sy = std::min((by << BRICK_SHIFT) + y, height - 1);
+                    for (auto x = 0u; x < BRICK_SIZE; ++x) {
+                        const auto sx = std::min((bx << BRICK_SHIFT) + x, width - 1);
+                        const auto src = slices + (((size_t)sz * height + sy) * width + sx) * channels;
+
+                        auto& v = texels[local(x, y, z)];
+                        for (auto c = 0u; c < channels; ++c) {
+                            TexelChannels<T>::Set(v, c, src[c]);
+                            uniform &= src[c] == TexelChannels<T>::Get(texels[0], c);
+                        }
+                    }
+                }
+            }
+
+            if (uniform) {
+                m_index.push_back(UNIFORM_BRICK | (unsigned)m_uniform.size());
+                m_uniform.push_back(texels[0]);
+                continue;
+            }
+
+            m_index.push_back(GetDenseBrickCount());
+            if (!m_quantize) {
+                m_texels.insert(m_texels.end(), texels, texels + BRICK_TEXELS);
+                continue;
+            }
+
+            // Each channel is quantized relative to the range of values of the channel in the brick.
+            T lo, scale;
+            for (auto c = 0u; c < channels; ++c) {
+                auto c_min = TexelChannels<T>::Get(texels[0], c), c_max = c_min;
+                for (auto i = 1u; i < BRICK_TEXELS; ++i) {
+                    c_min = std::min(c_min, TexelChannels<T>::Get(texels[i], c));
+                    c_max = std::max(c_max, TexelChannels<T>::Get(texels[i], c));
+                }
+                TexelChannels<T>::Set(lo, c, c_min);
+                TexelChannels<T>::Set(scale, c, (c_max - c_min) / 65535.0f);
+            }
+            m_brickMin.push_back(lo);
+            m_brickScale.push_back(scale);
+
+            for (auto i = 0u; i < BRICK_TEXELS; ++i) {
+                for (auto c = 0u; c < channels; ++c) {
+                    const auto s = TexelChannels<T>::Get(scale, c);
+                    const auto q = s > 0.0f ? std::round((TexelChannels<T>::Get(texels[i], c) - TexelChannels<T>::Get(lo, c)) / s) : 0.0f;
+                    m_quantized.push_back((uint16_t)clamp(q, 0.0f, 65535.0f));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,199 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2020 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "texturebase.h"
+
+class IStreamBase;
+
+//! @brief  Access to the float channels of a texel, texels are quantized channel by channel.
+template<class T>
+struct TexelChannels;
+
+template<>
+struct TexelChannels<float>{
+    static constexpr unsigned COUNT = 1;
+
+    static SORT_FORCEINLINE float   Get( const float& v , unsigned c ) {
+        return v;
+    }
+    static SORT_FORCEINLINE void    Set( float& v , unsigned c , float value ) {
+        v = value;
+    }
+};
+
+template<>
+struct TexelChannels<Spectrum>{
+    static constexpr unsigned COUNT = 3;
+
+    static SORT_FORCEINLINE float   Get( const Spectrum& v , unsigned c ) {
+        return v[c];
+    }
+    static SORT_FORCEINLINE void    Set( Spectrum& v , unsigned c , float value ) {
+        v[c] = value;
+    }
+};
+
+//! @brief  Sparse 3D texture made of bricks.
+/**
+ * The volume is divided into bricks of 8x8x8 texels, a top level index keeps track of the bricks. Bricks with the
+ * same value in all of their texels, which are the majority in smoke and clouds, only keep the value itself, the
+ * rest keep all of their texels, either in full precision or quantized to 16 bits per channel relative to the
+ * range of values in the brick.
+ * Texels are streamed in a few slices at a time, the dense volume is never fully loaded in memory.
+ */
+template<class T>
+class SparseTexture3D : public Texture3DBase<T>{
+public:
+    //! @brief  Default constructor.
+    SparseTexture3D() : Texture3DBase<T>(0u, 0u, 0u) {}
+
+    //! @brief  Take a sample in 3D texture given a position of texel.
+    //!
+    //! @param  x       X coordinate position.
+    //! @param  y       Y coordinate position.
+    //! @param  z       Z coordinate position.
+    T Sample(int x, int y, int z) const override;
+
+    //! @brief  Take a sample in 3D texture with trilinear interpolation.
+    //!
+    //! @param u        U coordinate.
+    //! @param v        V coordinate.
+    //! @param w        W coordinate.
+    T Sample(float u, float v, float w) const override;
+
+    //! @brief  Build the texture from dense texels.
+    //!
+    //! @param  width       Width of the texture.
+    //! @param  height      Height of the texture.
+    //! @param  depth       Depth of the texture.
+    //! @param  data        Channels of all texels, x goes first, then y and z.
+    //! @param  quantize    Whether to store texels in 16 bits per channel.
+    void    Build(unsigned width, unsigned height, unsigned depth, const float* data, bool quantize);
+
+    //! @brief  Serializing data from stream.
+    //!
+    //! The dimension, whether to quantize texels and channels of all texels are expected in the stream.
+    //!
+    //! @param  stream  Where the serialization data comes from.
+    void    Serialize(IStreamBase& stream);
+
+    //! @brief  Visit texels in a box, bricks with the same value in all texels are only visited once.
+    //!
+    //! @param  x0      Minimum texel along x axis.
+    //! @param  y0      Minimum texel along y axis.
+    //! @param  z0      Minimum texel along z axis.
+    //! @param  x1      Maximum texel along x axis, it is inclusive.
+    //! @param  y1      Maximum texel along y axis, it is inclusive.
+    //! @param  z1      Maximum texel along z axis, it is inclusive.
+    //! @param  func    Functor called with the value of texels.
+    template<class Func>
+    void    VisitTexels(unsigned x0, unsigned y0, unsigned z0, unsigned x1, unsigned y1, unsigned z1, Func&& func) const;
+
+    //! @brief  Number of bricks keeping all of their texels.
+    SORT_FORCEINLINE unsigned   GetDenseBrickCount() const {
+        return (unsigned)( m_quantize ? m_brickMin.size() : m_texels.size() / BRICK_TEXELS );
+    }
+
+    //! @brief  Memory used by the texture in bytes.
+    size_t  GetMemoryUsage() const;
+
+private:
+    static constexpr unsigned   BRICK_SHIFT = 3;
+    static constexpr unsigned   BRICK_SIZE = 1u << BRICK_SHIFT;
+    static constexpr unsigned   BRICK_MASK = BRICK_SIZE - 1;
+    static constexpr unsigned   BRICK_TEXELS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+    static constexpr unsigned   UNIFORM_BRICK = 0x80000000u;
+
+    unsigned                m_bricks[3] = { 0 , 0 , 0 };    /**< Number of bricks along each axis. */
+    std::vector<unsigned>   m_index;        /**< Dense brick index, or uniform value index with UNIFORM_BRICK set. */
+    std::vector<T>          m_uniform;      /**< Values of uniform bricks. */
+    std::vector<T>          m_texels;       /**< Texels of dense bricks in full precision. */
+    std::vector<uint16_t>   m_quantized;    /**< Quantized channels of texels of dense bricks. */
+    std::vector<T>          m_brickMin;     /**< Minimum value of each quantized brick. */
+    std::vector<T>          m_brickScale;   /**< Size of a quantization step of each quantized brick. */
+    bool                    m_quantize = false; /**< Whether texels are quantized. */
+
+    //! @brief  Reset the texture before adding bricks.
+    void        initialize(unsigned width, unsigned height, unsigned depth, bool quantize);
+
+    //! @brief  Add a row of bricks along z axis.
+    //!
+    //! @param  bz          Index of the row of bricks.
+    //! @param  slices      Channels of the texels in the slices covered by the row.
+    void        addBricks(unsigned bz, const float* slices);
+
+    //! @brief  Index of the brick containing a texel.
+    SORT_FORCEINLINE unsigned brick(unsigned x, unsigned y, unsigned z) const {
+        return m_index[((z >> BRICK_SHIFT) * m_bricks[1] + (y >> BRICK_SHIFT)) * m_bricks[0] + (x >> BRICK_SHIFT)];
+    }
+
+    //! @brief  Offset of a texel inside its brick.
+    static SORT_FORCEINLINE unsigned local(unsigned x, unsigned y, unsigned z) {
+        return ((z & BRICK_MASK) << (2 * BRICK_SHIFT)) | ((y & BRICK_MASK) << BRICK_SHIFT) | (x & BRICK_MASK);
+    }
+
+    //! @brief  Value of a texel in a dense brick.
+    SORT_FORCEINLINE T fetch(unsigned dense, unsigned offset) const {
+        if (!m_quantize)
+            return m_texels[(size_t)dense * BRICK_TEXELS + offset];
+
+        auto v = m_brickMin[dense];
+        const auto& scale = m_brickScale[dense];
+        const auto q = &m_quantized[((size_t)dense * BRICK_TEXELS + offset) * TexelChannels<T>::COUNT];
+        for (auto c = 0u; c < TexelChannels<T>::COUNT; ++c)
+            TexelChannels<T>::Set(v, c, TexelChannels<T>::Get(v, c) + TexelChannels<T>::Get(scale, c) * q[c]);
+        return v;
+    }
+
+    //! @brief  Value of a texel inside the texture.
+    SORT_FORCEINLINE T texel(unsigned x, unsigned y, unsigned z) const {
+        const auto b = brick(x, y, z);
+        if (b & UNIFORM_BRICK)
+            return m_uniform[b & ~UNIFORM_BRICK];
+        return fetch(b, local(x, y, z));
+    }
+};
+
+template<class T>
+template<class Func>
+void SparseTexture3D<T>::VisitTexels(unsigned x0, unsigned y0, unsigned z0, unsigned x1, unsigned y1, unsigned z1, Func&& func) const {
+    for (auto bz = z0 >> BRICK_SHIFT; bz <= (z1 >> BRICK_SHIFT); ++bz) {
+        for (auto by = y0 >> BRICK_SHIFT; by <= (y1 >> BRICK_SHIFT); ++by) {
+            for (auto bx = x0 >> BRICK_SHIFT; bx <= (x1 >> BRICK_SHIFT); ++bx) {
+                const auto b = m_index[(bz * m_bricks[1] + by) * m_bricks[0] + bx];
+                if (b & UNIFORM_BRICK) {
+                    func(m_uniform[b & ~UNIFORM_BRICK]);
+                    continue;
+                }
+
+                // the part of the box inside the brick
+                const auto lx0 = std::max(x0, bx << BRICK_SHIFT), lx1 = std::min(x1, (bx << BRICK_SHIFT) + BRICK_MASK);
+                const auto ly0 = std::max(y0, by << BRICK_SHIFT), ly1 = std::min(y1, (by << BRICK_SHIFT) + BRICK_MASK);
+                const auto lz0 = std::max(z0, bz << BRICK_SHIFT), lz1 = std::min(z1, (bz << BRICK_SHIFT) + BRICK_MASK);
+                for (auto z = lz0; z <= lz1; ++z)
+                    for (auto y = ly0; y <= ly1; ++y)
+                        for (auto x = lx0; x <= lx1; ++x)
+                            func(fetch(b, local(x, y, z)));
+            }
+        }
+    }
+}
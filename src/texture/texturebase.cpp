@@ -15,41 +15,39 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
-#include <regex>
 #include <math.h>
+#include <memory>
 #include "texturebase.h"
 #include "core/sassert.h"
 #include "math/interaction.h"
-#include "thirdparty/tiny_exr/tinyexr.h"
-#include "thirdparty/stb_image/stb_image.h"
+#include "task/task.h"
 
-bool Texture2DBase::Output( const std::string& name ){
-    std::regex exr_reg(".*\\.exr$", std::regex_constants::icase);
-    if (std::regex_match(name, exr_reg)) {
-        const auto totalXRes = GetWidth();
-        const auto totalYRes = GetHeight();
-        const auto total = totalXRes * totalYRes;
-        const auto data = std::make_unique<float[]>(total * 3);
-        for (auto i = 0; i < total; ++i)
-        {
-            auto x = i % totalXRes;
-            auto y = i / totalXRes;
-            Spectrum c = GetColor(x, y);
+bool Texture2DBase::Output( const std::string& name , const ImageOutputConfig& config ){
+    const auto w = GetWidth();
+    const auto h = GetHeight();
 
-            data[3 * i] = c.r;
-            data[3 * i + 1] = c.g;
-            data[3 * i + 2] = c.b;
-        }
-
-        int ret = SaveEXR(data.get(), GetWidth(), GetHeight(), 3, true, name.c_str());
-        if (ret < 0)
-            slog(WARNING, MATERIAL, "Fail to save image file %s", name.c_str());
-        return ret >= 0;
-    }
+    // Textures with planar data are written out directly, there is no extra copy of the image.
+    if( GetPlane(0) && GetPlane(1) && GetPlane(2) )
+        return SaveImage( name , w , h , { { "R" , GetPlane(0) } , { "G" , GetPlane(1) } , { "B" , GetPlane(2) } } , config );
 
-    sAssertMsg( false , IMAGE , "SORT doesn't support exporting file %s",name.c_str());
+    const auto total = w * h;
+    const auto data = std::make_unique<float[]>( total * 3 );
+    const auto r = data.get();
+    const auto g = r + total;
+    const auto b = g + total;
+    ParallelForRows( h , [&]( int y0 , int y1 ){
+        for( auto y = y0 ; y < y1 ; ++y ){
+            for( auto x = 0 ; x < w ; ++x ){
+                const auto c = GetColor( x , y );
+                const auto i = y * w + x;
+                r[i] = c.r;
+                g[i] = c.g;
+                b[i] = c.b;
+            }
+        }
+    });
 
-    return false;
+    return SaveImage( name , w , h , { { "R" , r } , { "G" , g } , { "B" , b } } , config );
 }
 
 void Texture2DBase::texCoordFilter( int& x , int& y ) const{
@@ -19,6 +19,7 @@
 
 #include "core/define.h"
 #include "spectrum/spectrum.h"
+#include "texture/imageoutput.h"
 
 // texture filter
 enum TEXCOORDFILTER{
@@ -54,9 +55,23 @@ public:
 
     //! @brief  Output the texture to file
     //!
+    //! The format of the file is decided by its extension, EXR, PNG and HDR are supported.
+    //!
     //! @param filename     The name of the output file.
+    //! @param config       Settings of the output image.
     //! @return             Whether the file is output successfully.
-    bool Output( const std::string& filename );
+    bool Output( const std::string& filename , const ImageOutputConfig& config = ImageOutputConfig() );
+
+    //! @brief  Get the plane of a channel of the texture, if the texture stores its data in planes.
+    //!
+    //! Textures storing each channel in a separate plane, top row first, could be written out without
+    //! any conversion. Other textures will be converted through 'GetColor' before written out.
+    //!
+    //! @param  channel     Index of the channel, 0 for red, 1 for green and 2 for blue.
+    //! @return             The plane of the channel, 'nullptr' if there is no such a plane.
+    virtual const float* GetPlane( int channel ) const {
+        return nullptr;
+    }
 
     //! @brief  Get the color at a specific position.
     //!
@@ -163,6 +178,27 @@ public:
         return m_width > 0 && m_height > 0 && m_depth > 0;
     }
 
+    //! @brief  Get the width of the texture.
+    //!
+    //! @return             The width of the 3d texture.
+    SORT_FORCEINLINE unsigned GetWidth() const {
+        return m_width;
+    }
+
+    //! @brief  Get the height of the texture.
+    //!
+    //! @return             The height of the 3d texture.
+    SORT_FORCEINLINE unsigned GetHeight() const {
+        return m_height;
+    }
+
+    //! @brief  Get the depth of the texture.
+    //!
+    //! @return             The depth of the 3d texture.
+    SORT_FORCEINLINE unsigned GetDepth() const {
+        return m_depth;
+    }
+
 protected:
     /**< Size of the 3D texture. */
     unsigned m_width;
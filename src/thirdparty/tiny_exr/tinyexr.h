@@ -105,6 +105,11 @@ extern "C" {
 // http://computation.llnl.gov/projects/floating-point-compression
 #endif
 
+// Use C++11 threads to compress scanline blocks in parallel when saving images.
+#ifndef TINYEXR_USE_THREAD
+#define TINYEXR_USE_THREAD (0)
+#endif
+
 #define TINYEXR_SUCCESS (0)
 #define TINYEXR_ERROR_INVALID_MAGIC_NUMBER (-1)
 #define TINYEXR_ERROR_INVALID_EXR_VERSION (-2)
@@ -474,6 +479,11 @@ extern int LoadEXRFromMemory(float **out_rgba, int *width, int *height,
 #include <omp.h>
 #endif
 
+#if TINYEXR_USE_THREAD
+#include <atomic>
+#include <thread>
+#endif
+
 #if TINYEXR_USE_MINIZ
 #else
 //  Issue #46. Please include your own zlib-compatible API header before
@@ -11657,12 +11667,25 @@ size_t SaveEXRImageToMemory(const EXRImage *exr_image,
   }
 #endif
 
+#if TINYEXR_USE_THREAD
+  std::atomic<int> block_count(0);
+  std::vector<std::thread> workers;
+
+  int num_threads = (std::max)(1, int(std::thread::hardware_concurrency()));
+  num_threads = (std::min)(num_threads, num_blocks);
+
+  for (int t = 0; t < num_threads; t++) {
+    workers.emplace_back(std::thread([&]() {
+      int i = 0;
+      while ((i = block_count++) < num_blocks) {
+#else
 // Use signed int since some OpenMP compiler doesn't allow unsigned type for
 // `parallel for`
 #ifdef _OPENMP
 #pragma omp parallel for
 #endif
   for (int i = 0; i < num_blocks; i++) {
+#endif
     size_t ii = static_cast<size_t>(i);
     int start_y = num_scanlines * i;
     int endY = (std::min)(num_scanlines * (i + 1), exr_image->height);
@@ -11911,7 +11934,17 @@ size_t SaveEXRImageToMemory(const EXRImage *exr_image,
     } else {
       assert(0);
     }
+#if TINYEXR_USE_THREAD
+      }
+    }));
+  }
+
+  for (auto &t : workers) {
+    t.join();
+  }
+#else
   }  // omp parallel
+#endif
 
   for (size_t i = 0; i < static_cast<size_t>(num_blocks); i++) {
     data.insert(data.end(), data_list[i].begin(), data_list[i].end());